@@ -0,0 +1,229 @@
+"""Export of the sample store to CSV, the DAQ log, Parquet and Arrow.
+
+Everything here reads the store in chunks of absolute rows (`SampleStore.read`)
+and is meant to run off the GUI thread. `export` writes what the store holds
+once. `Recorder` follows the store as scans arrive and appends them to a file,
+flushed and synced every interval. The file then holds every scan so far in
+each recordable format: CSV lines, Arrow stream batches, and for the DAQ log
+also the block being filled. So a crash loses at most the last interval.
+
+Files have one row per scan: the time and one temperature column per channel.
+The DAQ log is the compressed block format of tslog.py. Parquet and Arrow need
+pyarrow. `formats` only lists what is installed.
+"""
+
+import os
+import threading
+from datetime import datetime
+
+from tslog import LogWriter
+
+try:
+    import pyarrow as pa
+    import pyarrow.ipc
+    import pyarrow.parquet
+except ImportError:
+    pa = None
+
+CHUNK_ROWS = 65536
+RECORD_INTERVAL = 0.5
+
+
+class CsvWriter:
+    name = "CSV"
+    suffix = ".csv"
+    recordable = True
+
+    def __init__(self, path, channels):
+        self.channels = channels
+        self.file = open(path, 'w', newline='')
+        self.file.write(",".join(["Time", "Time (ns)"] + [f"Channel {ch} °C" for ch in channels]) + "\n")
+
+    def write(self, times, values):
+        columns = [values[ch] for ch in self.channels]
+        lines = []
+        for i, t in enumerate(times):
+            cells = [datetime.fromtimestamp(t / 1e9).isoformat(timespec='milliseconds'), str(t)]
+            # Empty where the scan did not carry the channel
+            cells.extend("" if column[i] != column[i] else f"{column[i]:.6g}" for column in columns)
+            lines.append(",".join(cells))
+        lines.append("")
+        self.file.write("\n".join(lines))
+
+    def flush(self):
+        self.file.flush()
+        os.fsync(self.file.fileno())
+
+    def close(self):
+        self.file.close()
+
+
+class ArrowWriter:
+    """Arrow IPC, the file format for exports and the stream format for recording.
+
+    A stream cut off by a crash still reads up to its last complete batch.
+    """
+    name = "Arrow IPC"
+    suffix = ".arrow"
+    recordable = True
+
+    def __init__(self, path, channels, stream=False):
+        self.channels = channels
+        self.schema = pa.schema([("time", pa.timestamp('ns', tz='UTC'))] +
+                                [(f"ch{ch}", pa.float32()) for ch in channels])
+        # A Python file under the Arrow sink, pa.OSFile has no descriptor to sync
+        self.file = open(path, 'wb')
+        self.sink = pa.PythonFile(self.file, mode='w')
+        self.writer = (pa.ipc.new_stream if stream else pa.ipc.new_file)(self.sink, self.schema)
+
+    def _batch(self, times, values):
+        # The store's arrays are handed over as buffers, without a copy
+        n = len(times)
+        arrays = [pa.Array.from_buffers(self.schema.field(0).type, n, [None, pa.py_buffer(times)])]
+        arrays += [pa.Array.from_buffers(pa.float32(), n, [None, pa.py_buffer(values[ch])]) for ch in self.channels]
+        return pa.RecordBatch.from_arrays(arrays, schema=self.schema)
+
+    def write(self, times, values):
+        self.writer.write_batch(self._batch(times, values))
+
+    def flush(self):
+        self.sink.flush()
+        self.file.flush()
+        os.fsync(self.file.fileno())
+
+    def close(self):
+        self.writer.close()
+        self.sink.close()
+        self.file.close()
+
+
+class ParquetWriter(ArrowWriter):
+    """Parquet, one row group per chunk. Only readable once closed, so not for recording."""
+    name = "Parquet"
+    suffix = ".parquet"
+    recordable = False
+
+    def __init__(self, path, channels):
+        self.channels = channels
+        self.schema = pa.schema([("time", pa.timestamp('ns', tz='UTC'))] +
+                                [(f"ch{ch}", pa.float32()) for ch in channels])
+        self.writer = pa.parquet.ParquetWriter(path, self.schema)
+
+    def write(self, times, values):
+        self.writer.write_table(pa.Table.from_batches([self._batch(times, values)]))
+
+    def flush(self):
+        pass
+
+    def close(self):
+        self.writer.close()
+
+
+def formats(recording=False):
+    """Writer classes that are installed, CSV first."""
+    writers = [CsvWriter, LogWriter] + ([ArrowWriter, ParquetWriter] if pa is not None else [])
+    return [w for w in writers if w.recordable or not recording]
+
+
+def writer_for(path, channels, recording=False):
+    writer = writer_class(path, recording)
+    if writer is ArrowWriter:
+        return writer(path, channels, stream=recording)
+    return writer(path, channels)
+
+
+def writer_class(path, recording=False):
+    for writer in formats(recording):
+        if path.lower().endswith(writer.suffix):
+            return writer
+    raise ValueError(f"No writer for {os.path.basename(path)}")
+
+
+def export(store, path, progress=None, cancel=None):
+    """Writes the rows the store holds when called. Returns the number of rows written.
+
+    `progress(done, total)` is called after every chunk, `cancel` is a
+    threading.Event that stops the export early. Rows evicted from the store
+    while the export runs are skipped.
+    """
+    # One consistent view: the GUI thread appends and evicts under the lock while this runs on a worker
+    with store.lock:
+        start, stop, channels = store.first, store.total, list(store.channels)
+    writer = writer_for(path, channels)
+    written = 0
+    try:
+        row = start
+        while row < stop:
+            if cancel is not None and cancel.is_set():
+                break
+            first, times, values = store.read(row, min(row + CHUNK_ROWS, stop))
+            if times:
+                writer.write(times, values)
+                written += len(times)
+            row = max(first + len(times), row + 1)
+            if progress:
+                progress(row - start, stop - start)
+    finally:
+        writer.close()
+    return written
+
+
+class Recorder(threading.Thread):
+    """Appends every scan the store receives to a file until stopped.
+
+    Starts with what the store already holds. When a new channel appears the
+    file is closed and recording goes on in a new one, `name-2.csv` and so on,
+    since no format can add a column later.
+    """
+
+    def __init__(self, store, path, interval=RECORD_INTERVAL):
+        super().__init__(daemon=True)
+        self.store = store
+        self.path = path
+        self.interval = interval
+        with store.lock:
+            self.row = store.first
+        self.rows = 0
+        self.missed = 0         # Evicted from the store before they were written
+        self.files = []
+        self.writer = None
+        self.error = None
+        self.stopped = threading.Event()
+        writer_class(path, recording=True)
+
+    def _open(self, channels):
+        if self.writer is not None:
+            self.writer.close()
+        stem, suffix = os.path.splitext(self.path)
+        path = self.path if not self.files else f"{stem}-{len(self.files) + 1}{suffix}"
+        self.writer = writer_for(path, channels, recording=True)
+        self.files.append(path)
+
+    def _drain(self):
+        while self.row < self.store.total:
+            first, times, values = self.store.read(self.row, self.row + CHUNK_ROWS)
+            self.missed += first - self.row
+            if times:
+                channels = sorted(values)
+                if self.writer is None or channels != self.writer.channels:
+                    self._open(channels)
+                self.writer.write(times, values)
+                self.rows += len(times)
+            self.row = first + len(times)
+        if self.writer is not None:
+            self.writer.flush()
+
+    def run(self):
+        try:
+            while not self.stopped.wait(self.interval):
+                self._drain()
+            self._drain()
+        except Exception as e:
+            self.error = e
+        finally:
+            if self.writer is not None:
+                self.writer.close()
+
+    def stop(self):
+        self.stopped.set()
+        self.join()
@@ -0,0 +1,498 @@
+"""Serial ingest for the DAQ stream.
+
+Bytes are read in large blocking reads straight into a ring buffer and parsed
+in place. The board sends either binary telemetry frames (see
+Drivers/Telemetry/Telemetry.h in the firmware) or CSV text lines, mixed with
+console messages; all three are recognised in the same stream. Samples come
+out as columnar batches: one int64 time column in ns and one float64 column
+per channel, as array.array so numpy can wrap them without a copy.
+
+The native core in native/ (`python setup.py build_ext --inplace`) does the
+reading and parsing in C++ with the GIL released and is used whenever it is
+built and the port has a file descriptor. StreamParser and RingBuffer below
+are the same logic in Python and the fallback everywhere else.
+"""
+
+import os
+import struct
+import sys
+import threading
+import time
+import zlib
+import selectors
+from array import array
+from collections import namedtuple
+
+try:
+    import _daq_ingest
+except ImportError:
+    _daq_ingest = None
+
+SYNC = b'\xaa\x55'
+HEADER = struct.Struct('<2sBBIQHHI')
+HEADER_SIZE = HEADER.size
+CRC_SIZE = 4
+MAX_PAYLOAD = 4096
+RESET_STEP_NS = 1000000000
+
+TYPE_CODE = 1
+TYPE_CENTI_CELSIUS = 2
+TYPE_ALARM = 3
+TYPE_CHANGES = 4
+
+ALARM_KINDS = {1: 'high', 2: 'low', 4: 'rise'}
+
+AlarmEvent = namedtuple('AlarmEvent', 'time channel kind active source value')
+
+_REVERSE = bytes(int(f'{b:08b}'[::-1], 2) for b in range(256))
+_TEXT = bytes(range(0x20, 0x7f)) + b'\t\r'
+
+
+def _reverse32(value):
+    return int(f'{value:032b}'[::-1], 2)
+
+
+def crc_mpeg2(data):
+    """CRC-32/MPEG-2 of bytes in order, CRC_MODE_MPEG2 of the firmware.
+
+    Polynomial 0x04C11DB7, initial value 0xFFFFFFFF, no reflection, no final
+    XOR. zlib does the work on bit reversed bytes, so this runs at C speed.
+    """
+    return _reverse32(zlib.crc32(bytes(data).translate(_REVERSE)) ^ 0xFFFFFFFF)
+
+
+def crc32(data):
+    """CRC-32 of zlib, CRC_MODE_CRC32 of the firmware."""
+    return zlib.crc32(data)
+
+
+def crc_words(data):
+    """CRC of the firmware frames: the STM32 CRC unit over little endian words.
+
+    CRC_MODE_WORDS of the firmware. The unit takes each word most significant
+    byte first, i.e. MPEG-2 over the byte swapped words.
+    """
+    words = array('I')
+    words.frombytes(data)
+    if sys.byteorder == 'little':
+        words.byteswap()
+    return crc_mpeg2(words.tobytes())
+
+
+CRC_MODE_WORDS = 0
+CRC_MODE_MPEG2 = 1
+CRC_MODE_CRC32 = 2
+
+_CRC_MODES = {CRC_MODE_WORDS: crc_words, CRC_MODE_MPEG2: crc_mpeg2, CRC_MODE_CRC32: crc32}
+
+
+def crc(mode, data):
+    """CRC of `data` as CRC_Compute of the firmware computes it for CRC_MODE_x `mode`."""
+    return _CRC_MODES[mode](data)
+
+
+class Batch:
+    """Scans of one channel set, times in ns since the epoch."""
+    __slots__ = ('channels', 'time', 'columns')
+
+    def __init__(self, channels):
+        self.channels = tuple(channels)
+        self.time = array('q')
+        self.columns = [array('d') for _ in self.channels]
+
+    def __len__(self):
+        return len(self.time)
+
+    def to_numpy(self):
+        import numpy as np
+        return (np.frombuffer(self.time, dtype=np.int64),
+                [np.frombuffer(c, dtype=np.float64) for c in self.columns])
+
+
+class RingBuffer:
+    """Byte ring that is read into and parsed in place.
+
+    Unparsed bytes are moved to the front when the free space at the end runs
+    out, so the parser always sees one contiguous view. That copy only covers
+    a partial frame or line.
+    """
+
+    def __init__(self, capacity=1 << 20):
+        self.buffer = bytearray(capacity)
+        self.view = memoryview(self.buffer)
+        self.head = 0
+        self.tail = 0
+        self.overflows = 0
+
+    def writable(self):
+        capacity = len(self.buffer)
+        if self.tail == capacity:
+            if self.head == 0:
+                # Nothing the parser could use, drop the older half
+                self.head = capacity // 2
+                self.overflows += 1
+            pending = self.tail - self.head
+            self.buffer[:pending] = self.view[self.head:self.tail]
+            self.head, self.tail = 0, pending
+        return self.view[self.tail:]
+
+    def written(self, count):
+        self.tail += count
+
+    def readable(self):
+        return self.view[self.head:self.tail]
+
+    def consume(self, count):
+        self.head += count
+        if self.head == self.tail:
+            self.head = self.tail = 0
+
+
+class StreamParser:
+    """Splits the byte stream into frames, sample lines and console messages."""
+
+    def __init__(self):
+        self.batches = []
+        self.alarms = []
+        self.messages = []
+        self.frames = 0
+        self.crc_errors = 0
+        self.lost_frames = 0
+        self.lines = 0
+        self.skipped = 0
+        self._offset = None
+        self._last_device_time = None
+        self._sequence = {}
+        self._changes = None
+
+    def feed(self, data, start=0, end=None):
+        """Parses the complete frames and lines in data[start:end], returns where parsing stopped."""
+        end = len(data) if end is None else end
+        view = memoryview(data)
+        position = start
+        while position < end:
+            if data.startswith(SYNC, position, end):
+                used = self._frame(data, view, position, end)
+                if used > 0:
+                    position += used
+                    continue
+                if used == 0:
+                    break
+            newline = data.find(b'\n', position, end)
+            sync = data.find(SYNC, position + 1, end)
+            if sync >= 0 and (newline < 0 or sync < newline):
+                # Console output and frames are queued whole, anything before a frame is a line of its own
+                self._line(view[position:sync])
+                position = sync
+            elif newline >= 0:
+                self._line(view[position:newline])
+                position = newline + 1
+            else:
+                break
+        return position
+
+    def take(self):
+        """Returns and clears the batches, alarm events and messages parsed so far."""
+        batches, alarms, messages = self.batches, self.alarms, self.messages
+        self.batches, self.alarms, self.messages = [], [], []
+        return batches, alarms, messages
+
+    def _batch(self, channels):
+        if self.batches and self.batches[-1].channels == tuple(channels):
+            return self.batches[-1]
+        batch = Batch(channels)
+        self.batches.append(batch)
+        return batch
+
+    def _wall(self, device_time):
+        # Device time runs from reset, anchor it to the host clock once and again after a reset.
+        # Alarm frames overtake queued sample frames, so small steps back are normal.
+        if self._offset is None or device_time + RESET_STEP_NS < self._last_device_time:
+            self._offset = time.time_ns() - device_time
+            self._last_device_time = device_time
+        self._last_device_time = max(self._last_device_time, device_time)
+        return device_time + self._offset
+
+    def _line(self, view):
+        raw = bytes(view)
+        if raw.translate(None, _TEXT):
+            # Rest of a damaged frame
+            self.skipped += len(raw) + 1
+            return
+        self.lines += 1
+        text = raw.decode().strip()
+        if not text:
+            return
+        values = []
+        for part in text.split(','):
+            try:
+                values.append(float(part))
+            except ValueError:
+                self.messages.append(text)
+                return
+        batch = self._batch(range(len(values)))
+        batch.time.append(time.time_ns())
+        for column, value in zip(batch.columns, values):
+            column.append(value)
+
+    def _frame(self, data, view, position, end):
+        """Returns the frame length, 0 when incomplete or -1 when it is no frame."""
+        if end - position < HEADER_SIZE:
+            return 0
+        _, kind, scans, sequence, timestamp, mask, length, period = HEADER.unpack_from(data, position)
+        if kind not in (TYPE_CODE, TYPE_CENTI_CELSIUS, TYPE_ALARM, TYPE_CHANGES) or length > MAX_PAYLOAD or length & 3:
+            return -1
+        size = HEADER_SIZE + length + CRC_SIZE
+        if end - position < size:
+            return 0
+        crc, = struct.unpack_from('<I', data, position + HEADER_SIZE + length)
+        if crc_words(view[position:position + HEADER_SIZE + length]) != crc:
+            self.crc_errors += 1
+            return -1
+
+        self.frames += 1
+        stream = 'alarm' if kind == TYPE_ALARM else 'samples'
+        expected = self._sequence.get(stream)
+        if expected is not None and sequence != expected:
+            self.lost_frames += (sequence - expected) & 0xFFFFFFFF
+            if kind == TYPE_CHANGES:
+                self._changes = None
+        self._sequence[stream] = (sequence + 1) & 0xFFFFFFFF
+
+        channels = [ch for ch in range(16) if mask & (1 << ch)]
+        payload = view[position + HEADER_SIZE:position + HEADER_SIZE + length]
+        wall = self._wall(timestamp)
+        if kind == TYPE_ALARM:
+            for record in range(min(scans, length // 8)):
+                channel, alarm, active, source, value = struct.unpack_from('<BBBBi', payload, record * 8)
+                self.alarms.append(AlarmEvent(wall, channel, ALARM_KINDS.get(alarm, str(alarm)),
+                                              bool(active), source, value / 100.0))
+        elif kind == TYPE_CHANGES:
+            try:
+                self._records(payload, scans, channels, wall, period)
+            except IndexError:
+                # Records running past the payload, keep those before
+                pass
+        elif channels:
+            # Whole scans only, a payload shorter than the header claims would leave the columns ragged
+            scans = min(scans, length // (2 * len(channels)))
+            samples = array('h' if kind == TYPE_CENTI_CELSIUS else 'H')
+            samples.frombytes(payload[:scans * len(channels) * 2])
+            if sys.byteorder != 'little':
+                samples.byteswap()
+            scale = 0.01 if kind == TYPE_CENTI_CELSIUS else 1.0
+            batch = self._batch(channels)
+            batch.time.extend(wall + scan * period for scan in range(scans))
+            for index, column in enumerate(batch.columns):
+                column.extend(value * scale for value in samples[index::len(channels)])
+        return size
+
+    def _records(self, payload, records, channels, wall, period):
+        """Change-only records: values are held between records, resynchronised by keyframes."""
+        position = 0
+        record_time = wall
+        for record in range(records):
+            head, position = _varint(payload, position)
+            changed, position = _varint(payload, position)
+            key = head & 1
+            if record > 0:
+                record_time += (head >> 1) * period
+            if key or self._changes is None or len(self._changes) != len(channels):
+                if not key:
+                    # Differences without the values they refer to
+                    for index in range(len(channels)):
+                        if changed & (1 << index):
+                            _, position = _varint(payload, position)
+                    continue
+                self._changes = [0] * len(channels)
+            for index in range(len(channels)):
+                if changed & (1 << index):
+                    code, position = _varint(payload, position)
+                    value = (code >> 1) ^ -(code & 1)
+                    self._changes[index] = value if key else self._changes[index] + value
+            batch = self._batch(channels)
+            batch.time.append(record_time)
+            for column, value in zip(batch.columns, self._changes):
+                column.append(value * 0.01)
+
+
+def _varint(data, position):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[position]
+        position += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, position
+        shift += 7
+
+
+def _fileno(port):
+    if os.name != 'posix':
+        return None
+    if isinstance(port, int):
+        return port
+    try:
+        return port.fileno()
+    except (AttributeError, OSError, ValueError):
+        return None
+
+
+class Ingest(threading.Thread):
+    """Reads a port on its own thread and hands out what was parsed.
+
+    `callback(batches, alarms, messages)` runs on this thread at most once per
+    `interval` seconds, with everything that arrived in between coalesced. On
+    POSIX the thread sleeps in epoll/select until bytes arrive and reads them
+    straight into the ring; elsewhere it blocks in the port's read().
+
+    With the native core (`native=None` uses it when built) the ring and the
+    parser are C++ and `parser` is the native reader, which has the same
+    counters. `native=False` forces the Python path.
+    """
+
+    def __init__(self, port, callback, interval=0.05, capacity=1 << 20, native=None):
+        super().__init__(daemon=True)
+        self.port = port
+        self.callback = callback
+        self.interval = interval
+        self.bytes = 0
+        self.error = None
+        self._running = True
+        fd = _fileno(port)
+        if native is None:
+            native = _daq_ingest is not None and fd is not None
+        if native:
+            if _daq_ingest is None or fd is None:
+                raise RuntimeError('The native ingest core is not built or the port has no file descriptor')
+            self.ring = None
+            self.parser = _daq_ingest.Reader(fd, capacity, Batch, AlarmEvent)
+        else:
+            self.ring = RingBuffer(capacity)
+            self.parser = StreamParser()
+
+    @property
+    def native(self):
+        return self.ring is None
+
+    @property
+    def overflows(self):
+        return self.parser.overflows if self.native else self.ring.overflows
+
+    def stop(self):
+        self._running = False
+
+    def run(self):
+        if self.native:
+            self._run_native()
+            return
+        fd = _fileno(self.port)
+        selector = None
+        if fd is not None:
+            selector = selectors.DefaultSelector()
+            selector.register(fd, selectors.EVENT_READ)
+        deadline = time.monotonic() + self.interval
+        try:
+            while self._running:
+                count = self._read(fd, selector, max(0.0, deadline - time.monotonic()))
+                if count is None:
+                    break
+                if count:
+                    self.ring.written(count)
+                    self.bytes += count
+                    stop = self.parser.feed(self.ring.buffer, self.ring.head, self.ring.tail)
+                    self.ring.consume(stop - self.ring.head)
+                now = time.monotonic()
+                if now >= deadline:
+                    deadline = now + self.interval
+                    self._hand_out()
+        finally:
+            self._hand_out()
+            if selector is not None:
+                selector.close()
+
+    def _run_native(self):
+        deadline = time.monotonic() + self.interval
+        try:
+            while self._running:
+                try:
+                    count = self.parser.read(max(0.0, deadline - time.monotonic()))
+                except OSError as error:
+                    self.error = error
+                    break
+                if count is None:
+                    break
+                self.bytes += count
+                now = time.monotonic()
+                if now >= deadline:
+                    deadline = now + self.interval
+                    self._hand_out()
+        finally:
+            self._hand_out()
+
+    def _hand_out(self):
+        batches, alarms, messages = self.parser.take()
+        if batches or alarms or messages:
+            self.callback(batches, alarms, messages)
+
+    def _read(self, fd, selector, timeout):
+        """Bytes read into the ring, 0 on timeout, None once the port is gone."""
+        target = self.ring.writable()
+        try:
+            if selector is not None:
+                if not selector.select(timeout):
+                    return 0
+                count = os.readv(fd, [target])
+                return count if count > 0 else None
+            self.port.timeout = timeout
+            data = self.port.read(max(1, min(len(target), getattr(self.port, 'in_waiting', 0))))
+            target[:len(data)] = data
+            return len(data)
+        except BlockingIOError:
+            return 0
+        except OSError as error:
+            self.error = error
+            return None
+
+
+def main(argv):
+    """ingest.py <port> [baud]: prints the ingest rates, e.g. against a pty."""
+    path = argv[1]
+    baud = int(argv[2]) if len(argv) > 2 else 115200
+    try:
+        import serial
+        port = serial.Serial(path, baud, timeout=0)
+    except ImportError:
+        port = os.open(path, os.O_RDONLY | os.O_NONBLOCK | os.O_NOCTTY)
+
+    totals = {'scans': 0, 'values': 0}
+
+    def count(batches, alarms, messages):
+        for batch in batches:
+            totals['scans'] += len(batch)
+            totals['values'] += len(batch) * len(batch.channels)
+        for event in alarms:
+            print(f'alarm ch {event.channel} {event.kind} {"raised" if event.active else "cleared"} {event.value:.2f}')
+        for message in messages:
+            print(message)
+
+    ingest = Ingest(port, count)
+    ingest.start()
+    start = time.monotonic()
+    try:
+        while ingest.is_alive():
+            ingest.join(1.0)
+            elapsed = time.monotonic() - start
+            parser = ingest.parser
+            print(f'{ingest.bytes / elapsed:10.0f} B/s {totals["scans"] / elapsed:8.0f} scans/s '
+                  f'{totals["values"] / elapsed:8.0f} values/s frames {parser.frames} crc {parser.crc_errors} '
+                  f'lost {parser.lost_frames} overflows {ingest.overflows}'
+                  f'{" (native)" if ingest.native else ""}')
+    except KeyboardInterrupt:
+        ingest.stop()
+        ingest.join()
+
+
+if __name__ == '__main__':
+    main(sys.argv)
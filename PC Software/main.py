@@ -1,41 +1,105 @@
 import sys
-import csv
+import math
 import threading
-from collections import defaultdict
 from datetime import datetime
 from PyQt5 import QtWidgets, QtCore
 from PyQt5.QtWidgets import (
     QMainWindow, QWidget, QLabel, QPushButton,
-    QListWidget, QTableWidget, QTableWidgetItem,
-    QFileDialog, QHBoxLayout, QVBoxLayout
+    QListWidget, QTableView, QHeaderView,
+    QFileDialog, QProgressDialog, QHBoxLayout, QVBoxLayout
 )
-from matplotlib.backends.backend_qt5agg import FigureCanvasQTAgg as FigureCanvas
-from matplotlib.figure import Figure
 import serial
 import serial.tools.list_ports
+from ingest import Ingest
+from plot import LivePlot
+from store import SampleStore
+import export
 
 class SerialReader(QtCore.QObject):
-    data_received = QtCore.pyqtSignal(str)
+    # Batches, alarm events and console messages, coalesced by the ingest thread
+    data_received = QtCore.pyqtSignal(object, object, object)
 
     def __init__(self, ser):
         super().__init__()
-        self.ser = ser
-        self._running = True
+        self.ingest = Ingest(ser, self.data_received.emit)
 
     def start(self):
-        threading.Thread(target=self.read_loop, daemon=True).start()
+        self.ingest.start()
 
     def stop(self):
-        self._running = False
+        self.ingest.stop()
 
-    def read_loop(self):
-        while self._running:
-            if self.ser.in_waiting:
-                try:
-                    line = self.ser.readline().decode(errors='ignore').strip()
-                    self.data_received.emit(line)
-                except Exception:
-                    pass
+class ExportWorker(QtCore.QThread):
+    # Rows done and rows in total, then the number of rows written or the error
+    progress = QtCore.pyqtSignal(int, int)
+    done = QtCore.pyqtSignal(object)
+
+    def __init__(self, store, path):
+        super().__init__()
+        self.store = store
+        self.path = path
+        self.cancel = threading.Event()
+
+    def run(self):
+        try:
+            self.done.emit(export.export(self.store, self.path, self.progress.emit, self.cancel))
+        except Exception as e:
+            self.done.emit(e)
+
+class SampleTableModel(QtCore.QAbstractTableModel):
+    # One row per channel of each scan held in the store, cells are formatted when the view asks
+    HEADERS = ["Channel", "Time", "Temp °C", "Temp °F"]
+
+    def __init__(self, store):
+        super().__init__()
+        self.store = store
+        self.rows = 0
+        self.channels = []
+
+    def rowCount(self, parent=QtCore.QModelIndex()):
+        return 0 if parent.isValid() else self.rows
+
+    def columnCount(self, parent=QtCore.QModelIndex()):
+        return 0 if parent.isValid() else len(self.HEADERS)
+
+    def headerData(self, section, orientation, role=QtCore.Qt.DisplayRole):
+        if orientation == QtCore.Qt.Horizontal and role == QtCore.Qt.DisplayRole:
+            return self.HEADERS[section]
+        return super().headerData(section, orientation, role)
+
+    def data(self, index, role=QtCore.Qt.DisplayRole):
+        if role != QtCore.Qt.DisplayRole or not index.isValid():
+            return None
+        scan, slot = divmod(index.row(), len(self.channels))
+        ch = self.channels[slot]
+        column = index.column()
+        if column == 0:
+            return str(ch)
+        if column == 1:
+            return datetime.fromtimestamp(self.store.time_at(scan) / 1e9).strftime("%H:%M:%S")
+        num = self.store.value_at(ch, scan)
+        if math.isnan(num):
+            return ""
+        return f"{num:.2f}" if column == 2 else f"{num * 9/5 + 32:.2f}"
+
+    def refresh(self, evicted):
+        # Rows only leave at the top and arrive at the bottom, so the view keeps its place
+        if self.channels != self.store.channels:
+            self.beginResetModel()
+            self.channels = list(self.store.channels)
+            self.rows = len(self.store) * len(self.channels)
+            self.endResetModel()
+            return
+        removed = min(evicted * len(self.channels), self.rows)
+        if removed:
+            self.beginRemoveRows(QtCore.QModelIndex(), 0, removed - 1)
+            self.rows -= removed
+            self.endRemoveRows()
+        added = len(self.store) * len(self.channels) - self.rows
+        if added > 0:
+            self.beginInsertRows(QtCore.QModelIndex(), self.rows, self.rows + added - 1)
+            self.rows += added
+            self.endInsertRows()
 
 class DataLoggerWindow(QMainWindow):
     def __init__(self):
@@ -46,7 +110,9 @@ class DataLoggerWindow(QMainWindow):
         self.serial = None
         self.reader = None
         self.paused = False
-        self.data_buffers = defaultdict(list)
+        self.store = SampleStore()
+        self.exporter = None
+        self.recorder = None
         self.channels = [0]
 
         # Section A: Serial controls
@@ -67,9 +133,12 @@ class DataLoggerWindow(QMainWindow):
         self.resume_btn = QPushButton("Resume")
         self.resume_btn.clicked.connect(self.resume)
         self.resume_btn.setEnabled(False)
-        self.export_btn = QPushButton("Export CSV")
+        self.export_btn = QPushButton("Export")
         self.export_btn.clicked.connect(self.export_data)
         self.export_btn.setEnabled(False)
+        self.record_btn = QPushButton("Record")
+        self.record_btn.setCheckable(True)
+        self.record_btn.toggled.connect(self.toggle_recording)
 
         # Section C: Channel panel
         ch_label = QLabel("Channels:")
@@ -80,15 +149,15 @@ class DataLoggerWindow(QMainWindow):
         self.add_ch_btn = QPushButton("+")
         self.add_ch_btn.clicked.connect(self.add_channel)
 
-        # Section E: Data table
-        self.table = QTableWidget()
-        self.table.setColumnCount(4)
-        self.table.setHorizontalHeaderLabels(["Channel", "Time", "Temp °C", "Temp °F"])
+        # Section E: Data table, a view of the store
+        self.table_model = SampleTableModel(self.store)
+        self.table = QTableView()
+        self.table.setModel(self.table_model)
+        self.table.verticalHeader().setSectionResizeMode(QHeaderView.Fixed)
+        self.table.horizontalHeader().setSectionResizeMode(QHeaderView.Stretch)
 
-        # Section D: Chart
-        self.figure = Figure()
-        self.canvas = FigureCanvas(self.figure)
-        self.ax = self.figure.add_subplot(111)
+        # Section D: Chart, redrawn by its own timer
+        self.plot = LivePlot()
 
         # Layout A
         secA = QHBoxLayout()
@@ -103,6 +172,7 @@ class DataLoggerWindow(QMainWindow):
         secB.addWidget(self.pause_btn)
         secB.addWidget(self.resume_btn)
         secB.addWidget(self.export_btn)
+        secB.addWidget(self.record_btn)
 
         # Top layout (A and B proportional)
         top_layout = QHBoxLayout()
@@ -121,7 +191,7 @@ class DataLoggerWindow(QMainWindow):
         # Middle layout (left: channel panel, right: chart proportional)
         middle_layout = QHBoxLayout()
         middle_layout.addLayout(ch_panel, 1)
-        middle_layout.addWidget(self.canvas, 4)
+        middle_layout.addWidget(self.plot.canvas, 4)
 
         # Main layout (top and middle proportional)
         main_widget = QWidget()
@@ -146,7 +216,7 @@ class DataLoggerWindow(QMainWindow):
         port = self.port_combo.currentText()
         baud = int(self.baud_combo.currentText())
         try:
-            self.serial = serial.Serial(port, baud, timeout=1)
+            self.serial = serial.Serial(port, baud, timeout=0)
             self.reader = SerialReader(self.serial)
             self.reader.data_received.connect(self.handle_data)
             self.reader.start()
@@ -175,34 +245,23 @@ class DataLoggerWindow(QMainWindow):
         self.pause_btn.setEnabled(True)
         self.resume_btn.setEnabled(False)
 
-    def handle_data(self, line):
+    def handle_data(self, batches, alarms, messages):
+        for text in messages:
+            self.statusBar().showMessage(text)
+        for event in alarms:
+            state = "raised" if event.active else "cleared"
+            self.statusBar().showMessage(f"Alarm channel {event.channel} {event.kind} {state} at {event.value:.2f}")
         if self.paused:
             return
-        parts = line.split(',')
-        timestamp = datetime.now().strftime("%H:%M:%S")
-        for idx, val in enumerate(parts):
-            try:
-                num = float(val)
-                self.data_buffers[idx].append(num)
-                # populate table E
-                row = self.table.rowCount()
-                self.table.insertRow(row)
-                self.table.setItem(row, 0, QTableWidgetItem(str(idx)))
-                self.table.setItem(row, 1, QTableWidgetItem(timestamp))
-                self.table.setItem(row, 2, QTableWidgetItem(f"{num:.2f}"))
-                f_val = num * 9/5 + 32
-                self.table.setItem(row, 3, QTableWidgetItem(f"{f_val:.2f}"))
-            except ValueError:
-                pass
-        self.update_plot()
-
-    def update_plot(self):
-        ch = self.channel_list.currentRow()
-        data = self.data_buffers.get(ch, [])
-        self.ax.clear()
-        self.ax.plot(data)
-        self.ax.set_title(f"Channel {ch}")
-        self.canvas.draw()
+        evicted = 0
+        for batch in batches:
+            evicted += self.store.append(batch)
+            self.plot.add(batch)
+        if batches:
+            self.table_model.refresh(evicted)
+
+    def update_plot(self, ch):
+        self.plot.set_channel(ch)
 
     def add_channel(self):
         new_idx = len(self.channels)
@@ -210,16 +269,61 @@ class DataLoggerWindow(QMainWindow):
         self.channel_list.addItem(f"Channel {new_idx}")
         self.channel_list.setCurrentRow(new_idx)
 
+    def file_filter(self, recording=False):
+        return ";;".join(f"{w.name} Files (*{w.suffix})" for w in export.formats(recording))
+
     def export_data(self):
-        path, _ = QFileDialog.getSaveFileName(self, "Save CSV", filter="CSV Files (*.csv)")
-        if path:
-            with open(path, 'w', newline='') as csvfile:
-                writer = csv.writer(csvfile)
-                headers = [self.table.horizontalHeaderItem(i).text() for i in range(self.table.columnCount())]
-                writer.writerow(headers)
-                for r in range(self.table.rowCount()):
-                    row_data = [self.table.item(r, c).text() for c in range(self.table.columnCount())]
-                    writer.writerow(row_data)
+        path, _ = QFileDialog.getSaveFileName(self, "Export", filter=self.file_filter())
+        if not path or self.exporter:
+            return
+        self.exporter = ExportWorker(self.store, path)
+        dialog = QProgressDialog("Exporting...", "Cancel", 0, 100, self)
+        dialog.setWindowModality(QtCore.Qt.WindowModal)
+        dialog.canceled.connect(self.exporter.cancel.set)
+        self.exporter.progress.connect(lambda done, total: dialog.setValue(done * 100 // max(total, 1)))
+        self.exporter.done.connect(lambda result: self.export_done(result, dialog))
+        self.exporter.start()
+
+    def export_done(self, result, dialog):
+        dialog.reset()
+        self.exporter.wait()
+        self.exporter = None
+        if isinstance(result, Exception):
+            QtWidgets.QMessageBox.critical(self, "Error", str(result))
+        else:
+            self.statusBar().showMessage(f"Exported {result} scans")
+
+    def toggle_recording(self, checked):
+        if checked:
+            path, _ = QFileDialog.getSaveFileName(self, "Record to", filter=self.file_filter(True))
+            if not path:
+                self.record_btn.setChecked(False)
+                return
+            try:
+                self.recorder = export.Recorder(self.store, path)
+            except ValueError as e:
+                QtWidgets.QMessageBox.critical(self, "Error", str(e))
+                self.record_btn.setChecked(False)
+                return
+            self.recorder.start()
+            self.record_btn.setText("Stop recording")
+            self.statusBar().showMessage(f"Recording to {path}, synced every {self.recorder.interval:g} s")
+        elif self.recorder:
+            self.recorder.stop()
+            recorder, self.recorder = self.recorder, None
+            self.record_btn.setText("Record")
+            if recorder.error:
+                QtWidgets.QMessageBox.critical(self, "Error", str(recorder.error))
+            else:
+                self.statusBar().showMessage(f"Recorded {recorder.rows} scans to {', '.join(recorder.files)}")
+
+    def closeEvent(self, event):
+        if self.recorder:
+            self.recorder.stop()
+        if self.exporter:
+            self.exporter.cancel.set()
+            self.exporter.wait()
+        super().closeEvent(event)
 
 if __name__ == '__main__':
     app = QtWidgets.QApplication(sys.argv)
@@ -0,0 +1,476 @@
+/**
+ * @file ingest_core.cpp
+ * @brief Native ingest of the DAQ serial stream.
+ *
+ * Implementation of the ring, parser and reader declared in @ref ingest_core.h.
+ *
+ * @version 1.0
+ * @date 2025-06-20
+ *
+ * @author Kunal Salvi
+ */
+
+#include "ingest_core.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+
+#ifndef _WIN32
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+#endif
+
+namespace daq
+{
+
+static const uint8_t SYNC[2] = {0xAA, 0x55};
+
+/* Bytes of a text line: printable ASCII, tab and carriage return */
+static bool is_text(uint8_t byte)
+{
+	return ((byte >= 0x20) && (byte < 0x7F)) || (byte == '\t') || (byte == '\r');
+}
+
+static bool is_blank(uint8_t byte)
+{
+	return (byte == ' ') || (byte == '\t') || (byte == '\r');
+}
+
+static int64_t now_ns()
+{
+	timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+template<typename T> static T load(const uint8_t *data)
+{
+	T value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+/* Polynomial 0x04C11DB7, most significant bit first */
+struct Crc_Table
+{
+	uint32_t entries[256];
+
+	Crc_Table()
+	{
+		for(uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t crc = i << 24;
+			for(int bit = 0; bit < 8; bit++) crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+			entries[i] = crc;
+		}
+	}
+};
+
+static const Crc_Table crc_table;
+
+uint32_t crc_words(const uint8_t *data, size_t size)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	// The unit takes each little endian word most significant byte first
+	for(size_t i = 0; i + 4 <= size; i += 4)
+	{
+		for(int byte = 3; byte >= 0; byte--)
+		{
+			crc = (crc << 8) ^ crc_table.entries[(crc >> 24) ^ data[i + byte]];
+		}
+	}
+	return crc;
+}
+
+
+RingBuffer::RingBuffer(size_t capacity) : buffer(capacity)
+{
+}
+
+uint8_t *RingBuffer::writable(size_t *size)
+{
+	size_t capacity = buffer.size();
+
+	if(tail == capacity)
+	{
+		if(head == 0)
+		{
+			// Nothing the parser could use, drop the older half
+			head = capacity / 2;
+			overflows++;
+		}
+		size_t pending = tail - head;
+		memmove(buffer.data(), buffer.data() + head, pending);
+		head = 0;
+		tail = pending;
+	}
+	*size = capacity - tail;
+	return buffer.data() + tail;
+}
+
+void RingBuffer::written(size_t count)
+{
+	tail += count;
+}
+
+const uint8_t *RingBuffer::readable(size_t *size) const
+{
+	*size = tail - head;
+	return buffer.data() + head;
+}
+
+void RingBuffer::consume(size_t count)
+{
+	head += count;
+	if(head == tail) head = tail = 0;
+}
+
+
+size_t StreamParser::feed(const uint8_t *data, size_t size)
+{
+	size_t position = 0;
+
+	while(position < size)
+	{
+		if((size - position >= 2) && (data[position] == SYNC[0]) && (data[position + 1] == SYNC[1]))
+		{
+			long used = frame(data + position, size - position);
+			if(used > 0)
+			{
+				position += used;
+				continue;
+			}
+			if(used == 0) break;
+		}
+
+		const uint8_t *newline = (const uint8_t *)memchr(data + position, '\n', size - position);
+		const uint8_t *sync = nullptr;
+		for(const uint8_t *search = data + position + 1; search + 1 < data + size; search++)
+		{
+			search = (const uint8_t *)memchr(search, SYNC[0], data + size - 1 - search);
+			if(search == nullptr) break;
+			if(search[1] == SYNC[1])
+			{
+				sync = search;
+				break;
+			}
+		}
+
+		if((sync != nullptr) && ((newline == nullptr) || (sync < newline)))
+		{
+			// Console output and frames are queued whole, anything before a frame is a line of its own
+			line(data + position, sync - (data + position));
+			position = sync - data;
+		}
+		else if(newline != nullptr)
+		{
+			line(data + position, newline - (data + position));
+			position = newline - data + 1;
+		}
+		else
+		{
+			break;
+		}
+	}
+	return position;
+}
+
+Batch &StreamParser::batch(const std::vector<uint8_t> &channels)
+{
+	if(!batches.empty() && (batches.back().channels == channels)) return batches.back();
+
+	batches.emplace_back();
+	Batch &batch = batches.back();
+	batch.channels = channels;
+	batch.columns.resize(channels.size());
+	return batch;
+}
+
+int64_t StreamParser::wall(int64_t device_time)
+{
+	// Device time runs from reset, anchor it to the host clock once and again after a reset.
+	// Alarm frames overtake queued sample frames, so small steps back are normal.
+	if(!offset || (device_time + RESET_STEP_NS < last_device_time))
+	{
+		offset = now_ns() - device_time;
+		last_device_time = device_time;
+	}
+	if(device_time > last_device_time) last_device_time = device_time;
+	return device_time + *offset;
+}
+
+void StreamParser::line(const uint8_t *data, size_t size)
+{
+	for(size_t i = 0; i < size; i++)
+	{
+		if(!is_text(data[i]))
+		{
+			// Rest of a damaged frame
+			skipped += size + 1;
+			return;
+		}
+	}
+	lines++;
+
+	size_t start = 0, end = size;
+	while((start < end) && is_blank(data[start])) start++;
+	while((end > start) && is_blank(data[end - 1])) end--;
+	if(start == end) return;
+
+	const char *text = (const char *)data + start;
+	const char *text_end = (const char *)data + end;
+	std::vector<double> values;
+
+	for(const char *part = text; ; )
+	{
+		const char *comma = (const char *)memchr(part, ',', text_end - part);
+		const char *part_end = (comma != nullptr) ? comma : text_end;
+		double value;
+
+		// float() of Python: surrounding blanks and a leading plus, never the locale's decimal point
+		while((part < part_end) && is_blank(*part)) part++;
+		while((part_end > part) && is_blank(part_end[-1])) part_end--;
+		if((part < part_end) && (*part == '+') && ((part_end - part) > 1) && (part[1] != '-')) part++;
+
+		std::from_chars_result result = std::from_chars(part, part_end, value);
+		if((part == part_end) || (result.ec != std::errc()) || (result.ptr != part_end))
+		{
+			messages.emplace_back(text, text_end - text);
+			return;
+		}
+		values.push_back(value);
+
+		if(comma == nullptr) break;
+		part = comma + 1;
+	}
+
+	std::vector<uint8_t> channels(values.size());
+	for(size_t ch = 0; ch < channels.size(); ch++) channels[ch] = (uint8_t)ch;
+
+	Batch &target = batch(channels);
+	target.time.push_back(now_ns());
+	for(size_t ch = 0; ch < values.size(); ch++) target.columns[ch].push_back(values[ch]);
+}
+
+long StreamParser::frame(const uint8_t *data, size_t size)
+{
+	if(size < HEADER_SIZE) return 0;
+
+	uint8_t kind = data[2];
+	uint8_t scans = data[3];
+	uint32_t sequence_number = load<uint32_t>(data + 4);
+	int64_t timestamp = (int64_t)load<uint64_t>(data + 8);
+	uint16_t mask = load<uint16_t>(data + 16);
+	uint16_t length = load<uint16_t>(data + 18);
+	uint32_t period = load<uint32_t>(data + 20);
+
+	if((kind < TYPE_CODE) || (kind > TYPE_CHANGES) || (length > MAX_PAYLOAD) || (length & 3)) return -1;
+
+	size_t frame_size = HEADER_SIZE + length + CRC_SIZE;
+	if(size < frame_size) return 0;
+
+	if(crc_words(data, HEADER_SIZE + length) != load<uint32_t>(data + HEADER_SIZE + length))
+	{
+		crc_errors++;
+		return -1;
+	}
+
+	frames++;
+	std::optional<uint32_t> &expected = sequence[(kind == TYPE_ALARM) ? 1 : 0];
+	if(expected && (sequence_number != *expected))
+	{
+		lost_frames += (uint32_t)(sequence_number - *expected);
+		if(kind == TYPE_CHANGES) changes.reset();
+	}
+	expected = sequence_number + 1;
+
+	std::vector<uint8_t> channels;
+	for(uint8_t ch = 0; ch < 16; ch++) if(mask & (1 << ch)) channels.push_back(ch);
+
+	const uint8_t *payload = data + HEADER_SIZE;
+	int64_t time = wall(timestamp);
+
+	if(kind == TYPE_ALARM)
+	{
+		for(uint32_t record = 0; (record < scans) && ((record + 1) * 8 <= length); record++)
+		{
+			const uint8_t *entry = payload + record * 8;
+			alarms.push_back({time, entry[0], entry[1], entry[2], entry[3], load<int32_t>(entry + 4)});
+		}
+	}
+	else if(kind == TYPE_CHANGES)
+	{
+		records(payload, length, scans, channels, time, period);
+	}
+	else if(!channels.empty())
+	{
+		size_t count = channels.size();
+		uint32_t whole = ((size_t)scans * count * 2 <= length) ? scans : (uint32_t)(length / (count * 2));
+		double scale = (kind == TYPE_CENTI_CELSIUS) ? 0.01 : 1.0;
+		Batch &target = batch(channels);
+
+		for(uint32_t scan = 0; scan < whole; scan++) target.time.push_back(time + (int64_t)scan * period);
+		for(size_t index = 0; index < count; index++)
+		{
+			std::vector<double> &column = target.columns[index];
+			for(uint32_t scan = 0; scan < whole; scan++)
+			{
+				const uint8_t *sample = payload + (scan * count + index) * 2;
+				double value = (kind == TYPE_CENTI_CELSIUS) ? load<int16_t>(sample) : load<uint16_t>(sample);
+				column.push_back(value * scale);
+			}
+		}
+	}
+	return (long)frame_size;
+}
+
+/* Unsigned LEB128, false past the end of the payload */
+static bool varint(const uint8_t *data, size_t length, size_t *position, uint64_t *value)
+{
+	*value = 0;
+	for(unsigned shift = 0; *position < length; shift += 7)
+	{
+		uint8_t byte = data[(*position)++];
+		if(shift < 64) *value |= (uint64_t)(byte & 0x7F) << shift;
+		if(byte < 0x80) return true;
+	}
+	return false;
+}
+
+void StreamParser::records(const uint8_t *payload, size_t length, uint32_t count, const std::vector<uint8_t> &channels, int64_t time, uint32_t period)
+{
+	// Change-only records: values are held between records, resynchronised by keyframes
+	size_t position = 0;
+	int64_t record_time = time;
+
+	for(uint32_t record = 0; record < count; record++)
+	{
+		uint64_t head, changed, code;
+
+		if(!varint(payload, length, &position, &head) || !varint(payload, length, &position, &changed)) return;
+
+		bool key = head & 1;
+		if(record > 0) record_time += (int64_t)(head >> 1) * period;
+
+		if(key || !changes || (changes->size() != channels.size()))
+		{
+			if(!key)
+			{
+				// Differences without the values they refer to
+				for(size_t index = 0; index < channels.size(); index++)
+				{
+					if((changed & (1ULL << index)) && !varint(payload, length, &position, &code)) return;
+				}
+				continue;
+			}
+			changes = std::vector<int64_t>(channels.size(), 0);
+		}
+
+		for(size_t index = 0; index < channels.size(); index++)
+		{
+			if(!(changed & (1ULL << index))) continue;
+			if(!varint(payload, length, &position, &code)) return;
+
+			int64_t value = (int64_t)(code >> 1) ^ -(int64_t)(code & 1);
+			(*changes)[index] = key ? value : (*changes)[index] + value;
+		}
+
+		Batch &target = batch(channels);
+		target.time.push_back(record_time);
+		for(size_t index = 0; index < channels.size(); index++) target.columns[index].push_back((*changes)[index] * 0.01);
+	}
+}
+
+
+Reader::Reader(int fd, size_t capacity) : ring(capacity), fd(fd)
+{
+#ifdef __linux__
+	if(fd >= 0)
+	{
+		wait_fd = epoll_create1(EPOLL_CLOEXEC);
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		if((wait_fd >= 0) && (epoll_ctl(wait_fd, EPOLL_CTL_ADD, fd, &event) != 0))
+		{
+			close(wait_fd);
+			wait_fd = -1;
+		}
+	}
+#endif
+}
+
+Reader::~Reader()
+{
+#ifdef __linux__
+	if(wait_fd >= 0) close(wait_fd);
+#endif
+}
+
+long Reader::read(int timeout_ms)
+{
+#ifdef _WIN32
+	errno = ENOSYS;
+	return -2;
+#else
+	if(fd < 0)
+	{
+		errno = EBADF;
+		return -2;
+	}
+
+#ifdef __linux__
+	epoll_event event;
+	int ready = (wait_fd >= 0) ? epoll_wait(wait_fd, &event, 1, timeout_ms) : -1;
+	if(wait_fd < 0) errno = EBADF;
+#else
+	pollfd event = {fd, POLLIN, 0};
+	int ready = poll(&event, 1, timeout_ms);
+#endif
+	if(ready < 0) return (errno == EINTR) ? 0 : -2;
+	if(ready == 0) return 0;
+
+	size_t room;
+	uint8_t *target = ring.writable(&room);
+	ssize_t count = ::read(fd, target, room);
+
+	if(count < 0) return ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) ? 0 : -2;
+	if(count == 0) return -1;
+
+	ring.written((size_t)count);
+	parse();
+	return count;
+#endif
+}
+
+void Reader::feed(const uint8_t *data, size_t size)
+{
+	while(size > 0)
+	{
+		size_t room;
+		uint8_t *target = ring.writable(&room);
+		size_t count = (size < room) ? size : room;
+
+		memcpy(target, data, count);
+		ring.written(count);
+		parse();
+		data += count;
+		size -= count;
+	}
+}
+
+void Reader::parse()
+{
+	size_t size;
+	const uint8_t *data = ring.readable(&size);
+	ring.consume(parser.feed(data, size));
+}
+
+}
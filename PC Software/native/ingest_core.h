@@ -0,0 +1,162 @@
+/**
+ * @file ingest_core.h
+ * @brief Native ingest of the DAQ serial stream.
+ *
+ * The same stream handling as ingest.py, without the interpreter in the loop:
+ * a port is waited on with epoll (poll outside Linux), read straight into a
+ * byte ring and parsed in place. Telemetry frames, CSV sample lines and console
+ * messages are recognised in the same stream and samples are collected in
+ * columnar batches, one int64 time column in ns and one double column per
+ * channel, which the Python module hands out as array.array.
+ *
+ * The parser follows ingest.StreamParser rule for rule, so both produce the
+ * same batches, alarm events, messages and counters for the same bytes.
+ *
+ * @version 1.0
+ * @date 2025-06-20
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef DAQ_INGEST_CORE_H_
+#define DAQ_INGEST_CORE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace daq
+{
+
+constexpr size_t HEADER_SIZE = 24;
+constexpr size_t CRC_SIZE = 4;
+constexpr size_t MAX_PAYLOAD = 4096;
+constexpr int64_t RESET_STEP_NS = 1000000000;
+
+constexpr uint8_t TYPE_CODE = 1;
+constexpr uint8_t TYPE_CENTI_CELSIUS = 2;
+constexpr uint8_t TYPE_ALARM = 3;
+constexpr uint8_t TYPE_CHANGES = 4;
+
+/** @brief STM32 CRC unit over little endian words, crc_words of ingest.py. */
+uint32_t crc_words(const uint8_t *data, size_t size);
+
+/** @brief Scans of one channel set, times in ns since the epoch. */
+struct Batch
+{
+	std::vector<uint8_t> channels;
+	std::vector<int64_t> time;
+	std::vector<std::vector<double>> columns;
+};
+
+/** @brief One alarm record, value in 0.01 °C. */
+struct Alarm
+{
+	int64_t time;
+	uint8_t channel;
+	uint8_t kind;
+	uint8_t active;
+	uint8_t source;
+	int32_t value;
+};
+
+/**
+ * @brief Byte ring that is read into and parsed in place.
+ *
+ * Unparsed bytes are moved to the front when the free space at the end runs
+ * out, so the parser always sees one contiguous block. That copy only covers a
+ * partial frame or line.
+ */
+class RingBuffer
+{
+public:
+	explicit RingBuffer(size_t capacity);
+
+	/** Free space at the end, never empty. */
+	uint8_t *writable(size_t *size);
+	void written(size_t count);
+
+	const uint8_t *readable(size_t *size) const;
+	void consume(size_t count);
+
+	std::atomic<uint64_t> overflows{0};		///< Times the ring was full of bytes the parser could not use
+
+private:
+	std::vector<uint8_t> buffer;
+	size_t head = 0;
+	size_t tail = 0;
+};
+
+/** @brief Splits the byte stream into frames, sample lines and console messages. */
+class StreamParser
+{
+public:
+	/** Parses the complete frames and lines, returns the number of bytes used. */
+	size_t feed(const uint8_t *data, size_t size);
+
+	std::vector<Batch> batches;
+	std::vector<Alarm> alarms;
+	std::vector<std::string> messages;
+
+	/* Counters, atomic so other threads can read them while the parser runs */
+	std::atomic<uint64_t> frames{0};
+	std::atomic<uint64_t> crc_errors{0};
+	std::atomic<uint64_t> lost_frames{0};
+	std::atomic<uint64_t> lines{0};
+	std::atomic<uint64_t> skipped{0};
+
+private:
+	Batch &batch(const std::vector<uint8_t> &channels);
+	int64_t wall(int64_t device_time);
+	void line(const uint8_t *data, size_t size);
+	/** Frame length, 0 when incomplete or -1 when it is no frame. */
+	long frame(const uint8_t *data, size_t size);
+	void records(const uint8_t *payload, size_t length, uint32_t records, const std::vector<uint8_t> &channels, int64_t wall, uint32_t period);
+
+	std::optional<int64_t> offset;
+	int64_t last_device_time = 0;
+	std::optional<uint32_t> sequence[2];		///< Next sequence number of the sample and the alarm stream
+	std::optional<std::vector<int64_t>> changes;
+};
+
+/**
+ * @brief Port, ring and parser.
+ *
+ * `read` sleeps until bytes arrive, reads them into the ring with one call
+ * and parses them. It touches no Python object, the module calls it with the
+ * GIL released.
+ */
+class Reader
+{
+public:
+	Reader(int fd, size_t capacity);
+	~Reader();
+	Reader(const Reader &) = delete;
+	Reader &operator=(const Reader &) = delete;
+
+	/**
+	 * @brief Waits up to `timeout_ms` for bytes and parses them.
+	 *
+	 * @return Bytes read, 0 on timeout, -1 once the port is closed or -2 with `errno` set on an error.
+	 */
+	long read(int timeout_ms);
+
+	/** @brief Parses bytes that did not come from the port. */
+	void feed(const uint8_t *data, size_t size);
+
+	RingBuffer ring;
+	StreamParser parser;
+
+private:
+	void parse();
+
+	int fd;
+	int wait_fd = -1;
+};
+
+}
+
+#endif /* DAQ_INGEST_CORE_H_ */
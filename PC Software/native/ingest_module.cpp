@@ -0,0 +1,316 @@
+/**
+ * @file ingest_module.cpp
+ * @brief Python module `_daq_ingest` around the native ingest core.
+ *
+ * One type, `Reader(fd, capacity, batch_type, alarm_type)`:
+ *
+ * - `read(timeout)` waits up to `timeout` seconds for the port, reads and
+ *   parses with the GIL released and returns the bytes read, 0 on timeout or
+ *   None once the port is closed. Errors raise OSError.
+ * - `feed(data)` parses bytes from elsewhere, e.g. a port without a file
+ *   descriptor.
+ * - `take()` returns and clears (batches, alarm events, messages), built with
+ *   `batch_type(channels)` and `alarm_type(time, channel, kind, active,
+ *   source, value)` so they are the objects ingest.py hands out. The columns
+ *   are copied once into the array.array of each batch.
+ * - `frames`, `crc_errors`, `lost_frames`, `lines`, `skipped` and `overflows`
+ *   count like ingest.StreamParser and ingest.RingBuffer.
+ *
+ * Only the C API of CPython is used, so the module builds with a compiler and
+ * the Python headers alone, see setup.py.
+ *
+ * @version 1.0
+ * @date 2025-06-20
+ *
+ * @author Kunal Salvi
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <cerrno>
+#include <cmath>
+#include <new>
+
+#include "ingest_core.h"
+
+typedef struct
+{
+	PyObject_HEAD
+	daq::Reader *reader;
+	PyObject *batch_type;
+	PyObject *alarm_type;
+	bool busy;					/* read() runs without the GIL, the other methods must wait */
+}ReaderObject;
+
+static int reader_init(ReaderObject *self, PyObject *args, PyObject *kwargs)
+{
+	static const char *keywords[] = {"fd", "capacity", "batch_type", "alarm_type", nullptr};
+	int fd;
+	Py_ssize_t capacity;
+	PyObject *batch_type, *alarm_type;
+
+	if(!PyArg_ParseTupleAndKeywords(args, kwargs, "inOO", (char **)keywords, &fd, &capacity, &batch_type, &alarm_type)) return -1;
+	if(capacity < 64)
+	{
+		PyErr_SetString(PyExc_ValueError, "capacity below 64 bytes");
+		return -1;
+	}
+
+	delete self->reader;
+	self->reader = new(std::nothrow) daq::Reader(fd, (size_t)capacity);
+	if(self->reader == nullptr)
+	{
+		PyErr_NoMemory();
+		return -1;
+	}
+
+	Py_INCREF(batch_type);
+	Py_XSETREF(self->batch_type, batch_type);
+	Py_INCREF(alarm_type);
+	Py_XSETREF(self->alarm_type, alarm_type);
+	self->busy = false;
+	return 0;
+}
+
+static void reader_dealloc(ReaderObject *self)
+{
+	PyTypeObject *type = Py_TYPE(self);
+
+	delete self->reader;
+	Py_XDECREF(self->batch_type);
+	Py_XDECREF(self->alarm_type);
+	type->tp_free((PyObject *)self);
+	Py_DECREF(type);
+}
+
+static bool reader_ready(ReaderObject *self)
+{
+	if(self->reader == nullptr)
+	{
+		PyErr_SetString(PyExc_ValueError, "Reader not initialised");
+		return false;
+	}
+	if(self->busy)
+	{
+		PyErr_SetString(PyExc_RuntimeError, "Reader used from two threads");
+		return false;
+	}
+	return true;
+}
+
+static PyObject *reader_read(ReaderObject *self, PyObject *args)
+{
+	double timeout;
+
+	if(!PyArg_ParseTuple(args, "d", &timeout) || !reader_ready(self)) return nullptr;
+
+	int timeout_ms = (timeout <= 0.0) ? 0 : (timeout > 3600.0) ? 3600000 : (int)std::ceil(timeout * 1000.0);
+	long count;
+
+	self->busy = true;
+	Py_BEGIN_ALLOW_THREADS
+	count = self->reader->read(timeout_ms);
+	Py_END_ALLOW_THREADS
+	self->busy = false;
+
+	if(count == -2) return PyErr_SetFromErrno(PyExc_OSError);
+	if(count == -1) Py_RETURN_NONE;
+	return PyLong_FromLong(count);
+}
+
+static PyObject *reader_feed(ReaderObject *self, PyObject *args)
+{
+	Py_buffer data;
+
+	if(!PyArg_ParseTuple(args, "y*", &data)) return nullptr;
+	if(!reader_ready(self))
+	{
+		PyBuffer_Release(&data);
+		return nullptr;
+	}
+
+	self->reader->feed((const uint8_t *)data.buf, (size_t)data.len);
+	PyBuffer_Release(&data);
+	Py_RETURN_NONE;
+}
+
+/* array.frombytes of a vector, the one copy of the samples on their way out */
+static bool extend_array(PyObject *array, const void *data, size_t size)
+{
+	PyObject *view = PyMemoryView_FromMemory((char *)data, (Py_ssize_t)size, PyBUF_READ);
+	if(view == nullptr) return false;
+
+	PyObject *result = PyObject_CallMethod(array, "frombytes", "O", view);
+	Py_DECREF(view);
+	Py_XDECREF(result);
+	return result != nullptr;
+}
+
+static PyObject *make_batch(ReaderObject *self, const daq::Batch &batch)
+{
+	PyObject *channels = PyTuple_New((Py_ssize_t)batch.channels.size());
+	if(channels == nullptr) return nullptr;
+	for(size_t i = 0; i < batch.channels.size(); i++) PyTuple_SET_ITEM(channels, i, PyLong_FromLong(batch.channels[i]));
+
+	PyObject *object = PyObject_CallFunctionObjArgs(self->batch_type, channels, nullptr);
+	Py_DECREF(channels);
+	if(object == nullptr) return nullptr;
+
+	PyObject *time = PyObject_GetAttrString(object, "time");
+	PyObject *columns = PyObject_GetAttrString(object, "columns");
+	bool ok = (time != nullptr) && (columns != nullptr) && extend_array(time, batch.time.data(), batch.time.size() * sizeof(int64_t));
+
+	for(size_t i = 0; ok && (i < batch.columns.size()); i++)
+	{
+		PyObject *column = PySequence_GetItem(columns, (Py_ssize_t)i);
+		ok = (column != nullptr) && extend_array(column, batch.columns[i].data(), batch.columns[i].size() * sizeof(double));
+		Py_XDECREF(column);
+	}
+
+	Py_XDECREF(time);
+	Py_XDECREF(columns);
+	if(!ok)
+	{
+		Py_DECREF(object);
+		return nullptr;
+	}
+	return object;
+}
+
+static PyObject *make_alarm(ReaderObject *self, const daq::Alarm &alarm)
+{
+	const char *kind = (alarm.kind == 1) ? "high" : (alarm.kind == 2) ? "low" : (alarm.kind == 4) ? "rise" : nullptr;
+	PyObject *name = (kind != nullptr) ? PyUnicode_FromString(kind) : PyUnicode_FromFormat("%d", alarm.kind);
+	if(name == nullptr) return nullptr;
+
+	PyObject *object = PyObject_CallFunction(self->alarm_type, "LiOOid", (long long)alarm.time, alarm.channel, name,
+			alarm.active ? Py_True : Py_False, alarm.source, alarm.value / 100.0);
+	Py_DECREF(name);
+	return object;
+}
+
+static PyObject *reader_take(ReaderObject *self, PyObject *Py_UNUSED(ignored))
+{
+	if(!reader_ready(self)) return nullptr;
+
+	daq::StreamParser &parser = self->reader->parser;
+	PyObject *batches = PyList_New(0);
+	PyObject *alarms = PyList_New(0);
+	PyObject *messages = PyList_New(0);
+	bool ok = (batches != nullptr) && (alarms != nullptr) && (messages != nullptr);
+
+	for(size_t i = 0; ok && (i < parser.batches.size()); i++)
+	{
+		PyObject *item = make_batch(self, parser.batches[i]);
+		ok = (item != nullptr) && (PyList_Append(batches, item) == 0);
+		Py_XDECREF(item);
+	}
+	for(size_t i = 0; ok && (i < parser.alarms.size()); i++)
+	{
+		PyObject *item = make_alarm(self, parser.alarms[i]);
+		ok = (item != nullptr) && (PyList_Append(alarms, item) == 0);
+		Py_XDECREF(item);
+	}
+	for(size_t i = 0; ok && (i < parser.messages.size()); i++)
+	{
+		PyObject *item = PyUnicode_DecodeASCII(parser.messages[i].data(), (Py_ssize_t)parser.messages[i].size(), "replace");
+		ok = (item != nullptr) && (PyList_Append(messages, item) == 0);
+		Py_XDECREF(item);
+	}
+
+	parser.batches.clear();
+	parser.alarms.clear();
+	parser.messages.clear();
+
+	if(!ok)
+	{
+		Py_XDECREF(batches);
+		Py_XDECREF(alarms);
+		Py_XDECREF(messages);
+		return nullptr;
+	}
+	return Py_BuildValue("(NNN)", batches, alarms, messages);
+}
+
+/* Read from any thread, also while read() runs */
+#define READER_COUNTER(name, field)														\
+	static PyObject *reader_get_##name(ReaderObject *self, void *Py_UNUSED(closure))	\
+	{																					\
+		if(self->reader == nullptr) return PyLong_FromLong(0);							\
+		return PyLong_FromUnsignedLongLong(self->reader->field.load(std::memory_order_relaxed));						\
+	}
+
+READER_COUNTER(frames, parser.frames)
+READER_COUNTER(crc_errors, parser.crc_errors)
+READER_COUNTER(lost_frames, parser.lost_frames)
+READER_COUNTER(lines, parser.lines)
+READER_COUNTER(skipped, parser.skipped)
+READER_COUNTER(overflows, ring.overflows)
+
+static PyGetSetDef reader_getset[] =
+{
+	{"frames", (getter)reader_get_frames, nullptr, "Frames with a valid CRC", nullptr},
+	{"crc_errors", (getter)reader_get_crc_errors, nullptr, "Frames dropped for their CRC", nullptr},
+	{"lost_frames", (getter)reader_get_lost_frames, nullptr, "Gaps in the sequence numbers", nullptr},
+	{"lines", (getter)reader_get_lines, nullptr, "Text lines", nullptr},
+	{"skipped", (getter)reader_get_skipped, nullptr, "Bytes of damaged frames", nullptr},
+	{"overflows", (getter)reader_get_overflows, nullptr, "Times the ring dropped its older half", nullptr},
+	{nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+static PyMethodDef reader_methods[] =
+{
+	{"read", (PyCFunction)reader_read, METH_VARARGS, "read(timeout) -> bytes read, 0 on timeout, None once the port is closed"},
+	{"feed", (PyCFunction)reader_feed, METH_VARARGS, "feed(data): parses bytes that did not come from the port"},
+	{"take", (PyCFunction)reader_take, METH_NOARGS, "take() -> (batches, alarms, messages) parsed so far"},
+	{nullptr, nullptr, 0, nullptr},
+};
+
+static PyType_Slot reader_slots[] =
+{
+	{Py_tp_dealloc, (void *)reader_dealloc},
+	{Py_tp_doc, (void *)"Reader(fd, capacity, batch_type, alarm_type): port, ring and parser"},
+	{Py_tp_methods, reader_methods},
+	{Py_tp_getset, reader_getset},
+	{Py_tp_init, (void *)reader_init},
+	{Py_tp_new, (void *)PyType_GenericNew},
+	{0, nullptr},
+};
+
+static PyType_Spec reader_spec =
+{
+	"_daq_ingest.Reader",
+	sizeof(ReaderObject),
+	0,
+	Py_TPFLAGS_DEFAULT,
+	reader_slots,
+};
+
+static PyModuleDef module =
+{
+	PyModuleDef_HEAD_INIT,
+	"_daq_ingest",
+	"Native ingest of the DAQ serial stream, used by ingest.py when built.",
+	-1,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+	nullptr,
+};
+
+PyMODINIT_FUNC PyInit__daq_ingest(void)
+{
+	PyObject *object = PyModule_Create(&module);
+	if(object == nullptr) return nullptr;
+
+	PyObject *type = PyType_FromSpec(&reader_spec);
+	if((type == nullptr) || (PyModule_AddObject(object, "Reader", type) < 0))
+	{
+		Py_XDECREF(type);
+		Py_DECREF(object);
+		return nullptr;
+	}
+	return object;
+}
@@ -0,0 +1,160 @@
+"""Live chart of one channel at a constant cost per redraw.
+
+Arriving samples only go into a min/max pyramid per channel. A timer redraws
+at a fixed rate, and only when something arrived. The line is updated in
+place and blitted over a cached background. The axes are redrawn only when
+the data leaves the current limits, which grow with headroom.
+
+The pyramid holds the envelope of the series at every power of two bucket
+size. A redraw takes the finest level with at most `points` buckets, so it
+draws the same number of vertices after a minute or after a week. Finer
+levels than that are never needed again for the whole-history view and are
+dropped as the series grows, also for the channels not on screen, so every
+series stays at about 2 * `points` buckets.
+"""
+
+from array import array
+
+from PyQt5 import QtCore
+from matplotlib.backends.backend_qt5agg import FigureCanvasQTAgg as FigureCanvas
+from matplotlib.figure import Figure
+
+RENDER_FPS = 20
+ENVELOPE_POINTS = 2048
+
+
+class MinMaxPyramid:
+    """Min/max envelope of one series at bucket sizes 1, 2, 4, ..."""
+
+    def __init__(self, points=ENVELOPE_POINTS):
+        self.points = points
+        self.count = 0
+        self.floor = 0          # Levels below are no longer stored
+        self.levels = []        # (start times, lows, highs) per level
+        self.pending = []       # First half of the next bucket one level up
+
+    def extend(self, times, values):
+        for t, value in zip(times, values):
+            self._push(0, t, value, value)
+        self.count += len(values)
+        self._trim()
+
+    def _trim(self):
+        # The finest level with at most `points` buckets becomes the floor, finer ones are dropped
+        level = self.floor
+        while level + 1 < len(self.levels) and len(self.levels[level][0]) > self.points:
+            level += 1
+        for finer in range(self.floor, level):
+            self.levels[finer] = (array('d'), array('d'), array('d'))
+        self.floor = level
+
+    def _push(self, level, t, low, high):
+        while True:
+            if level == len(self.levels):
+                self.levels.append((array('d'), array('d'), array('d')))
+                self.pending.append(None)
+            if level >= self.floor:
+                times, lows, highs = self.levels[level]
+                times.append(t)
+                lows.append(low)
+                highs.append(high)
+            first = self.pending[level]
+            if first is None:
+                self.pending[level] = (t, low, high)
+                return
+            self.pending[level] = None
+            t, low, high = first[0], min(first[1], low), max(first[2], high)
+            level += 1
+
+    def envelope(self):
+        """Returns (start times, lows, highs) of at most `points` + 1 buckets covering every sample."""
+        level = self.floor
+        times, lows, highs = (array('d', column) for column in self.levels[level])
+        # Samples not yet in a bucket of this level wait in the finer pending halves, oldest highest up
+        tail = [bucket for bucket in reversed(self.pending[:level]) if bucket is not None]
+        if tail:
+            times.append(tail[0][0])
+            lows.append(min(bucket[1] for bucket in tail))
+            highs.append(max(bucket[2] for bucket in tail))
+        return times, lows, highs
+
+
+class LivePlot:
+    """Canvas with one blitted line, fed with ingest batches."""
+
+    def __init__(self, fps=RENDER_FPS):
+        self.figure = Figure()
+        self.canvas = FigureCanvas(self.figure)
+        self.ax = self.figure.add_subplot(111)
+        self.ax.set_xlabel("Time (s)")
+        self.line, = self.ax.plot([], [], linewidth=1, animated=True)
+        self.series = {}
+        self.channel = 0
+        self.start = None
+        self.background = None
+        self.dirty = False
+        self.rescale = True
+        self.canvas.mpl_connect('draw_event', self._on_draw)
+        self.timer = QtCore.QTimer()
+        self.timer.timeout.connect(self.render)
+        self.timer.start(int(1000 / fps))
+
+    def add(self, batch):
+        if not len(batch):
+            return
+        if self.start is None:
+            self.start = batch.time[0]
+        for ch, column in zip(batch.channels, batch.columns):
+            self.series.setdefault(ch, MinMaxPyramid()).extend(batch.time, column)
+            self.dirty |= ch == self.channel
+
+    def set_channel(self, ch):
+        self.channel = ch
+        self.rescale = True
+        self.dirty = True
+
+    def render(self):
+        if not self.dirty:
+            return
+        self.dirty = False
+
+        series = self.series.get(self.channel)
+        if series is None or series.count == 0:
+            x, y = [], []
+        else:
+            times, lows, highs = series.envelope()
+            # Each bucket becomes a vertical stroke from its minimum to its maximum
+            x = array('d', bytes(16 * len(times)))
+            y = array('d', bytes(16 * len(times)))
+            seconds = array('d', ((t - self.start) / 1e9 for t in times))
+            x[0::2] = seconds
+            x[1::2] = seconds
+            y[0::2] = lows
+            y[1::2] = highs
+            self._limits(seconds[-1], min(lows), max(highs))
+        self.line.set_data(x, y)
+
+        if self.rescale or self.background is None:
+            self.rescale = False
+            self.ax.set_title(f"Channel {self.channel}")
+            self.canvas.draw()
+        else:
+            self.canvas.restore_region(self.background)
+            self.ax.draw_artist(self.line)
+            self.canvas.blit(self.ax.bbox)
+
+    def _limits(self, right, low, high):
+        left, limit = self.ax.get_xlim()
+        bottom, top = self.ax.get_ylim()
+        if self.rescale or right > limit:
+            self.ax.set_xlim(0, right * 1.25 + 1)
+            self.rescale = True
+        if self.rescale or low < bottom or high > top:
+            margin = max(0.5, (high - low) * 0.1)
+            self.ax.set_ylim(low - margin, high + margin)
+            self.rescale = True
+
+    def _on_draw(self, event):
+        # A full draw, also after a resize, leaves the axes without the animated line
+        self.background = self.canvas.copy_from_bbox(self.ax.bbox)
+        self.ax.draw_artist(self.line)
@@ -0,0 +1,21 @@
+"""Builds the native ingest core, `python setup.py build_ext --inplace`.
+
+ingest.py uses the module when it is importable and falls back to its own
+parser otherwise, so the GUI runs either way.
+"""
+
+from setuptools import Extension, setup
+
+setup(
+    name='daq-ingest',
+    version='1.0',
+    ext_modules=[
+        Extension(
+            '_daq_ingest',
+            sources=['native/ingest_core.cpp', 'native/ingest_module.cpp'],
+            include_dirs=['native'],
+            language='c++',
+            extra_compile_args=['-std=c++17', '-O2', '-Wall', '-Wextra'],
+        ),
+    ],
+)
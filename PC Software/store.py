@@ -0,0 +1,103 @@
+"""Bounded columnar store of received samples.
+
+A row is one scan: an int64 time in ns since the epoch and one float32 per
+channel, NaN where the scan did not carry that channel. Every column is
+preallocated as a ring of `capacity` rows, so memory is fixed from the first
+sample of a channel on. When the ring is full the oldest rows are handed to
+`spill`, if given, before they are overwritten.
+
+Rows are addressed by absolute index, counted from the first row ever
+appended. `first` and `total` give the range still held, so a reader on
+another thread can tell which rows it missed.
+"""
+
+import math
+import threading
+from array import array
+
+STORE_ROWS = 1000000
+
+
+class SampleStore:
+
+    def __init__(self, capacity=STORE_ROWS, spill=None):
+        self.capacity = capacity
+        self.spill = spill      # Called with (times, {channel: values}) of rows about to be overwritten
+        self.times = array('q', bytes(8 * capacity))
+        self.columns = {}
+        self.channels = []
+        self.head = 0           # Ring position of the next row
+        self.count = 0
+        self.total = 0
+        self.lock = threading.Lock()
+
+    def __len__(self):
+        return self.count
+
+    @property
+    def first(self):
+        return self.total - self.count
+
+    def _column(self, ch):
+        column = self.columns.get(ch)
+        if column is None:
+            column = array('f', [math.nan]) * self.capacity
+            self.columns[ch] = column
+            self.channels = sorted(self.columns)
+        return column
+
+    def append(self, batch):
+        """Adds the scans of an ingest batch. Returns the number of rows evicted."""
+        rows = len(batch)
+        evicted = 0
+        with self.lock:
+            given = [(self._column(ch), values) for ch, values in zip(batch.channels, batch.columns)]
+            absent = [column for ch, column in self.columns.items() if ch not in batch.channels]
+            done = 0
+            while done < rows:
+                start = self.head
+                n = min(rows - done, self.capacity - start)
+                end = start + n
+                # The ring only wraps once it is full, so the rows overwritten are exactly start..end
+                lost = max(0, self.count + n - self.capacity)
+                if lost and self.spill:
+                    self.spill(self.times[start:end], {ch: column[start:end] for ch, column in self.columns.items()})
+                self.times[start:end] = batch.time[done:done + n]
+                for column, values in given:
+                    column[start:end] = array('f', values[done:done + n])
+                for column in absent:
+                    column[start:end] = array('f', [math.nan]) * n
+                self.head = end % self.capacity
+                self.count += n - lost
+                self.total += n
+                evicted += lost
+                done += n
+        return evicted
+
+    def time_at(self, row):
+        """Time of the row `row` places after the oldest one held."""
+        return self.times[(self.head - self.count + row) % self.capacity]
+
+    def value_at(self, ch, row):
+        return self.columns[ch][(self.head - self.count + row) % self.capacity]
+
+    def read(self, start, stop):
+        """Copies absolute rows start..stop, clipped to what is still held.
+
+        Returns (first row, times, {channel: values}), safe to call from any thread.
+        """
+        with self.lock:
+            start = max(start, self.first)
+            stop = min(stop, self.total)
+            times = array('q')
+            values = {ch: array('f') for ch in self.channels}
+            if start < stop:
+                ring = (self.head - (self.total - start)) % self.capacity
+                while start < stop:
+                    n = min(stop - start, self.capacity - ring)
+                    times.extend(self.times[ring:ring + n])
+                    for ch, column in self.columns.items():
+                        values[ch].extend(column[ring:ring + n])
+                    ring = 0
+                    start += n
+            return stop - len(times), times, values
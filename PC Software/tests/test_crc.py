@@ -0,0 +1,64 @@
+"""Host CRC modes of ingest.py against zlib and bitwise references.
+
+Run from PC Software with `python -m unittest discover tests`.
+"""
+
+import os
+import random
+import struct
+import sys
+import unittest
+import zlib
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+
+import ingest
+
+
+def reference_mpeg2(data):
+    crc = 0xFFFFFFFF
+    for byte in data:
+        crc ^= byte << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x04C11DB7 if crc & 0x80000000 else crc << 1) & 0xFFFFFFFF
+    return crc
+
+
+def reference_words(data):
+    crc = 0xFFFFFFFF
+    for word, in struct.iter_unpack('<I', data):
+        crc ^= word
+        for _ in range(32):
+            crc = ((crc << 1) ^ 0x04C11DB7 if crc & 0x80000000 else crc << 1) & 0xFFFFFFFF
+    return crc
+
+
+class CrcTest(unittest.TestCase):
+
+    def setUp(self):
+        rng = random.Random(1)
+        self.data = bytes(rng.randrange(256) for _ in range(1024))
+
+    def test_check_values(self):
+        self.assertEqual(ingest.crc32(b'123456789'), 0xCBF43926)
+        self.assertEqual(ingest.crc_mpeg2(b'123456789'), 0x0376E6E7)
+
+    def test_crc32_matches_zlib(self):
+        for length in range(300):
+            data = self.data[length % 4:length % 4 + length]
+            self.assertEqual(ingest.crc(ingest.CRC_MODE_CRC32, data), zlib.crc32(data))
+
+    def test_mpeg2(self):
+        for length in range(100):
+            data = self.data[:length]
+            self.assertEqual(ingest.crc(ingest.CRC_MODE_MPEG2, data), reference_mpeg2(data))
+
+    def test_words(self):
+        for length in range(0, 256, 4):
+            data = self.data[:length]
+            self.assertEqual(ingest.crc(ingest.CRC_MODE_WORDS, data), reference_words(data))
+        self.assertEqual(ingest.crc_words(memoryview(self.data)[:64]), reference_words(self.data[:64]))
+
+
+if __name__ == '__main__':
+    unittest.main()
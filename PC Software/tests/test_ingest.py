@@ -0,0 +1,202 @@
+"""Ingest of a simulated board on a pseudo terminal, native and Python paths.
+
+The board side writes 15 channels at 1 kHz as CENTI frames mixed with a
+console message, a damaged frame, a gap of two sequence numbers, an alarm
+frame, a CHANGES frame and a CSV line into the master of a pty; Ingest reads
+the slave like a serial port. Both parsers also have to agree exactly on the
+same bytes fed in random pieces.
+
+Run from PC Software with `python -m unittest discover tests`. The native
+cases are skipped unless `python setup.py build_ext --inplace` was run.
+"""
+
+import math
+import os
+import random
+import struct
+import sys
+import threading
+import time
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+
+import ingest
+
+try:
+    import pty
+    import tty
+except ImportError:
+    pty = None
+
+CHANNELS = 15
+RATE = 1000
+SCANS = 5
+SECONDS = 2
+PERIOD = 1000000000 // RATE
+
+
+def frame(kind, scans, sequence, device_time, mask, payload, period):
+    payload += b'\0' * (-len(payload) % 4)
+    body = ingest.HEADER.pack(ingest.SYNC, kind, scans, sequence, device_time, mask, len(payload), period) + payload
+    return body + struct.pack('<I', ingest.crc_words(body))
+
+
+def varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def zigzag(value):
+    return ((value << 1) ^ (value >> 31)) & 0xFFFFFFFF
+
+
+def centi(channel, scan):
+    return round(2000 + 100 * channel + 500 * math.sin(scan / 200.0))
+
+
+def stream():
+    """The simulated board, as a list of writes."""
+    writes = [b'Thermistor table: max error 0.01 C\r\n']
+    sequence = 0
+    for scan in range(0, RATE * SECONDS, SCANS):
+        payload = b''.join(struct.pack('<h', centi(channel, scan + i)) for i in range(SCANS) for channel in range(CHANNELS))
+        data = frame(ingest.TYPE_CENTI_CELSIUS, SCANS, sequence, 10 ** 9 + scan * PERIOD, (1 << CHANNELS) - 1, payload, PERIOD)
+        sequence += 1
+        if scan == 500:
+            data = data[:30] + bytes([data[30] ^ 1]) + data[31:]
+        if scan == 1000:
+            sequence += 2
+        writes.append(data)
+    writes.append(frame(ingest.TYPE_ALARM, 1, 0, 2 * 10 ** 9, 1, struct.pack('<BBBBi', 0, 1, 1, 1, 8123), 0))
+    # Keyframe of three channels, then one changed channel 3 periods on and two 1 period on
+    records = varint(1) + varint(7) + b''.join(varint(zigzag(v)) for v in (2000, 2100, -500)) \
+        + varint(3 << 1) + varint(2) + varint(zigzag(-7)) \
+        + varint(1 << 1) + varint(5) + varint(zigzag(3)) + varint(zigzag(1))
+    writes.append(frame(ingest.TYPE_CHANGES, 3, sequence, 3 * 10 ** 9, 7, records, PERIOD))
+    writes.append(b'20.50, 21.25, 19.00 \r\nAlarm ch 1 high raised 8100\r\n')
+    return writes
+
+
+def collect(batches, alarms, messages, result):
+    result['batches'] += batches
+    result['alarms'] += alarms
+    result['messages'] += messages
+
+
+def relative(batch):
+    return [round((t - batch.time[0]) / PERIOD) for t in batch.time]
+
+
+@unittest.skipIf(pty is None, 'no pseudo terminals')
+class PtyTest(unittest.TestCase):
+
+    def run_ingest(self, native):
+        master, slave = pty.openpty()
+        tty.setraw(slave)
+        result = {'batches': [], 'alarms': [], 'messages': []}
+        reader = ingest.Ingest(slave, lambda *args: collect(*args, result), native=native)
+        self.assertEqual(reader.native, native)
+        reader.start()
+
+        def board():
+            for i, data in enumerate(stream()):
+                os.write(master, data)
+                if i % 20 == 0:
+                    time.sleep(0.002)
+
+        writer = threading.Thread(target=board)
+        writer.start()
+        writer.join()
+        deadline = time.monotonic() + 5
+        while reader.parser.lines < 2 and time.monotonic() < deadline:
+            time.sleep(0.01)
+        reader.stop()
+        reader.join()
+        os.close(master)
+        os.close(slave)
+        return reader, result
+
+    def check(self, native):
+        reader, result = self.run_ingest(native)
+        parser = reader.parser
+
+        full = [b for b in result['batches'] if len(b.channels) == CHANNELS]
+        scans = sum(len(b) for b in full)
+        self.assertEqual(scans, RATE * SECONDS - SCANS)
+        self.assertEqual(parser.crc_errors, 1)
+        # The damaged frame and the gap of two
+        self.assertEqual(parser.lost_frames, 3)
+        self.assertEqual(reader.overflows, 0)
+        self.assertIsNone(reader.error)
+
+        first = full[0]
+        for channel in (0, 7, 14):
+            self.assertEqual(first.columns[channel][3], centi(channel, 3) / 100)
+
+        self.assertEqual(len(result['alarms']), 1)
+        alarm = result['alarms'][0]
+        self.assertEqual((alarm.channel, alarm.kind, alarm.active, alarm.source, alarm.value), (0, 'high', True, 1, 81.23))
+
+        self.assertIn('Thermistor table: max error 0.01 C', result['messages'])
+        self.assertIn('Alarm ch 1 high raised 8100', result['messages'])
+
+        # The CSV line has the channels of the CHANGES frame and joins its batch
+        changes = [b for b in result['batches'] if b.channels == (0, 1, 2)]
+        self.assertEqual(len(changes), 1)
+        self.assertEqual(relative(changes[0])[:3], [0, 3, 4])
+        self.assertEqual([list(c) for c in changes[0].columns],
+                         [[20.0, 20.0, 20.03, 20.5], [21.0, 20.93, 20.93, 21.25], [-5.0, -5.0, -4.99, 19.0]])
+
+    def test_python(self):
+        self.check(False)
+
+    @unittest.skipIf(ingest._daq_ingest is None, 'native core not built')
+    def test_native(self):
+        self.check(True)
+
+
+@unittest.skipIf(ingest._daq_ingest is None, 'native core not built')
+class ParityTest(unittest.TestCase):
+
+    def test_pieces(self):
+        data = b''.join(stream())
+        rng = random.Random(7)
+        # Damage on top: a short frame, garbage and a payload shorter than its scan count
+        data += b'\xaa\x55\x02' + bytes(rng.randrange(256) for _ in range(300)) + b'\n'
+        data += frame(ingest.TYPE_CENTI_CELSIUS, 200, 999, 4 * 10 ** 9, 3, bytes(8), PERIOD)
+
+        native = ingest._daq_ingest.Reader(-1, 1 << 16, ingest.Batch, ingest.AlarmEvent)
+        python = ingest.StreamParser()
+        buffer = bytearray()
+        position = 0
+        while position < len(data):
+            piece = data[position:position + rng.randrange(1, 700)]
+            position += len(piece)
+            native.feed(piece)
+            buffer += piece
+            used = python.feed(buffer)
+            del buffer[:used]
+
+        native_batches, native_alarms, native_messages = native.take()
+        python_batches, python_alarms, python_messages = python.take()
+
+        self.assertEqual(len(native_batches), len(python_batches))
+        for a, b in zip(native_batches, python_batches):
+            self.assertEqual(a.channels, b.channels)
+            # Text lines are stamped on arrival and the parsers run a few ms apart
+            self.assertLessEqual(max(abs(x - y) for x, y in zip(relative(a), relative(b))), 10)
+            self.assertEqual(len(a), len(b))
+            self.assertEqual(a.columns, b.columns)
+        self.assertEqual([a[1:] for a in native_alarms], [a[1:] for a in python_alarms])
+        self.assertEqual(native_messages, python_messages)
+        for counter in ('frames', 'crc_errors', 'lost_frames', 'lines', 'skipped'):
+            self.assertEqual(getattr(native, counter), getattr(python, counter), counter)
+
+
+if __name__ == '__main__':
+    unittest.main()
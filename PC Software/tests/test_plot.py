@@ -0,0 +1,69 @@
+"""Min/max pyramid of plot.py against a brute force envelope.
+
+Every series drops its finer levels while it grows, whether it is drawn or
+not, and the envelope of the level left covers every sample exactly.
+
+Run from PC Software with `python -m unittest discover tests`. Qt and
+matplotlib are only needed by LivePlot and are stubbed when missing.
+"""
+
+import os
+import random
+import sys
+import types
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+
+for name in ('PyQt5', 'matplotlib', 'matplotlib.backends', 'matplotlib.backends.backend_qt5agg', 'matplotlib.figure'):
+    try:
+        __import__(name)
+    except ImportError:
+        stub = sys.modules.setdefault(name, types.ModuleType(name))
+        stub.QtCore = stub.FigureCanvasQTAgg = stub.Figure = None
+
+import plot
+
+
+def reference(times, values, size):
+    """Buckets of `size` samples, the last one partial."""
+    return ([times[i] for i in range(0, len(values), size)],
+            [min(values[i:i + size]) for i in range(0, len(values), size)],
+            [max(values[i:i + size]) for i in range(0, len(values), size)])
+
+
+class PyramidTest(unittest.TestCase):
+
+    def test_envelope(self):
+        rng = random.Random(3)
+        pyramid = plot.MinMaxPyramid(points=64)
+        times, values = [], []
+        while len(values) < 20000:
+            count = rng.randrange(1, 300)
+            batch_times = [float(len(times) + i) for i in range(count)]
+            batch_values = [rng.uniform(-100, 100) for _ in range(count)]
+            pyramid.extend(batch_times, batch_values)
+            times += batch_times
+            values += batch_values
+
+            size = 1 << pyramid.floor
+            expected = reference(times, values, size)
+            envelope = pyramid.envelope()
+            self.assertLessEqual(len(envelope[0]), 64 + 1)
+            self.assertEqual([list(column) for column in envelope], [list(column) for column in expected])
+
+    def test_hidden_series_trimmed(self):
+        pyramid = plot.MinMaxPyramid(points=100)
+        for start in range(0, 100000, 50):
+            pyramid.extend(range(start, start + 50), [float(v % 37) for v in range(start, start + 50)])
+
+        # Never drawn, still at the level a redraw would use
+        stored = sum(len(level[0]) for level in pyramid.levels)
+        self.assertEqual(pyramid.count, 100000)
+        self.assertLessEqual(len(pyramid.levels[pyramid.floor][0]), 100)
+        self.assertLessEqual(stored, 2 * 100)
+        self.assertTrue(all(len(level[0]) == 0 for level in pyramid.levels[:pyramid.floor]))
+
+
+if __name__ == '__main__':
+    unittest.main()
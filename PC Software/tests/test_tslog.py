@@ -0,0 +1,162 @@
+"""DAQ log of tslog.py: bit exact round trip, range and min/max queries.
+
+Run from PC Software with `python -m unittest discover tests`.
+"""
+
+import math
+import os
+import random
+import sys
+import tempfile
+import unittest
+from array import array
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+
+import tslog
+
+CHANNELS = [0, 3, 4, 9]
+
+
+def scans(count, rng, start=1750000000 * 10 ** 9):
+    """Steady 1 ms scans with jitter and gaps of every delta of delta width, and channels of every kind."""
+    times = array('q')
+    t = start
+    for i in range(count):
+        step = 1000000
+        if i % 97 == 0:
+            step += rng.randrange(-5000, 5000)
+        if i % 1500 == 1499:
+            step += rng.choice((3 * 10 ** 9, 10 ** 13))
+        t += step
+        times.append(t)
+    values = {
+        0: array('f', (round(21 + 2 * math.sin(i / 300) + rng.choice((-1, 0, 1)) * 0.01, 2) for i in range(count))),
+        3: array('f', [25.5] * count),
+        4: array('f', (math.nan if i % 7 == 0 else rng.uniform(-1e6, 1e6) for i in range(count))),
+        9: array('f', [math.nan] * count),
+    }
+    return times, values
+
+
+class LogTest(unittest.TestCase):
+
+    def setUp(self):
+        handle, self.path = tempfile.mkstemp(suffix=tslog.LogWriter.suffix)
+        os.close(handle)
+        rng = random.Random(5)
+        self.times, self.values = scans(6000, rng)
+        writer = tslog.LogWriter(self.path, CHANNELS, block_size=1024)
+        for start in range(0, len(self.times), 333):
+            writer.write(self.times[start:start + 333], {ch: column[start:start + 333] for ch, column in self.values.items()})
+        writer.close()
+        self.reader = tslog.LogReader(self.path)
+
+    def tearDown(self):
+        self.reader.close()
+        os.remove(self.path)
+
+    def test_round_trip(self):
+        self.assertGreater(self.reader.blocks, 10)
+        times, values = self.reader.query(-2 ** 63, 2 ** 63 - 1)
+        self.assertEqual(times, self.times)
+        for ch in CHANNELS:
+            self.assertEqual(values[ch].tobytes(), self.values[ch].tobytes(), ch)
+
+    def test_ranges(self):
+        rng = random.Random(9)
+        for _ in range(50):
+            a, b = sorted(rng.randrange(len(self.times)) for _ in range(2))
+            start, stop = self.times[a], self.times[b] + rng.randrange(2)
+            times, values = self.reader.query(start, stop)
+            rows = [i for i, t in enumerate(self.times) if start <= t < stop]
+            self.assertEqual(list(times), [self.times[i] for i in rows])
+
+            ranges = self.reader.minmax(start, stop)
+            for ch in CHANNELS:
+                present = [self.values[ch][i] for i in rows if self.values[ch][i] == self.values[ch][i]]
+                expected = (min(present), max(present)) if present else None
+                low, high = ranges[ch]
+                if expected is None:
+                    self.assertTrue(math.isnan(low) and math.isnan(high))
+                else:
+                    self.assertEqual((low, high), expected)
+
+    def round_trip(self, times, values, block_size=1024):
+        handle, path = tempfile.mkstemp(suffix=tslog.LogWriter.suffix)
+        os.close(handle)
+        try:
+            writer = tslog.LogWriter(path, sorted(values), block_size=block_size)
+            writer.write(times, values)
+            writer.close()
+            reader = tslog.LogReader(path)
+            decoded_times, decoded = reader.query(-2 ** 63, 2 ** 63 - 1)
+            blocks = reader.blocks
+            reader.close()
+        finally:
+            os.remove(path)
+        self.assertEqual(decoded_times, times)
+        for ch in values:
+            self.assertEqual(decoded[ch].tobytes(), values[ch].tobytes(), ch)
+        return blocks
+
+    def test_long_period(self):
+        # Every second row of a block opens with a 64 bit delta of delta
+        times = array('q', (1750000000 * 10 ** 9 + i * 5 * 10 ** 9 for i in range(100)))
+        values = {0: array('f', (20 + i * 0.01 for i in range(100))), 1: array('f', [21.5] * 100)}
+        self.assertGreater(self.round_trip(times, values, block_size=256), 1)
+
+    def test_gap_after_block_start(self):
+        # 1 ms scans with a pause every 50, which lands at every row of a block, also right after the first
+        count = 4000
+        times = array('q')
+        t = 1750000000 * 10 ** 9
+        for i in range(count):
+            t += 10 ** 6 if i % 50 != 1 else 10 ** 13
+            times.append(t)
+        values = {0: array('f', (round(21 + math.sin(i / 50), 2) for i in range(count)))}
+        self.assertGreater(self.round_trip(times, values, block_size=128), 10)
+
+    def test_flush(self):
+        # Whatever was flushed reads back while the writer is still open, as after a crash
+        handle, path = tempfile.mkstemp(suffix=tslog.LogWriter.suffix)
+        os.close(handle)
+        writer = tslog.LogWriter(path, CHANNELS, block_size=1024)
+        try:
+            start = 0
+            for stop in (100, 120, 121, 2000, 2001, 3000):
+                writer.write(self.times[start:stop], {ch: column[start:stop] for ch, column in self.values.items()})
+                writer.flush()
+                self.assertEqual(self.written(path), self.times[:stop])
+                start = stop
+            # A crash drops the scans since the flush, appending keeps the partial block and starts a new one
+            writer.write(self.times[3000:3050], {ch: column[3000:3050] for ch, column in self.values.items()})
+            writer.file.close()
+            writer = tslog.LogWriter(path, CHANNELS, append=True)
+            writer.write(self.times[3000:3100], {ch: column[3000:3100] for ch, column in self.values.items()})
+            writer.close()
+            self.assertEqual(self.written(path), self.times[:3100])
+        finally:
+            os.remove(path)
+
+    def written(self, path):
+        reader = tslog.LogReader(path)
+        times, values = reader.query(-2 ** 63, 2 ** 63 - 1)
+        reader.close()
+        self.assertEqual(values[0].tobytes(), self.values[0][:len(times)].tobytes())
+        return times
+
+    def test_append(self):
+        more_times, more_values = scans(500, random.Random(6), start=self.times[-1])
+        writer = tslog.LogWriter(self.path, CHANNELS, append=True)
+        writer.write(more_times, more_values)
+        writer.close()
+        reader = tslog.LogReader(self.path)
+        times, values = reader.query(-2 ** 63, 2 ** 63 - 1)
+        reader.close()
+        self.assertEqual(times, self.times + more_times)
+        self.assertEqual(values[4].tobytes(), (self.values[4] + more_values[4]).tobytes())
+
+
+if __name__ == '__main__':
+    unittest.main()
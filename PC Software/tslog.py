@@ -0,0 +1,411 @@
+"""Append-only on-disk log of DAQ scans.
+
+The file is a sequence of fixed-size blocks. Block 0 is the file header: the
+magic, the block size and the channel ids. Every later block holds a run of
+scans, compressed as in Gorilla (Pelkonen et al., VLDB 2015):
+
+- Times (int64 ns) are stored as delta of delta, which costs 1 bit at a steady
+  scan period.
+- Values (float32) are XORed with the channel's previous value. An unchanged
+  value costs 1 bit, a small change about the length of its differing
+  mantissa bits.
+
+Each block carries its first row as it is, the time and the float32 bit
+patterns, in its header and the bit stream goes on from there. It decodes on
+its own, and no channel starts from zero: XOR against zero would open a
+31 bit window the rest of the block keeps paying for. The header doubles as
+the sparse index: rows, first and last time, and min/max of every channel. A
+reader maps the file and loads only these headers. A range query bisects them
+and decodes the blocks it overlaps, and a min/max query decodes only the two
+blocks at its ends.
+
+Cost, for 15 channels at 1 kHz with 0.01 °C steps and noise on every channel:
+about 23 B a scan, 2.0 GB and 120 000 blocks a day (32 B a scan with 4 KiB
+blocks started from zero). Opening a day-long log reads the 120 000 headers in
+about 0.2 s. Min/max over a day takes about 0.13 s, mostly the per-channel
+min over the index. A range query decodes about 150 000 scans/s in CPython,
+so a whole day takes about 10 minutes; day-sized views want min/max or a
+decimated export, not `query`.
+
+Sealed blocks are written as they fill, and `flush` also writes the block
+being filled, in its place, which later flushes and the seal write over. A
+block holds all its rows up to then and reads like any other. After a crash
+the file ends at the last block written, so only the scans since the last
+flush are lost.
+
+Block layout, little endian:
+
+| Offset   | Size      | Field                                          |
+|----------|-----------|------------------------------------------------|
+| 0        | 4         | Rows                                           |
+| 4        | 4         | Payload length in bits                         |
+| 8        | 8         | Time of the first row, ns since the epoch      |
+| 16       | 8         | Time of the last row                           |
+| 24       | 8 * n     | float32 min and max per channel, inf and -inf  |
+|          |           | if none                                        |
+| 24 + 8n  | 4 * n     | float32 bit pattern per channel of the first   |
+|          |           | row                                            |
+| 24 + 12n | rest      | Bit stream, most significant bit first         |
+
+Per row after the first the bit stream holds the time, then one value per
+channel in header order:
+
+    time   0                         delta of delta 0
+           10     + 7 bits           two's complement
+           110    + 12 bits
+           1110   + 20 bits
+           11110  + 32 bits
+           11111  + 64 bits
+    value  0                         same as the previous value
+           10     + meaningful bits  XOR fits the previous leading/trailing zeros
+           11     + 5 bits leading zeros + 5 bits length - 1 + meaningful bits
+"""
+
+import math
+import mmap
+import os
+import struct
+import sys
+import time
+from array import array
+from bisect import bisect_left
+
+MAGIC = b'DAQTSLOG'
+VERSION = 2
+BLOCK_SIZE = 16384
+FILE_HEADER = struct.Struct('<8sHHI')
+BLOCK_HEADER = struct.Struct('<IIqq')
+
+# (Prefix, prefix bits, width) of the delta of delta buckets, after the single 0 of a zero
+TIME_BUCKETS = ((0b10, 2, 7), (0b110, 3, 12), (0b1110, 4, 20), (0b11110, 5, 32), (0b11111, 5, 64))
+TIME_BITS = tuple(bits for _, _, bits in TIME_BUCKETS)
+ROW_TIME_BITS = 5 + 64
+VALUE_BITS = 2 + 5 + 5 + 32
+
+# Leading ones of a 5 bit prefix, at most 5
+_ONES = bytes(min(5, 5 - (31 - prefix).bit_length()) for prefix in range(32))
+# Refill below this many buffered bits, the longest field is a 64 bit delta of delta and its prefix
+_REFILL = ROW_TIME_BITS
+
+
+def _float_bits(values):
+    """float32 values as their uint32 bit patterns."""
+    if not isinstance(values, array) or values.typecode != 'f':
+        values = array('f', values)
+    bits = array('I')
+    bits.frombytes(values.tobytes())
+    return bits
+
+
+class LogWriter:
+    """Appends scans of a fixed channel set, in the export writer interface."""
+    name = "DAQ log"
+    suffix = ".daqlog"
+    recordable = True
+
+    def __init__(self, path, channels, append=False, block_size=BLOCK_SIZE):
+        self.channels = list(channels)
+        n = len(self.channels)
+        if append and os.path.exists(path):
+            self.file = open(path, 'r+b')
+            reader = LogReader(path)
+            same = (reader.channels == self.channels)
+            block_size = reader.block_size
+            reader.close()
+            if not same:
+                self.file.close()
+                raise ValueError(f"{os.path.basename(path)} has other channels")
+            # A block cut off by a crash is dropped
+            self.file.truncate(os.path.getsize(path) // block_size * block_size)
+            self.file.seek(0, os.SEEK_END)
+        else:
+            self.file = open(path, 'wb')
+            header = FILE_HEADER.pack(MAGIC, VERSION, n, block_size) + array('H', self.channels).tobytes()
+            self.file.write(header.ljust(block_size, b'\0'))
+        self.block_size = block_size
+        self.capacity = (block_size - BLOCK_HEADER.size - 12 * n) * 8
+        self.worst = ROW_TIME_BITS + VALUE_BITS * n
+        if self.capacity < self.worst:
+            self.file.close()
+            raise ValueError(f"{n} channels do not fit in {block_size} byte blocks")
+        self._reset()
+
+    def _reset(self):
+        n = len(self.channels)
+        self.payload = bytearray()
+        self.acc = 0            # The last used % 8 bits, not yet a whole byte
+        self.used = 0
+        self.rows = 0
+        self.first = self.last = self.delta = 0
+        self.seeds = array('I', bytes(4 * n))
+        self.previous = [0] * n
+        self.windows = [None] * n
+        self.lows = [math.inf] * n
+        self.highs = [-math.inf] * n
+
+    def write(self, times, values):
+        columns = [values[ch] for ch in self.channels]
+        patterns = [_float_bits(column) for column in columns]
+        lows, highs, previous, windows = self.lows, self.highs, self.previous, self.windows
+        for i, t in enumerate(times):
+            if self.used + self.worst > self.capacity:
+                self._seal()
+                lows, highs, previous, windows = self.lows, self.highs, self.previous, self.windows
+
+            for c, column in enumerate(columns):
+                value = column[i]
+                if value == value:
+                    if value < lows[c]:
+                        lows[c] = value
+                    if value > highs[c]:
+                        highs[c] = value
+
+            if self.rows == 0:
+                # The first row goes into the block header as it is
+                self.first = self.last = t
+                self.delta = 0
+                for c, pattern in enumerate(patterns):
+                    self.seeds[c] = previous[c] = pattern[i]
+                self.rows = 1
+                continue
+
+            acc = self.acc
+            width = self.used & 7
+            delta = t - self.last
+            dod = delta - self.delta
+            self.last, self.delta = t, delta
+            if dod == 0:
+                acc <<= 1
+                width += 1
+            else:
+                for prefix, prefix_bits, bits in TIME_BUCKETS:
+                    if -(1 << (bits - 1)) <= dod < (1 << (bits - 1)):
+                        acc = (((acc << prefix_bits) | prefix) << bits) | (dod & ((1 << bits) - 1))
+                        width += prefix_bits + bits
+                        break
+
+            for c, pattern in enumerate(patterns):
+                xor = pattern[i] ^ previous[c]
+                previous[c] = pattern[i]
+                if xor == 0:
+                    acc <<= 1
+                    width += 1
+                    continue
+                leading = 32 - xor.bit_length()
+                trailing = (xor & -xor).bit_length() - 1
+                window = windows[c]
+                if window is not None and leading >= window[0] and trailing >= window[1]:
+                    length = 32 - window[0] - window[1]
+                    acc = (((acc << 2) | 0b10) << length) | (xor >> window[1])
+                    width += 2 + length
+                else:
+                    length = 32 - leading - trailing
+                    acc = (((acc << 12) | (0b11 << 10) | (leading << 5) | (length - 1)) << length) | (xor >> trailing)
+                    width += 12 + length
+                    windows[c] = (leading, trailing)
+
+            # Whole bytes out, the rest waits for the next row
+            whole = width >> 3
+            if whole:
+                self.payload += (acc >> (width & 7)).to_bytes(whole, 'big')
+            self.acc = acc & ((1 << (width & 7)) - 1)
+            self.used += width - (self.used & 7)
+            self.rows += 1
+
+    def _block(self):
+        payload = self.payload
+        if self.used & 7:
+            payload = payload + bytes((self.acc << (8 - (self.used & 7)),))
+        stats = array('f')
+        for low, high in zip(self.lows, self.highs):
+            stats.extend((low, high))
+        block = BLOCK_HEADER.pack(self.rows, self.used, self.first, self.last) + stats.tobytes() + self.seeds.tobytes() + payload
+        return block.ljust(self.block_size, b'\0')
+
+    def _seal(self):
+        if self.rows == 0:
+            return
+        self.file.write(self._block())
+        self._reset()
+
+    def flush(self):
+        # The block being filled goes out as it is and is written over until it is sealed
+        if self.rows:
+            position = self.file.tell()
+            self.file.write(self._block())
+            self.file.seek(position)
+        self.file.flush()
+        os.fsync(self.file.fileno())
+
+    def close(self):
+        self._seal()
+        self.file.close()
+
+
+class LogReader:
+    """Memory-mapped view of a log, for range and min/max queries."""
+
+    def __init__(self, path):
+        self.file = open(path, 'rb')
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+        magic, version, n, self.block_size = FILE_HEADER.unpack_from(self.map, 0)
+        if magic != MAGIC or version != VERSION:
+            self.close()
+            raise ValueError(f"{os.path.basename(path)} is not a DAQ log of version {VERSION}")
+        self.channels = list(array('H', self.map[FILE_HEADER.size:FILE_HEADER.size + 2 * n]))
+        self.stats_offset = BLOCK_HEADER.size
+        self.seeds_offset = BLOCK_HEADER.size + 8 * n
+        self.payload_offset = BLOCK_HEADER.size + 12 * n
+
+        self.blocks = len(self.map) // self.block_size - 1
+        self.rows = array('I')
+        self.first = array('q')
+        self.last = array('q')
+        stats = array('f')
+        for b in range(self.blocks):
+            offset = (b + 1) * self.block_size
+            rows, bits, first, last = BLOCK_HEADER.unpack_from(self.map, offset)
+            self.rows.append(rows)
+            self.first.append(first)
+            self.last.append(last)
+            stats.frombytes(self.map[offset + self.stats_offset:offset + self.seeds_offset])
+        # Per channel min and max of every block, a min/max over whole blocks never touches the file
+        self.lows = [stats[2 * c::2 * n] for c in range(n)]
+        self.highs = [stats[2 * c + 1::2 * n] for c in range(n)]
+
+    def __len__(self):
+        return sum(self.rows)
+
+    def stats(self, b):
+        """(lows, highs) of block `b`, one float per channel, inf and -inf where it has no value."""
+        return [low[b] for low in self.lows], [high[b] for high in self.highs]
+
+    def block(self, b):
+        """Decodes block `b` into (times, {channel: values})."""
+        offset = (b + 1) * self.block_size
+        rows, length, first, _ = BLOCK_HEADER.unpack_from(self.map, offset)
+        n = len(self.channels)
+        previous = list(array('I', self.map[offset + self.seeds_offset:offset + self.payload_offset]))
+        # Zeros past the end so every refill takes 8 bytes
+        payload = self.map[offset + self.payload_offset:offset + self.payload_offset + (length + 7) // 8] + bytes(24)
+
+        times = array('q', [first])
+        patterns = [array('I', [seed]) for seed in previous]
+        windows = [None] * n
+        last, delta = first, 0
+        acc = 0
+        avail = 0               # Bits of acc not yet read, the low ones
+        p = 0
+        for _ in range(rows - 1):
+            while avail < _REFILL:
+                acc = ((acc & ((1 << avail) - 1)) << 64) | int.from_bytes(payload[p:p + 8], 'big')
+                p += 8
+                avail += 64
+            ones = _ONES[(acc >> (avail - 5)) & 31]
+            avail -= ones + (ones < 5)
+            if ones:
+                bits = TIME_BITS[ones - 1]
+                dod = (acc >> (avail - bits)) & ((1 << bits) - 1)
+                if dod >= 1 << (bits - 1):
+                    dod -= 1 << bits
+                avail -= bits
+                delta += dod
+            last += delta
+            times.append(last)
+
+            for c in range(n):
+                while avail < _REFILL:
+                    acc = ((acc & ((1 << avail) - 1)) << 64) | int.from_bytes(payload[p:p + 8], 'big')
+                    p += 8
+                    avail += 64
+                control = (acc >> (avail - 2)) & 3
+                if control < 2:
+                    avail -= 1
+                else:
+                    if control == 2:
+                        leading, trailing = windows[c]
+                        size = 32 - leading - trailing
+                        avail -= 2
+                    else:
+                        fields = (acc >> (avail - 12)) & 0x3FF
+                        size = (fields & 31) + 1
+                        leading = fields >> 5
+                        trailing = 32 - leading - size
+                        windows[c] = (leading, trailing)
+                        avail -= 12
+                    avail -= size
+                    previous[c] ^= ((acc >> avail) & ((1 << size) - 1)) << trailing
+                patterns[c].append(previous[c])
+
+        values = {}
+        for ch, pattern in zip(self.channels, patterns):
+            values[ch] = array('f')
+            values[ch].frombytes(pattern.tobytes())
+        return times, values
+
+    def _blocks(self, start, stop):
+        b = bisect_left(self.last, start)
+        while b < self.blocks and self.first[b] < stop:
+            yield b
+            b += 1
+
+    def query(self, start, stop):
+        """Scans with start <= time < stop, as (times, {channel: values})."""
+        times = array('q')
+        values = {ch: array('f') for ch in self.channels}
+        for b in self._blocks(start, stop):
+            block_times, block_values = self.block(b)
+            lo = bisect_left(block_times, start)
+            hi = bisect_left(block_times, stop)
+            times.extend(block_times[lo:hi])
+            for ch in self.channels:
+                values[ch].extend(block_values[ch][lo:hi])
+        return times, values
+
+    def minmax(self, start, stop):
+        """{channel: (min, max)} over start <= time < stop, from the index except at both ends."""
+        # Blocks lo to hi lie wholly in the range, only the ones around them can be cut
+        lo = bisect_left(self.first, start)
+        hi = max(lo, bisect_left(self.last, stop))
+        lows = [min(low[lo:hi], default=math.inf) for low in self.lows]
+        highs = [max(high[lo:hi], default=-math.inf) for high in self.highs]
+        for b in (lo - 1, hi):
+            if 0 <= b < self.blocks and self.last[b] >= start and self.first[b] < stop:
+                _, values = self.query(max(start, self.first[b]), min(stop, self.last[b] + 1))
+                for c, ch in enumerate(self.channels):
+                    lows[c] = min(lows[c], min((v for v in values[ch] if v == v), default=math.inf))
+                    highs[c] = max(highs[c], max((v for v in values[ch] if v == v), default=-math.inf))
+        return {ch: (low, high) if low <= high else (math.nan, math.nan)
+                for ch, low, high in zip(self.channels, lows, highs)}
+
+    def close(self):
+        self.map.close()
+        self.file.close()
+
+
+def main(argv):
+    """tslog.py <file> [start end]: prints the index and times a query, start and end in seconds into the log."""
+    reader = LogReader(argv[1])
+    if not reader.blocks:
+        print("empty")
+        return
+    size = os.path.getsize(argv[1])
+    rows = len(reader)
+    origin = reader.first[0]
+    print(f'{reader.blocks} blocks {rows} scans of {len(reader.channels)} channels, '
+          f'{(reader.last[-1] - origin) / 1e9:.1f} s, {size / max(rows, 1):.1f} B/scan')
+    start = origin + int(float(argv[2]) * 1e9) if len(argv) > 2 else origin
+    stop = origin + int(float(argv[3]) * 1e9) if len(argv) > 3 else reader.last[-1] + 1
+    began = time.perf_counter()
+    times, _ = reader.query(start, stop)
+    queried = time.perf_counter()
+    ranges = reader.minmax(start, stop)
+    print(f'query {len(times)} scans in {(queried - began) * 1e3:.1f} ms, '
+          f'min/max in {(time.perf_counter() - queried) * 1e3:.1f} ms')
+    for ch, (low, high) in ranges.items():
+        print(f'ch {ch}: {low:.2f} .. {high:.2f}')
+    reader.close()
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -24,94 +24,129 @@ DMA_Config xADC;
  */
 int8_t pin_temp = 0;
 
-//void ADC_IRQHandler(void)
-//{
-//	if(ADC1 -> SR & ADC_SR_OVR)
-//	{
-//		ADC1 -> SR &= ~(ADC_SR_OVR | ADC_SR_EOC);
-//		ADC1 -> CR2 |= ADC_CR2_ADON ;
-//		ADC1 -> CR2 |= ADC_CR2_SWSTART;
-//		DMA_Set_Target(&xADC);
-//		DMA_Set_Trigger(&xADC);
-//	}
-//}
+/**
+ * @brief Sample time and sequence registers of a channel set
+ */
+typedef struct ADC_Registers{
+	uint32_t SMPR1;
+	uint32_t SMPR2;
+	uint32_t SQR1;
+	uint32_t SQR2;
+	uint32_t SQR3;
+}ADC_Registers;
 
 /**
- * @brief Initializes the external timer trigger for the ADC.
- *
- * This function sets up the external timer trigger for the ADC based on the
- * provided configuration. It enables the corresponding timer and configures
- * its registers to trigger the ADC conversion. The function supports multiple
- * trigger events, including various channels and timers.
- *
- * @param[in] config Pointer to the ADC configuration structure.
+ * @brief Converters that share the regular sequence, 1 in independent mode
  */
+static uint8_t multi_converters = 1;
 
+/**
+ * @brief Samples moved by one DMA transfer, 2 when dual mode packs a rank into a word
+ */
+static uint8_t dma_samples = 1;
 
-typedef struct {
-    uint16_t PSC;
-    uint16_t ARR;
-    float    actualFreq;   // The frequency you’ll actually get
-    float    errorPercent; // (actualFreq - targetFreq) / targetFreq * 100
-} TimerSettings_t;
+/**
+ * @brief State of the double-buffered block acquisition
+ */
+static volatile uint16_t *block_buffer;
+static uint16_t block_scans = 0;
+static volatile int8_t block_ready_half = -1;
+static volatile uint32_t block_sequence = 0;
+static volatile uint32_t block_overruns = 0;
+static void (*block_callback)(void) = NULL;
+static uint32_t block_capacity = 0;					// Samples in the capture buffer
+static volatile uint64_t block_scan_total = 0;		// Scans in all published blocks
+static uint64_t block_layout_scan = 0;				// First scan of the current buffer layout
+static volatile uint16_t *block_ready_data;			// Layout of the published block
+static volatile uint16_t block_ready_scans = 0;
+static volatile uint8_t block_ready_channels = 0;
 
 /**
- * @brief  Compute PSC and ARR for a desired timer frequency.
- * @param  timerClkHz: Timer peripheral clock in Hz (e.g. HAL_RCC_GetPCLK1Freq()*2 for TIM2–7/12–14
- *                     or HAL_RCC_GetPCLK2Freq()*2 for TIM1/8)
- * @param  targetFreqHz: Desired output frequency in Hz
- * @retval TimerSettings_t with PSC, ARR, actualFreq and errorPercent
+ * @brief Timer that paces the conversions, used to timestamp the blocks.
+ *        Times are counted in cycles of the timer clock so that they survive prescaler changes.
  */
-TimerSettings_t Timer_CalcPrescalerAndReload(uint32_t timerClkHz, uint32_t targetFreqHz)
-{
-    TimerSettings_t best = {0, 0, 0, 100.0f};
-    float bestError = 1e6f;
+static TIM_TypeDef *trigger_timer = NULL;
+static volatile uint32_t *trigger_compare = NULL;	// Compare register of the trigger channel, NULL for update events
+static uint32_t trigger_flag = 0;					// Status and interrupt enable bit of the trigger event
+static uint32_t trigger_clock = 0;					// Timer clock in Hz
+static uint32_t trigger_period = 0;					// Timer clocks per scan
+static uint32_t trigger_phase = 0;					// Timer clocks from the update to the trigger
+static volatile uint64_t trigger_count = 0;			// Timer clocks at the trigger of the next block, extended to 64 bits
+static volatile uint64_t block_trigger_count = 0;
+static volatile uint32_t block_trigger_period = 0;
 
-    // Loop PSC from 0..65535
-    for (uint32_t psc = 0; psc < 0x10000; ++psc) {
-        // Compute tentative ARR:
-        // ARR+1 = timerClkHz / ((PSC+1) * targetFreqHz)
-        float arrf = ((float)timerClkHz / ((psc + 1) * (float)targetFreqHz)) - 1.0f;
-        if (arrf < 0 || arrf > 0xFFFF) continue;
+/**
+ * @brief Sampling rate change, applied by the trigger interrupt and accounted for by the next block
+ */
+static Timer_Settings rate_settings;
+static volatile bool rate_requested = false;
+static volatile bool rate_applied = false;
+static uint64_t rate_scan = 0;						// First scan at the new rate
+static uint64_t rate_count = 0;						// Timer clocks at its trigger
+static uint32_t rate_period = 0;
+static volatile uint16_t block_rate_scan = 0;
+static volatile uint64_t block_rate_count = 0;
+static volatile uint32_t block_rate_period = 0;
 
-        uint32_t arr = (uint32_t)(arrf + 0.5f); // round to nearest
-        float actualFreq = (float)timerClkHz / ((psc + 1) * (arr + 1));
-        float error = fabsf((actualFreq - targetFreqHz) / targetFreqHz) * 100.0f;
+/**
+ * @brief Channel set and rate change, applied between two blocks
+ */
+static ADC_TypeDef *reconfig_port = NULL;
+static ADC_Registers reconfig_registers[ADC_MAX_CONVERTERS];
+static uint8_t reconfig_channels = 0;
+static uint16_t reconfig_scans = 0;
+static bool reconfig_rate = false;
+static Timer_Settings reconfig_settings;
+static volatile bool reconfig_requested = false;
 
-        if (error < bestError) {
-            bestError = error;
-            best.PSC = (uint16_t)psc;
-            best.ARR = (uint16_t)arr;
-            best.actualFreq = actualFreq;
-            best.errorPercent = error;
+/**
+ * @brief Analog watchdog, one shot
+ */
+static ADC_TypeDef *watchdog_port = NULL;
+static void (*watchdog_callback)(void) = NULL;
 
-            // Perfect match?
-            if (error < 0.0001f) break;
-        }
-    }
+/* Programs the trigger timer for the sampling rate, a compare trigger lands half way through the period */
+static int8_t ADC_Trigger_Timer_Config(TIM_TypeDef *timer, volatile uint32_t *compare, uint32_t flag, uint32_t frequency)
+{
+	Timer_Settings settings;
 
-    return best;
-}
+	if(Timer_Solve(Timer_Clock(timer), frequency, Timer_Max_Reload(timer), &settings) < 0)
+	{
+		return -1;
+	}
 
+	timer->PSC = settings.Prescaler;
+	timer->ARR = settings.Reload;
+	if(compare != NULL) *compare = settings.Compare;
+	timer->CR1 |= TIM_CR1_ARPE;			// Rate changes take effect at the next update
+	timer->EGR = TIM_EGR_UG;			// Loads the prescaler
 
+	trigger_timer = timer;
+	trigger_compare = compare;
+	trigger_flag = flag;
 
-static void ADC_Timer_External_Trigger_Init(ADC_Config *config)
+	return 1;
+}
+
+/**
+ * @brief Initializes the external timer trigger for the ADC.
+ *
+ * This function sets up the external timer trigger for the ADC based on the
+ * provided configuration. It enables the corresponding timer and configures
+ * its registers to trigger the ADC conversion. The function supports multiple
+ * trigger events, including various channels and timers.
+ *
+ * @param[in] config Pointer to the ADC configuration structure.
+ *
+ * @return int8_t Returns 1 on success, or -1 if the timer cannot reach the sampling frequency.
+ */
+static int8_t ADC_Timer_External_Trigger_Init(ADC_Config *config)
 {
-	TimerSettings_t ts = Timer_CalcPrescalerAndReload(168000000, config->External_Trigger.Sampling_Frequency);
+	uint32_t frequency = config->External_Trigger.Sampling_Frequency;
+	int8_t result = 1;
 
-//	RCC -> APB1ENR |= RCC_APB1ENR_TIM2EN;
-//	TIM2->CR2 &= ~TIM_CR2_MMS;
-//	TIM2->CR2 |=  (TIM_CR2_MMS_0 | TIM_CR2_MMS_1);
-//	TIM2->CCMR1 &= ~TIM_CCMR1_CC2S;          // CC2 as output
-//	TIM2->CCMR1 &= ~TIM_CCMR1_OC2M;
-//	TIM2->CCMR1 |=  TIM_CCMR1_OC2M_1        // OC2M = 110: PWM Mode 1 (OC2REF toggles high when CNT==CCR2)
-//	                  | TIM_CCMR1_OC2M_2;
-//	TIM2->CCMR1 |=  TIM_CCMR1_OC2PE;         // preload enable
-//	TIM2->CCR2 = (config->External_Trigger.Sampling_Frequency)/2 -1;
-//	TIM2->CCER |= TIM_CCER_CC2E;
-//	TIM2->PSC = ts.PSC;
-//	TIM2->ARR = ts.ARR;     // period = 2000 ticks
-//	TIM2->CR1 |= TIM_CR1_CEN;
+	trigger_timer = NULL;
+	trigger_compare = NULL;
 
 	if(config->External_Trigger.Trigger_Event == ADC_Configuration.Regular_External_Trigger_Event.Timer_1_CC1)
 	{
@@ -124,10 +159,8 @@ static void ADC_Timer_External_Trigger_Init(ADC_Config *config)
 		TIM1->CCMR1 |=  TIM_CCMR1_OC1M_1        // OC2M = 110: PWM Mode 1 (OC2REF toggles high when CNT==CCR2)
 		                  | TIM_CCMR1_OC1M_2;
 		TIM1->CCMR1 |=  TIM_CCMR1_OC1PE;         // preload enable
-		TIM1->CCR2 = (config->External_Trigger.Sampling_Frequency)/2 -1;
 		TIM1->CCER |= TIM_CCER_CC1E;
-		TIM1->PSC = ts.PSC;
-		TIM1->ARR = ts.ARR;     // period = 2000 ticks
+		result = ADC_Trigger_Timer_Config(TIM1, &TIM1->CCR1, TIM_SR_CC1IF, frequency);
 		TIM1->CR1 |= TIM_CR1_CEN;
 
 
@@ -149,10 +182,8 @@ static void ADC_Timer_External_Trigger_Init(ADC_Config *config)
 		TIM1->CCMR1 |=  TIM_CCMR1_OC2M_1        // OC2M = 110: PWM Mode 1 (OC2REF toggles high when CNT==CCR2)
 		                  | TIM_CCMR1_OC2M_2;
 		TIM1->CCMR1 |=  TIM_CCMR1_OC2PE;         // preload enable
-		TIM1->CCR2 = (config->External_Trigger.Sampling_Frequency)/2 -1;
 		TIM1->CCER |= TIM_CCER_CC2E;
-		TIM1->PSC = ts.PSC;
-		TIM1->ARR = ts.ARR;     // period = 2000 ticks
+		result = ADC_Trigger_Timer_Config(TIM1, &TIM1->CCR2, TIM_SR_CC2IF, frequency);
 		TIM1->CR1 |= TIM_CR1_CEN;
 	}
 	else if(config->External_Trigger.Trigger_Event == ADC_Configuration.Regular_External_Trigger_Event.Timer_1_CC3)
@@ -188,10 +219,8 @@ static void ADC_Timer_External_Trigger_Init(ADC_Config *config)
 		TIM2->CCMR1 |=  TIM_CCMR1_OC1M_1        // OC1M = 110: PWM Mode 1 (OC1REF toggles high when CNT==CCR1)
 		                  | TIM_CCMR1_OC1M_2;
 		TIM2->CCMR1 |=  TIM_CCMR1_OC1PE;         // preload enable
-		TIM2->CCR1 = (config->External_Trigger.Sampling_Frequency)/2 -1;
 		TIM2->CCER |= TIM_CCER_CC1E;
-		TIM2->PSC = ts.PSC;
-		TIM2->ARR = ts.ARR;     // period = 2000 ticks
+		result = ADC_Trigger_Timer_Config(TIM2, &TIM2->CCR1, TIM_SR_CC1IF, frequency);
 		TIM2->CR1 |= TIM_CR1_CEN;
 	}
 	else if(config->External_Trigger.Trigger_Event == ADC_Configuration.Regular_External_Trigger_Event.Timer_2_CC2)
@@ -204,10 +233,8 @@ static void ADC_Timer_External_Trigger_Init(ADC_Config *config)
 		TIM2->CCMR1 |=  TIM_CCMR1_OC2M_1        // OC2M = 110: PWM Mode 1 (OC2REF toggles high when CNT==CCR2)
 		                  | TIM_CCMR1_OC2M_2;
 		TIM2->CCMR1 |=  TIM_CCMR1_OC2PE;         // preload enable
-		TIM2->CCR2 = (config->External_Trigger.Sampling_Frequency)/2 -1;
 		TIM2->CCER |= TIM_CCER_CC2E;
-		TIM2->PSC = ts.PSC;
-		TIM2->ARR = ts.ARR;     // period = 2000 ticks
+		result = ADC_Trigger_Timer_Config(TIM2, &TIM2->CCR2, TIM_SR_CC2IF, frequency);
 		TIM2->CR1 |= TIM_CR1_CEN;
 	}
 	else if(config->External_Trigger.Trigger_Event == ADC_Configuration.Regular_External_Trigger_Event.Timer_2_CC3)
@@ -240,8 +267,7 @@ static void ADC_Timer_External_Trigger_Init(ADC_Config *config)
 		// NVIC_EnableIRQ(TIM1_CC_IRQn);
 		//	NVIC_SetPriority(TIM1_CC_IRQn,1);
 		TIM2 -> CR2 |=  TIM_CR2_MMS_1;
-		TIM2->PSC = 1000-1;
-		TIM2->ARR = 16800-1;
+		result = ADC_Trigger_Timer_Config(TIM2, NULL, TIM_SR_UIF, frequency);
 		TIM2->CR1 |= TIM_CR1_CEN;
 		TIM2 -> EGR |= TIM_EGR_UG;
 	}
@@ -280,6 +306,52 @@ static void ADC_Timer_External_Trigger_Init(ADC_Config *config)
 		TIM3->CR1 |= TIM_CR1_CEN;
 	}
 	/***************************************************************************************************************/
+
+	return result;
+}
+
+/* Replaces the channel set, only while no conversion is running */
+static void ADC_Write_Registers(ADC_TypeDef *port, const ADC_Registers *registers)
+{
+	port->SMPR1 = registers->SMPR1;
+	port->SMPR2 = registers->SMPR2;
+	port->SQR1 = registers->SQR1;
+	port->SQR2 = registers->SQR2;
+	port->SQR3 = registers->SQR3;
+}
+
+/* Converter `index` of the multi mode, ADC1 is the master */
+static ADC_TypeDef *ADC_Converter(uint8_t index)
+{
+	return (index == 0) ? ADC1 : ((index == 1) ? ADC2 : ADC3);
+}
+
+static uint8_t ADC_Converters(ADC_Config *config)
+{
+	if(config->Multi_Mode == ADC_Configuration.Multi_Mode.Dual_Regular_Simultaneous) return 2;
+	if(config->Multi_Mode == ADC_Configuration.Multi_Mode.Triple_Regular_Simultaneous) return 3;
+	return 1;
+}
+
+/* Writes the channel set of every converter that takes part in the conversions */
+static void ADC_Write_Channel_Set(ADC_TypeDef *port, const ADC_Registers *registers)
+{
+	if(multi_converters == 1)
+	{
+		ADC_Write_Registers(port, registers);
+		return;
+	}
+
+	for(uint8_t converter = 0; converter < multi_converters; converter++)
+	{
+		ADC_Write_Registers(ADC_Converter(converter), &registers[converter]);
+	}
+}
+
+/* Data register the DMA reads, the common one once the converters work together */
+static uint32_t ADC_Data_Register(ADC_Config *config)
+{
+	return (multi_converters == 1) ? (uint32_t)&(config->Port->DR) : (uint32_t)&(ADC123_COMMON->CDR);
 }
 
 /**
@@ -290,95 +362,99 @@ static void ADC_Timer_External_Trigger_Init(ADC_Config *config)
  * corresponding sample time register (SMPR1 or SMPR2). The function also counts
  * the number of channels that are enabled and returns this count.
  *
+ * The registers are built in `registers`, which starts cleared, so no setting
+ * of an earlier channel set is left behind.
+ *
  * @param[in] config Pointer to the ADC configuration structure.
+ * @param[in,out] registers Register image the sample times are added to.
  *
  * @return int8_t Returns the number of enabled channels after configuration.
  */
-static int8_t ADC_Sampling_Config(ADC_Config *config)
+static int8_t ADC_Sampling_Config(ADC_Config *config, ADC_Registers *registers)
 {
     uint8_t conversion_Counter = 0;
 
     // Configure sampling time for Channel 0 if enabled
     if(config->Channel_0.Enable == ENABLE)
     {
-        config->Port->SMPR2 |= config->Channel_0.Sample_Time << ADC_SMPR2_SMP0_Pos;
+        registers->SMPR2 |= config->Channel_0.Sample_Time << ADC_SMPR2_SMP0_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 1 if enabled
     if(config->Channel_1.Enable == ENABLE)
     {
-        config->Port->SMPR2 |= config->Channel_1.Sample_Time << ADC_SMPR2_SMP1_Pos;
+        registers->SMPR2 |= config->Channel_1.Sample_Time << ADC_SMPR2_SMP1_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 2 if enabled
     if(config->Channel_2.Enable == ENABLE)
     {
-        config->Port->SMPR2 |= config->Channel_2.Sample_Time << ADC_SMPR2_SMP2_Pos;
+        registers->SMPR2 |= config->Channel_2.Sample_Time << ADC_SMPR2_SMP2_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 3 if enabled
     if(config->Channel_3.Enable == ENABLE)
     {
-        config->Port->SMPR2 |= config->Channel_3.Sample_Time << ADC_SMPR2_SMP3_Pos;
+        registers->SMPR2 |= config->Channel_3.Sample_Time << ADC_SMPR2_SMP3_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 4 if enabled
     if(config->Channel_4.Enable == ENABLE)
     {
-        config->Port->SMPR2 |= config->Channel_4.Sample_Time << ADC_SMPR2_SMP4_Pos;
+        registers->SMPR2 |= config->Channel_4.Sample_Time << ADC_SMPR2_SMP4_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 5 if enabled
     if(config->Channel_5.Enable == ENABLE)
     {
-        config->Port->SMPR2 |= config->Channel_5.Sample_Time << ADC_SMPR2_SMP5_Pos;
+        registers->SMPR2 |= config->Channel_5.Sample_Time << ADC_SMPR2_SMP5_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 6 if enabled
     if(config->Channel_6.Enable == ENABLE)
     {
-        config->Port->SMPR2 |= config->Channel_6.Sample_Time << ADC_SMPR2_SMP6_Pos;
+        registers->SMPR2 |= config->Channel_6.Sample_Time << ADC_SMPR2_SMP6_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 7 if enabled
     if(config->Channel_7.Enable == ENABLE)
     {
-        config->Port->SMPR2 |= config->Channel_7.Sample_Time << ADC_SMPR2_SMP7_Pos;
+        registers->SMPR2 |= config->Channel_7.Sample_Time << ADC_SMPR2_SMP7_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 8 if enabled
     if(config->Channel_8.Enable == ENABLE)
     {
-        config->Port->SMPR2 |= config->Channel_8.Sample_Time << ADC_SMPR2_SMP8_Pos;
+        registers->SMPR2 |= config->Channel_8.Sample_Time << ADC_SMPR2_SMP8_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 9 if enabled
     if(config->Channel_9.Enable == ENABLE)
     {
-        config->Port->SMPR1 |= config->Channel_9.Sample_Time << ADC_SMPR2_SMP9_Pos;
+        registers->SMPR1 |= config->Channel_9.Sample_Time << ADC_SMPR2_SMP9_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 10 if enabled
     if(config->Channel_10.Enable == ENABLE)
     {
-        config->Port->SMPR1 |= config->Channel_10.Sample_Time << ADC_SMPR1_SMP10_Pos;
+        registers->SMPR1 |= config->Channel_10.Sample_Time << ADC_SMPR1_SMP10_Pos;
         conversion_Counter += 1;
     }
 
     // Configure sampling time for Channel 11 if enabled
     if(config->Channel_11.Enable == ENABLE)
     {
-        config->Port->SMPR1 |= config->Channel_11.Sample_Time << ADC_SMPR1_SMP11_Pos;
+        registers->SMPR1 |= config->Channel_11.Sample_Time << ADC_SMPR1_SMP11_Pos;
         conversion_Counter += 1;
     }
 
@@ -387,7 +463,7 @@ static int8_t ADC_Sampling_Config(ADC_Config *config)
     // Configure sampling time for Channel 12 if enabled
     if(config->Channel_12.Enable == ENABLE)
     {
-        config->Port->SMPR1 |= config->Channel_12.Sample_Time << ADC_SMPR1_SMP12_Pos;
+        registers->SMPR1 |= config->Channel_12.Sample_Time << ADC_SMPR1_SMP12_Pos;
         conversion_Counter += 1;
     }
 
@@ -396,7 +472,7 @@ static int8_t ADC_Sampling_Config(ADC_Config *config)
     // Configure sampling time for Channel 13 if enabled
     if(config->Channel_13.Enable == ENABLE)
     {
-        config->Port->SMPR1 |= config->Channel_13.Sample_Time << ADC_SMPR1_SMP13_Pos;
+        registers->SMPR1 |= config->Channel_13.Sample_Time << ADC_SMPR1_SMP13_Pos;
         conversion_Counter += 1;
     }
 
@@ -405,7 +481,7 @@ static int8_t ADC_Sampling_Config(ADC_Config *config)
     // Configure sampling time for Channel 14 if enabled
     if(config->Channel_14.Enable == ENABLE)
     {
-        config->Port->SMPR1 |= config->Channel_14.Sample_Time << ADC_SMPR1_SMP14_Pos;
+        registers->SMPR1 |= config->Channel_14.Sample_Time << ADC_SMPR1_SMP14_Pos;
         conversion_Counter += 1;
     }
 
@@ -414,7 +490,7 @@ static int8_t ADC_Sampling_Config(ADC_Config *config)
     // Configure sampling time for Channel 15 if enabled
     if(config->Channel_15.Enable == ENABLE)
     {
-        config->Port->SMPR1 |= config->Channel_15.Sample_Time << ADC_SMPR1_SMP15_Pos;
+        registers->SMPR1 |= config->Channel_15.Sample_Time << ADC_SMPR1_SMP15_Pos;
         conversion_Counter += 1;
     }
 
@@ -614,127 +690,117 @@ static int8_t ADC_Pin_Init(ADC_Config *config)
 /**
  * @brief Configures the ADC conversion sequence based on enabled channels.
  *
- * This function sets up the ADC conversion sequence by configuring the sequence
- * registers (SQR1, SQR2, SQR3) based on the channels that are enabled in the
- * provided `ADC_Config` structure. Each channel is assigned a specific sequence
- * number within the ADC conversion sequence.
+ * The n-th enabled channel becomes rank n + 1, so any subset of the channels
+ * makes a gapless sequence of SQR1.L + 1 ranks and its samples arrive in the
+ * order of the channel list, as in @ref ADC_Multi_Sequence_Config.
  *
  * @param[in] config Pointer to the ADC configuration structure.
+ * @param[in,out] registers Register image the sequence is added to.
  *
- * @return int8_t Returns 1 on successful configuration of the sequence.
+ * @return int8_t Returns the number of ranks configured.
  */
-static int8_t ADC_Sequence_Config(ADC_Config *config)
+static int8_t ADC_Sequence_Config(ADC_Config *config, ADC_Registers *registers)
 {
-    // Configure sequence for Channel 0
-    if(config->Channel_0.Enable == ENABLE)
-    {
-        config->Port->SQR3 |= config->Channel_0.Sequence_Number << ADC_SQR3_SQ1_Pos;
-    }
+	const ADC_Pin *pins[16] = {
+		&config->Channel_0, &config->Channel_1, &config->Channel_2, &config->Channel_3,
+		&config->Channel_4, &config->Channel_5, &config->Channel_6, &config->Channel_7,
+		&config->Channel_8, &config->Channel_9, &config->Channel_10, &config->Channel_11,
+		&config->Channel_12, &config->Channel_13, &config->Channel_14, &config->Channel_15,
+	};
+	uint8_t rank = 0;
+
+	for(uint8_t slot = 0; slot < 16; slot++)
+	{
+		if(pins[slot]->Enable != ENABLE) continue;
 
-    // Configure sequence for Channel 1
-    if(config->Channel_1.Enable == ENABLE)
-    {
-        config->Port->SQR3 |= config->Channel_1.Sequence_Number << ADC_SQR3_SQ2_Pos;
-    }
+		uint32_t input = pins[slot]->Sequence_Number & 0x1F;
 
-    // Configure sequence for Channel 2
-    if(config->Channel_2.Enable == ENABLE)
-    {
-        config->Port->SQR3 |= config->Channel_2.Sequence_Number << ADC_SQR3_SQ3_Pos;
-    }
+		if(rank < 6) registers->SQR3 |= input << (5 * rank);
+		else if(rank < 12) registers->SQR2 |= input << (5 * (rank - 6));
+		else registers->SQR1 |= input << (5 * (rank - 12));
 
-    // Configure sequence for Channel 3
-    if(config->Channel_3.Enable == ENABLE)
-    {
-        config->Port->SQR3 |= config->Channel_3.Sequence_Number << ADC_SQR3_SQ4_Pos;
-    }
+		rank++;
+	}
 
-    // Configure sequence for Channel 4
-    if(config->Channel_4.Enable == ENABLE)
-    {
-        config->Port->SQR3 |= config->Channel_4.Sequence_Number << ADC_SQR3_SQ5_Pos;
-    }
+	return (int8_t)rank;
+}
 
-    // Configure sequence for Channel 5
-    if(config->Channel_5.Enable == ENABLE)
-    {
-        config->Port->SQR3 |= config->Channel_5.Sequence_Number << ADC_SQR3_SQ6_Pos;
-    }
 
-    // Configure sequence for Channel 6
-    if(config->Channel_6.Enable == ENABLE)
-    {
-        config->Port->SQR2 |= config->Channel_6.Sequence_Number << ADC_SQR2_SQ7_Pos;
-    }
 
-    // Configure sequence for Channel 7
-    if(config->Channel_7.Enable == ENABLE)
-    {
-        config->Port->SQR2 |= config->Channel_7.Sequence_Number << ADC_SQR2_SQ8_Pos;
-    }
+/**
+ * @brief Deals the enabled channels out to the converters of the multi mode.
+ *
+ * The n-th enabled channel becomes rank `n / converters` of converter
+ * `n % converters`. The converters write a rank in the order ADC1, ADC2, ADC3,
+ * so the samples of a scan arrive in the order of the channel list.
+ *
+ * @param[in] config Pointer to the ADC configuration structure.
+ * @param[in] converters 2 or 3.
+ * @param[out] registers Register images of the converters, cleared by the caller.
+ *
+ * @return int8_t Returns the number of channels of all converters, or -1 if they cannot be shared out.
+ */
+static int8_t ADC_Multi_Sequence_Config(ADC_Config *config, uint8_t converters, ADC_Registers *registers)
+{
+	const ADC_Pin *pins[16] = {
+		&config->Channel_0, &config->Channel_1, &config->Channel_2, &config->Channel_3,
+		&config->Channel_4, &config->Channel_5, &config->Channel_6, &config->Channel_7,
+		&config->Channel_8, &config->Channel_9, &config->Channel_10, &config->Channel_11,
+		&config->Channel_12, &config->Channel_13, &config->Channel_14, &config->Channel_15,
+	};
+	uint8_t channels = 0;
+
+	for(uint8_t slot = 0; slot < 16; slot++)
+	{
+		if(pins[slot]->Enable != ENABLE) continue;
 
-    // Configure sequence for Channel 8
-    if(config->Channel_8.Enable == ENABLE)
-    {
-        config->Port->SQR2 |= config->Channel_8.Sequence_Number << ADC_SQR2_SQ9_Pos;
-    }
+		uint8_t converter = channels % converters;
+		uint8_t rank = channels / converters;
+		uint8_t input = pins[slot]->Sequence_Number & 0x1F;
+		uint32_t sample_time = pins[slot]->Sample_Time & 0x07;
+		ADC_Registers *image = &registers[converter];
 
-    // Configure sequence for Channel 9
-    if(config->Channel_9.Enable == ENABLE)
-    {
-        config->Port->SQR2 |= config->Channel_9.Sequence_Number << ADC_SQR2_SQ10_Pos;
-    }
+		if(input > 15) return -1;
+		if((converter == 2) && !(ADC3_CHANNEL_MASK & (1U << input))) return -1;
 
-    // Configure sequence for Channel 10
-    if(config->Channel_10.Enable == ENABLE)
-    {
-        config->Port->SQR2 |= config->Channel_10.Sequence_Number << ADC_SQR2_SQ11_Pos;
-    }
+		if(rank < 6) image->SQR3 |= (uint32_t)input << (5 * rank);
+		else if(rank < 12) image->SQR2 |= (uint32_t)input << (5 * (rank - 6));
+		else image->SQR1 |= (uint32_t)input << (5 * (rank - 12));
 
-    // Configure sequence for Channel 11
-    if(config->Channel_11.Enable == ENABLE)
-    {
-        config->Port->SQR2 |= config->Channel_11.Sequence_Number << ADC_SQR2_SQ12_Pos;
-    }
+		if(input < 10) image->SMPR2 |= sample_time << (3 * input);
+		else image->SMPR1 |= sample_time << (3 * (input - 10));
 
-    /**************************************************************************************************************/
+		channels++;
+	}
 
-    // Configure sequence for Channel 12
-    if(config->Channel_12.Enable == ENABLE)
-    {
-        config->Port->SQR1 |= config->Channel_12.Sequence_Number << ADC_SQR1_SQ13_Pos;
-    }
+	// Every converter runs a sequence of the same length
+	if((channels == 0) || ((channels % converters) != 0)) return -1;
 
-    /**************************************************************************************************************/
+	for(uint8_t converter = 0; converter < converters; converter++)
+	{
+		registers[converter].SQR1 |= (uint32_t)(channels / converters - 1) << ADC_SQR1_L_Pos;
+	}
 
-    // Configure sequence for Channel 13
-    if(config->Channel_13.Enable == ENABLE)
-    {
-        config->Port->SQR1 |= config->Channel_13.Sequence_Number << ADC_SQR1_SQ14_Pos;
-    }
+	return (int8_t)channels;
+}
 
-    /**************************************************************************************************************/
+/* Builds the channel set of all converters, returns the channels per scan or -1 */
+static int8_t ADC_Channel_Set_Config(ADC_Config *config, ADC_Registers *registers)
+{
+	uint8_t converters = ADC_Converters(config);
 
-    // Configure sequence for Channel 14
-    if(config->Channel_14.Enable == ENABLE)
-    {
-        config->Port->SQR1 |= config->Channel_14.Sequence_Number << ADC_SQR1_SQ15_Pos;
-    }
+	if(converters > 1) return ADC_Multi_Sequence_Config(config, converters, registers);
 
-    /**************************************************************************************************************/
+	int8_t channels = ADC_Sampling_Config(config, &registers[0]);
+	if(channels == 0) return -1;
 
-    // Configure sequence for Channel 15
-    if(config->Channel_15.Enable == ENABLE)
-    {
-        config->Port->SQR1 |= config->Channel_15.Sequence_Number << ADC_SQR1_SQ16_Pos;
-    }
+	registers[0].SQR1 |= (uint32_t)(channels - 1) << ADC_SQR1_L_Pos;
+	ADC_Sequence_Config(config, &registers[0]);
 
-    // Return success
-    return 1;
+	return channels;
 }
 
 
-
 /**
  * @brief Initializes the ADC with the provided configuration.
  *
@@ -743,14 +809,26 @@ static int8_t ADC_Sequence_Config(ADC_Config *config)
  * conversion mode, data alignment, and external trigger if enabled. It also
  * sets up the DMA for ADC data transfer.
  *
+ * In dual or triple mode the slave converters get the same settings without a
+ * trigger of their own, and the common data register is read by one DMA stream.
+ * Dual mode moves both samples of a rank in one 32-bit transfer.
+ *
  * @param[in] config Pointer to the ADC configuration structure.
  *
  * @return int8_t Returns 1 on successful initialization, or -1 if an error occurs.
  */
 int8_t ADC_Init(ADC_Config *config)
 {
+    uint8_t converters = ADC_Converters(config);
+
+    // ADC1 is the master of the multi mode, it alone is triggered
+    if ((converters > 1) && (config->Port != ADC_Configuration.Port._ADC1_))
+        return -1;
+
     // Enable the clock for the selected ADC port
-    if (config->Port == ADC_Configuration.Port._ADC1_)
+    if (converters > 1)
+        RCC->APB2ENR |= RCC_APB2ENR_ADC1EN | RCC_APB2ENR_ADC2EN | ((converters > 2) ? RCC_APB2ENR_ADC3EN : 0);
+    else if (config->Port == ADC_Configuration.Port._ADC1_)
         RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
     else if (config->Port == ADC_Configuration.Port._ADC2_)
         RCC->APB2ENR |= RCC_APB2ENR_ADC2EN;
@@ -796,8 +874,10 @@ int8_t ADC_Init(ADC_Config *config)
     }
 
     // Configure sampling settings and initialize ADC pins
-    pin_temp = ADC_Sampling_Config(config);
-    config->Port->SQR1 |= (pin_temp - 1) << ADC_SQR1_L_Pos;
+    ADC_Registers registers[ADC_MAX_CONVERTERS] = {{0}};
+    pin_temp = ADC_Channel_Set_Config(config, registers);
+    if (pin_temp <= 0)
+        return -1;
     ADC_Pin_Init(config);
 
     // Configure external trigger for regular or injected channels
@@ -808,23 +888,43 @@ int8_t ADC_Init(ADC_Config *config)
             // config->Port->CR2 |= config->External_Trigger.Trigger_Event << ADC_CR2_EXTSEL_Pos;
             config->Port->CR2 |= ADC_CR2_EXTSEL_0 | ADC_CR2_EXTSEL_1;
             config->Port->CR2 |= ADC_CR2_EXTEN_0;
-            ADC_Timer_External_Trigger_Init(config);
+            if(ADC_Timer_External_Trigger_Init(config) != 1) return -1;
         }
     } else if (config->Channel_Type == ADC_Configuration.Channel_Type.Injected) {
         config->Port->CR2 &= ~ADC_CR2_JEXTSEL;
         config->Port->CR2 |= config->External_Trigger.Enable << ADC_CR2_JEXTEN_Pos;
         config->Port->CR2 |= config->External_Trigger.Trigger_Event << ADC_CR2_JEXTSEL_Pos;
-        ADC_Timer_External_Trigger_Init(config);
+        if(ADC_Timer_External_Trigger_Init(config) != 1) return -1;
     } else {
         return -1;
     }
 
-    // Enable DMA and set DDS for continuous requests
-    config->Port->CR2 |= ADC_CR2_DMA;
-    config->Port->CR2 |= ADC_CR2_DDS;
+    multi_converters = converters;
+    dma_samples = (converters == 2) ? 2 : 1;
+
+    if (converters == 1) {
+        // Enable DMA and set DDS for continuous requests
+        ADC123_COMMON->CCR &= ~(ADC_CCR_MULTI | ADC_CCR_DMA | ADC_CCR_DDS);
+        config->Port->CR2 |= ADC_CR2_DMA;
+        config->Port->CR2 |= ADC_CR2_DDS;
+    } else {
+        // The slaves convert with the master, the common register serves the DMA
+        config->Port->CR2 &= ~(ADC_CR2_DMA | ADC_CR2_DDS);
+
+        for (uint8_t converter = 1; converter < converters; converter++) {
+            ADC_TypeDef *slave = ADC_Converter(converter);
+            slave->CR1 = config->Port->CR1 & (ADC_CR1_SCAN | ADC_CR1_RES);
+            slave->CR2 = config->Port->CR2 & (ADC_CR2_CONT | ADC_CR2_EOCS | ADC_CR2_ALIGN);
+        }
+
+        // DMA mode 2 packs the samples of ADC1 and ADC2 in one word, triple mode needs mode 1
+        ADC123_COMMON->CCR &= ~(ADC_CCR_MULTI | ADC_CCR_DMA);
+        ADC123_COMMON->CCR |= ((converters == 2) ? ADC_CCR_DMA_1 : ADC_CCR_DMA_0) | ADC_CCR_DDS;
+        ADC123_COMMON->CCR |= (uint32_t)config->Multi_Mode << ADC_CCR_MULTI_Pos;
+    }
 
     // Configure ADC sequence
-    ADC_Sequence_Config(config);
+    ADC_Write_Channel_Set(config->Port, registers);
 
     // Enable the ADC
 //    ADC_Enable(config);
@@ -834,8 +934,8 @@ int8_t ADC_Init(ADC_Config *config)
     xADC.transfer_direction = DMA_Configuration.Transfer_Direction.Peripheral_to_memory;
     xADC.circular_mode = DMA_Configuration.Circular_Mode.Enable;
     xADC.flow_control = DMA_Configuration.Flow_Control.DMA_Control;
-    xADC.memory_data_size = DMA_Configuration.Memory_Data_Size.half_word;
-    xADC.peripheral_data_size = DMA_Configuration.Peripheral_Data_Size.half_word;
+    xADC.memory_data_size = (dma_samples == 2) ? DMA_Configuration.Memory_Data_Size.word : DMA_Configuration.Memory_Data_Size.half_word;
+    xADC.peripheral_data_size = (dma_samples == 2) ? DMA_Configuration.Peripheral_Data_Size.word : DMA_Configuration.Peripheral_Data_Size.half_word;
     xADC.memory_pointer_increment = DMA_Configuration.Memory_Pointer_Increment.Enable;
 //    xADC.interrupts = DMA_Configuration.DMA_Interrupts.Transfer_Complete | DMA_Configuration.DMA_Interrupts.Half_Transfer_Complete;
     xADC.peripheral_pointer_increment = DMA_Configuration.Peripheral_Pointer_Increment.Disable;
@@ -853,7 +953,8 @@ int8_t ADC_Init(ADC_Config *config)
  * @brief Enables the ADC and introduces a delay.
  *
  * This function enables the ADC by setting the ADON bit in the control register.
- * After enabling the ADC, it introduces a delay to allow the ADC to stabilize.
+ * After enabling the ADC, it waits the stabilization time tSTAB. An ADC that is
+ * already on is left alone. In dual or triple mode the slaves are switched on too.
  *
  * @param[in] config Pointer to the ADC configuration structure.
  *
@@ -861,11 +962,17 @@ int8_t ADC_Init(ADC_Config *config)
  */
 int8_t ADC_Enable(ADC_Config *config)
 {
-    // Enable the ADC by setting the ADON bit
+    // Already running, nothing to wait for
+    if (config->Port->CR2 & ADC_CR2_ADON)
+        return 1;
+
+    // Enable the ADC by setting the ADON bit, the slaves of the multi mode as well
+    for (uint8_t converter = 1; converter < multi_converters; converter++)
+        ADC_Converter(converter)->CR2 |= ADC_CR2_ADON;
     config->Port->CR2 |= ADC_CR2_ADON;
 
     // Introduce a delay for ADC stabilization
-    Delay_milli(1000);
+    Delay_us(ADC_STABILIZATION_US);
 
     // Return success
     return 1;
@@ -921,8 +1028,8 @@ int8_t ADC_Start_Capture(ADC_Config *config, uint16_t *buffer)
 	config -> Port -> CR2 |= ADC_CR2_CONT;
 
     // Configure DMA settings for the ADC capture
-    xADC.buffer_length = pin_temp;
-    xADC.peripheral_address = (uint32_t)&(config->Port->DR);
+    xADC.buffer_length = pin_temp / dma_samples;
+    xADC.peripheral_address = ADC_Data_Register(config);
     xADC.memory_address = (uint32_t)buffer;
 
     // Initialize DMA with the target settings
@@ -939,3 +1046,576 @@ int8_t ADC_Start_Capture(ADC_Config *config, uint16_t *buffer)
     // Return success
     return 1;
 }
+
+
+/* Scan the DMA is writing and its trigger timer count, with interrupts masked or from the trigger interrupt */
+static uint64_t ADC_Current_Scan(uint64_t *count)
+{
+	uint32_t buffer_scans = 2UL * block_scans;
+	uint32_t position = ((xADC.buffer_length - xADC.Request.Stream->NDTR) * dma_samples) / (uint8_t)pin_temp;
+	uint64_t published = block_scan_total;
+	uint32_t offset = (uint32_t)((published - block_layout_scan) % buffer_scans);
+	uint64_t scan = published + (position + buffer_scans - offset) % buffer_scans;
+
+	*count = trigger_count + (scan - published) * trigger_period;
+
+	return scan;
+}
+
+/**
+ * @brief Applies a requested sampling rate right after a trigger.
+ *
+ * The new prescaler, reload and compare values are preloaded and take over at the
+ * next update, so the scan triggered just now is the last one at the old rate.
+ * Running right after the trigger leaves the rest of the period to write them.
+ */
+static void ADC_Trigger_ISR(void)
+{
+	if(!(trigger_timer->SR & trigger_flag)) return;
+
+	trigger_timer->SR = (uint32_t)~trigger_flag;
+	trigger_timer->DIER &= ~trigger_flag;
+
+	if(!rate_requested) return;
+
+	// The scan just triggered has not been written completely, the DMA position is its index
+	uint64_t count;
+	uint64_t scan = ADC_Current_Scan(&count);
+
+	trigger_timer->PSC = rate_settings.Prescaler;
+	trigger_timer->ARR = rate_settings.Reload;
+	if(trigger_compare != NULL) *trigger_compare = rate_settings.Compare;
+
+	// Start of the next period, plus the phase of the new trigger
+	rate_count = count - trigger_phase + trigger_period;
+	trigger_phase = (trigger_compare != NULL) ? (rate_settings.Prescaler + 1) * rate_settings.Compare : 0;
+	rate_count += trigger_phase;
+	rate_period = (uint32_t)rate_settings.Division;
+	rate_scan = scan + 1;
+
+	rate_requested = false;
+	rate_applied = true;
+}
+
+void TIM1_CC_IRQHandler(void)
+{
+	if(trigger_timer == TIM1) ADC_Trigger_ISR();
+}
+
+void TIM2_IRQHandler(void)
+{
+	if(trigger_timer == TIM2) ADC_Trigger_ISR();
+}
+
+/**
+ * @brief Changes the sampling rate of a running timer triggered block capture.
+ *
+ * The new rate takes over with the scan after the next trigger, i.e. within one
+ * scan period. The block that contains the change times both parts correctly,
+ * see @ref ADC_Block_Timestamp.
+ *
+ * @param[in,out] config Pointer to the ADC configuration structure.
+ * @param[in] frequency New sampling rate in scans per second.
+ *
+ * @return int8_t Returns 1 if the change was scheduled, 0 while the previous change is
+ *         still in progress, or -1 if there is no trigger timer or the rate is out of range.
+ */
+int8_t ADC_Set_Sampling_Frequency(ADC_Config *config, uint32_t frequency)
+{
+	Timer_Settings settings;
+
+	if((trigger_timer == NULL) || (trigger_clock == 0)) return -1;
+
+	if(Timer_Solve(trigger_clock, frequency, Timer_Max_Reload(trigger_timer), &settings) < 0) return -1;
+
+	if(rate_requested || rate_applied || reconfig_requested) return 0;
+
+	__disable_irq();
+	rate_settings = settings;
+	rate_requested = true;
+	__enable_irq();
+
+	config->External_Trigger.Sampling_Frequency = frequency;
+
+	trigger_timer->SR = (uint32_t)~trigger_flag;
+	trigger_timer->DIER |= trigger_flag;
+	NVIC_EnableIRQ((trigger_timer == TIM1) ? TIM1_CC_IRQn : TIM2_IRQn);
+
+	return 1;
+}
+
+
+/**
+ * @brief Switches a running block capture to a new channel set and sampling rate.
+ *
+ * The enabled channels, their sample times and sequence numbers and the sampling
+ * frequency are taken from `config`. The registers are built from scratch and
+ * written between two scans, right after the last scan of the capture buffer,
+ * together with the rate. The ADC stays on, so acquisition does not pause.
+ *
+ * The capture buffer keeps its size, a block holds as many complete scans of the
+ * new channel set as fit in half of it. Blocks from the change on report the new
+ * `Channels` and `Scans`.
+ *
+ * Without a running block capture the channel set and rate are written immediately.
+ *
+ * @param[in] config Pointer to the ADC configuration structure with the new settings.
+ *
+ * @return int8_t Returns 1 if the change was scheduled, 0 while the previous change is
+ *         still in progress, or -1 for an empty channel set or an unreachable rate.
+ */
+int8_t ADC_Reconfigure(ADC_Config *config)
+{
+	ADC_Registers registers[ADC_MAX_CONVERTERS] = {{0}};
+	Timer_Settings settings;
+	bool rate = false;
+
+	// The converters stay in the mode they were initialized in
+	if(ADC_Converters(config) != multi_converters) return -1;
+
+	int8_t result = ADC_Channel_Set_Config(config, registers);
+	if(result <= 0) return -1;
+
+	uint8_t channels = (uint8_t)result;
+
+	if(trigger_timer != NULL)
+	{
+		uint32_t clock = Timer_Clock(trigger_timer);
+
+		if(Timer_Solve(clock, config->External_Trigger.Sampling_Frequency, Timer_Max_Reload(trigger_timer), &settings) < 0)
+		{
+			return -1;
+		}
+
+		rate = true;
+	}
+
+	if(rate_requested || rate_applied || reconfig_requested) return 0;
+
+	ADC_Pin_Init(config);
+
+	if(block_scans == 0)
+	{
+		ADC_Write_Channel_Set(config->Port, registers);
+		pin_temp = channels;
+
+		if(rate)
+		{
+			trigger_timer->PSC = settings.Prescaler;
+			trigger_timer->ARR = settings.Reload;
+			if(trigger_compare != NULL) *trigger_compare = settings.Compare;
+		}
+
+		return 1;
+	}
+
+	// A free running ADC has no gap between scans to switch in
+	if(trigger_clock == 0) return -1;
+
+	// The first new block must end before the block published with the change begins
+	uint32_t room = block_capacity / 2;
+	uint32_t published_start = (uint32_t)block_scans * (uint8_t)pin_temp;
+	if(room > published_start) room = published_start;
+
+	uint32_t scans = room / channels;
+	if(scans == 0) return -1;
+
+	__disable_irq();
+	reconfig_port = config->Port;
+	for(uint8_t converter = 0; converter < ADC_MAX_CONVERTERS; converter++)
+	{
+		reconfig_registers[converter] = registers[converter];
+	}
+	reconfig_channels = channels;
+	reconfig_scans = (uint16_t)scans;
+	reconfig_rate = rate;
+	reconfig_settings = settings;
+	reconfig_requested = true;
+	__enable_irq();
+
+	return 1;
+}
+
+
+/**
+ * @brief Switches to the requested channel set and rate after the last scan of the buffer.
+ *
+ * Runs in the transfer complete interrupt, between the last scan of the buffer and
+ * the next trigger, so no conversion is running. The new layout starts over at the
+ * beginning of the buffer, its first block stays clear of the block just published.
+ */
+static void ADC_Apply_Reconfiguration(void)
+{
+	DMA_Stream_TypeDef *stream = xADC.Request.Stream;
+
+	stream->CR &= ~DMA_SxCR_EN;
+	while(stream->CR & DMA_SxCR_EN){}
+
+	ADC_Write_Channel_Set(reconfig_port, reconfig_registers);
+
+	pin_temp = reconfig_channels;
+	block_scans = reconfig_scans;
+	block_layout_scan = block_scan_total;
+
+	xADC.buffer_length = (uint16_t)((2UL * block_scans * reconfig_channels) / dma_samples);
+	stream->NDTR = xADC.buffer_length;
+	DMA_Set_Trigger(&xADC);			// Also clears the transfer complete flag of the disable
+
+	if(reconfig_rate && (trigger_timer != NULL))
+	{
+		// Preloaded, the period of the next scan already runs at the new rate
+		trigger_timer->PSC = reconfig_settings.Prescaler;
+		trigger_timer->ARR = reconfig_settings.Reload;
+		if(trigger_compare != NULL) *trigger_compare = reconfig_settings.Compare;
+
+		trigger_count -= trigger_phase;
+		trigger_phase = (trigger_compare != NULL) ? (reconfig_settings.Prescaler + 1) * reconfig_settings.Compare : 0;
+		trigger_count += trigger_phase;
+		trigger_period = (uint32_t)reconfig_settings.Division;
+	}
+
+	reconfig_requested = false;
+}
+
+/**
+ * @brief Publishes the half of the capture buffer that has just been filled.
+ *
+ * A previously published block that was not picked up yet is counted as overrun.
+ *
+ * @param[in] half 0 for the first half of the buffer, 1 for the second half.
+ */
+static void ADC_Block_Complete(int8_t half)
+{
+	if(block_ready_half >= 0)
+	{
+		block_overruns += 1;
+	}
+
+	block_ready_half = half;
+	block_ready_scans = block_scans;
+	block_ready_channels = (uint8_t)pin_temp;
+	block_ready_data = &block_buffer[(uint32_t)half * block_scans * (uint8_t)pin_temp];
+	block_sequence += 1;
+
+	// Every period of the trigger timer converts one scan, counting scans extends its count
+	uint64_t first = block_scan_total;
+	block_scan_total += block_scans;
+
+	block_trigger_count = trigger_count;
+	block_trigger_period = trigger_period;
+
+	if(rate_applied && (rate_scan < first + block_scans))
+	{
+		block_rate_scan = (uint16_t)(rate_scan - first);
+		block_rate_count = rate_count;
+		block_rate_period = rate_period;
+
+		trigger_period = rate_period;
+		trigger_count = rate_count + (first + block_scans - rate_scan) * rate_period;
+		rate_applied = false;
+	}
+	else
+	{
+		trigger_count += (uint64_t)block_scans * trigger_period;
+
+		block_rate_scan = block_scans;
+		block_rate_count = trigger_count;
+		block_rate_period = trigger_period;
+	}
+
+	if((half == 1) && reconfig_requested) ADC_Apply_Reconfiguration();
+
+	if(block_callback) block_callback();
+}
+
+static void ADC_Block_Half_Transfer_ISR(void)
+{
+	ADC_Block_Complete(0);
+}
+
+static void ADC_Block_Full_Transfer_ISR(void)
+{
+	ADC_Block_Complete(1);
+}
+
+
+/**
+ * @brief Starts double-buffered block acquisition.
+ *
+ * The circular DMA stream is pointed at a buffer holding two blocks of
+ * `scans_per_block` complete scans each. The half transfer and transfer complete
+ * interrupts publish the block that has just been filled while the DMA keeps writing
+ * into the other one, so the application always works on a finished block.
+ *
+ * @param[in] config Pointer to the ADC configuration structure.
+ * @param[out] buffer Capture buffer of `2 * scans_per_block * channels` samples.
+ * @param[in] scans_per_block Number of complete scans in one block.
+ *
+ * @return int8_t Returns 1 on success, or -1 if the buffer does not fit in one DMA transfer.
+ */
+int8_t ADC_Start_Block_Capture(ADC_Config *config, uint16_t *buffer, uint16_t scans_per_block)
+{
+	uint32_t length = 2UL * scans_per_block * pin_temp;
+
+	if((scans_per_block == 0) || (length == 0) || ((length / dma_samples) > 0xFFFF))
+	{
+		return -1;
+	}
+
+	block_buffer = buffer;
+	block_scans = scans_per_block;
+	block_capacity = length;
+	block_scan_total = 0;
+	block_layout_scan = 0;
+	block_ready_half = -1;
+	block_sequence = 0;
+	block_overruns = 0;
+	trigger_clock = 0;
+	reconfig_requested = false;
+
+	// Re-initialize the stream with the half/full transfer interrupts
+	xADC.interrupts = DMA_Configuration.DMA_Interrupts.Transfer_Complete | DMA_Configuration.DMA_Interrupts.Half_Transfer_Complete;
+	xADC.ISR_Routines.Half_Transfer_Complete_ISR = ADC_Block_Half_Transfer_ISR;
+	xADC.ISR_Routines.Full_Transfer_Commplete_ISR = ADC_Block_Full_Transfer_ISR;
+	DMA_Init(&xADC);
+
+	xADC.buffer_length = (uint16_t)(length / dma_samples);
+	xADC.peripheral_address = ADC_Data_Register(config);
+	xADC.memory_address = (uint32_t)buffer;
+
+	DMA_Set_Target(&xADC);
+	DMA_Set_Trigger(&xADC);
+
+	// Clear the ADC status register
+	config->Port->SR = 0;
+
+	if((config->External_Trigger.Enable == ENABLE) &&
+	   (config->Conversion_Mode == ADC_Configuration.Conversion_Mode.Single))
+	{
+		// Every trigger converts one scan, the timer paces the acquisition
+		if(trigger_timer != NULL) trigger_timer->CR1 &= ~TIM_CR1_CEN;
+
+		ADC_Enable(config);
+
+		if(trigger_timer != NULL)
+		{
+			// Restart the timer so that its count and the scan count begin together
+			trigger_clock = Timer_Clock(trigger_timer);
+			trigger_period = (trigger_timer->PSC + 1) * (trigger_timer->ARR + 1);
+			trigger_phase = (trigger_compare != NULL) ? (trigger_timer->PSC + 1) * *trigger_compare : 0;
+			trigger_count = trigger_phase;
+			rate_requested = false;
+			rate_applied = false;
+			trigger_timer->EGR = TIM_EGR_UG;			// Clears the counter and the prescaler
+			trigger_timer->CR1 |= TIM_CR1_CEN;
+		}
+	}
+	else
+	{
+		for(uint8_t converter = 1; converter < multi_converters; converter++)
+		{
+			ADC_Converter(converter)->CR2 |= ADC_CR2_CONT;
+		}
+
+		config->Port->CR2 |= ADC_CR2_CONT;
+		ADC_Enable(config);
+		config->Port->CR2 |= ADC_CR2_SWSTART;
+	}
+
+	return 1;
+}
+
+
+/**
+ * @brief Sets a function called from the DMA interrupt whenever a block is published.
+ *
+ * @param[in] callback Function to call, NULL to disable.
+ */
+void ADC_Set_Block_Callback(void (*callback)(void))
+{
+	block_callback = callback;
+}
+
+
+/**
+ * @brief Picks up the most recently completed block.
+ *
+ * @param[out] block Filled with the descriptor of the completed block.
+ *
+ * @return int8_t Returns 1 if a new block was available, 0 otherwise.
+ */
+int8_t ADC_Get_Block(ADC_Block *block)
+{
+	int8_t half;
+
+	__disable_irq();
+	half = block_ready_half;
+	block_ready_half = -1;
+	block->Sequence = block_sequence;
+	block->Overruns = block_overruns;
+	block->Trigger_Count = block_trigger_count;
+	block->Scan_Period = block_trigger_period;
+	block->Rate_Scan = block_rate_scan;
+	block->Rate_Count = block_rate_count;
+	block->Rate_Period = block_rate_period;
+	block->Channels = block_ready_channels;
+	block->Scans = block_ready_scans;
+	block->Data = block_ready_data;
+	__enable_irq();
+
+	if(half < 0)
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+
+/**
+ * @brief Hands a block back after processing.
+ *
+ * The DMA starts overwriting a block as soon as the following one is completed,
+ * so the block is intact as long as no newer block has been published.
+ *
+ * @param[in] block Block obtained from @ref ADC_Get_Block.
+ *
+ * @return int8_t Returns 1 if the block was still intact, 0 if it was (partly) overwritten.
+ */
+int8_t ADC_Release_Block(const ADC_Block *block)
+{
+	return (block_sequence == block->Sequence) ? 1 : 0;
+}
+
+
+/**
+ * @brief Time at which a scan of a block was triggered.
+ *
+ * The time is counted in cycles of the trigger timer clock from the start of the block capture.
+ *
+ * @param[in] block Block obtained from @ref ADC_Get_Block.
+ * @param[in] scan Scan within the block, may also be `Scans` for the end of the block.
+ *
+ * @return uint64_t Nanoseconds since the capture started, 0 without a trigger timer.
+ */
+uint64_t ADC_Block_Timestamp(const ADC_Block *block, uint32_t scan)
+{
+	if(trigger_clock == 0) return 0;
+
+	uint64_t count;
+
+	if(scan < block->Rate_Scan)
+	{
+		count = block->Trigger_Count + (uint64_t)scan * block->Scan_Period;
+	}
+	else
+	{
+		count = block->Rate_Count + (uint64_t)(scan - block->Rate_Scan) * block->Rate_Period;
+	}
+
+	// Split in whole seconds and the rest, the product stays within 64 bits
+	return (count / trigger_clock) * 1000000000ULL + ((count % trigger_clock) * 1000000000ULL) / trigger_clock;
+}
+
+
+/**
+ * @brief Time between two scans of the block capture, as of the last published block.
+ *
+ * @return uint32_t Scan period in ns, 0 without a trigger timer.
+ */
+uint32_t ADC_Get_Scan_Period(void)
+{
+	if(trigger_clock == 0) return 0;
+
+	return (uint32_t)(((uint64_t)trigger_period * 1000000000ULL + trigger_clock / 2) / trigger_clock);
+}
+
+
+/**
+ * @brief Time of the scan that is being converted.
+ *
+ * Taken from the DMA position, so within one scan of the conversion that is
+ * running. Meant to time events such as the analog watchdog on the same clock
+ * as the blocks.
+ *
+ * @return uint64_t Nanoseconds since the capture started, 0 without a trigger timer.
+ */
+uint64_t ADC_Get_Time(void)
+{
+	if((trigger_clock == 0) || (block_scans == 0)) return 0;
+
+	uint64_t count;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	ADC_Current_Scan(&count);
+	__set_PRIMASK(primask);
+
+	return (count / trigger_clock) * 1000000000ULL + ((count % trigger_clock) * 1000000000ULL) / trigger_clock;
+}
+
+
+void ADC_IRQHandler(void)
+{
+	if((watchdog_port == NULL) || !(watchdog_port->SR & ADC_SR_AWD)) return;
+
+	// Every further scan out of the window would interrupt again, stay quiet until re-armed
+	watchdog_port->CR1 &= ~ADC_CR1_AWDIE;
+	watchdog_port->SR = (uint32_t)~ADC_SR_AWD;
+
+	if(watchdog_callback) watchdog_callback();
+}
+
+
+/**
+ * @brief Arms the analog watchdog on one regular channel.
+ *
+ * The channel and the window come from `config->Watchdog_Analog`, the thresholds
+ * are raw codes of the configured resolution. The watchdog compares every
+ * conversion in hardware, so the CPU is only involved when a conversion falls
+ * outside the window. It then calls `callback` from the ADC interrupt once and
+ * disarms itself until it is armed again.
+ *
+ * @param[in] config Pointer to the ADC configuration structure.
+ * @param[in] callback Called from the ADC interrupt when the window is left, may be NULL.
+ *
+ * @return int8_t Returns 1 on success, or -1 if the watchdog is disabled in `config`.
+ */
+int8_t ADC_Watchdog_Arm(ADC_Config *config, void (*callback)(void))
+{
+	ADC_TypeDef *port = config->Port;
+
+	if(config->Watchdog_Analog.Enable != ADC_Configuration._Watchdog_Analog_.Enable) return -1;
+	if(config->Watchdog_Analog.Channel > 18) return -1;
+
+	port->CR1 &= ~(ADC_CR1_AWDIE | ADC_CR1_AWDEN | ADC_CR1_JAWDEN | ADC_CR1_AWDSGL | ADC_CR1_AWDCH);
+
+	port->HTR = config->Watchdog_Analog.Higher_Threshold & ADC_HTR_HT;
+	port->LTR = config->Watchdog_Analog.Lower_Threshold & ADC_LTR_LT;
+
+	if(config->Watchdog_Analog.Channel_Scan == ADC_Configuration._Watchdog_Analog_.Channel_Scan.Single_Channel)
+	{
+		port->CR1 |= ADC_CR1_AWDSGL | ((uint32_t)config->Watchdog_Analog.Channel << ADC_CR1_AWDCH_Pos);
+	}
+
+	watchdog_port = port;
+	watchdog_callback = callback;
+
+	port->SR = (uint32_t)~ADC_SR_AWD;
+	port->CR1 |= ADC_CR1_AWDEN | ADC_CR1_AWDIE;
+	NVIC_EnableIRQ(ADC_IRQn);
+
+	return 1;
+}
+
+
+/**
+ * @brief Tells whether the analog watchdog still waits for a conversion outside its window.
+ *
+ * @param[in] config Pointer to the ADC configuration structure.
+ *
+ * @return bool true while armed, false once it has fired or if it was never armed.
+ */
+bool ADC_Watchdog_Armed(ADC_Config *config)
+{
+	return (config->Port->CR1 & ADC_CR1_AWDIE) != 0;
+}
@@ -29,6 +29,12 @@
  * - External trigger support for starting ADC conversions.
  * - Analog watchdog feature for monitoring ADC channels.
  * - Integrated DMA support for efficient data transfer.
+ * - Double-buffered block acquisition that hands complete, sequence-numbered
+ *   scan blocks to the application using the DMA half/full transfer interrupts.
+ * - Block timestamps counted on the timer that triggers the conversions.
+ * - Dual and triple regular simultaneous mode, the converters share the channel
+ *   list and one DMA stream.
+ * - One shot analog watchdog interrupt on a single channel.
  *
  * @section usage_sec Usage
  *
@@ -40,6 +46,7 @@
  * 3. **Initialize the ADC**: Call `ADC_Init()` with the configuration structure to initialize the ADC.
  * 4. **Enable the ADC**: Use `ADC_Enable()` to power on the ADC and introduce a stabilization delay.
  * 5. **Start Conversion**: Use `ADC_Start()` or `ADC_Start_Capture()` to begin the ADC conversion process.
+ *    For glitch free processing use `ADC_Start_Block_Capture()` and poll `ADC_Get_Block()`.
  *
  * @section examples_sec Example Code
  *
@@ -79,8 +86,12 @@
 #include "main.h"
 #include "GPIO/GPIO.h"
 #include "DMA/DMA.h"
+#include "Timer/Timer.h"
 #include "ADC_Defs.h"
 
+#define ADC_STABILIZATION_US	3	/**< Power-up time tSTAB of the ADC, datasheet maximum */
+#define ADC_MAX_CONVERTERS		3	/**< ADC1, ADC2 and ADC3 */
+#define ADC3_CHANNEL_MASK		0x3C0FU	/**< Inputs of ADC3 on the LQFP100 package, IN0 to IN3 and IN10 to IN13 */
 
 typedef struct ADC_Pin{
 	bool Enable;
@@ -129,11 +140,27 @@ typedef struct ADC_Config{
  */
 	uint8_t Channel_Type;
 
+/**
+ * @brief	Lets ADC2, or ADC2 and ADC3, convert together with ADC1.
+ * 			@ref ADC_Configuration.Multi_Mode
+ *
+ * 			Every trigger converts one rank on all converters at the same
+ * 			time. The enabled channels are dealt out in sequence order, so
+ * 			with two converters the 1st, 3rd, 5th... channel is converted by
+ * 			ADC1 and the 2nd, 4th, 6th... by ADC2. The samples still arrive
+ * 			in sequence order. `Port` must be ADC1, the channel count a
+ * 			multiple of the converters and, in triple mode, every 3rd channel
+ * 			an input of ADC3 (@ref ADC3_CHANNEL_MASK). Channels converted
+ * 			together should have the same sample time.
+ *
+ */
+	uint8_t Multi_Mode;
+
 	struct External_Trigger
 	{
 		bool Enable;
 		uint8_t Trigger_Event;
-		uint8_t Sampling_Frequency;
+		uint32_t Sampling_Frequency;
 	}External_Trigger;
 
 	ADC_Pin Channel_0;
@@ -166,6 +193,29 @@ typedef struct ADC_Config{
 	}Watchdog_Analog;
 }ADC_Config;
 
+/** @struct ADC_Block
+ *  @brief  Descriptor of a completed block of scans handed out by @ref ADC_Get_Block.
+ *
+ *  The samples are stored scan after scan, i.e. `Data[scan * Channels + rank]`.
+ *  The block lives inside the capture buffer and stays intact only until the DMA
+ *  finishes the other half of the buffer, check it with @ref ADC_Release_Block.
+ *
+ *  Scans are triggered by the compare match of a timer, so the time of every scan
+ *  is a count of that timer's clock. @ref ADC_Block_Timestamp turns it into nanoseconds.
+ */
+typedef struct ADC_Block{
+	volatile uint16_t *Data;	/**< First sample of the block */
+	uint16_t Scans;				/**< Number of complete scans in the block */
+	uint8_t Channels;			/**< Number of conversions in one scan */
+	uint32_t Sequence;			/**< Incrementing block sequence number, starts at 1 */
+	uint32_t Overruns;			/**< Blocks that were overwritten before being picked up */
+	uint64_t Trigger_Count;		/**< Trigger timer clocks at the first scan, extended to 64 bits */
+	uint32_t Scan_Period;		/**< Trigger timer clocks between two scans */
+	uint16_t Rate_Scan;			/**< First scan at a new sampling rate, `Scans` if the rate did not change */
+	uint64_t Rate_Count;		/**< Trigger timer clocks at `Rate_Scan` */
+	uint32_t Rate_Period;		/**< Trigger timer clocks between two scans from `Rate_Scan` on */
+}ADC_Block;
+
 /**
  * @brief Initializes the ADC with the provided configuration.
  *
@@ -174,6 +224,10 @@ typedef struct ADC_Config{
  * conversion mode, data alignment, and external trigger if enabled. It also
  * sets up the DMA for ADC data transfer.
  *
+ * In dual or triple mode the slave converters get the same settings without a
+ * trigger of their own, and the common data register is read by one DMA stream.
+ * Dual mode moves both samples of a rank in one 32-bit transfer.
+ *
  * @param[in] config Pointer to the ADC configuration structure.
  *
  * @return int8_t Returns 1 on successful initialization, or -1 if an error occurs.
@@ -184,7 +238,8 @@ int8_t ADC_Init(ADC_Config *config);
  * @brief Enables the ADC and introduces a delay.
  *
  * This function enables the ADC by setting the ADON bit in the control register.
- * After enabling the ADC, it introduces a delay to allow the ADC to stabilize.
+ * After enabling the ADC, it waits the stabilization time tSTAB. An ADC that is
+ * already on is left alone. In dual or triple mode the slaves are switched on too.
  *
  * @param[in] config Pointer to the ADC configuration structure.
  *
@@ -219,4 +274,158 @@ int8_t ADC_Start(ADC_Config *config);
  */
 int8_t ADC_Start_Capture(ADC_Config *config, uint16_t *buffer);
 
+/**
+ * @brief Starts double-buffered block acquisition.
+ *
+ * The circular DMA stream is pointed at a buffer holding two blocks of
+ * `scans_per_block` complete scans each. The half transfer and transfer complete
+ * interrupts publish the block that has just been filled while the DMA keeps writing
+ * into the other one, so the application always works on a finished block.
+ *
+ * When the external trigger is enabled and the conversion mode is Single every
+ * trigger converts one scan, otherwise the ADC is run in continuous mode.
+ *
+ * @param[in] config Pointer to the ADC configuration structure.
+ * @param[out] buffer Capture buffer of `2 * scans_per_block * channels` samples.
+ * @param[in] scans_per_block Number of complete scans in one block.
+ *
+ * @return int8_t Returns 1 on success, or -1 if the buffer does not fit in one DMA transfer.
+ */
+int8_t ADC_Start_Block_Capture(ADC_Config *config, uint16_t *buffer, uint16_t scans_per_block);
+
+/**
+ * @brief Sets a function called from the DMA interrupt whenever a block is published.
+ *
+ * Meant to wake up the task that calls @ref ADC_Get_Block, e.g. with `Scheduler_Signal`.
+ *
+ * @param[in] callback Function to call, NULL to disable.
+ */
+void ADC_Set_Block_Callback(void (*callback)(void));
+
+/**
+ * @brief Picks up the most recently completed block.
+ *
+ * @param[out] block Filled with the descriptor of the completed block.
+ *
+ * @return int8_t Returns 1 if a new block was available, 0 otherwise.
+ */
+int8_t ADC_Get_Block(ADC_Block *block);
+
+/**
+ * @brief Hands a block back after processing.
+ *
+ * The DMA starts overwriting a block as soon as the following one is completed.
+ * Calling this after processing tells whether the data that was used is still the
+ * data of `block`.
+ *
+ * @param[in] block Block obtained from @ref ADC_Get_Block.
+ *
+ * @return int8_t Returns 1 if the block was still intact, 0 if it was (partly) overwritten.
+ */
+int8_t ADC_Release_Block(const ADC_Block *block);
+
+/**
+ * @brief Time at which a scan of a block was triggered.
+ *
+ * The trigger timer is restarted together with the block capture and every period
+ * of it converts one scan. Counting the scans therefore extends the timer count to
+ * 64 bits without an interrupt per scan, and the time of a scan is exact to one
+ * timer count. Only timer triggered captures in Single conversion mode have a time.
+ *
+ * @param[in] block Block obtained from @ref ADC_Get_Block.
+ * @param[in] scan Scan within the block, may also be `Scans` for the end of the block.
+ *
+ * @return uint64_t Nanoseconds since the capture started, 0 without a trigger timer.
+ */
+uint64_t ADC_Block_Timestamp(const ADC_Block *block, uint32_t scan);
+
+/**
+ * @brief Changes the sampling rate of a running timer triggered block capture.
+ *
+ * The prescaler and reload come from @ref Timer_Solve. The new values are written
+ * from the trigger interrupt right after the next scan is triggered and take over
+ * at the following update, i.e. within one scan period.
+ *
+ * @param[in,out] config Pointer to the ADC configuration structure.
+ * @param[in] frequency New sampling rate in scans per second.
+ *
+ * @return int8_t Returns 1 if the change was scheduled, 0 while the previous change is
+ *         still in progress, or -1 if there is no trigger timer or the rate is out of range.
+ */
+int8_t ADC_Set_Sampling_Frequency(ADC_Config *config, uint32_t frequency);
+
+/**
+ * @brief Switches a running block capture to a new channel set and sampling rate.
+ *
+ * The enabled channels, their sample times and sequence numbers and the sampling
+ * frequency are taken from `config`. Any subset of the channels can be enabled,
+ * the n-th enabled channel is converted as rank n. The registers are built from scratch and
+ * written between two scans, right after the last scan of the capture buffer,
+ * together with the rate. The ADC stays on, so acquisition does not pause.
+ *
+ * The capture buffer keeps its size, a block holds as many complete scans of the
+ * new channel set as fit in half of it. Blocks from the change on report the new
+ * `Channels` and `Scans`.
+ *
+ * Without a running block capture the channel set and rate are written immediately.
+ *
+ * @code
+ * thermistor_config.Channel_2.Enable = DISABLE;
+ * thermistor_config.External_Trigger.Sampling_Frequency = 8000;
+ * ADC_Reconfigure(&thermistor_config);
+ * @endcode
+ *
+ * @param[in] config Pointer to the ADC configuration structure with the new settings.
+ *
+ * @return int8_t Returns 1 if the change was scheduled, 0 while the previous change is
+ *         still in progress, or -1 for an empty channel set, an unreachable rate or a
+ *         capture that is not timer triggered.
+ */
+int8_t ADC_Reconfigure(ADC_Config *config);
+
+/**
+ * @brief Time between two scans of the block capture, as of the last published block.
+ *
+ * @return uint32_t Scan period in ns, 0 without a trigger timer.
+ */
+uint32_t ADC_Get_Scan_Period(void);
+
+/**
+ * @brief Time of the scan that is being converted.
+ *
+ * Taken from the DMA position, so within one scan of the conversion that is
+ * running. Meant to time events such as the analog watchdog on the same clock
+ * as the blocks.
+ *
+ * @return uint64_t Nanoseconds since the capture started, 0 without a trigger timer.
+ */
+uint64_t ADC_Get_Time(void);
+
+/**
+ * @brief Arms the analog watchdog on one regular channel.
+ *
+ * The channel and the window come from `config->Watchdog_Analog`, the thresholds
+ * are raw codes of the configured resolution. The watchdog compares every
+ * conversion in hardware, so the CPU is only involved when a conversion falls
+ * outside the window. It then calls `callback` from the ADC interrupt once and
+ * disarms itself until it is armed again.
+ *
+ * In dual or triple mode only the conversions of `Port`, the master, are watched.
+ *
+ * @param[in] config Pointer to the ADC configuration structure.
+ * @param[in] callback Called from the ADC interrupt when the window is left, may be NULL.
+ *
+ * @return int8_t Returns 1 on success, or -1 if the watchdog is disabled in `config`.
+ */
+int8_t ADC_Watchdog_Arm(ADC_Config *config, void (*callback)(void));
+
+/**
+ * @brief Tells whether the analog watchdog still waits for a conversion outside its window.
+ *
+ * @param[in] config Pointer to the ADC configuration structure.
+ *
+ * @return bool true while armed, false once it has fired or if it was never armed.
+ */
+bool ADC_Watchdog_Armed(ADC_Config *config);
+
 #endif /* ADC_H_ */
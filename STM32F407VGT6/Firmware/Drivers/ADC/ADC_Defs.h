@@ -215,8 +215,33 @@ static const struct ADC_Configuration{
 
     }_Watchdog_Analog_;
 
+    struct Multi_Mode{
+        uint8_t Independent;                    /**< ADC1, ADC2 and ADC3 run on their own */
+        uint8_t Dual_Regular_Simultaneous;      /**< ADC1 and ADC2 convert the regular sequence together */
+        uint8_t Triple_Regular_Simultaneous;    /**< ADC1, ADC2 and ADC3 convert the regular sequence together */
+    }Multi_Mode;
+
 }ADC_Configuration = {
 
+    .Multi_Mode = {
+        .Independent = 0,
+        .Dual_Regular_Simultaneous = 6,
+        .Triple_Regular_Simultaneous = 22,
+    },
+
+    ._Watchdog_Analog_ = {
+        .Channel_Type = {
+            .Regular = 0,
+            .Injected = 1,
+        },
+        .Enable = 1,
+        .Disable = 0,
+        .Channel_Scan = {
+            .All_Channels = 0,
+            .Single_Channel = 1,
+        },
+    },
+
     .Channel_Type = {
         .Regular = 0,
         .Injected = 1,
@@ -0,0 +1,389 @@
+/**
+ * @file Alarm.c
+ * @brief Temperature limit and rate of rise alarms with hysteresis.
+ *
+ * Implementation of the alarms declared in @ref Alarm.h.
+ *
+ * @version 1.0
+ * @date 2025-06-17
+ *
+ * @author Kunal Salvi
+ */
+
+#include "Alarm.h"
+
+
+/* First raw code at or above a temperature */
+static uint16_t Alarm_Code(const Alarm_Config *alarm, int32_t centi)
+{
+	uint32_t code = Thermistor_Celsius_To_Code(alarm->Model, (float)centi / 100.0f);
+
+	return (uint16_t)((code + (1UL << alarm->Shift) - 1) >> alarm->Shift);
+}
+
+static int32_t Alarm_Centi(const Alarm_Config *alarm, uint16_t code)
+{
+	int64_t q16 = Thermistor_Code_To_Q16(alarm->Model, (uint16_t)(code << alarm->Shift));
+
+	return (int32_t)((q16 * 100 + THERMISTOR_Q16_ONE / 2) >> 16);
+}
+
+/*
+ * Flips the state of one alarm and queues the change. The watchdog interrupt
+ * raises alarms too, so the state is tested and changed with interrupts masked
+ * and a change already made by the other side is not reported twice.
+ */
+static bool Alarm_Change(Alarm_Config *alarm, uint8_t channel, uint8_t kind, bool active, uint8_t source, int32_t value, uint64_t time)
+{
+	volatile uint16_t *state = (kind == ALARM_KIND_HIGH) ? &alarm->High_Active : ((kind == ALARM_KIND_LOW) ? &alarm->Low_Active : &alarm->Rise_Active);
+	uint16_t bit = 1U << channel;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if(((*state & bit) != 0) == active)
+	{
+		__set_PRIMASK(primask);
+		return false;
+	}
+
+	*state ^= bit;
+	alarm->Events++;
+
+	uint8_t head = alarm->Head;
+	uint8_t next = (head + 1) & (ALARM_QUEUE_LENGTH - 1);
+
+	if(next != alarm->Tail)
+	{
+		Alarm_Event *event = &alarm->Queue[head];
+
+		event->Record.Channel = channel;
+		event->Record.Kind = kind;
+		event->Record.Active = active ? 1 : 0;
+		event->Record.Source = source;
+		event->Record.Value = value;
+		event->Time = time;
+		alarm->Head = next;
+	}
+	else
+	{
+		alarm->Dropped++;
+	}
+
+	__set_PRIMASK(primask);
+	return true;
+}
+
+/* First scan in which channel `channel` is beyond `limit` */
+static uint16_t Alarm_Find(const volatile uint16_t *samples, uint8_t channels, uint16_t scans, uint8_t channel, uint16_t limit, bool above)
+{
+	samples += channel;
+
+	for(uint16_t scan = 0; scan < scans; scan++)
+	{
+		uint16_t code = *samples;
+
+		if(above ? (code >= limit) : (code < limit)) return scan;
+		samples += channels;
+	}
+
+	return 0;
+}
+
+static void Alarm_Range_Scalar(const volatile uint16_t *samples, uint8_t channels, uint16_t scans, uint16_t *min, uint16_t *max)
+{
+	for(uint16_t scan = 0; scan < scans; scan++)
+	{
+		for(uint8_t ch = 0; ch < channels; ch++)
+		{
+			uint16_t code = samples[ch];
+
+			if(code < min[ch]) min[ch] = code;
+			if(code > max[ch]) max[ch] = code;
+		}
+		samples += channels;
+	}
+}
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+/*
+ * Two scans make up exactly `channels` 32-bit words, so word w of every scan pair
+ * holds the samples 2w and 2w + 1 of the pair, modulo the channel count. __USUB16
+ * compares both halves of a word at once and __SEL keeps the larger or smaller
+ * half, the lanes are folded into the channels at the end.
+ */
+static void Alarm_Range_SIMD(const uint32_t *words, uint8_t channels, uint16_t pairs, uint16_t *min, uint16_t *max)
+{
+	uint32_t low[ALARM_MAX_CHANNELS];
+	uint32_t high[ALARM_MAX_CHANNELS];
+
+	for(uint8_t w = 0; w < channels; w++)
+	{
+		low[w] = 0xFFFFFFFFUL;
+		high[w] = 0;
+	}
+
+	for(uint16_t p = 0; p < pairs; p++)
+	{
+		for(uint8_t w = 0; w < channels; w++)
+		{
+			uint32_t word = words[w];
+
+			__USUB16(word, high[w]);
+			high[w] = __SEL(word, high[w]);
+			__USUB16(low[w], word);
+			low[w] = __SEL(word, low[w]);
+		}
+		words += channels;
+	}
+
+	for(uint8_t w = 0; w < channels; w++)
+	{
+		uint8_t first = (2 * w) % channels;
+		uint8_t second = (2 * w + 1) % channels;
+
+		if((low[w] & 0xFFFF) < min[first]) min[first] = low[w] & 0xFFFF;
+		if((high[w] & 0xFFFF) > max[first]) max[first] = high[w] & 0xFFFF;
+		if((low[w] >> 16) < min[second]) min[second] = low[w] >> 16;
+		if((high[w] >> 16) > max[second]) max[second] = high[w] >> 16;
+	}
+}
+#endif
+
+static void Alarm_Range(const volatile uint16_t *samples, uint8_t channels, uint16_t scans, uint16_t *min, uint16_t *max)
+{
+	for(uint8_t ch = 0; ch < channels; ch++)
+	{
+		min[ch] = 0xFFFF;
+		max[ch] = 0;
+	}
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+	if((((uintptr_t)samples) & 0x3) == 0)
+	{
+		uint16_t pairs = scans / 2;
+
+		Alarm_Range_SIMD((const uint32_t *)samples, channels, pairs, min, max);
+		samples += (uint32_t)pairs * 2 * channels;
+		scans -= pairs * 2;
+	}
+#endif
+	Alarm_Range_Scalar(samples, channels, scans, min, max);
+}
+
+
+int8_t Alarm_Init(Alarm_Config *alarm, const Thermistor_Config *model, uint8_t input_bits)
+{
+	if((input_bits == 0) || (input_bits > model->Code_Bits)) return -1;
+	if((alarm->Watchdog_Channel != ALARM_NO_WATCHDOG) && (alarm->Watchdog_Channel >= ALARM_MAX_CHANNELS)) return -1;
+
+	alarm->Model = model;
+	alarm->Shift = model->Code_Bits - input_bits;
+
+	for(uint8_t ch = 0; ch < ALARM_MAX_CHANNELS; ch++)
+	{
+		if(!(alarm->Enable_Mask & (1U << ch))) continue;
+
+		// Raised beyond the limit, cleared only once the whole block is back past the hysteresis
+		alarm->Set_High[ch] = Alarm_Code(alarm, alarm->High_Centi[ch]);
+		alarm->Clear_High[ch] = Alarm_Code(alarm, (int32_t)alarm->High_Centi[ch] - alarm->Hysteresis_Centi);
+		alarm->Set_Low[ch] = Alarm_Code(alarm, alarm->Low_Centi[ch]);
+		alarm->Clear_Low[ch] = Alarm_Code(alarm, (int32_t)alarm->Low_Centi[ch] + alarm->Hysteresis_Centi);
+	}
+
+	alarm->High_Active = 0;
+	alarm->Low_Active = 0;
+	alarm->Rise_Active = 0;
+	alarm->Head = 0;
+	alarm->Tail = 0;
+	alarm->Events = 0;
+	alarm->Dropped = 0;
+	alarm->Last_Latency_us = 0;
+	alarm->Max_Latency_us[0] = 0;
+	alarm->Max_Latency_us[1] = 0;
+
+	return 1;
+}
+
+uint8_t Alarm_Check_Block(Alarm_Config *alarm, const volatile uint16_t *samples, uint8_t channels, uint16_t scans,
+		uint64_t time, uint32_t period)
+{
+	uint16_t min[ALARM_MAX_CHANNELS];
+	uint16_t max[ALARM_MAX_CHANNELS];
+	uint8_t changes = 0;
+
+	if((scans == 0) || (channels == 0) || (channels > ALARM_MAX_CHANNELS)) return 0;
+
+	Alarm_Range(samples, channels, scans, min, max);
+
+	for(uint8_t ch = 0; ch < channels; ch++)
+	{
+		uint16_t bit = 1U << ch;
+
+		if(!(alarm->Enable_Mask & bit)) continue;
+
+		if(!(alarm->High_Active & bit))
+		{
+			if(max[ch] >= alarm->Set_High[ch])
+			{
+				uint16_t scan = Alarm_Find(samples, channels, scans, ch, alarm->Set_High[ch], true);
+				uint16_t code = samples[(uint32_t)scan * channels + ch];
+
+				changes += Alarm_Change(alarm, ch, ALARM_KIND_HIGH, true, ALARM_SOURCE_BLOCK, Alarm_Centi(alarm, code),
+						time + (uint64_t)scan * period);
+			}
+		}
+		else if(max[ch] < alarm->Clear_High[ch])
+		{
+			changes += Alarm_Change(alarm, ch, ALARM_KIND_HIGH, false, ALARM_SOURCE_BLOCK, Alarm_Centi(alarm, max[ch]), time);
+		}
+
+		if(!(alarm->Low_Active & bit))
+		{
+			if(min[ch] < alarm->Set_Low[ch])
+			{
+				uint16_t scan = Alarm_Find(samples, channels, scans, ch, alarm->Set_Low[ch], false);
+				uint16_t code = samples[(uint32_t)scan * channels + ch];
+
+				changes += Alarm_Change(alarm, ch, ALARM_KIND_LOW, true, ALARM_SOURCE_BLOCK, Alarm_Centi(alarm, code),
+						time + (uint64_t)scan * period);
+			}
+		}
+		else if(min[ch] >= alarm->Clear_Low[ch])
+		{
+			changes += Alarm_Change(alarm, ch, ALARM_KIND_LOW, false, ALARM_SOURCE_BLOCK, Alarm_Centi(alarm, min[ch]), time);
+		}
+	}
+
+	return changes;
+}
+
+uint8_t Alarm_Check_Rate(Alarm_Config *alarm, const int32_t *rate, uint8_t channels, uint64_t time)
+{
+	uint8_t changes = 0;
+
+	if(alarm->Rise_Centi_Per_s <= 0) return 0;
+	if(channels > ALARM_MAX_CHANNELS) channels = ALARM_MAX_CHANNELS;
+
+	for(uint8_t ch = 0; ch < channels; ch++)
+	{
+		uint16_t bit = 1U << ch;
+
+		if(!(alarm->Enable_Mask & bit)) continue;
+
+		if(!(alarm->Rise_Active & bit))
+		{
+			if(rate[ch] >= alarm->Rise_Centi_Per_s)
+			{
+				changes += Alarm_Change(alarm, ch, ALARM_KIND_RISE, true, ALARM_SOURCE_BLOCK, rate[ch], time);
+			}
+		}
+		else if(rate[ch] <= alarm->Rise_Centi_Per_s / 2)
+		{
+			changes += Alarm_Change(alarm, ch, ALARM_KIND_RISE, false, ALARM_SOURCE_BLOCK, rate[ch], time);
+		}
+	}
+
+	return changes;
+}
+
+void Alarm_Watchdog_ISR(Alarm_Config *alarm, uint64_t time)
+{
+	uint8_t ch = alarm->Watchdog_Channel;
+
+	if((ch == ALARM_NO_WATCHDOG) || !(alarm->Enable_Mask & (1U << ch))) return;
+
+	// The conversion itself is gone, the limit is the best known value
+	Alarm_Change(alarm, ch, ALARM_KIND_HIGH, true, ALARM_SOURCE_WATCHDOG, alarm->High_Centi[ch], time);
+}
+
+/* Time from the sample to now, for the latency statistics */
+static void Alarm_Delivered(Alarm_Config *alarm, const Alarm_Event *event, uint64_t now)
+{
+	uint32_t latency = (now > event->Time) ? (uint32_t)((now - event->Time) / 1000) : 0;
+	uint8_t source = (event->Record.Source == ALARM_SOURCE_WATCHDOG) ? 1 : 0;
+
+	alarm->Last_Latency_us = latency;
+	if(latency > alarm->Max_Latency_us[source]) alarm->Max_Latency_us[source] = latency;
+}
+
+int8_t Alarm_Get_Event(Alarm_Config *alarm, Alarm_Event *event, uint64_t now)
+{
+	uint8_t tail = alarm->Tail;
+
+	if(tail == alarm->Head) return 0;
+
+	*event = alarm->Queue[tail];
+	alarm->Tail = (tail + 1) & (ALARM_QUEUE_LENGTH - 1);
+	Alarm_Delivered(alarm, event, now);
+
+	return 1;
+}
+
+uint8_t Alarm_Send(Alarm_Config *alarm, Telemetry_Config *telemetry, uint64_t now)
+{
+	uint8_t sent = 0;
+
+	while(alarm->Tail != alarm->Head)
+	{
+		Alarm_Event *event = &alarm->Queue[alarm->Tail];
+
+		if(Telemetry_Send_Urgent(telemetry, TELEMETRY_TYPE_ALARM, 1, 1U << event->Record.Channel, event->Time,
+				&event->Record, sizeof(event->Record)) != 1)
+		{
+			break;
+		}
+
+		Alarm_Delivered(alarm, event, now);
+		alarm->Tail = (alarm->Tail + 1) & (ALARM_QUEUE_LENGTH - 1);
+		sent++;
+	}
+
+	return sent;
+}
+
+uint8_t Alarm_Pending(const Alarm_Config *alarm)
+{
+	return (alarm->Head - alarm->Tail) & (ALARM_QUEUE_LENGTH - 1);
+}
+
+/* Formats 0.01 units with two decimals, keeps printf free of floats */
+static char *Alarm_Text(char *text, size_t size, int32_t centi)
+{
+	uint32_t magnitude = (centi < 0) ? (uint32_t)(-centi) : (uint32_t)centi;
+
+	snprintf(text, size, "%s%lu.%02lu", (centi < 0) ? "-" : "", (unsigned long)(magnitude / 100), (unsigned long)(magnitude % 100));
+
+	return text;
+}
+
+void Alarm_Dump(const Alarm_Config *alarm, void (*print)(char *msg, ...))
+{
+	char text[2][16];
+
+	print("ch      low     high  active\r\n");
+
+	for(uint8_t ch = 0; ch < ALARM_MAX_CHANNELS; ch++)
+	{
+		uint16_t bit = 1U << ch;
+
+		if(!(alarm->Enable_Mask & bit)) continue;
+
+		print("%2u %8s %8s  %s%s%s%s\r\n", ch,
+				Alarm_Text(text[0], sizeof(text[0]), alarm->Low_Centi[ch]),
+				Alarm_Text(text[1], sizeof(text[1]), alarm->High_Centi[ch]),
+				(alarm->High_Active & bit) ? "high " : "",
+				(alarm->Low_Active & bit) ? "low " : "",
+				(alarm->Rise_Active & bit) ? "rise " : "",
+				(ch == alarm->Watchdog_Channel) ? "(watchdog)" : "");
+	}
+
+	print("Hysteresis %s C, rise %s C/s\r\n",
+			Alarm_Text(text[0], sizeof(text[0]), alarm->Hysteresis_Centi),
+			Alarm_Text(text[1], sizeof(text[1]), alarm->Rise_Centi_Per_s));
+	print("Events %lu, dropped %lu, pending %u\r\n", (unsigned long)alarm->Events, (unsigned long)alarm->Dropped, Alarm_Pending(alarm));
+	print("Latency last %lu.%03lu ms, worst block %lu.%03lu ms, worst watchdog %lu.%03lu ms\r\n",
+			(unsigned long)(alarm->Last_Latency_us / 1000), (unsigned long)(alarm->Last_Latency_us % 1000),
+			(unsigned long)(alarm->Max_Latency_us[0] / 1000), (unsigned long)(alarm->Max_Latency_us[0] % 1000),
+			(unsigned long)(alarm->Max_Latency_us[1] / 1000), (unsigned long)(alarm->Max_Latency_us[1] % 1000));
+}
@@ -0,0 +1,207 @@
+/**
+ * @file Alarm.h
+ * @brief Temperature limit and rate of rise alarms with hysteresis.
+ *
+ * Limits are set per channel in 0.01 °C and mapped once, at @ref Alarm_Init,
+ * to raw ADC codes through the thermistor model, which rises monotonically
+ * with temperature. Checking a block of raw samples is then a search for the
+ * smallest and largest code of each channel, done two samples at a time with
+ * __USUB16 and __SEL, and a compare against the code limits. No sample is
+ * converted unless an alarm changes state.
+ *
+ * An alarm is raised on the first sample at or beyond its limit and cleared
+ * once a whole block stays `Hysteresis_Centi` inside it, so a signal sitting on
+ * the limit does not toggle. The rate of rise alarm uses the rate of change of
+ * @ref Statistics_Config and clears below half of its limit.
+ *
+ * One channel can be watched by the ADC analog watchdog as well. It compares
+ * every conversion in hardware and reports through @ref Alarm_Watchdog_ISR, so
+ * that channel is not bound to the block period. @ref ALARM_WATCHDOG_THRESHOLD
+ * gives the watchdog high threshold that matches the software limit.
+ *
+ * Changes are queued as @ref Alarm_Event and sent by @ref Alarm_Send as urgent
+ * telemetry frames of type @ref TELEMETRY_TYPE_ALARM, ahead of the sample frames.
+ * The delay from the offending sample to the queued frame is tracked per source.
+ *
+ * @code
+ * Alarm_Config alarm = {.Enable_Mask = 0x1F, .High_Centi = {8000, ...}, .Hysteresis_Centi = 200};
+ *
+ * Alarm_Init(&alarm, &thermistor_model, 12);
+ * Alarm_Check_Block(&alarm, block.Data, block.Channels, block.Scans, time, period);
+ * Alarm_Send(&alarm, &telemetry, ADC_Get_Time());
+ * @endcode
+ *
+ * @version 1.0
+ * @date 2025-06-17
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef ALARM_ALARM_H_
+#define ALARM_ALARM_H_
+
+#include "main.h"
+#include "Thermistor/Thermistor.h"
+#include "Telemetry/Telemetry.h"
+
+#define ALARM_MAX_CHANNELS		16
+#define ALARM_QUEUE_LENGTH		16		/**< Power of 2 */
+
+#define ALARM_KIND_HIGH			0x01
+#define ALARM_KIND_LOW			0x02
+#define ALARM_KIND_RISE			0x04
+
+#define ALARM_SOURCE_BLOCK		0		/**< Software check of a sample block */
+#define ALARM_SOURCE_WATCHDOG	1		/**< ADC analog watchdog */
+
+#define ALARM_NO_WATCHDOG		0xFF
+
+/**
+ * @brief ADC watchdog high threshold of a channel, the watchdog fires on codes above it.
+ */
+#define ALARM_WATCHDOG_THRESHOLD(alarm, channel)	((uint16_t)((alarm)->Set_High[channel] - 1))
+
+/** @struct Alarm_Record
+ *  @brief  Payload of a @ref TELEMETRY_TYPE_ALARM frame.
+ */
+typedef struct __attribute__((packed)) Alarm_Record{
+	uint8_t Channel;
+	uint8_t Kind;				/**< ALARM_KIND_x */
+	uint8_t Active;				/**< 1 raised, 0 cleared */
+	uint8_t Source;				/**< ALARM_SOURCE_x */
+	int32_t Value;				/**< 0.01 °C, or 0.01 °C/s for ALARM_KIND_RISE */
+}Alarm_Record;
+
+/** @struct Alarm_Event
+ *  @brief  A queued alarm change.
+ */
+typedef struct Alarm_Event{
+	Alarm_Record Record;
+	uint64_t Time;				/**< Time of the sample that changed the alarm (ns) */
+}Alarm_Event;
+
+/** @struct Alarm_Config
+ *  @brief  Limits and state of the alarms, the fields above the state are filled in by the application.
+ */
+typedef struct Alarm_Config{
+	uint16_t Enable_Mask;							/**< Bit n enables the alarms of channel n */
+	int16_t High_Centi[ALARM_MAX_CHANNELS];			/**< Raised at or above, 0.01 °C */
+	int16_t Low_Centi[ALARM_MAX_CHANNELS];			/**< Raised below, 0.01 °C */
+	int16_t Hysteresis_Centi;						/**< Distance back inside a limit before it clears */
+	int32_t Rise_Centi_Per_s;						/**< Rate of rise limit, 0 disables it */
+	uint8_t Watchdog_Channel;						/**< Channel also watched by the ADC, @ref ALARM_NO_WATCHDOG for none */
+
+	/* State */
+	const Thermistor_Config *Model;
+	uint8_t Shift;									/**< Model code bits minus ADC code bits */
+	uint16_t Set_High[ALARM_MAX_CHANNELS];			/**< Raw code limits */
+	uint16_t Clear_High[ALARM_MAX_CHANNELS];
+	uint16_t Set_Low[ALARM_MAX_CHANNELS];
+	uint16_t Clear_Low[ALARM_MAX_CHANNELS];
+	volatile uint16_t High_Active;					/**< Bit n set while channel n is above its limit */
+	volatile uint16_t Low_Active;
+	volatile uint16_t Rise_Active;
+
+	Alarm_Event Queue[ALARM_QUEUE_LENGTH];
+	volatile uint8_t Head;							/**< Written with interrupts masked, thread and watchdog interrupt */
+	volatile uint8_t Tail;							/**< Written by the sender */
+	uint32_t Events;
+	uint32_t Dropped;								/**< Changes lost because the queue was full */
+	uint32_t Last_Latency_us;
+	uint32_t Max_Latency_us[2];						/**< Worst delay from sample to queued frame, per source */
+}Alarm_Config;
+
+/**
+ * @brief Maps the limits to ADC codes and clears all alarms.
+ *
+ * A limit outside the range of the model never triggers.
+ *
+ * @param[in,out] alarm Alarms with the limits filled in.
+ * @param[in] model Thermistor model, must stay valid.
+ * @param[in] input_bits Resolution of the checked ADC codes, at most `Code_Bits` of the model.
+ *
+ * @return int8_t Returns 1 on success, or -1 for an invalid resolution or watchdog channel.
+ */
+int8_t Alarm_Init(Alarm_Config *alarm, const Thermistor_Config *model, uint8_t input_bits);
+
+/**
+ * @brief Checks a block of raw scans against the high and low limits.
+ *
+ * Channels not in the block keep their state.
+ *
+ * @param[in,out] alarm Alarms.
+ * @param[in] samples Raw codes, `samples[scan * channels + channel]`.
+ * @param[in] channels Channels in one scan.
+ * @param[in] scans Number of scans in the block.
+ * @param[in] time Time of the first scan (ns).
+ * @param[in] period Time between two scans (ns).
+ *
+ * @return uint8_t Number of alarms that changed.
+ */
+uint8_t Alarm_Check_Block(Alarm_Config *alarm, const volatile uint16_t *samples, uint8_t channels, uint16_t scans,
+		uint64_t time, uint32_t period);
+
+/**
+ * @brief Checks the rate of change of every channel against the rate of rise limit.
+ *
+ * @param[in,out] alarm Alarms.
+ * @param[in] rate Rate of change per channel in 0.01 °C/s, e.g. `Statistics_Config.Rate`.
+ * @param[in] channels Number of channels.
+ * @param[in] time Time the rates refer to (ns).
+ *
+ * @return uint8_t Number of alarms that changed.
+ */
+uint8_t Alarm_Check_Rate(Alarm_Config *alarm, const int32_t *rate, uint8_t channels, uint64_t time);
+
+/**
+ * @brief Raises the high alarm of the watchdog channel, call from the ADC watchdog interrupt.
+ *
+ * @param[in,out] alarm Alarms.
+ * @param[in] time Time of the conversion, e.g. @ref ADC_Get_Time (ns).
+ */
+void Alarm_Watchdog_ISR(Alarm_Config *alarm, uint64_t time);
+
+/**
+ * @brief Takes the oldest queued change.
+ *
+ * For output other than telemetry, @ref Alarm_Send and this share the queue.
+ *
+ * @param[in,out] alarm Alarms.
+ * @param[out] event Oldest change.
+ * @param[in] now Current time on the clock of the events (ns), for the latency.
+ *
+ * @return int8_t Returns 1 if an event was taken, 0 if the queue is empty.
+ */
+int8_t Alarm_Get_Event(Alarm_Config *alarm, Alarm_Event *event, uint64_t now);
+
+/**
+ * @brief Sends the queued changes as urgent telemetry frames, one change per frame.
+ *
+ * Stops when the link does not accept a frame, the remaining changes stay queued.
+ *
+ * @param[in,out] alarm Alarms.
+ * @param[in,out] telemetry Stream with `Write_Urgent` set.
+ * @param[in] now Current time on the clock of the events (ns), for the latency.
+ *
+ * @return uint8_t Number of changes sent.
+ */
+uint8_t Alarm_Send(Alarm_Config *alarm, Telemetry_Config *telemetry, uint64_t now);
+
+/**
+ * @brief Number of changes waiting to be sent.
+ *
+ * @param[in] alarm Alarms.
+ *
+ * @return uint8_t Queued changes.
+ */
+uint8_t Alarm_Pending(const Alarm_Config *alarm);
+
+/**
+ * @brief Prints limits, active alarms and latencies.
+ *
+ * @param[in] alarm Alarms.
+ * @param[in] print Output function, e.g. `printConsole` or `Log_Print`.
+ */
+void Alarm_Dump(const Alarm_Config *alarm, void (*print)(char *msg, ...));
+
+#endif /* ALARM_ALARM_H_ */
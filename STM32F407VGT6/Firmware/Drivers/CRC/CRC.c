@@ -8,77 +8,297 @@
 
 #include "CRC.h"
 
+/* Largest DMA job, NDTR is 16 bits */
+#define CRC_DMA_MAX_WORDS	0xFFFF
+
+/* Remainder of each top nibble, the software path takes 4 bits per step */
+static const uint32_t CRC_Nibble_Table[16] =
+{
+	0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9, 0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+	0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61, 0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
+};
+
+static const uint8_t CRC_Nibble_Reverse[16] = {0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF};
+
+#if CRC_HARDWARE
+// Context the DMA is feeding the CRC unit for, NULL while the unit is free
+static CRC_Context *volatile crc_dma_owner = NULL;
+#endif
+
+
+static uint32_t CRC_Reverse_32(uint32_t value)
+{
+#if CRC_HARDWARE
+	return __RBIT(value);
+#else
+	uint32_t result = 0;
+
+	for(uint8_t i = 0; i < 8; i++)
+	{
+		result = (result << 4) | CRC_Nibble_Reverse[value & 0xF];
+		value >>= 4;
+	}
+	return result;
+#endif
+}
+
+static uint32_t CRC_Swap_32(uint32_t value)
+{
+#if CRC_HARDWARE
+	return __REV(value);
+#else
+	return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+#endif
+}
+
+/* Word of the buffer as the CRC unit has to see it, most significant bit first */
+static uint32_t CRC_Word(uint8_t mode, const uint8_t *bytes)
+{
+	uint32_t word;
+
+	if(((uintptr_t)bytes & 3) == 0) word = *(const uint32_t *)bytes;
+	else memcpy(&word, bytes, 4);
+
+	if(mode == CRC_MODE_MPEG2) return CRC_Swap_32(word);
+	if(mode == CRC_MODE_CRC32) return CRC_Reverse_32(word);
+	return word;
+}
+
+static uint32_t CRC_Software_Word(uint32_t state, uint32_t word)
+{
+	state ^= word;
+	for(uint8_t i = 0; i < 8; i++) state = (state << 4) ^ CRC_Nibble_Table[state >> 28];
+
+	return state;
+}
+
+/* Single byte of the byte modes, CRC-32 takes it least significant bit first */
+static uint32_t CRC_Software_Byte(uint32_t state, uint8_t mode, uint8_t byte)
+{
+	if(mode == CRC_MODE_CRC32) byte = (uint8_t)((CRC_Nibble_Reverse[byte & 0xF] << 4) | CRC_Nibble_Reverse[byte >> 4]);
+
+	state ^= (uint32_t)byte << 24;
+	state = (state << 4) ^ CRC_Nibble_Table[state >> 28];
+	state = (state << 4) ^ CRC_Nibble_Table[state >> 28];
+
+	return state;
+}
+
+#if CRC_HARDWARE
+/* Puts a context's state into the CRC unit */
+static void CRC_Load(uint32_t state)
+{
+	// Nobody used the unit since this state was read back
+	if(CRC->DR == state) return;
+
+	CRC_Reset();
+	if(state == CRC_Initial_Value) return;
+
+	// The unit has no initial value register, run the 32 shifts backwards to find the word that leads from the reset value to `state`
+	uint32_t seed = state;
+	for(uint8_t i = 0; i < 32; i++) seed = (seed & 1) ? (((seed ^ CRC_Polynomial) >> 1) | 0x80000000) : (seed >> 1);
+
+	CRC->DR = seed ^ CRC_Initial_Value;
+}
+
+static void CRC_DMA_Done(void *context);
+
+static int8_t CRC_DMA_Next(CRC_Context *crc)
+{
+	uint16_t count = (crc->Words > CRC_DMA_MAX_WORDS) ? CRC_DMA_MAX_WORDS : (uint16_t)crc->Words;
+	const uint8_t *source = crc->Next;
+
+	crc->Next += (uint32_t)count * 4;
+	crc->Words -= count;
+
+	return DMA_M2M_Submit(&CRC->DR, 4, false, source, 4, true, count, CRC_DMA_Done, crc);
+}
+
+/* Stream interrupt, one job of the buffer is in */
+static void CRC_DMA_Done(void *context)
+{
+	CRC_Context *crc = (CRC_Context *)context;
+
+	crc->State = CRC->DR;
+
+	if(crc->Words > 0)
+	{
+		if(CRC_DMA_Next(crc) == 1) return;
+
+		// No room in the DMA queue, the unit is still this context's
+		while(crc->Words > 0)
+		{
+			CRC->DR = *(const uint32_t *)crc->Next;
+			crc->Next += 4;
+			crc->Words--;
+		}
+		crc->State = CRC->DR;
+	}
+
+	crc_dma_owner = NULL;
+	crc->Busy = false;
+
+	if(crc->Callback) crc->Callback(crc->Context);
+}
+#endif
+
+
 void CRC_Init(void)
 {
+#if CRC_HARDWARE
 	RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+#endif
 }
 
 void CRC_Reset(void)
 {
+#if CRC_HARDWARE
 	CRC->CR |= CRC_CR_RESET;
+#endif
 }
 
-uint32_t CRC_Compute_Single_Word(uint32_t word)
+void CRC_Start(CRC_Context *crc, uint8_t mode)
 {
-	CRC_Reset();
-	CRC->DR = (uint32_t)(word);
-	return (CRC->DR);
+	crc->State = CRC_Initial_Value;
+	crc->Mode = mode;
+	crc->Busy = false;
+	crc->Next = NULL;
+	crc->Words = 0;
+	crc->Callback = NULL;
+	crc->Context = NULL;
 }
 
-uint32_t CRC_Compute_8Bit_Block(volatile uint8_t *wordBlock, size_t length)
+int8_t CRC_Update(CRC_Context *crc, const void *data, size_t length)
 {
-	uint8_t temp=0;
-	CRC_Reset();
-	for(uint32_t i = 0; i < length; i++)
+	const uint8_t *bytes = (const uint8_t *)data;
+	uint8_t mode = crc->Mode;
+	uint32_t state = crc->State;
+
+	if(crc->Busy) return 0;
+	if((mode == CRC_MODE_WORDS) && (length & 3)) return -1;
+
+	// Byte modes feed the unit from the first aligned word on
+	while((mode != CRC_MODE_WORDS) && (length > 0) && ((uintptr_t)bytes & 3))
 	{
-		temp = wordBlock[i];
-		CRC -> DR = 0x00000000 | (temp);
+		state = CRC_Software_Byte(state, mode, *bytes++);
+		length--;
+	}
+
+	size_t words = length / 4;
 
+#if CRC_HARDWARE
+	if((words > 0) && (crc_dma_owner == NULL))
+	{
+		CRC_Load(state);
+		for(size_t i = 0; i < words; i++) CRC->DR = CRC_Word(mode, &bytes[i * 4]);
+		state = CRC->DR;
+	}
+	else
+#endif
+	{
+		for(size_t i = 0; i < words; i++) state = CRC_Software_Word(state, CRC_Word(mode, &bytes[i * 4]));
 	}
-	return (CRC -> DR);
+
+	bytes += words * 4;
+	length -= words * 4;
+
+	while(length > 0)
+	{
+		state = CRC_Software_Byte(state, mode, *bytes++);
+		length--;
+	}
+
+	crc->State = state;
+	return 1;
 }
 
-uint32_t CRC_Compute_32Bit_Block(volatile uint32_t *wordBlock, size_t length)
+int8_t CRC_Update_Async(CRC_Context *crc, const void *data, size_t length, void (*callback)(void *context), void *context)
 {
-	uint32_t temp = 0;
-	CRC_Reset();
-	for(uint32_t i = 0; i < length; i++)
+	if((crc->Mode != CRC_MODE_WORDS) || ((uintptr_t)data & 3) || (length & 3)) return -1;
+	if(crc->Busy) return 0;
+
+#if CRC_HARDWARE
+	if(length >= DMA_M2M_CPU_THRESHOLD)
 	{
-		temp = *wordBlock++;
-		CRC -> DR = (uint32_t)(temp);
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		if(crc_dma_owner != NULL)
+		{
+			__set_PRIMASK(primask);
+			return 0;
+		}
+		crc_dma_owner = crc;
+		__set_PRIMASK(primask);
+
+		crc->Next = (const uint8_t *)data;
+		crc->Words = length / 4;
+		crc->Callback = callback;
+		crc->Context = context;
+		crc->Busy = true;
+
+		CRC_Load(crc->State);
+
+		int8_t result = CRC_DMA_Next(crc);
+
+		if(result != 1)
+		{
+			crc->Busy = false;
+			crc_dma_owner = NULL;
+		}
+		return result;
 	}
-	return (CRC -> DR)&0xFFFFffff;
+#endif
+
+	CRC_Update(crc, data, length);
+	if(callback) callback(context);
+
+	return 1;
 }
 
+uint32_t CRC_Final(const CRC_Context *crc)
+{
+	// CRC-32 is defined on reflected bits and inverted at the end
+	if(crc->Mode == CRC_MODE_CRC32) return ~CRC_Reverse_32(crc->State);
+
+	return crc->State;
+}
+
+uint32_t CRC_Compute(uint8_t mode, const void *data, size_t length)
+{
+	CRC_Context crc;
+
+	CRC_Start(&crc, mode);
+	if(CRC_Update(&crc, data, length) != 1) return 0;
+
+	return CRC_Final(&crc);
+}
+
+bool CRC_Busy(void)
+{
+#if CRC_HARDWARE
+	return crc_dma_owner != NULL;
+#else
+	return false;
+#endif
+}
+
+uint32_t CRC_Compute_Single_Word(uint32_t word)
+{
+	return CRC_Compute(CRC_MODE_WORDS, &word, 4);
+}
+
+uint32_t CRC_Compute_8Bit_Block(volatile uint8_t *wordBlock, size_t length)
+{
+	return CRC_Compute(CRC_MODE_CRC32, (const void *)wordBlock, length);
+}
+
+uint32_t CRC_Compute_32Bit_Block(volatile uint32_t *wordBlock, size_t length)
+{
+	return CRC_Compute(CRC_MODE_WORDS, (const void *)wordBlock, length * 4);
+}
 
+/* Length in words. The CPU stores into the data register as fast as the DMA would, without waiting for it */
 uint32_t CRC_Compute_Flash_Data(volatile uint32_t Flash_Address, size_t length)
 {
-//	RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
-//
-//	DMA2_Stream0->CR = 0;
-//	while (DMA2_Stream0->CR & DMA_SxCR_EN);  // Make sure stream is disabled
-//
-//	DMA2_Stream0->PAR = (uint32_t)&CRC->DR;
-//	DMA2_Stream0->M0AR = (uint32_t)Flash_Address;
-//	DMA2_Stream0->NDTR = length;
-//	DMA2_Stream0->CR |=
-//			(0 << DMA_SxCR_CHSEL_Pos) |      // Channel 0
-//			(1 << DMA_SxCR_DIR_Pos)    |     // Memory-to-peripheral
-//			(0 << DMA_SxCR_PINC_Pos)   |     // Peripheral address not incremented
-//			(1 << DMA_SxCR_MINC_Pos)   |     // Memory address incremented
-//			(2 << DMA_SxCR_MSIZE_Pos)  |     // Memory size: word (32-bit)
-//			(2 << DMA_SxCR_PSIZE_Pos);       // Peripheral size: word
-//	DMA2_Stream0->FCR = 0; // Direct mode, no FIFO
-//
-//	    DMA2_Stream0->CR |= DMA_SxCR_EN;
-//
-//	    // Wait for transfer complete
-//	    while (!(DMA2->LISR & DMA_LISR_TCIF0));
-//	    DMA2->LIFCR |= DMA_LIFCR_CTCIF0;
-
-	DMA_Memory_To_Memory_Transfer(Flash_Address, 32, 1, &CRC->DR, 32, 0, length);
-
-	    uint32_t crc_value = CRC->DR;
-
-	    return crc_value;
+	return CRC_Compute(CRC_MODE_WORDS, (const void *)(uintptr_t)Flash_Address, length * 4);
 }
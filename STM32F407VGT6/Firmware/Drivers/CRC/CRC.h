@@ -9,15 +9,137 @@
 #define CRC_CRC_H_
 
 #include "main.h"
+
+/*
+ * The CRC unit is used when the device header provides it, a PC build of the
+ * module computes the same values in software.
+ */
+#ifndef CRC_HARDWARE
+#ifdef CRC_BASE
+#define CRC_HARDWARE 1
+#else
+#define CRC_HARDWARE 0
+#endif
+#endif
+
+#if CRC_HARDWARE
 #include "DMA/DMA.h"
+#endif
 
 #define CRC_Polynomial 0x4C11DB7
+#define CRC_Initial_Value 0xFFFFFFFF
+
+/**
+ * @brief What a CRC is computed over and how it is presented.
+ *
+ * | Mode                 | Input                                   | Result                                            |
+ * |----------------------|-----------------------------------------|---------------------------------------------------|
+ * | @ref CRC_MODE_WORDS  | 32-bit words as they sit in memory      | Register of the CRC unit, telemetry and RS485 frames |
+ * | @ref CRC_MODE_MPEG2  | Bytes in order                          | CRC-32/MPEG-2                                     |
+ * | @ref CRC_MODE_CRC32  | Bytes in order                          | CRC-32 of zlib, Ethernet, PNG (Python `zlib.crc32`) |
+ *
+ * All three use polynomial 0x04C11DB7 and initial value 0xFFFFFFFF. The CRC unit
+ * takes one word at a time, most significant bit first, so for the byte modes a
+ * word is byte swapped (MPEG-2) or bit reversed (CRC-32) on its way in, and
+ * unaligned bytes at either end of a buffer are done in software.
+ * @ref CRC_MODE_WORDS takes whole words only, the other two any length.
+ */
+#define CRC_MODE_WORDS		0
+#define CRC_MODE_MPEG2		1
+#define CRC_MODE_CRC32		2
 
+/** @struct CRC_Context
+ *  @brief  CRC computed over several buffers, see @ref CRC_Start.
+ *
+ * Any number of contexts can be open at the same time, each update moves the
+ * state of its context into the CRC unit first.
+ */
+typedef struct CRC_Context{
+	uint32_t State;					/**< Register value so far, before reflection and final XOR */
+	uint8_t Mode;					/**< CRC_MODE_x */
+
+	/* Asynchronous update */
+	volatile bool Busy;
+	const uint8_t *Next;
+	uint32_t Words;					/**< Still to be fed by the DMA */
+	void (*Callback)(void *context);
+	void *Context;
+}CRC_Context;
 
 void CRC_Init(void);
 void CRC_Reset(void);
+
+/**
+ * @brief Opens a CRC.
+ *
+ * @param[out] crc Context.
+ * @param[in] mode CRC_MODE_x.
+ */
+void CRC_Start(CRC_Context *crc, uint8_t mode);
+
+/**
+ * @brief Adds a buffer to a CRC.
+ *
+ * Feeds the CRC unit with one word per store. While an asynchronous update owns
+ * the unit the same CRC is computed in software, so this never waits for the DMA.
+ * Not to be called from interrupts.
+ *
+ * @param[in,out] crc Context.
+ * @param[in] data Buffer, any alignment.
+ * @param[in] length Number of bytes, a multiple of 4 for @ref CRC_MODE_WORDS.
+ *
+ * @return int8_t Returns 1 on success, 0 while an asynchronous update of `crc` runs, or -1 for an invalid length.
+ */
+int8_t CRC_Update(CRC_Context *crc, const void *data, size_t length);
+
+/**
+ * @brief Adds a large buffer to a CRC with the DMA feeding the CRC unit.
+ *
+ * The memory-to-memory engine copies the buffer into the data register while the
+ * CPU does other work, `callback` runs in its stream interrupt once the last word
+ * is in. @ref CRC_MODE_WORDS only, the DMA can neither swap nor reverse. Buffers
+ * shorter than `DMA_M2M_CPU_THRESHOLD` are done in place before returning.
+ * A transfer error is counted in `DMA_M2M_Errors`.
+ *
+ * @param[in,out] crc Context, `crc->Busy` until the callback.
+ * @param[in] data Buffer, 32-bit aligned, must stay valid until the callback.
+ * @param[in] length Number of bytes, a multiple of 4.
+ * @param[in] callback Called when done, may be NULL.
+ * @param[in] context Passed to `callback`.
+ *
+ * @return int8_t Returns 1 when started, 0 while the CRC unit or the DMA queue is taken, or -1 for an invalid buffer or mode.
+ */
+int8_t CRC_Update_Async(CRC_Context *crc, const void *data, size_t length, void (*callback)(void *context), void *context);
+
+/**
+ * @brief CRC of everything added so far, the context stays open for more.
+ *
+ * @param[in] crc Context, not busy.
+ *
+ * @return uint32_t CRC in the format of its mode.
+ */
+uint32_t CRC_Final(const CRC_Context *crc);
+
+/**
+ * @brief CRC of one buffer, @ref CRC_Start, @ref CRC_Update and @ref CRC_Final in one.
+ *
+ * @param[in] mode CRC_MODE_x.
+ * @param[in] data Buffer, any alignment.
+ * @param[in] length Number of bytes, a multiple of 4 for @ref CRC_MODE_WORDS.
+ *
+ * @return uint32_t CRC, 0 for an invalid length.
+ */
+uint32_t CRC_Compute(uint8_t mode, const void *data, size_t length);
+
+/** @brief True while a DMA feeds the CRC unit. */
+bool CRC_Busy(void);
+
+/* Register of the CRC unit over whole words, same as CRC_MODE_WORDS */
 uint32_t CRC_Compute_Single_Word(uint32_t word);
-uint32_t CRC_Compute_8Bit_Block(volatile uint8_t *wordBlock, size_t length);
 uint32_t CRC_Compute_32Bit_Block(volatile uint32_t *wordBlock, size_t length);
 uint32_t CRC_Compute_Flash_Data(volatile uint32_t Flash_Address, size_t length);
+
+/* Standard CRC-32 of a byte buffer, same as CRC_MODE_CRC32 */
+uint32_t CRC_Compute_8Bit_Block(volatile uint8_t *wordBlock, size_t length);
+
 #endif /* CRC_CRC_H_ */
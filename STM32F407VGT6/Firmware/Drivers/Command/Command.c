@@ -0,0 +1,124 @@
+/**
+ * @file Command.c
+ * @brief Text commands over the console.
+ *
+ * Implementation of the command table declared in @ref Command.h.
+ *
+ * @version 1.0
+ * @date 2025-06-10
+ *
+ * @author Kunal Salvi
+ */
+
+#define DEBUG_PRINTF 1
+
+#include "Command.h"
+#include "Console/Console.h"
+
+static const Command_Entry *command_table[COMMAND_MAX_ENTRIES];
+static uint8_t command_count = 0;
+
+static char command_line[COMMAND_LINE_LENGTH];
+static uint16_t command_length = 0;
+static bool command_overflow = false;
+
+
+static void Command_Help(int argc, char *argv[])
+{
+	(void)argc;
+	(void)argv;
+
+	printConsole("help       List the commands\r\n");
+	for(uint8_t index = 0; index < command_count; index++)
+	{
+		printConsole("%-10s %s\r\n", command_table[index]->Name, command_table[index]->Help);
+	}
+}
+
+int8_t Command_Register(const Command_Entry *entry)
+{
+	if(command_count >= COMMAND_MAX_ENTRIES) return -1;
+
+	command_table[command_count++] = entry;
+	return 1;
+}
+
+int8_t Command_Execute(char *line)
+{
+	char *argv[COMMAND_MAX_ARGUMENTS];
+	int argc = 0;
+	char *word = strtok(line, " \t");
+
+	while((word != NULL) && (argc < COMMAND_MAX_ARGUMENTS))
+	{
+		argv[argc++] = word;
+		word = strtok(NULL, " \t");
+	}
+
+	if(argc == 0) return 0;
+
+	if(strcmp(argv[0], "help") == 0)
+	{
+		Command_Help(argc, argv);
+		return 1;
+	}
+
+	for(uint8_t index = 0; index < command_count; index++)
+	{
+		if(strcmp(argv[0], command_table[index]->Name) == 0)
+		{
+			command_table[index]->Handler(argc, argv);
+			return 1;
+		}
+	}
+
+	printConsole("Unknown command '%s', try help\r\n", argv[0]);
+	return -1;
+}
+
+int8_t Command_Poll(void)
+{
+	USART_RX_Frame frame;
+	int8_t executed = 0;
+
+	// A terminal sends one frame per key stroke, lines are put together here
+	while(Console_Get_Frame(&frame) == 1)
+	{
+		for(uint8_t piece = 0; piece < 2; piece++)
+		{
+			for(uint16_t index = 0; index < frame.Length[piece]; index++)
+			{
+				char ch = (char)frame.Data[piece][index];
+
+				if((ch == '\r') || (ch == '\n'))
+				{
+					command_line[command_length] = '\0';
+
+					if(command_overflow)
+					{
+						printConsole("Line too long\r\n");
+					}
+					else if(Command_Execute(command_line) == 1)
+					{
+						executed = 1;
+					}
+
+					command_length = 0;
+					command_overflow = false;
+				}
+				else if(command_length < COMMAND_LINE_LENGTH - 1)
+				{
+					command_line[command_length++] = ch;
+				}
+				else
+				{
+					command_overflow = true;
+				}
+			}
+		}
+
+		Console_Release_Frame(&frame);
+	}
+
+	return executed;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file Command.h
+ * @brief Text commands over the console.
+ *
+ * Input received by the console is collected into lines; every line is split
+ * into words and the first word selects a registered command. The handler gets
+ * the words like `main` gets its arguments. `help` lists all commands.
+ *
+ * @code
+ * static void Uptime_Command(int argc, char *argv[])
+ * {
+ *     printConsole("%lu\r\n", uptime);
+ * }
+ *
+ * static const Command_Entry uptime_command = {"uptime", "Seconds since reset", Uptime_Command};
+ *
+ * Command_Register(&uptime_command);
+ *
+ * for(;;)
+ * {
+ *     Command_Poll();
+ *     ...
+ * }
+ * @endcode
+ *
+ * @version 1.0
+ * @date 2025-06-10
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef COMMAND_COMMAND_H_
+#define COMMAND_COMMAND_H_
+
+#include "main.h"
+
+#define COMMAND_MAX_ENTRIES			16
+#define COMMAND_MAX_ARGUMENTS		8
+#define COMMAND_LINE_LENGTH			128
+
+/** @struct Command_Entry
+ *  @brief  A named command, must stay valid while registered.
+ */
+typedef struct Command_Entry{
+	const char *Name;
+	const char *Help;
+	void (*Handler)(int argc, char *argv[]);
+}Command_Entry;
+
+/**
+ * @brief Adds a command to the command table.
+ *
+ * @param[in] entry Command.
+ *
+ * @return int8_t Returns 1 on success, or -1 if the table is full.
+ */
+int8_t Command_Register(const Command_Entry *entry);
+
+/**
+ * @brief Runs the command in a line.
+ *
+ * @param[in,out] line Null terminated line, split in place.
+ *
+ * @return int8_t Returns 1 if a command ran, 0 for an empty line, -1 for an unknown command.
+ */
+int8_t Command_Execute(char *line);
+
+/**
+ * @brief Collects console input and runs every complete line.
+ *
+ * Never waits, call it from the main loop.
+ *
+ * @return int8_t Returns 1 if a command ran, 0 otherwise.
+ */
+int8_t Command_Poll(void);
+
+#endif /* COMMAND_COMMAND_H_ */
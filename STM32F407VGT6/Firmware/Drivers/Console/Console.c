@@ -4,15 +4,15 @@
 #include "CRC/CRC.h"
 #include "USART/USART.h"
 
-// Flags to control and monitor UART reception
-volatile int rx_get_flag = 0; // Indicates if the reception is active
-volatile int rx_flag = 0;     // Indicates if data reception is complete
+#define RX_Buffer_Length 200 // Length of the transmission buffer and of one input line
+#define RX_Ring_Length 512   // Length of the circular reception ring
 
-#define RX_Buffer_Length 200 // Length of the reception buffer
+volatile uint8_t TRX_Buffer[RX_Buffer_Length]; // Buffer for transmitted data
+char RX_Line[RX_Buffer_Length];                // Input line handed to vsscanf
 
-// Variables to track the length of received data and the reception buffer
-volatile int RX_Length = 0;
-volatile uint8_t TRX_Buffer[RX_Buffer_Length]; // Buffer for received and transmitted data
+// Circular DMA reception, runs for as long as the console is up
+volatile uint8_t RX_Ring_Buffer[RX_Ring_Length];
+USART_RX_Ring console_rx;
 
 // USART configuration structure
 USART_Config serial;
@@ -54,35 +54,6 @@ USART_Config serial;
 //    }
 //}
 
-void Console_IRQ(void){
-    if (rx_get_flag == 1) { // Check if reception is active
-        (void)UART4->SR; // Read the status register to clear flags
-        (void)UART4->DR; // Read the data register to clear flags
-
-        __disable_irq(); // Disable interrupts to safely update DMA configurations
-
-        // Disable DMA stream
-        serial.USART_DMA_Instance_RX.Request.Stream->CR &= ~DMA_SxCR_EN;
-
-        // Calculate the length of received data
-        RX_Length = RX_Buffer_Length - serial.USART_DMA_Instance_RX.Request.Stream->NDTR;
-
-        // Prevent buffer overflow
-        if (RX_Length > RX_Buffer_Length) {
-            RX_Length = RX_Buffer_Length;
-        }
-
-        // Reset DMA stream for the next reception
-        serial.USART_DMA_Instance_RX.Request.Stream->NDTR = RX_Buffer_Length;
-        serial.USART_DMA_Instance_RX.Request.Stream->CR |= DMA_SxCR_EN;
-
-        __enable_irq(); // Re-enable interrupts
-
-        rx_flag = 1; // Set the flag indicating data reception is complete
-    }
-}
-
-
 /**
  * @brief Initializes the console with a specified baud rate.
  *
@@ -104,11 +75,13 @@ void Console_Init(int32_t baudrate) {
     serial.RX_Pin = UART4_RX_Pin.PC11; // RX pin is PC11
     serial.interrupt = USART_Configuration.Interrupt_Type.IDLE_Enable; // Enable IDLE interrupt
     serial.dma_enable = USART_Configuration.DMA_Enable.TX_Enable | USART_Configuration.DMA_Enable.RX_Enable; // Enable DMA for TX and RX
-    serial.ISR_Routines.Idle_Line_ISR = Console_IRQ;
     // Initialize USART
     if (USART_Init(&serial) != true) {
         // Handle USART initialization failure (e.g., log error or halt execution)
     }
+
+    // Keep receiving in the background, idle line marks the end of an input
+    USART_RX_Ring_Start(&serial, &console_rx, RX_Ring_Buffer, RX_Ring_Length);
 }
 
 
@@ -139,6 +112,48 @@ void Console_Init(int32_t baudrate) {
      va_end(args);
  }
 
+ /**
+  * @brief Sends raw bytes to the console.
+  *
+  * The buffer is handed to the UART DMA as is, no formatting and no copy
+  * into the transmission buffer.
+  *
+  * @param data Bytes to send.
+  * @param length Number of bytes to send.
+  */
+ void Console_Write(const uint8_t *data, uint16_t length) {
+     USART_TX_Buffer(&serial, (uint8_t *)data, length);
+ }
+
+ /**
+  * @brief Queues raw bytes on the console.
+  *
+  * Returns as soon as the buffer is queued, the UART DMA chains it behind
+  * anything already being sent.
+  *
+  * @param data Bytes to send.
+  * @param length Number of bytes to send.
+  * @param complete Called once the bytes are sent, may be NULL.
+  * @param context Passed to `complete`.
+  * @return 1 if queued, 0 if dropped, -1 on error.
+  */
+ int8_t Console_Write_Async(const uint8_t *data, uint16_t length, void (*complete)(void *context), void *context) {
+     return USART_TX_Buffer_Async(&serial, data, length, complete, context);
+ }
+
+ /**
+  * @brief Sends raw bytes ahead of everything queued on the console.
+  *
+  * @param data Bytes to send.
+  * @param length Number of bytes to send.
+  * @param complete Called once the bytes are sent, may be NULL.
+  * @param context Passed to `complete`.
+  * @return 1 if accepted, 0 if the previous urgent buffer is not sent yet, -1 on error.
+  */
+ int8_t Console_Write_Urgent(const uint8_t *data, uint16_t length, void (*complete)(void *context), void *context) {
+     return USART_TX_Buffer_Urgent(&serial, data, length, complete, context);
+ }
+
 //int readConsole(const char *msg, ...)
 //{
 //	va_list args;
@@ -158,11 +173,31 @@ void Console_Init(int32_t baudrate) {
 
 
 
+ /**
+  * @brief Returns the oldest complete input without copying it.
+  *
+  * @param frame View of the input inside the reception ring.
+  * @return 1 if an input was available, 0 otherwise.
+  */
+ int8_t Console_Get_Frame(USART_RX_Frame *frame) {
+     return USART_RX_Get_Frame(&console_rx, frame);
+ }
+
+ /**
+  * @brief Hands an input obtained from `Console_Get_Frame` back to the ring.
+  *
+  * @param frame Input to release.
+  */
+ void Console_Release_Frame(const USART_RX_Frame *frame) {
+     USART_RX_Release_Frame(&console_rx, frame);
+ }
+
  /**
   * @brief Reads a formatted input from the console.
   *
-  * This function waits for user input, processes it using `vsscanf`,
-  * and stores the parsed data in the provided variables.
+  * This function waits for the next input line, processes it using `vsscanf`,
+  * and stores the parsed data in the provided variables. Input that arrives
+  * while nobody is reading stays queued in the reception ring.
   *
   * @param msg Format string for the expected input.
   * @param ... Pointers to variables where the input data will be stored.
@@ -171,37 +206,31 @@ void Console_Init(int32_t baudrate) {
  int readConsole(const char *msg, ...) {
      va_list args;
      int result;
+     USART_RX_Frame frame;
 
-     rx_get_flag = 1; // Enable reception
+     // Wait until an input line is complete
+     while (USART_RX_Get_Frame(&console_rx, &frame) != 1) {
+         // Wait loop
+     }
 
-     // Start DMA reception
-     USART_RX_Buffer(&serial, (uint8_t *)TRX_Buffer, RX_Buffer_Length, 0);
+     uint16_t length = USART_RX_Frame_Copy(&frame, (uint8_t *)RX_Line, RX_Buffer_Length - 1);
+     USART_RX_Release_Frame(&console_rx, &frame);
 
-     // Wait until data reception is complete
-     while (rx_flag == 0) {
-         // Wait loop
+     // Strip the line ending and null-terminate the received string
+     while ((length > 0) && ((RX_Line[length - 1] == '\r') || (RX_Line[length - 1] == '\n'))) {
+         length--;
      }
+     RX_Line[length] = '\0';
 
      // Check for valid input length
-     if (RX_Length < 2) {
-         // Reset flags and return error
-         rx_get_flag = 0;
-         rx_flag = 0;
+     if (length == 0) {
          return -1;
      }
 
-     // Null-terminate the received string
-     TRX_Buffer[RX_Length - 1] = '\0';
-
      // Parse the input using the format string
      va_start(args, msg);
-     result = vsscanf((char *)TRX_Buffer, msg, args);
+     result = vsscanf(RX_Line, msg, args);
      va_end(args);
 
-     // Reset reception flags
-     rx_get_flag = 0;
-     rx_flag = 0;
-
      return result;
  }
-
@@ -29,7 +29,9 @@
  * - UART initialization with custom baud rate
  * - Formatted printing using `printConsole`
  * - Formatted input using `readConsole`
- * - DMA-based UART reception for high efficiency
+ * - Raw binary output using `Console_Write` and the non-blocking `Console_Write_Async`
+ * - Continuous circular DMA reception, input is never lost between reads
+ * - Zero-copy access to received input with `Console_Get_Frame`
  * - Designed to support common debugging and communication tasks
  *
  * @section dependencies_sec Dependencies
@@ -101,12 +103,69 @@ void Console_Init(int32_t baudrate);
  */
 void printConsole(char *msg, ...);
 
+/**
+ * @brief Sends raw bytes over the console.
+ *
+ * Unlike `printConsole` the data is not formatted or copied, it is sent
+ * straight from `data` using DMA. Used for binary telemetry frames.
+ *
+ * @param data Bytes to send.
+ * @param length Number of bytes to send.
+ */
+void Console_Write(const uint8_t *data, uint16_t length);
+
+/**
+ * @brief Queues raw bytes for transmission and returns immediately.
+ *
+ * The buffer is queued on the console UART and sent by DMA in the background.
+ * It must not be modified until `complete` has been called.
+ *
+ * @param data Bytes to send.
+ * @param length Number of bytes to send.
+ * @param complete Called from the DMA interrupt once the bytes are sent, may be NULL.
+ * @param context Passed to `complete`.
+ * @return 1 if queued, 0 if dropped because the queue is full, -1 on error.
+ */
+int8_t Console_Write_Async(const uint8_t *data, uint16_t length, void (*complete)(void *context), void *context);
+
+/**
+ * @brief Sends raw bytes ahead of everything queued on the console.
+ *
+ * Meant for rare and short messages such as alarms. The bytes go out as soon as
+ * the transfer in flight has completed. Only one urgent buffer can be pending.
+ *
+ * @param data Bytes to send.
+ * @param length Number of bytes to send.
+ * @param complete Called from the DMA interrupt once the bytes are sent, may be NULL.
+ * @param context Passed to `complete`.
+ * @return 1 if accepted, 0 if the previous urgent buffer is not sent yet, -1 on error.
+ */
+int8_t Console_Write_Urgent(const uint8_t *data, uint16_t length, void (*complete)(void *context), void *context);
+
+/**
+ * @brief Returns the oldest complete input without copying it.
+ *
+ * An input ends when the line goes idle. The bytes stay in the reception ring
+ * until `Console_Release_Frame` is called.
+ *
+ * @param frame View of the input inside the reception ring.
+ * @return 1 if an input was available, 0 otherwise.
+ */
+int8_t Console_Get_Frame(USART_RX_Frame *frame);
+
+/**
+ * @brief Hands an input obtained from `Console_Get_Frame` back to the ring.
+ *
+ * @param frame Input to release.
+ */
+void Console_Release_Frame(const USART_RX_Frame *frame);
+
 /**
  * @brief Reads a formatted input from the console.
  *
- * This function waits for user input, processes it using `vsscanf`,
- * and stores the result in the provided variables. DMA is used for
- * efficient data reception.
+ * This function waits for the next input line, processes it using `vsscanf`,
+ * and stores the result in the provided variables. Input is received in the
+ * background by a circular DMA.
  *
  * @param msg Format string for the expected input.
  * @param ... Pointers to variables where the input data will be stored.
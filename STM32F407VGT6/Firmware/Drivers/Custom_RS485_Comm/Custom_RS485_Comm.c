@@ -1,111 +1,224 @@
 
 #include "Custom_RS485_Comm.h"
 
-// Flags to control and monitor UART reception
-volatile int custom_rx_get_flag = 0; // Indicates if the reception is active
-volatile int custom_rx_flag = 0;     // Indicates if data reception is complete
+#define Custom_RX_Ring_Length 512 // Length of the circular reception ring
 
-#define Custom_RX_Buffer_Length 300 // Length of the reception buffer
-
-// Variables to track the length of received data and the reception buffer
-volatile int Custom_RX_Length = 0;
-volatile uint8_t Custom_TRX_Buffer[Custom_RX_Buffer_Length]; // Buffer for received and transmitted data
+// Circular DMA reception, frames are separated by idle line
+volatile uint8_t Custom_RX_Ring_Buffer[Custom_RX_Ring_Length];
+USART_RX_Ring Custom_Comm_RX;
 
 // USART configuration structure
 USART_Config Custom_Comm;
+Custom_Comm_Config Custom_Comm_Bus;
 
-void Custom_Console_IRQ(void){
-	if (custom_rx_get_flag == 1) { // Check if reception is active
-		(void)UART4->SR; // Read the status register to clear flags
-		(void)UART4->DR; // Read the data register to clear flags
+// Set from the start of a frame until DE has been dropped after its last stop bit
+static volatile bool Custom_Comm_Transmitting = false;
 
-		__disable_irq(); // Disable interrupts to safely update DMA configurations
+// Frames of this side, the CRC unit reads them as words
+static uint32_t Custom_TX_Frame[RS485_FRAME_MAX / 4];
+static uint32_t Custom_RX_Frame[RS485_FRAME_MAX / 4];
 
-		// Disable DMA stream
-		Custom_Comm.USART_DMA_Instance_RX.Request.Stream->CR &= ~DMA_SxCR_EN;
 
-		// Calculate the length of received data
-		Custom_RX_Length = Custom_RX_Buffer_Length - Custom_Comm.USART_DMA_Instance_RX.Request.Stream->NDTR;
+/* Last byte left the shift register, release the bus */
+static void Custom_Comm_TX_Complete_ISR(void)
+{
+	// The flag is also seen on idle line interrupts, only the end of a frame counts
+	if(!(Custom_Comm.Port->CR1 & USART_CR1_TCIE)) return;
 
-		// Prevent buffer overflow
-		if (Custom_RX_Length > Custom_RX_Buffer_Length) {
-			Custom_RX_Length = Custom_RX_Buffer_Length;
-		}
+	Custom_Comm.Port->CR1 &= ~USART_CR1_TCIE;
+	GPIO_Pin_Low(Custom_Comm_Bus.DE_Port, Custom_Comm_Bus.DE_Pin);
+	Custom_Comm_Transmitting = false;
+}
 
-		// Reset DMA stream for the next reception
-		Custom_Comm.USART_DMA_Instance_RX.Request.Stream->NDTR = Custom_RX_Buffer_Length;
-		Custom_Comm.USART_DMA_Instance_RX.Request.Stream->CR |= DMA_SxCR_EN;
+/* DMA handed over the last byte, the USART still has to shift it out */
+static void Custom_Comm_TX_Done(void *context)
+{
+	Custom_Comm.Port->CR1 |= USART_CR1_TCIE;
+}
 
-		__enable_irq(); // Re-enable interrupts
 
-		custom_rx_flag = 1; // Set the flag indicating data reception is complete
-	}
+void Custom_Comm_Config_Reset(Custom_Comm_Config *config)
+{
+	config->Port = USART1;
+	config->TX_Pin = USART1_TX_Pin.PB6;
+	config->RX_Pin = USART1_RX_Pin.PB7;
+	config->DE_Port = GPIOA;
+	config->DE_Pin = 8;
+	config->Baudrate = 115200;
+	config->Timeout_us = 10000;	// Node turnaround plus a response of about 100 bytes
 }
 
 
-void Custom_Comm_Init(int32_t baudrate) {
+int8_t Custom_Comm_Init(const Custom_Comm_Config *config) {
+	if((config->Port != USART1) && (config->Port != UART4)) return -1;
+
+	Custom_Comm_Bus = *config;
+
+	// Receiver side until the first frame is sent
+	GPIO_Pin_Init(config->DE_Port, config->DE_Pin, GPIO_Configuration.Mode.General_Purpose_Output,
+			GPIO_Configuration.Output_Type.Push_Pull,
+			GPIO_Configuration.Speed.Very_High_Speed,
+			GPIO_Configuration.Pull.No_Pull_Up_Down,
+			GPIO_Configuration.Alternate_Functions.None);
+	GPIO_Pin_Low(config->DE_Port, config->DE_Pin);
+
 	// Reset USART configuration to default values
 	USART_Config_Reset(&Custom_Comm);
 
 	// Configure USART parameters
-	Custom_Comm.Port = UART4; // Use UART4 for console communication
-	Custom_Comm.baudrate = baudrate; // Set the baud rate
+	Custom_Comm.Port = config->Port;
+	Custom_Comm.baudrate = config->Baudrate; // Set the baud rate
 	Custom_Comm.mode = USART_Configuration.Mode.Asynchronous; // Asynchronous mode
 	Custom_Comm.stop_bits = USART_Configuration.Stop_Bits.Bit_1; // 1 stop bit
-	Custom_Comm.TX_Pin = UART4_TX_Pin.PC10; // TX pin is PC10
-	Custom_Comm.RX_Pin = UART4_RX_Pin.PC11; // RX pin is PC11
+	Custom_Comm.TX_Pin = config->TX_Pin;
+	Custom_Comm.RX_Pin = config->RX_Pin;
 	Custom_Comm.interrupt = USART_Configuration.Interrupt_Type.IDLE_Enable; // Enable IDLE interrupt
 	Custom_Comm.dma_enable = USART_Configuration.DMA_Enable.TX_Enable | USART_Configuration.DMA_Enable.RX_Enable; // Enable DMA for TX and RX
-	Custom_Comm.ISR_Routines.Idle_Line_ISR = Custom_Console_IRQ;
+	Custom_Comm.ISR_Routines.Transmission_Complete_ISR = Custom_Comm_TX_Complete_ISR;
 	// Initialize USART
-	if (USART_Init(&Custom_Comm) != true) {}
+	if (USART_Init(&Custom_Comm) != true) return -1;
+
+	CRC_Init();
+
+	return USART_RX_Ring_Start(&Custom_Comm, &Custom_Comm_RX, Custom_RX_Ring_Buffer, Custom_RX_Ring_Length);
 }
 
 
-void Custom_Comm_Send(volatile uint8_t *buffer, size_t buffer_size) {
+int8_t Custom_Comm_Send(const uint8_t *buffer, uint16_t length) {
+	if(Custom_Comm_Transmitting) return 0;
 
-	if(buffer_size == 1)
+	Custom_Comm_Transmitting = true;
+	GPIO_Pin_High(Custom_Comm_Bus.DE_Port, Custom_Comm_Bus.DE_Pin);
+
+	// A stale flag from the previous frame would drop DE at the first byte
+	Custom_Comm.Port->SR &= ~USART_SR_TC;
+
+	if(USART_TX_Buffer_Async(&Custom_Comm, buffer, length, Custom_Comm_TX_Done, NULL) != 1)
 	{
-		USART_TX_Single_Byte(&Custom_Comm, buffer[0]);
+		GPIO_Pin_Low(Custom_Comm_Bus.DE_Port, Custom_Comm_Bus.DE_Pin);
+		Custom_Comm_Transmitting = false;
+		return -1;
 	}
 
-	// Transmit the buffer using DMA
-	USART_TX_Buffer(&Custom_Comm, (uint8_t *)&buffer[0], buffer_size);
+	return 1;
+}
 
+
+bool Custom_Comm_Busy(void)
+{
+	return Custom_Comm_Transmitting;
 }
 
 
-uint16_t Custom_Comm_Receive(volatile uint8_t *buffer)
+void Custom_Comm_Set_Frame_Callback(void (*callback)(void))
 {
-	int result;
+	Custom_Comm_RX.Frame_Received_ISR = callback;
+}
+
 
-	custom_rx_get_flag = 1; // Enable reception
+int8_t Custom_Comm_Get_Frame(USART_RX_Frame *frame)
+{
+	return USART_RX_Get_Frame(&Custom_Comm_RX, frame);
+}
 
-	// Start DMA reception
-	USART_RX_Buffer(&Custom_Comm, (uint8_t *)Custom_TRX_Buffer, Custom_RX_Buffer_Length, 0);
 
-	// Wait until data reception is complete
-	while (custom_rx_flag == 0) {
-		// Wait loop
+void Custom_Comm_Release_Frame(const USART_RX_Frame *frame)
+{
+	USART_RX_Release_Frame(&Custom_Comm_RX, frame);
+}
+
+
+uint16_t Custom_Comm_Receive(uint8_t *buffer, uint16_t size, uint32_t timeout_us)
+{
+	USART_RX_Frame frame;
+	uint16_t result;
+	uint64_t start = Timebase_Micros();
+
+	// Wait until a frame is complete
+	while (USART_RX_Get_Frame(&Custom_Comm_RX, &frame) != 1) {
+		if((Timebase_Micros() - start) >= timeout_us) return 0;
 	}
 
-	// Check for valid input length
-	if (Custom_RX_Length < 2) {
-		// Reset flags and return error
-		custom_rx_get_flag = 0;
-		custom_rx_flag = 0;
-		return -1;
+	result = USART_RX_Frame_Copy(&frame, buffer, size);
+	USART_RX_Release_Frame(&Custom_Comm_RX, &frame);
+
+	return result;
+}
+
+
+uint32_t Custom_Comm_CRC(const uint32_t *words, uint32_t count)
+{
+	return CRC_Compute(CRC_MODE_WORDS, words, count * 4);
+}
+
+
+int8_t Custom_Comm_Transaction(RS485_Host *host, uint8_t address, uint8_t function, const uint8_t *request, uint8_t length,
+		uint8_t *response, RS485_Header *header, const uint8_t **payload)
+{
+	uint8_t *frame = (uint8_t *)Custom_TX_Frame;
+	USART_RX_Frame stale;
+
+	// Anything still in the ring belongs to an earlier transaction
+	while(USART_RX_Get_Frame(&Custom_Comm_RX, &stale) == 1) USART_RX_Release_Frame(&Custom_Comm_RX, &stale);
+
+	uint16_t size = RS485_Host_Request(host, frame, address, function, request, length);
+
+	if((size == 0) || (Custom_Comm_Send(frame, size) != 1)) return -1;
+
+	// The timeout starts once the request has left the bus
+	uint64_t start = Timebase_Micros();
+	uint64_t limit = (uint64_t)RS485_Transaction_us(Custom_Comm_Bus.Baudrate, length, 0, 0) * 2;
+
+	while(Custom_Comm_Transmitting)
+	{
+		if((Timebase_Micros() - start) >= limit) return -1;
 	}
 
-	result = Custom_RX_Length;
+	if(address == RS485_ADDRESS_BROADCAST) return 1;
 
-	DMA_Memory_To_Memory_Transfer(Custom_TRX_Buffer, 8,1,  buffer, 8, 1, Custom_RX_Length);
+	start = Timebase_Micros();
 
-	custom_rx_get_flag = 0; // Indicates if the reception is active
-	custom_rx_flag = 0;
+	while(1)
+	{
+		uint64_t elapsed = Timebase_Micros() - start;
 
+		if(elapsed >= Custom_Comm_Bus.Timeout_us) break;
 
-	return result;
+		uint16_t received = Custom_Comm_Receive(response, RS485_FRAME_MAX, Custom_Comm_Bus.Timeout_us - (uint32_t)elapsed);
 
+		if(received == 0) break;
+
+		// Echo of the request or a late answer is skipped
+		int8_t result = RS485_Host_Response(host, frame, response, received, header, payload);
+
+		if(result != 0) return result;
+	}
+
+	host->Timeouts++;
+	return 0;
+}
+
+
+uint8_t Custom_Comm_Node_Poll(RS485_Node *node)
+{
+	uint8_t *request = (uint8_t *)Custom_RX_Frame;
+	uint8_t *response = (uint8_t *)Custom_TX_Frame;
+	USART_RX_Frame frame;
+	uint8_t responses = 0;
+
+	while(USART_RX_Get_Frame(&Custom_Comm_RX, &frame) == 1)
+	{
+		uint16_t received = USART_RX_Frame_Copy(&frame, request, RS485_FRAME_MAX);
+
+		USART_RX_Release_Frame(&Custom_Comm_RX, &frame);
+
+		// The response buffer is still on the bus, the host would not wait for it anyway
+		if(Custom_Comm_Transmitting) continue;
+
+		uint16_t size = RS485_Node_Process(node, request, received, response);
+
+		if((size != 0) && (Custom_Comm_Send(response, size) == 1)) responses++;
+	}
 
+	return responses;
 }
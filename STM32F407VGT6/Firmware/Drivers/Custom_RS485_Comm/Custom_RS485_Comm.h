@@ -12,10 +12,62 @@
 #include "GPIO/GPIO.h"
 #include "USART/USART.h"
 #include "DMA/DMA.h"
+#include "CRC/CRC.h"
+#include "Timebase/Timebase.h"
+#include "Custom_RS485_Comm/RS485_Protocol.h"
 
-void Custom_Comm_Init(int32_t baudrate);
-void Custom_Comm_Send(volatile uint8_t *buffer, size_t buffer_size);
-uint16_t Custom_Comm_Receive(volatile uint8_t *buffer);
+/*
+ * Half-duplex RS485 transceiver on its own USART, separate from the console.
+ *
+ * DE (and ~RE, when both are tied) is raised before a frame is handed to the DMA
+ * and dropped in the USART transmission complete interrupt, right after the stop
+ * bit of the last byte, so the bus is free for the answer without a fixed delay.
+ * Only USART1 and UART4 have their interrupt handlers, UART4 is the console.
+ */
+typedef struct Custom_Comm_Config
+{
+	USART_TypeDef *Port;
+	uint8_t TX_Pin;
+	uint8_t RX_Pin;
+	GPIO_TypeDef *DE_Port;
+	uint8_t DE_Pin;
+	uint32_t Baudrate;
+	uint32_t Timeout_us;		// Wait of the host for a complete response after the end of its request, see RS485_Transaction_us
+}Custom_Comm_Config;
+
+/* USART1 on PB6 / PB7, DE on PA8, 115200 baud, 10 ms response timeout */
+void Custom_Comm_Config_Reset(Custom_Comm_Config *config);
+int8_t Custom_Comm_Init(const Custom_Comm_Config *config);
+
+/* Starts sending a frame, returns 0 while the previous one is still on the bus. The buffer has to stay valid until Custom_Comm_Busy returns false */
+int8_t Custom_Comm_Send(const uint8_t *buffer, uint16_t length);
+bool Custom_Comm_Busy(void);
+
+/* Copies the next received frame, returns its length or 0 if none arrived within timeout_us */
+uint16_t Custom_Comm_Receive(uint8_t *buffer, uint16_t size, uint32_t timeout_us);
+
+/* Called from the idle line interrupt after every frame, e.g. to signal the task that serves the bus */
+void Custom_Comm_Set_Frame_Callback(void (*callback)(void));
+
+/* Zero-copy access to received frames, release each frame once it is processed */
+int8_t Custom_Comm_Get_Frame(USART_RX_Frame *frame);
+void Custom_Comm_Release_Frame(const USART_RX_Frame *frame);
+
+/* CRC unit over 32-bit words, the CRC of RS485_Host and RS485_Node on the target */
+uint32_t Custom_Comm_CRC(const uint32_t *words, uint32_t count);
+
+/*
+ * Host side: sends a request and waits for its response, at most Timeout_us after
+ * the request has left the bus. `response` is a 32-bit aligned buffer of
+ * RS485_FRAME_MAX bytes that receives the response frame, `payload` points into it.
+ * Returns 1 for a response or a sent broadcast, 0 on timeout, -1 for a corrupted
+ * response or a request that could not be sent.
+ */
+int8_t Custom_Comm_Transaction(RS485_Host *host, uint8_t address, uint8_t function, const uint8_t *request, uint8_t length,
+		uint8_t *response, RS485_Header *header, const uint8_t **payload);
+
+/* Node side: serves every received frame and sends the responses, returns the number of responses sent */
+uint8_t Custom_Comm_Node_Poll(RS485_Node *node);
 
 
 #endif /* CUSTOM_RS485_COMM_CUSTOM_RS485_COMM_H_ */
@@ -0,0 +1,141 @@
+/**
+ * @file RS485_Protocol.c
+ * @brief Addressed request / response frames for a multi-drop RS485 bus.
+ *
+ * Implementation of the framing declared in @ref RS485_Protocol.h. Has no
+ * hardware dependency, the CRC comes in as a function.
+ *
+ * @version 1.0
+ * @date 2025-06-19
+ *
+ * @author Kunal Salvi
+ */
+
+#include "RS485_Protocol.h"
+
+
+uint16_t RS485_Finish(uint8_t *frame, uint8_t address, uint8_t function, uint8_t sequence, uint8_t length, RS485_CRC crc)
+{
+	if(length > RS485_MAX_PAYLOAD) return 0;
+
+	RS485_Header *header = (RS485_Header *)frame;
+	uint16_t padded = (length + 3) & ~3;
+
+	header->Address = address;
+	header->Function = function;
+	header->Sequence = sequence;
+	header->Length = length;
+
+	// Zero the padding so the CRC is reproducible
+	memset(&frame[RS485_HEADER_SIZE + length], 0, padded - length);
+
+	uint32_t words = (RS485_HEADER_SIZE + padded) / 4;
+	uint32_t value = crc((const uint32_t *)frame, words);
+
+	memcpy(&frame[words * 4], &value, RS485_CRC_SIZE);
+
+	return RS485_FRAME_SIZE(length);
+}
+
+int8_t RS485_Parse(const uint8_t *frame, uint16_t size, RS485_Header *header, const uint8_t **payload, RS485_CRC crc)
+{
+	if(size < RS485_FRAME_SIZE(0)) return -1;
+
+	memcpy(header, frame, RS485_HEADER_SIZE);
+
+	if((header->Length > RS485_MAX_PAYLOAD) || (size != RS485_FRAME_SIZE(header->Length))) return -1;
+
+	uint32_t words = (size - RS485_CRC_SIZE) / 4;
+	uint32_t value;
+
+	memcpy(&value, &frame[words * 4], RS485_CRC_SIZE);
+	if(crc((const uint32_t *)frame, words) != value) return -1;
+
+	*payload = &frame[RS485_HEADER_SIZE];
+	return 1;
+}
+
+uint16_t RS485_Node_Process(RS485_Node *node, const uint8_t *frame, uint16_t size, uint8_t *response)
+{
+	RS485_Header header;
+	const uint8_t *payload;
+
+	if(RS485_Parse(frame, size, &header, &payload, node->Crc) != 1)
+	{
+		node->Errors++;
+		return 0;
+	}
+
+	// Answers of other nodes, or this node's own echo
+	if(header.Function & RS485_FUNCTION_RESPONSE) return 0;
+	if((header.Address != node->Address) && (header.Address != RS485_ADDRESS_BROADCAST)) return 0;
+
+	node->Requests++;
+
+	const RS485_Handler *handler = NULL;
+	for(uint8_t i = 0; i < node->Handler_Count; i++)
+	{
+		if(node->Handlers[i].Function == header.Function)
+		{
+			handler = &node->Handlers[i];
+			break;
+		}
+	}
+
+	uint8_t *data = &response[RS485_HEADER_SIZE];
+	int16_t length = (handler != NULL) ? handler->Handle(payload, header.Length, data, handler->Context) : -RS485_ERROR_FUNCTION;
+
+	if(header.Address == RS485_ADDRESS_BROADCAST) return 0;
+
+	uint8_t function = header.Function | RS485_FUNCTION_RESPONSE;
+
+	if((length < 0) || (length > RS485_MAX_PAYLOAD))
+	{
+		data[0] = (length < 0) ? (uint8_t)(-length) : RS485_ERROR_REQUEST;
+		function |= RS485_FUNCTION_ERROR;
+		length = 1;
+	}
+
+	node->Responses++;
+	return RS485_Finish(response, node->Address, function, header.Sequence, (uint8_t)length, node->Crc);
+}
+
+uint16_t RS485_Host_Request(RS485_Host *host, uint8_t *frame, uint8_t address, uint8_t function, const uint8_t *payload, uint8_t length)
+{
+	if(length > RS485_MAX_PAYLOAD) return 0;
+
+	if(length != 0) memcpy(&frame[RS485_HEADER_SIZE], payload, length);
+
+	host->Sequence++;
+	host->Transactions++;
+
+	return RS485_Finish(frame, address, function & ~(RS485_FUNCTION_RESPONSE | RS485_FUNCTION_ERROR), host->Sequence, length, host->Crc);
+}
+
+int8_t RS485_Host_Response(RS485_Host *host, const uint8_t *request, const uint8_t *frame, uint16_t size,
+		RS485_Header *header, const uint8_t **payload)
+{
+	const RS485_Header *sent = (const RS485_Header *)request;
+
+	if(RS485_Parse(frame, size, header, payload, host->Crc) != 1)
+	{
+		host->Errors++;
+		return -1;
+	}
+
+	// Own request echoed, or a late answer to an earlier one
+	if(!(header->Function & RS485_FUNCTION_RESPONSE)) return 0;
+	if((header->Address != sent->Address) || (header->Sequence != sent->Sequence)) return 0;
+	if((header->Function & ~(RS485_FUNCTION_RESPONSE | RS485_FUNCTION_ERROR)) != sent->Function) return 0;
+
+	if(header->Function & RS485_FUNCTION_ERROR) host->Errors++;
+
+	return 1;
+}
+
+uint32_t RS485_Transaction_us(uint32_t baudrate, uint8_t request, uint8_t response, uint32_t turnaround)
+{
+	uint32_t bits = 10UL * (RS485_FRAME_SIZE(request) + RS485_FRAME_SIZE(response));
+
+	return (uint32_t)(((uint64_t)bits * 1000000ULL + baudrate - 1) / baudrate) + turnaround;
+}
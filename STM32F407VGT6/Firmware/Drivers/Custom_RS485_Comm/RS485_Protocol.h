@@ -0,0 +1,213 @@
+/**
+ * @file RS485_Protocol.h
+ * @brief Addressed request / response frames for a multi-drop RS485 bus.
+ *
+ * One host polls up to 247 nodes. Every exchange is a request from the host
+ * followed by at most one response from the addressed node, so only one
+ * transmitter drives the bus at a time. Frames are delimited by the idle line
+ * and are
+ *
+ * | Offset | Size | Field                                                     |
+ * |--------|------|-----------------------------------------------------------|
+ * | 0      | 1    | Node address, @ref RS485_ADDRESS_BROADCAST for all nodes  |
+ * | 1      | 1    | Function, @ref RS485_FUNCTION_RESPONSE set in responses   |
+ * | 2      | 1    | Sequence number, echoed in the response                   |
+ * | 3      | 1    | Payload length n, at most @ref RS485_MAX_PAYLOAD          |
+ * | 4      | n    | Payload, zero padded to a multiple of 4                   |
+ * | 4 + p  | 4    | CRC                                                       |
+ *
+ * The CRC is the one of the telemetry frames: polynomial 0x04C11DB7, initial
+ * value 0xFFFFFFFF, over the header and padded payload as little endian 32-bit
+ * words, no reflection, no final XOR. On the target it comes from the CRC unit,
+ * the module itself only calls the function it is given, so the framing and the
+ * node and host logic run unchanged on a PC against a simulated bus.
+ *
+ * Broadcast requests are executed by every node and never answered. A node
+ * ignores frames with @ref RS485_FUNCTION_RESPONSE set, so the responses of
+ * other nodes, and its own echo on a bus with the receiver always enabled, are
+ * never taken for requests. An error response carries @ref RS485_FUNCTION_ERROR
+ * and a single byte error code.
+ *
+ * Functions of the DAQ nodes, all values little endian:
+ *
+ * | Function                    | Request               | Response                                      |
+ * |-----------------------------|-----------------------|-----------------------------------------------|
+ * | @ref RS485_FUNCTION_PING    | -                     | Protocol version, channels                    |
+ * | @ref RS485_FUNCTION_READ    | uint16 channel mask   | uint64 time (ns), uint16 mask, int16 0.01 °C per channel in the mask |
+ * | @ref RS485_FUNCTION_ALARMS  | -                     | uint16 high, low and rate of rise alarm masks |
+ *
+ * A channel mask of 0 reads every channel, so a single request per node and
+ * cycle fetches the whole scan.
+ *
+ * @version 1.0
+ * @date 2025-06-19
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef CUSTOM_RS485_COMM_RS485_PROTOCOL_H_
+#define CUSTOM_RS485_COMM_RS485_PROTOCOL_H_
+
+#include "main.h"
+
+#define RS485_VERSION				1
+
+#define RS485_ADDRESS_BROADCAST		0x00
+#define RS485_ADDRESS_MAX			247
+
+#define RS485_HEADER_SIZE			4
+#define RS485_CRC_SIZE				4
+#define RS485_MAX_PAYLOAD			248
+#define RS485_FRAME_MAX				(RS485_HEADER_SIZE + RS485_MAX_PAYLOAD + RS485_CRC_SIZE)
+
+#define RS485_FUNCTION_PING			0x01
+#define RS485_FUNCTION_READ			0x02
+#define RS485_FUNCTION_ALARMS		0x03
+#define RS485_FUNCTION_RESPONSE		0x40	/**< Set in every response */
+#define RS485_FUNCTION_ERROR		0x80	/**< Set in error responses */
+
+#define RS485_ERROR_FUNCTION		0x01	/**< Function not supported */
+#define RS485_ERROR_REQUEST			0x02	/**< Request payload not valid */
+#define RS485_ERROR_BUSY			0x03	/**< No data available yet */
+
+/**
+ * @brief CRC of `count` 32-bit words, e.g. the CRC unit.
+ */
+typedef uint32_t (*RS485_CRC)(const uint32_t *words, uint32_t count);
+
+typedef struct __attribute__((packed)) RS485_Header{
+	uint8_t Address;
+	uint8_t Function;
+	uint8_t Sequence;
+	uint8_t Length;
+}RS485_Header;
+
+/** @struct RS485_Handler
+ *  @brief  Function served by a node.
+ *
+ * `Handle` writes the response payload and returns its length, at most
+ * @ref RS485_MAX_PAYLOAD, or the negated RS485_ERROR_x code.
+ */
+typedef struct RS485_Handler{
+	uint8_t Function;
+	int16_t (*Handle)(const uint8_t *request, uint8_t length, uint8_t *response, void *context);
+	void *Context;
+}RS485_Handler;
+
+/** @struct RS485_Node
+ *  @brief  Node side, the fields above the state are filled in by the application.
+ */
+typedef struct RS485_Node{
+	uint8_t Address;				/**< 1 to @ref RS485_ADDRESS_MAX */
+	const RS485_Handler *Handlers;
+	uint8_t Handler_Count;
+	RS485_CRC Crc;
+
+	/* State */
+	uint32_t Requests;				/**< Requests for this node, broadcasts included */
+	uint32_t Responses;
+	uint32_t Errors;				/**< Frames with a wrong length or CRC */
+}RS485_Node;
+
+/** @struct RS485_Host
+ *  @brief  Host side, `Crc` is filled in by the application.
+ */
+typedef struct RS485_Host{
+	RS485_CRC Crc;
+
+	/* State */
+	uint8_t Sequence;
+	uint32_t Transactions;
+	uint32_t Timeouts;
+	uint32_t Errors;				/**< Corrupted responses and error responses */
+}RS485_Host;
+
+/**
+ * @brief Completes a frame whose payload is already in place behind the header.
+ *
+ * @param[in,out] frame Frame buffer, 32-bit aligned, @ref RS485_FRAME_MAX bytes.
+ * @param[in] address Node address.
+ * @param[in] function Function.
+ * @param[in] sequence Sequence number.
+ * @param[in] length Payload length.
+ * @param[in] crc CRC function.
+ *
+ * @return uint16_t Frame length in bytes, 0 if the payload is too long.
+ */
+uint16_t RS485_Finish(uint8_t *frame, uint8_t address, uint8_t function, uint8_t sequence, uint8_t length, RS485_CRC crc);
+
+/**
+ * @brief Checks a received frame.
+ *
+ * @param[in] frame Frame, 32-bit aligned.
+ * @param[in] size Bytes received.
+ * @param[out] header Header of the frame.
+ * @param[out] payload Start of the payload inside `frame`.
+ * @param[in] crc CRC function.
+ *
+ * @return int8_t Returns 1 for a valid frame, or -1 for a wrong length or CRC.
+ */
+int8_t RS485_Parse(const uint8_t *frame, uint16_t size, RS485_Header *header, const uint8_t **payload, RS485_CRC crc);
+
+/**
+ * @brief Serves one received frame.
+ *
+ * @param[in,out] node Node.
+ * @param[in] frame Received frame, 32-bit aligned.
+ * @param[in] size Bytes received.
+ * @param[out] response Response frame, 32-bit aligned, @ref RS485_FRAME_MAX bytes.
+ *
+ * @return uint16_t Length of the response to send, 0 when nothing is to be sent.
+ */
+uint16_t RS485_Node_Process(RS485_Node *node, const uint8_t *frame, uint16_t size, uint8_t *response);
+
+/**
+ * @brief Builds the next request of the host.
+ *
+ * @param[in,out] host Host.
+ * @param[out] frame Request frame, 32-bit aligned, @ref RS485_FRAME_MAX bytes.
+ * @param[in] address Node address.
+ * @param[in] function Function.
+ * @param[in] payload Request payload, may be NULL for none.
+ * @param[in] length Payload length.
+ *
+ * @return uint16_t Frame length in bytes, 0 if the payload is too long.
+ */
+uint16_t RS485_Host_Request(RS485_Host *host, uint8_t *frame, uint8_t address, uint8_t function, const uint8_t *payload, uint8_t length);
+
+/**
+ * @brief Matches a received frame against the request it should answer.
+ *
+ * @param[in,out] host Host.
+ * @param[in] request Request sent last.
+ * @param[in] frame Received frame, 32-bit aligned.
+ * @param[in] size Bytes received.
+ * @param[out] header Header of the response.
+ * @param[out] payload Start of the response payload inside `frame`.
+ *
+ * @return int8_t Returns 1 for the response, 0 for a frame that is not the response, or -1 for a corrupted frame.
+ */
+int8_t RS485_Host_Response(RS485_Host *host, const uint8_t *request, const uint8_t *frame, uint16_t size,
+		RS485_Header *header, const uint8_t **payload);
+
+/**
+ * @brief Bytes on the wire for a payload length.
+ */
+#define RS485_FRAME_SIZE(length)	(RS485_HEADER_SIZE + (((length) + 3) & ~3) + RS485_CRC_SIZE)
+
+/**
+ * @brief Time of one request and its response on the bus.
+ *
+ * 10 bits per byte plus the time the node takes to answer. A poll cycle over N
+ * nodes takes N times this, which fixes the cycle time of the host.
+ *
+ * @param[in] baudrate Bus baud rate.
+ * @param[in] request Request payload length.
+ * @param[in] response Response payload length.
+ * @param[in] turnaround Time from the end of the request to the start of the response in µs.
+ *
+ * @return uint32_t Transaction time in µs.
+ */
+uint32_t RS485_Transaction_us(uint32_t baudrate, uint8_t request, uint8_t response, uint32_t turnaround);
+
+#endif /* CUSTOM_RS485_COMM_RS485_PROTOCOL_H_ */
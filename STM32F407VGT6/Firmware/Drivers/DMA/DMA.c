@@ -14,1332 +14,203 @@
  */
 
 #include "DMA.h"
+#include "Profiler/Profiler.h"
 
-
-DMA_Config *__DMA1_Stream0_Config__;
-DMA_Config *__DMA1_Stream1_Config__;
-DMA_Config *__DMA1_Stream2_Config__;
-DMA_Config *__DMA1_Stream3_Config__;
-DMA_Config *__DMA1_Stream4_Config__;
-DMA_Config *__DMA1_Stream5_Config__;
-DMA_Config *__DMA1_Stream6_Config__;
-DMA_Config *__DMA1_Stream7_Config__;
-
-DMA_Config *__DMA2_Stream0_Config__;
-DMA_Config *__DMA2_Stream1_Config__;
-DMA_Config *__DMA2_Stream2_Config__;
-DMA_Config *__DMA2_Stream3_Config__;
-DMA_Config *__DMA2_Stream4_Config__;
-DMA_Config *__DMA2_Stream5_Config__;
-DMA_Config *__DMA2_Stream6_Config__;
-DMA_Config *__DMA2_Stream7_Config__;
-
-
-
-volatile uint32_t DMA_LISR = 0;
-volatile uint32_t DMA_HISR = 0;
-
-
-void DMA1_Stream0_IRQHandler(void)
-{
-	DMA_LISR = DMA1 -> LISR;
-
-	if(DMA_LISR & DMA_LISR_FEIF0)
-	{
-
-		if(__DMA1_Stream0_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Fifo_Error)
-		{
-			if (__DMA1_Stream0_Config__ -> ISR_Routines.FIFO_Error_ISR)
-			{
-				__DMA1_Stream0_Config__ ->ISR_Routines.FIFO_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CFEIF0;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_DMEIF0)
-	{
-		if(__DMA1_Stream0_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Direct_Mode_Error)
-		{
-			if (__DMA1_Stream0_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-			{
-				__DMA1_Stream0_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CDMEIF0;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TEIF0)
-	{
-		if(__DMA1_Stream0_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Error)
-		{
-			if (__DMA1_Stream0_Config__ -> ISR_Routines.Transfer_Error_ISR)
-			{
-				__DMA1_Stream0_Config__ ->ISR_Routines.Transfer_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CTEIF0;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_HTIF0)
-	{
-		if(__DMA1_Stream0_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Half_Transfer_Complete)
-		{
-			if (__DMA1_Stream0_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-			{
-				__DMA1_Stream0_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CHTIF0;
-
-				if(__DMA1_Stream0_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA1_Stream0_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA1_Stream0_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA1_Stream0_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TCIF0)
-	{
-		if(__DMA1_Stream0_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Complete)
-		{
-			if (__DMA1_Stream0_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-			{
-				__DMA1_Stream0_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CTCIF0;
-
-				if(__DMA1_Stream0_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA1_Stream0_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA1_Stream0_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA1_Stream0_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-
-	}
-}
-
-void DMA1_Stream1_IRQHandler(void)
-{
-	DMA_LISR = DMA1 -> LISR;
-
-	if(DMA_LISR & DMA_LISR_FEIF1)
-	{
-		if(__DMA1_Stream1_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Fifo_Error)
-		{
-			if (__DMA1_Stream1_Config__ -> ISR_Routines.FIFO_Error_ISR)
-			{
-				__DMA1_Stream1_Config__ ->ISR_Routines.FIFO_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CFEIF1;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_DMEIF1)
-	{
-		if(__DMA1_Stream1_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Direct_Mode_Error)
-		{
-			if (__DMA1_Stream1_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-			{
-				__DMA1_Stream1_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CDMEIF1;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TEIF1)
-	{
-		if(__DMA1_Stream1_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Error)
-		{
-			if (__DMA1_Stream1_Config__ -> ISR_Routines.Transfer_Error_ISR)
-			{
-				__DMA1_Stream1_Config__ ->ISR_Routines.Transfer_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CTEIF1;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_HTIF1)
-	{
-		if(__DMA1_Stream1_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Half_Transfer_Complete)
-		{
-			if (__DMA1_Stream1_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-			{
-				__DMA1_Stream1_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CHTIF1;
-
-				if(__DMA1_Stream1_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA1_Stream1_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA1_Stream1_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA1_Stream1_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TCIF1)
-	{
-		if(__DMA1_Stream1_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Complete)
-		{
-			if (__DMA1_Stream1_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-			{
-				__DMA1_Stream1_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CTCIF1;
-
-				if(__DMA1_Stream1_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA1_Stream1_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA1_Stream1_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA1_Stream1_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-	}
-}
-
-
-void DMA1_Stream2_IRQHandler(void)
-{
-	DMA_LISR = DMA1 -> LISR;
-
-	if(DMA_LISR & DMA_LISR_FEIF2)
-	{
-		if(__DMA1_Stream2_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Fifo_Error)
-		{
-			if (__DMA1_Stream2_Config__ -> ISR_Routines.FIFO_Error_ISR)
-			{
-				__DMA1_Stream2_Config__ ->ISR_Routines.FIFO_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CFEIF2;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_DMEIF2)
-	{
-		if(__DMA1_Stream2_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Direct_Mode_Error)
-		{
-			if (__DMA1_Stream2_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-			{
-				__DMA1_Stream2_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CDMEIF2;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TEIF2)
-	{
-		if(__DMA1_Stream2_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Error)
-		{
-			if(__DMA1_Stream2_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Error)
-			{
-				if (__DMA1_Stream2_Config__ -> ISR_Routines.Transfer_Error_ISR)
-				{
-					__DMA1_Stream2_Config__ ->ISR_Routines.Transfer_Error_ISR();
-					DMA1 -> LIFCR |= DMA_LIFCR_CTEIF2;
-				}
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_HTIF2)
-	{
-		if(__DMA1_Stream2_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Half_Transfer_Complete)
-		{
-			if (__DMA1_Stream2_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-			{
-				__DMA1_Stream2_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CHTIF2;
-
-				if(__DMA1_Stream2_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA1_Stream2_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA1_Stream2_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA1_Stream2_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TCIF2)
-	{
-		if(__DMA1_Stream2_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Complete)
-		{
-			if (__DMA1_Stream2_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-			{
-				__DMA1_Stream2_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CTCIF2;
-
-				if(__DMA1_Stream2_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA1_Stream2_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA1_Stream2_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA1_Stream2_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-	}
-}
-
-void DMA1_Stream3_IRQHandler(void)
-{
-	DMA_LISR = DMA1 -> LISR;
-
-	if(DMA_LISR & DMA_LISR_FEIF3)
-	{
-		if(__DMA1_Stream3_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Fifo_Error)
-		{
-			if (__DMA1_Stream3_Config__ -> ISR_Routines.FIFO_Error_ISR)
-			{
-				__DMA1_Stream3_Config__ ->ISR_Routines.FIFO_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CFEIF3;
-			}
-		}
-
-	}
-
-	if(DMA_LISR & DMA_LISR_DMEIF3)
-	{
-		if(__DMA1_Stream3_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Direct_Mode_Error)
-		{
-			if (__DMA1_Stream3_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-			{
-				__DMA1_Stream3_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CDMEIF3;
-			}
-		}
-
-	}
-
-	if(DMA_LISR & DMA_LISR_TEIF3)
-	{
-		if(__DMA1_Stream3_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Error)
-		{
-			if (__DMA1_Stream3_Config__ -> ISR_Routines.Transfer_Error_ISR)
-			{
-				__DMA1_Stream3_Config__ ->ISR_Routines.Transfer_Error_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CTEIF3;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_HTIF3)
-	{
-		if(__DMA1_Stream3_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Half_Transfer_Complete)
-		{
-			if (__DMA1_Stream3_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-			{
-				__DMA1_Stream3_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CHTIF3;
-
-				if(__DMA1_Stream3_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA1_Stream3_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA1_Stream3_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA1_Stream3_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TCIF3)
-	{
-		if(__DMA1_Stream3_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Complete)
-		{
-			if (__DMA1_Stream3_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-			{
-				__DMA1_Stream3_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-				DMA1 -> LIFCR |= DMA_LIFCR_CTCIF3;
-
-				if(__DMA1_Stream3_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA1_Stream3_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA1_Stream3_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA1_Stream3_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-	}
-}
-
-void DMA1_Stream4_IRQHandler(void)
-{
-	DMA_HISR = DMA1 -> HISR;
-
-	if(DMA_HISR & DMA_HISR_FEIF4)
-	{
-		if (__DMA1_Stream4_Config__ -> ISR_Routines.FIFO_Error_ISR)
-		{
-			__DMA1_Stream4_Config__ ->ISR_Routines.FIFO_Error_ISR();
-			DMA1 -> LIFCR |= DMA_HIFCR_CFEIF5;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_DMEIF4)
-	{
-		if (__DMA1_Stream4_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-		{
-			__DMA1_Stream4_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CDMEIF4;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_TEIF4)
-	{
-		if (__DMA1_Stream4_Config__ -> ISR_Routines.Transfer_Error_ISR)
-		{
-			__DMA1_Stream4_Config__ ->ISR_Routines.Transfer_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CTEIF4;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_HTIF4)
-	{
-		if (__DMA1_Stream4_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-		{
-			__DMA1_Stream4_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CHTIF4;
-
-			if(__DMA1_Stream4_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA1_Stream4_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA1_Stream4_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA1_Stream4_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_TCIF4)
-	{
-		if (__DMA1_Stream4_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-		{
-			__DMA1_Stream4_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CTCIF4;
-
-			if(__DMA1_Stream4_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA1_Stream4_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA1_Stream4_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA1_Stream4_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-}
-
-
-
-
-void DMA1_Stream5_IRQHandler(void)
-{
-	DMA_HISR = DMA1 -> HISR;
-
-	if(DMA_HISR & DMA_HISR_FEIF5)
-	{
-		if (__DMA1_Stream5_Config__ -> ISR_Routines.FIFO_Error_ISR)
-		{
-			__DMA1_Stream5_Config__ ->ISR_Routines.FIFO_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CFEIF5;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_DMEIF5)
-	{
-		if (__DMA1_Stream5_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-		{
-			__DMA1_Stream5_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CDMEIF5;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_TEIF5)
-	{
-		if (__DMA1_Stream5_Config__ -> ISR_Routines.Transfer_Error_ISR)
-		{
-			__DMA1_Stream5_Config__ ->ISR_Routines.Transfer_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CTEIF5;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_HTIF5)
-	{
-		if (__DMA1_Stream5_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-		{
-			__DMA1_Stream5_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CHTIF5;
-
-			if(__DMA1_Stream5_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA1_Stream5_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA1_Stream5_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA1_Stream5_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_TCIF5)
-	{
-		if (__DMA1_Stream5_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-		{
-			__DMA1_Stream5_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CTCIF5;
-
-			if(__DMA1_Stream5_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA1_Stream5_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA1_Stream5_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA1_Stream5_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-}
-
-
-
-void DMA1_Stream6_IRQHandler(void)
-{
-	DMA_HISR = DMA1 -> HISR;
-
-	if(DMA_HISR & DMA_HISR_FEIF6)
-	{
-		if (__DMA1_Stream6_Config__ -> ISR_Routines.FIFO_Error_ISR)
-		{
-			__DMA1_Stream6_Config__ ->ISR_Routines.FIFO_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CFEIF6;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_DMEIF6)
-	{
-		if (__DMA1_Stream6_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-		{
-			__DMA1_Stream6_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CDMEIF6;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_TEIF6)
-	{
-		if (__DMA1_Stream6_Config__ -> ISR_Routines.Transfer_Error_ISR)
-		{
-			__DMA1_Stream6_Config__ ->ISR_Routines.Transfer_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CTEIF6;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_HTIF6)
-	{
-		if (__DMA1_Stream6_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-		{
-			__DMA1_Stream6_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CHTIF6;
-
-			if(__DMA1_Stream6_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA1_Stream6_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA1_Stream6_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA1_Stream6_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_TCIF6)
-	{
-		if (__DMA1_Stream6_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-		{
-			__DMA1_Stream6_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CTCIF6;
-
-			if(__DMA1_Stream6_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA1_Stream6_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA1_Stream6_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA1_Stream6_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-}
-
-
-void DMA1_Stream7_IRQHandler(void)
-{
-	DMA_HISR = DMA1 -> HISR;
-
-	if(DMA_HISR & DMA_HISR_FEIF7)
-	{
-		if (__DMA1_Stream7_Config__ -> ISR_Routines.FIFO_Error_ISR)
-		{
-			__DMA1_Stream7_Config__ ->ISR_Routines.FIFO_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CFEIF7;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_DMEIF7)
-	{
-		if (__DMA1_Stream7_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-		{
-			__DMA1_Stream7_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CDMEIF7;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_TEIF7)
-	{
-		if (__DMA1_Stream7_Config__ -> ISR_Routines.Transfer_Error_ISR)
-		{
-			__DMA1_Stream7_Config__ ->ISR_Routines.Transfer_Error_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CTEIF7;
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_HTIF7)
-	{
-		if (__DMA1_Stream7_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-		{
-			__DMA1_Stream7_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CHTIF7;
-
-			if(__DMA1_Stream7_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA1_Stream7_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA1_Stream7_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA1_Stream7_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-
-	if(DMA_HISR & DMA_HISR_TCIF7)
-	{
-		if (__DMA1_Stream7_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-		{
-			__DMA1_Stream7_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-			DMA1 -> HIFCR |= DMA_HIFCR_CTCIF7;
-
-			if(__DMA1_Stream7_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA1_Stream7_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA1_Stream7_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA1_Stream7_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-}
-
-void DMA2_Stream0_IRQHandler(void)
-{
-	DMA_LISR = DMA2 -> LISR;
-
-	if(DMA_LISR & DMA_LISR_FEIF0)
-	{
-		if(__DMA2_Stream0_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Fifo_Error)
-		{
-			if (__DMA2_Stream0_Config__ -> ISR_Routines.FIFO_Error_ISR)
-			{
-				__DMA2_Stream0_Config__ ->ISR_Routines.FIFO_Error_ISR();
-				DMA2 -> LIFCR |= DMA_LIFCR_CFEIF0;
-			}
-		}
-
-	}
-
-	if(DMA_LISR & DMA_LISR_DMEIF0)
-	{
-		if(__DMA2_Stream0_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Direct_Mode_Error)
-		{
-			if (__DMA2_Stream0_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-			{
-				__DMA2_Stream0_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-				DMA2 -> LIFCR |= DMA_LIFCR_CDMEIF0;
-			}
-		}
-
-	}
-
-	if(DMA_LISR & DMA_LISR_TEIF0)
-	{
-		if(__DMA2_Stream0_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Error)
-		{
-			if (__DMA2_Stream0_Config__ -> ISR_Routines.Transfer_Error_ISR)
-			{
-				__DMA2_Stream0_Config__ ->ISR_Routines.Transfer_Error_ISR();
-				DMA2 -> LIFCR |= DMA_LIFCR_CTEIF0;
-			}
-		}
-
-	}
-
-	if(DMA_LISR & DMA_LISR_HTIF0)
-	{
-		if(__DMA2_Stream0_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Half_Transfer_Complete)
-		{
-			if (__DMA2_Stream0_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-			{
-				__DMA2_Stream0_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-				DMA2 -> LIFCR |= DMA_LIFCR_CHTIF0;
-
-				if(__DMA2_Stream0_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA2_Stream0_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA2_Stream0_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA2_Stream0_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-
-	}
-
-	if(DMA_LISR & DMA_LISR_TCIF0)
-	{
-		if(__DMA2_Stream0_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Complete)
-		{
-			if (__DMA2_Stream0_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-			{
-				__DMA2_Stream0_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-				DMA2 -> LIFCR |= DMA_LIFCR_CTCIF0;
-
-				if(__DMA2_Stream0_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA2_Stream0_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA2_Stream0_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA2_Stream0_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-
-	}
-}
-
-void DMA2_Stream1_IRQHandler(void)
-{
-	DMA_LISR = DMA2 -> LISR;
-
-	if(DMA_LISR & DMA_LISR_FEIF1)
-	{
-		if (__DMA2_Stream1_Config__ -> ISR_Routines.FIFO_Error_ISR)
-		{
-			__DMA2_Stream1_Config__ ->ISR_Routines.FIFO_Error_ISR();
-			DMA2 -> LIFCR |= DMA_LIFCR_CFEIF1;
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_DMEIF1)
-	{
-		if (__DMA2_Stream1_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-		{
-			__DMA2_Stream1_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-			DMA2 -> LIFCR |= DMA_LIFCR_CDMEIF1;
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TEIF1)
-	{
-		if (__DMA2_Stream1_Config__ -> ISR_Routines.Transfer_Error_ISR)
-		{
-			__DMA2_Stream1_Config__ ->ISR_Routines.Transfer_Error_ISR();
-			DMA2 -> LIFCR |= DMA_LIFCR_CTEIF1;
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_HTIF1)
-	{
-		if (__DMA2_Stream1_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-		{
-			__DMA2_Stream1_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-			DMA2 -> LIFCR |= DMA_LIFCR_CHTIF1;
-
-			if(__DMA2_Stream1_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream1_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream1_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream1_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TCIF1)
-	{
-		if (__DMA2_Stream1_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-		{
-			__DMA2_Stream1_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-			DMA2 -> LIFCR |= DMA_LIFCR_CTCIF1;
-
-			if(__DMA2_Stream1_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream1_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream1_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream1_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-}
-
-
-void DMA2_Stream2_IRQHandler(void)
-{
-	DMA_LISR = DMA2 -> LISR;
-
-	if(DMA_LISR & DMA_LISR_FEIF2)
-	{
-		if (__DMA2_Stream2_Config__ -> ISR_Routines.FIFO_Error_ISR)
-		{
-			__DMA2_Stream2_Config__ ->ISR_Routines.FIFO_Error_ISR();
-			DMA2 -> LIFCR |= DMA_LIFCR_CFEIF2;
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_DMEIF2)
-	{
-		if (__DMA2_Stream2_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-		{
-			__DMA2_Stream2_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-			DMA2 -> LIFCR |= DMA_LIFCR_CDMEIF2;
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TEIF2)
-	{
-		if (__DMA2_Stream2_Config__ -> ISR_Routines.Transfer_Error_ISR)
-		{
-			__DMA2_Stream2_Config__ ->ISR_Routines.Transfer_Error_ISR();
-			DMA2 -> LIFCR |= DMA_LIFCR_CTEIF2;
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_HTIF2)
-	{
-		if (__DMA2_Stream2_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-		{
-			__DMA2_Stream2_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-			DMA2 -> LIFCR |= DMA_LIFCR_CHTIF2;
-
-			if(__DMA2_Stream2_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream2_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream2_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream2_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TCIF2)
-	{
-		if (__DMA2_Stream2_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-		{
-			__DMA2_Stream2_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-			DMA2 -> LIFCR |= DMA_LIFCR_CTCIF2;
-
-			if(__DMA2_Stream2_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream2_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream2_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream2_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
-}
-
-void DMA2_Stream3_IRQHandler(void)
-{
-	DMA_LISR = DMA2 -> LISR;
-
-	if(DMA_LISR & DMA_LISR_FEIF3)
-	{
-		if(__DMA2_Stream3_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Fifo_Error)
-		{
-			if (__DMA2_Stream3_Config__ -> ISR_Routines.FIFO_Error_ISR)
-			{
-				__DMA2_Stream3_Config__ ->ISR_Routines.FIFO_Error_ISR();
-				DMA2 -> LIFCR |= DMA_LIFCR_CFEIF3;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_DMEIF3)
-	{
-		if(__DMA2_Stream3_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Direct_Mode_Error)
-		{
-			if (__DMA2_Stream3_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-			{
-				__DMA2_Stream3_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-				DMA2 -> LIFCR |= DMA_LIFCR_CDMEIF3;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_TEIF3)
-	{
-		if(__DMA2_Stream3_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Error)
-		{
-			if (__DMA2_Stream3_Config__ -> ISR_Routines.Transfer_Error_ISR)
-			{
-				__DMA2_Stream3_Config__ ->ISR_Routines.Transfer_Error_ISR();
-				DMA2 -> LIFCR |= DMA_LIFCR_CTEIF3;
-			}
-		}
-	}
-
-	if(DMA_LISR & DMA_LISR_HTIF3)
-	{
-		if(__DMA2_Stream3_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Half_Transfer_Complete)
-		{
-			if (__DMA2_Stream3_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-			{
-				__DMA2_Stream3_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-				DMA2 -> LIFCR |= DMA_LIFCR_CHTIF3;
-
-				if(__DMA2_Stream3_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA2_Stream3_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA2_Stream3_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA2_Stream3_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-
-	}
-
-	if(DMA_LISR & DMA_LISR_TCIF3)
-	{
-		if(__DMA2_Stream3_Config__->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Complete)
-		{
-			if (__DMA2_Stream3_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-			{
-				__DMA2_Stream3_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-				DMA2 -> LIFCR |= DMA_LIFCR_CTCIF3;
-
-				if(__DMA2_Stream3_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-				{
-					if((__DMA2_Stream3_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-					{
-						__DMA2_Stream3_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-					}
-					else
-					{
-						__DMA2_Stream3_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-					}
-				}
-			}
-		}
-	}
-}
-
-void DMA2_Stream4_IRQHandler(void)
+/*
+ * Stream table, indexed by DMA_Stream_Index: DMA1 Stream 0..7 followed by DMA2 Stream 0..7.
+ * Status and clear register plus bit offset of every stream are fixed by the hardware, so
+ * the interrupt path only indexes this table instead of branching per stream.
+ */
+static const struct DMA_Stream_Hardware
 {
-	DMA_HISR = DMA2 -> HISR;
+	DMA_Stream_TypeDef *Stream;
+	volatile uint32_t *Status;	// LISR or HISR
+	volatile uint32_t *Clear;	// LIFCR or HIFCR, write-one-to-clear
+	IRQn_Type IRQ;
+	uint8_t Shift;
+}dma_stream_hardware[16] =
+{
+	{DMA1_Stream0, &DMA1->LISR, &DMA1->LIFCR, DMA1_Stream0_IRQn, 0},
+	{DMA1_Stream1, &DMA1->LISR, &DMA1->LIFCR, DMA1_Stream1_IRQn, 6},
+	{DMA1_Stream2, &DMA1->LISR, &DMA1->LIFCR, DMA1_Stream2_IRQn, 16},
+	{DMA1_Stream3, &DMA1->LISR, &DMA1->LIFCR, DMA1_Stream3_IRQn, 22},
+	{DMA1_Stream4, &DMA1->HISR, &DMA1->HIFCR, DMA1_Stream4_IRQn, 0},
+	{DMA1_Stream5, &DMA1->HISR, &DMA1->HIFCR, DMA1_Stream5_IRQn, 6},
+	{DMA1_Stream6, &DMA1->HISR, &DMA1->HIFCR, DMA1_Stream6_IRQn, 16},
+	{DMA1_Stream7, &DMA1->HISR, &DMA1->HIFCR, DMA1_Stream7_IRQn, 22},
+	{DMA2_Stream0, &DMA2->LISR, &DMA2->LIFCR, DMA2_Stream0_IRQn, 0},
+	{DMA2_Stream1, &DMA2->LISR, &DMA2->LIFCR, DMA2_Stream1_IRQn, 6},
+	{DMA2_Stream2, &DMA2->LISR, &DMA2->LIFCR, DMA2_Stream2_IRQn, 16},
+	{DMA2_Stream3, &DMA2->LISR, &DMA2->LIFCR, DMA2_Stream3_IRQn, 22},
+	{DMA2_Stream4, &DMA2->HISR, &DMA2->HIFCR, DMA2_Stream4_IRQn, 0},
+	{DMA2_Stream5, &DMA2->HISR, &DMA2->HIFCR, DMA2_Stream5_IRQn, 6},
+	{DMA2_Stream6, &DMA2->HISR, &DMA2->HIFCR, DMA2_Stream6_IRQn, 16},
+	{DMA2_Stream7, &DMA2->HISR, &DMA2->HIFCR, DMA2_Stream7_IRQn, 22},
+};
+
+/* Flags of one stream once shifted down to bit 0 */
+#define DMA_STREAM_FLAG_FE		DMA_LISR_FEIF0
+#define DMA_STREAM_FLAG_DME		DMA_LISR_DMEIF0
+#define DMA_STREAM_FLAG_TE		DMA_LISR_TEIF0
+#define DMA_STREAM_FLAG_HT		DMA_LISR_HTIF0
+#define DMA_STREAM_FLAG_TC		DMA_LISR_TCIF0
+#define DMA_STREAM_FLAGS		(DMA_STREAM_FLAG_FE | DMA_STREAM_FLAG_DME | DMA_STREAM_FLAG_TE | DMA_STREAM_FLAG_HT | DMA_STREAM_FLAG_TC)
+
+typedef struct DMA_Stream_Context
+{
+	DMA_Config *Config;			// Owner registered by DMA_Init, NULL if unused
+	uint32_t Enabled_Flags;		// Flags the owner has callbacks for, shifted down to bit 0
+#if DMA_STREAM_COUNTERS
+	DMA_Stream_Counters Counters;
+#endif
+}DMA_Stream_Context;
 
-	if(DMA_HISR & DMA_HISR_FEIF4)
-	{
-		if (__DMA2_Stream4_Config__ -> ISR_Routines.FIFO_Error_ISR)
-		{
-			__DMA2_Stream4_Config__ ->ISR_Routines.FIFO_Error_ISR();
-			DMA2 -> LIFCR |= DMA_HIFCR_CFEIF5;
-		}
-	}
+static DMA_Stream_Context dma_stream_context[16];
 
-	if(DMA_HISR & DMA_HISR_DMEIF4)
-	{
-		if (__DMA2_Stream4_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-		{
-			__DMA2_Stream4_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CDMEIF4;
-		}
-	}
+/** Cycle counter sampled on entry of the last DMA stream interrupt */
+volatile uint32_t DMA_ISR_Entry_Cycles = 0;
 
-	if(DMA_HISR & DMA_HISR_TEIF4)
-	{
-		if (__DMA2_Stream4_Config__ -> ISR_Routines.Transfer_Error_ISR)
-		{
-			__DMA2_Stream4_Config__ ->ISR_Routines.Transfer_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CTEIF4;
-		}
-	}
+/* Time spent in the dispatcher and callbacks of all stream interrupts */
+static PROFILER_PROBE(dma_isr_probe, "dma_isr");
 
-	if(DMA_HISR & DMA_HISR_HTIF4)
-	{
-		if (__DMA2_Stream4_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-		{
-			__DMA2_Stream4_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CHTIF4;
-
-			if(__DMA2_Stream4_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream4_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream4_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream4_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
 
-	if(DMA_HISR & DMA_HISR_TCIF4)
-	{
-		if (__DMA2_Stream4_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-		{
-			__DMA2_Stream4_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CTCIF4;
-
-			if(__DMA2_Stream4_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream4_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream4_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream4_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
+static int8_t DMA_Stream_Index(const DMA_Stream_TypeDef *stream)
+{
+	if((stream >= DMA1_Stream0) && (stream <= DMA1_Stream7)) return (int8_t)(stream - DMA1_Stream0);
+	if((stream >= DMA2_Stream0) && (stream <= DMA2_Stream7)) return (int8_t)(8 + (stream - DMA2_Stream0));
+	return -1;
 }
 
-
-
-
-void DMA2_Stream5_IRQHandler(void)
+static void DMA_Double_Buffer_Target(DMA_Config *config)
 {
-	DMA_HISR = DMA2 -> HISR;
+	if(config->double_buffer_mode != DMA_Configuration.Double_Buffer_Mode.Enable) return;
 
-	if(DMA_HISR & DMA_HISR_FEIF5)
+	if((config->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
 	{
-		if (__DMA2_Stream5_Config__ -> ISR_Routines.FIFO_Error_ISR)
-		{
-			__DMA2_Stream5_Config__ ->ISR_Routines.FIFO_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CFEIF5;
-		}
+		if(config->ISR_Routines.Double_Buffer_Mode_Target_1_ISR) config->ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
 	}
-
-	if(DMA_HISR & DMA_HISR_DMEIF5)
+	else
 	{
-		if (__DMA2_Stream5_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-		{
-			__DMA2_Stream5_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CDMEIF5;
-		}
+		if(config->ISR_Routines.Double_Buffer_Mode_Target_2_ISR) config->ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
 	}
+}
 
-	if(DMA_HISR & DMA_HISR_TEIF5)
-	{
-		if (__DMA2_Stream5_Config__ -> ISR_Routines.Transfer_Error_ISR)
-		{
-			__DMA2_Stream5_Config__ ->ISR_Routines.Transfer_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CTEIF5;
-		}
-	}
+static void DMA_Stream_Callbacks(DMA_Config *config, uint32_t flags)
+{
+	if(flags & DMA_STREAM_FLAG_FE) config->ISR_Routines.FIFO_Error_ISR();
+	if(flags & DMA_STREAM_FLAG_DME) config->ISR_Routines.Direct_Mode_Error_ISR();
+	if(flags & DMA_STREAM_FLAG_TE) config->ISR_Routines.Transfer_Error_ISR();
 
-	if(DMA_HISR & DMA_HISR_HTIF5)
+	if(flags & DMA_STREAM_FLAG_HT)
 	{
-		if (__DMA2_Stream5_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-		{
-			__DMA2_Stream5_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CHTIF5;
-
-			if(__DMA2_Stream5_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream5_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream5_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream5_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
+		config->ISR_Routines.Half_Transfer_Complete_ISR();
+		DMA_Double_Buffer_Target(config);
 	}
 
-	if(DMA_HISR & DMA_HISR_TCIF5)
+	if(flags & DMA_STREAM_FLAG_TC)
 	{
-		if (__DMA2_Stream5_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-		{
-			__DMA2_Stream5_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CTCIF5;
-
-			if(__DMA2_Stream5_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream5_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream5_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream5_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
+		config->ISR_Routines.Full_Transfer_Commplete_ISR();
+		DMA_Double_Buffer_Target(config);
 	}
 }
 
-
-
-void DMA2_Stream6_IRQHandler(void)
+/*
+ * Common body of all stream interrupts. The pending flags are acknowledged with a single
+ * write before any callback runs, so a callback that restarts the stream cannot lose the
+ * flags of its new transfer.
+ */
+static void DMA_Stream_Dispatch(uint8_t index)
 {
-	DMA_HISR = DMA2 -> HISR;
+	uint32_t entry = DWT->CYCCNT;
+	DMA_ISR_Entry_Cycles = entry;
 
-	if(DMA_HISR & DMA_HISR_FEIF6)
-	{
-		if (__DMA2_Stream6_Config__ -> ISR_Routines.FIFO_Error_ISR)
-		{
-			__DMA2_Stream6_Config__ ->ISR_Routines.FIFO_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CFEIF6;
-		}
-	}
+	const struct DMA_Stream_Hardware *hardware = &dma_stream_hardware[index];
+	DMA_Stream_Context *context = &dma_stream_context[index];
+	uint32_t flags = (*hardware->Status >> hardware->Shift) & DMA_STREAM_FLAGS;
 
-	if(DMA_HISR & DMA_HISR_DMEIF6)
-	{
-		if (__DMA2_Stream6_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-		{
-			__DMA2_Stream6_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CDMEIF6;
-		}
-	}
+	*hardware->Clear = flags << hardware->Shift;
 
-	if(DMA_HISR & DMA_HISR_TEIF6)
-	{
-		if (__DMA2_Stream6_Config__ -> ISR_Routines.Transfer_Error_ISR)
-		{
-			__DMA2_Stream6_Config__ ->ISR_Routines.Transfer_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CTEIF6;
-		}
-	}
+#if DMA_STREAM_COUNTERS
+	context->Counters.Interrupts++;
+	if(flags & DMA_STREAM_FLAG_FE) context->Counters.Fifo_Error++;
+	if(flags & DMA_STREAM_FLAG_DME) context->Counters.Direct_Mode_Error++;
+	if(flags & DMA_STREAM_FLAG_TE) context->Counters.Transfer_Error++;
+	if(flags & DMA_STREAM_FLAG_HT) context->Counters.Half_Transfer++;
+	if(flags & DMA_STREAM_FLAG_TC) context->Counters.Transfer_Complete++;
+#endif
 
-	if(DMA_HISR & DMA_HISR_HTIF6)
+	flags &= context->Enabled_Flags;
+	if(flags != 0)
 	{
-		if (__DMA2_Stream6_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-		{
-			__DMA2_Stream6_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CHTIF6;
-
-			if(__DMA2_Stream6_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream6_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream6_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream6_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
+		DMA_Stream_Callbacks(context->Config, flags);
 	}
 
-	if(DMA_HISR & DMA_HISR_TCIF6)
-	{
-		if (__DMA2_Stream6_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-		{
-			__DMA2_Stream6_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CTCIF6;
-
-			if(__DMA2_Stream6_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream6_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream6_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream6_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
+	Profiler_End(&dma_isr_probe, entry);
 }
 
+/* Registers the owner of a stream and the flags it has callbacks for */
+static void DMA_Stream_Register(uint8_t index, DMA_Config *config)
+{
+	uint32_t enabled = 0;
+
+	if((config->interrupts & DMA_Configuration.DMA_Interrupts.Fifo_Error) && config->ISR_Routines.FIFO_Error_ISR) enabled |= DMA_STREAM_FLAG_FE;
+	if((config->interrupts & DMA_Configuration.DMA_Interrupts.Direct_Mode_Error) && config->ISR_Routines.Direct_Mode_Error_ISR) enabled |= DMA_STREAM_FLAG_DME;
+	if((config->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Error) && config->ISR_Routines.Transfer_Error_ISR) enabled |= DMA_STREAM_FLAG_TE;
+	if((config->interrupts & DMA_Configuration.DMA_Interrupts.Half_Transfer_Complete) && config->ISR_Routines.Half_Transfer_Complete_ISR) enabled |= DMA_STREAM_FLAG_HT;
+	if((config->interrupts & DMA_Configuration.DMA_Interrupts.Transfer_Complete) && config->ISR_Routines.Full_Transfer_Commplete_ISR) enabled |= DMA_STREAM_FLAG_TC;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	dma_stream_context[index].Config = config;
+	dma_stream_context[index].Enabled_Flags = enabled;
+	__set_PRIMASK(primask);
+}
 
-void DMA2_Stream7_IRQHandler(void)
+void DMA1_Stream0_IRQHandler(void) { DMA_Stream_Dispatch(0); }
+void DMA1_Stream1_IRQHandler(void) { DMA_Stream_Dispatch(1); }
+void DMA1_Stream2_IRQHandler(void) { DMA_Stream_Dispatch(2); }
+void DMA1_Stream3_IRQHandler(void) { DMA_Stream_Dispatch(3); }
+void DMA1_Stream4_IRQHandler(void) { DMA_Stream_Dispatch(4); }
+void DMA1_Stream5_IRQHandler(void) { DMA_Stream_Dispatch(5); }
+void DMA1_Stream6_IRQHandler(void) { DMA_Stream_Dispatch(6); }
+void DMA1_Stream7_IRQHandler(void) { DMA_Stream_Dispatch(7); }
+
+void DMA2_Stream0_IRQHandler(void) { DMA_Stream_Dispatch(8); }
+void DMA2_Stream1_IRQHandler(void) { DMA_Stream_Dispatch(9); }
+void DMA2_Stream2_IRQHandler(void) { DMA_Stream_Dispatch(10); }
+void DMA2_Stream3_IRQHandler(void) { DMA_Stream_Dispatch(11); }
+void DMA2_Stream4_IRQHandler(void) { DMA_Stream_Dispatch(12); }
+void DMA2_Stream5_IRQHandler(void) { DMA_Stream_Dispatch(13); }
+void DMA2_Stream6_IRQHandler(void) { DMA_Stream_Dispatch(14); }
+void DMA2_Stream7_IRQHandler(void) { DMA_Stream_Dispatch(15); }
+
+#if DMA_STREAM_COUNTERS
+int8_t DMA_Get_Counters(const DMA_Stream_TypeDef *stream, DMA_Stream_Counters *counters)
 {
-	DMA_HISR = DMA2 -> HISR;
+	int8_t index = DMA_Stream_Index(stream);
+	if(index < 0) return -1;
 
-	if(DMA_HISR & DMA_HISR_FEIF7)
-	{
-		if (__DMA2_Stream7_Config__ -> ISR_Routines.FIFO_Error_ISR)
-		{
-			__DMA2_Stream7_Config__ ->ISR_Routines.FIFO_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CFEIF7;
-		}
-	}
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	*counters = dma_stream_context[index].Counters;
+	__set_PRIMASK(primask);
 
-	if(DMA_HISR & DMA_HISR_DMEIF7)
-	{
-		if (__DMA2_Stream7_Config__ -> ISR_Routines.Direct_Mode_Error_ISR)
-		{
-			__DMA2_Stream7_Config__ ->ISR_Routines.Direct_Mode_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CDMEIF7;
-		}
-	}
+	return 1;
+}
 
-	if(DMA_HISR & DMA_HISR_TEIF7)
-	{
-		if (__DMA2_Stream7_Config__ -> ISR_Routines.Transfer_Error_ISR)
-		{
-			__DMA2_Stream7_Config__ ->ISR_Routines.Transfer_Error_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CTEIF7;
-		}
-	}
+int8_t DMA_Reset_Counters(const DMA_Stream_TypeDef *stream)
+{
+	int8_t index = DMA_Stream_Index(stream);
+	if(index < 0) return -1;
 
-	if(DMA_HISR & DMA_HISR_HTIF7)
-	{
-		if (__DMA2_Stream7_Config__ -> ISR_Routines.Half_Transfer_Complete_ISR)
-		{
-			__DMA2_Stream7_Config__ ->ISR_Routines.Half_Transfer_Complete_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CHTIF7;
-
-			if(__DMA2_Stream7_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream7_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream7_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream7_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	memset(&dma_stream_context[index].Counters, 0, sizeof(DMA_Stream_Counters));
+	__set_PRIMASK(primask);
 
-	if(DMA_HISR & DMA_HISR_TCIF7)
-	{
-		if (__DMA2_Stream7_Config__ -> ISR_Routines.Full_Transfer_Commplete_ISR)
-		{
-			__DMA2_Stream7_Config__ ->ISR_Routines.Full_Transfer_Commplete_ISR();
-			DMA2 -> HIFCR |= DMA_HIFCR_CTCIF7;
-
-			if(__DMA2_Stream7_Config__->double_buffer_mode == DMA_Configuration.Double_Buffer_Mode.Enable )
-			{
-				if((__DMA2_Stream7_Config__->Request.Stream->CR & DMA_SxCR_DBM_Msk) != 0)
-				{
-					__DMA2_Stream7_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_1_ISR();
-				}
-				else
-				{
-					__DMA2_Stream7_Config__ -> ISR_Routines.Double_Buffer_Mode_Target_2_ISR();
-				}
-			}
-		}
-	}
+	return 1;
 }
+#endif
 
 
 
@@ -1461,79 +332,12 @@ int8_t DMA_Init(DMA_Config *config)
 			config->Request.Stream->CR |= DMA_SxCR_DMEIE;
 		}
 
-		// Enable the corresponding NVIC interrupt for the DMA stream
-		if(config->Request.Controller == DMA1)
-		{
-			if(config->Request.Stream == DMA1_Stream0){
-				__DMA1_Stream0_Config__ = config;
-				NVIC_EnableIRQ(DMA1_Stream0_IRQn);
-			}
-			else if(config->Request.Stream == DMA1_Stream1){
-				__DMA1_Stream1_Config__ = config;
-				NVIC_EnableIRQ(DMA1_Stream1_IRQn);
-			}
-			else if(config->Request.Stream == DMA1_Stream2){
-				__DMA1_Stream2_Config__ = config;
-				NVIC_EnableIRQ(DMA1_Stream2_IRQn);
-			}
-			else if(config->Request.Stream == DMA1_Stream3){
-				__DMA1_Stream3_Config__ = config;
-				NVIC_EnableIRQ(DMA1_Stream3_IRQn);
-			}
-			else if(config->Request.Stream == DMA1_Stream4){
-				__DMA1_Stream4_Config__ = config;
-				NVIC_EnableIRQ(DMA1_Stream4_IRQn);
-			}
-			else if(config->Request.Stream == DMA1_Stream5){
-				__DMA1_Stream5_Config__ = config;
-				NVIC_EnableIRQ(DMA1_Stream5_IRQn);
-			}
-			else if(config->Request.Stream == DMA1_Stream6) {
-				__DMA1_Stream6_Config__ = config;
-				NVIC_EnableIRQ(DMA1_Stream6_IRQn);
-			}
-			else if(config->Request.Stream == DMA1_Stream7){
-				__DMA1_Stream7_Config__ = config;
-				NVIC_EnableIRQ(DMA1_Stream7_IRQn);
-			}
-		}
-		else if(config->Request.Controller == DMA2)
-		{
-			if(config->Request.Stream == DMA2_Stream0){
-				__DMA2_Stream0_Config__ = config;
-				NVIC_EnableIRQ(DMA2_Stream0_IRQn);
-			}
-			else if(config->Request.Stream == DMA2_Stream1){
-				__DMA2_Stream1_Config__ = config;
-				NVIC_EnableIRQ(DMA2_Stream1_IRQn);
-			}
-			else if(config->Request.Stream == DMA2_Stream2){
-				__DMA2_Stream2_Config__ = config;
-				NVIC_EnableIRQ(DMA2_Stream2_IRQn);
-			}
-			else if(config->Request.Stream == DMA2_Stream3){
-				__DMA2_Stream3_Config__ = config;
-				NVIC_EnableIRQ(DMA2_Stream3_IRQn);
-			}
-			else if(config->Request.Stream == DMA2_Stream4){
-				__DMA2_Stream4_Config__ = config;
-				NVIC_EnableIRQ(DMA2_Stream4_IRQn);
-			}
-			else if(config->Request.Stream == DMA2_Stream5){
-				__DMA2_Stream5_Config__ = config;
-				NVIC_EnableIRQ(DMA2_Stream5_IRQn);
-			}
-			else if(config->Request.Stream == DMA2_Stream6){
-				__DMA2_Stream6_Config__ = config;
-				NVIC_EnableIRQ(DMA2_Stream6_IRQn);
-			}
-			else if(config->Request.Stream == DMA2_Stream7){
-				__DMA2_Stream7_Config__ = config;
-				//            	NVIC_SetPriority(DMA2_Stream7_IRQn,0);
-				NVIC_EnableIRQ(DMA2_Stream7_IRQn);
-
-			}
-		}
+		// Hand the stream to the interrupt dispatcher and enable its NVIC line
+		int8_t index = DMA_Stream_Index(config->Request.Stream);
+		if(index < 0) return -1;
+
+		DMA_Stream_Register(index, config);
+		NVIC_EnableIRQ(dma_stream_hardware[index].IRQ);
 	}
 
 	// Configure memory and peripheral pointer increments
@@ -1620,40 +424,15 @@ void DMA_Set_Target(DMA_Config *config)
  */
 void DMA_Set_Trigger(DMA_Config *config)
 {
-	// Bit shift values for streams 0 to 7
-	static const uint8_t LIFCR_Shifts[4] = {0, 6, 16, 22};
-	static const uint8_t HIFCR_Shifts[4] = {0, 6, 16, 22};
-
-	DMA_TypeDef *controller = config->Request.Controller;
 	DMA_Stream_TypeDef *stream = config->Request.Stream;
-	uint32_t shift;
+	int8_t index = DMA_Stream_Index(stream);
 
-	if (controller == DMA1 || controller == DMA2)
-	{
-		// Determine the correct shift value and clear the corresponding flags in LIFCR or HIFCR
-		if (stream >= DMA1_Stream0 && stream <= DMA1_Stream3)
-		{
-			shift = LIFCR_Shifts[stream - DMA1_Stream0];
-			controller->LIFCR |= 0x3F << shift;  // Clear interrupt flags for the stream
-		}
-		else if (stream >= DMA1_Stream4 && stream <= DMA1_Stream7)
-		{
-			shift = HIFCR_Shifts[stream - DMA1_Stream4];
-			controller->HIFCR |= 0x3F << shift;  // Clear interrupt flags for the stream
-		}
-		else if (stream >= DMA2_Stream0 && stream <= DMA2_Stream3)
-		{
-			shift = LIFCR_Shifts[stream - DMA2_Stream0];
-			controller->LIFCR |= 0x3F << shift;  // Clear interrupt flags for the stream
-		}
-		else if (stream >= DMA2_Stream4 && stream <= DMA2_Stream7)
-		{
-			shift = HIFCR_Shifts[stream - DMA2_Stream4];
-			controller->HIFCR |= 0x3F << shift;  // Clear interrupt flags for the stream
-		}
+	if(index < 0) return;
 
-		stream->CR |= DMA_SxCR_EN;  // Enable the DMA stream
-	}
+	// Clear interrupt flags for the stream, the clear register is write-one-to-clear
+	*dma_stream_hardware[index].Clear = DMA_STREAM_FLAGS << dma_stream_hardware[index].Shift;
+
+	stream->CR |= DMA_SxCR_EN;  // Enable the DMA stream
 }
 
 void DMA_Disable_Target(DMA_Config *config)
@@ -1665,120 +444,473 @@ void DMA_Disable_Target(DMA_Config *config)
 
 
 
-/**
- * @brief Performs a memory-to-memory data transfer using DMA.
+/*
+ * Memory-to-memory engine
  *
- * This function configures and initiates a DMA transfer from a source memory
- * location to a destination memory location. It sets up the data size,
- * increment modes, and the length of the transfer. The function enables the
- * DMA stream, waits for the transfer to complete, and then disables the stream.
+ * Jobs are queued and dispatched to every DMA2 stream the engine owns. Only
+ * DMA2 can do memory-to-memory transfers. A stream is free when no peripheral
+ * has claimed it with DMA_Init before DMA_M2M_Init runs.
  *
- * @param[in] source Pointer to the source memory location.
- * @param[in] source_data_size Size of the data at the source (8, 16, or 32 bits).
- * @param[in] dest_data_size Size of the data at the destination (8, 16, or 32 bits).
- * @param[in] destination Pointer to the destination memory location.
- * @param[in] source_increment If true, the source address will be incremented after each transfer.
- * @param[in] destination_increment If true, the destination address will be incremented after each transfer.
- * @param[in] length Number of data items to transfer.
+ * NDTR holds at most 65535 items, a longer job runs as consecutive pieces on
+ * the stream it was dispatched to. The next piece is started from the transfer
+ * complete interrupt and the callback runs once, after the last one.
  */
-//void DMA_Memory_To_Memory_Transfer(volatile void *source,
-//		uint8_t source_data_size, uint8_t dest_data_size,
-//		volatile void *destination, bool source_increment,
-//		bool destination_increment, uint16_t length)
 
-void DMA_Memory_To_Memory_Transfer(volatile void *source,
-		uint8_t source_data_size, bool source_increment,
-		volatile void *destination, uint8_t dest_data_size,
-		bool destination_increment, uint16_t length)
+typedef struct DMA_M2M_Job
 {
-	// Enable DMA2 clock
-	RCC -> AHB1ENR |= RCC_AHB1ENR_DMA2EN;
-
-	// Clear the channel selection and set the transfer direction to memory-to-memory
-	DMA2_Stream0->CR &= (DMA_SxCR_CHSEL);
-	DMA2_Stream0->CR |= DMA_Configuration.Transfer_Direction.Memory_to_memory;
+	uint32_t Source;
+	uint32_t Destination;
+	uint32_t Count;				// Items of Source_Size bytes still to transfer
+	uint16_t Piece;				// Items of the piece running
+	uint8_t Source_Size;		// 1, 2 or 4 bytes
+	uint8_t Destination_Size;	// 1, 2 or 4 bytes
+	bool Source_Increment;
+	bool Destination_Increment;
+	uint32_t Pattern;			// Source of fill jobs, kept with the job while it runs
+	bool Fill;
+	DMA_M2M_Callback Callback;
+	void *Context;
+}DMA_M2M_Job;
+
+/* DMA2 streams are entries 8 to 15 of the stream table */
+#define DMA_M2M_STREAM(index)	(&dma_stream_hardware[8 + (index)])
+
+/* Largest piece, a multiple of 16 items so the pieces after the first keep the 16 byte alignment bursts need */
+#define DMA_M2M_PIECE			0xFFF0
+
+static DMA_M2M_Job dma_m2m_queue[DMA_M2M_QUEUE_LENGTH];
+static uint8_t dma_m2m_head;
+static uint8_t dma_m2m_tail;
+
+static DMA_Config dma_m2m_config[8];
+static DMA_M2M_Job dma_m2m_active[8];
+static uint8_t dma_m2m_streams;			// Streams owned by the engine
+static volatile uint8_t dma_m2m_busy;	// Streams running a job
+static bool dma_m2m_ready;
+
+volatile uint32_t DMA_M2M_Errors = 0;
+
+static uint32_t DMA_M2M_Size_Bits(uint8_t size)
+{
+	return (size == 4) ? 2 : (size == 2) ? 1 : 0;
+}
 
-	// Set the transfer complete interrupt and priority level
-	DMA2_Stream0->CR |= (DMA_SxCR_TCIE | DMA_SxCR_PL);
+static void DMA_M2M_Start(uint8_t index, DMA_M2M_Job *job)
+{
+	DMA_Stream_TypeDef *stream = DMA_M2M_STREAM(index)->Stream;
 
-	// Set the peripheral data size based on the source data size
-	if(source_data_size == 32)
+	if(job != &dma_m2m_active[index])
 	{
-		DMA2_Stream0->CR |= DMA_SxCR_PSIZE;
+		dma_m2m_active[index] = *job;
+		job = &dma_m2m_active[index];
 	}
-	else if(source_data_size == 16)
+
+	job->Piece = (job->Count > DMA_M2M_PIECE) ? DMA_M2M_PIECE : (uint16_t)job->Count;
+
+	stream->CR = 0;
+	while(stream->CR & DMA_SxCR_EN){}
+
+	// IFCR is write-one-to-clear, clear all flags of this stream only
+	*DMA_M2M_STREAM(index)->Clear = DMA_STREAM_FLAGS << DMA_M2M_STREAM(index)->Shift;
+
+	stream->PAR = job->Fill ? (uint32_t)&job->Pattern : job->Source;
+	stream->M0AR = job->Destination;
+	stream->NDTR = job->Piece;
+
+	// FIFO mode with full threshold, needed for memory-to-memory and for bursts
+	stream->FCR = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH;
+
+	uint32_t cr = DMA_SxCR_DIR_1 | DMA_SxCR_TCIE | DMA_SxCR_TEIE
+			| (DMA_M2M_Size_Bits(job->Source_Size) << DMA_SxCR_PSIZE_Pos)
+			| (DMA_M2M_Size_Bits(job->Destination_Size) << DMA_SxCR_MSIZE_Pos);
+
+	if(job->Source_Increment) cr |= DMA_SxCR_PINC;
+	if(job->Destination_Increment) cr |= DMA_SxCR_MINC;
+
+	// A burst fills the 16 byte FIFO, only used when no burst can cross a 1 KB boundary
+	uint32_t bytes = (uint32_t)job->Piece * job->Source_Size;
+	if((job->Source_Size == job->Destination_Size) && job->Destination_Increment
+			&& ((stream->PAR & 0xF) == 0) && ((job->Destination & 0xF) == 0) && ((bytes & 0xF) == 0))
 	{
-		DMA2_Stream0->CR |= DMA_SxCR_PSIZE_0;
-		DMA2_Stream0->CR &= ~DMA_SxCR_PSIZE_1;
+		uint32_t burst = (job->Source_Size == 4) ? 1 : (job->Source_Size == 2) ? 2 : 3;	// INCR4 / INCR8 / INCR16
+		cr |= (burst << DMA_SxCR_MBURST_Pos);
+		if(job->Source_Increment) cr |= (burst << DMA_SxCR_PBURST_Pos);
 	}
-	else
+
+	stream->CR = cr;
+	stream->CR |= DMA_SxCR_EN;
+}
+
+/* Starts queued jobs on idle streams, called with interrupts masked */
+static void DMA_M2M_Dispatch(void)
+{
+	for(uint8_t index = 0; (index < 8) && (dma_m2m_tail != dma_m2m_head); index++)
 	{
-		DMA2_Stream0->CR &= ~DMA_SxCR_PSIZE;
+		uint8_t mask = 1 << index;
+
+		if(((dma_m2m_streams & mask) == 0) || (dma_m2m_busy & mask)) continue;
+
+		dma_m2m_busy |= mask;
+		DMA_M2M_Start(index, &dma_m2m_queue[dma_m2m_tail]);
+		dma_m2m_tail = (dma_m2m_tail + 1) & (DMA_M2M_QUEUE_LENGTH - 1);
 	}
+}
+
+/*
+ * Runs from the stream interrupt after the dispatcher acknowledged the flags, so the
+ * next piece or job can be started right away. A transfer error ends the job.
+ */
+static void DMA_M2M_Complete(uint8_t index, bool error)
+{
+	DMA_M2M_Job *job = &dma_m2m_active[index];
+	DMA_M2M_Callback callback = job->Callback;
+	void *context = job->Context;
+	DMA_Stream_TypeDef *stream = DMA_M2M_STREAM(index)->Stream;
 
-	// Set the memory data size based on the destination data size
-	if(dest_data_size == 32)
+	/*
+	 * Transfer error and complete reported together: the error already finished the
+	 * job, the stream is either idle or running the next job.
+	 */
+	if(((dma_m2m_busy & (1 << index)) == 0) || (!error && (stream->CR & DMA_SxCR_EN))) return;
+
+	if(error)
 	{
-		DMA2_Stream0->CR |= DMA_SxCR_MSIZE;
+		DMA_M2M_Errors++;
+		stream->CR &= ~DMA_SxCR_EN;
 	}
-	else if(dest_data_size == 16)
+	else if(job->Count > job->Piece)
 	{
-		DMA2_Stream0->CR |= DMA_SxCR_MSIZE_0;
-		DMA2_Stream0->CR &= ~DMA_SxCR_MSIZE_1;
+		uint32_t piece = job->Piece;
+
+		job->Count -= piece;
+		if(job->Source_Increment) job->Source += piece * job->Source_Size;
+		if(job->Destination_Increment) job->Destination += piece * job->Destination_Size;
+
+		DMA_M2M_Start(index, job);
+		return;
 	}
-	else
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	dma_m2m_busy &= ~(1 << index);
+	DMA_M2M_Dispatch();
+	__set_PRIMASK(primask);
+
+	if(callback) callback(context);
+}
+
+static void DMA_M2M_Stream0_Complete(void) { DMA_M2M_Complete(0, 0); }
+static void DMA_M2M_Stream1_Complete(void) { DMA_M2M_Complete(1, 0); }
+static void DMA_M2M_Stream2_Complete(void) { DMA_M2M_Complete(2, 0); }
+static void DMA_M2M_Stream3_Complete(void) { DMA_M2M_Complete(3, 0); }
+static void DMA_M2M_Stream4_Complete(void) { DMA_M2M_Complete(4, 0); }
+static void DMA_M2M_Stream5_Complete(void) { DMA_M2M_Complete(5, 0); }
+static void DMA_M2M_Stream6_Complete(void) { DMA_M2M_Complete(6, 0); }
+static void DMA_M2M_Stream7_Complete(void) { DMA_M2M_Complete(7, 0); }
+
+static void DMA_M2M_Stream0_Error(void) { DMA_M2M_Complete(0, 1); }
+static void DMA_M2M_Stream1_Error(void) { DMA_M2M_Complete(1, 1); }
+static void DMA_M2M_Stream2_Error(void) { DMA_M2M_Complete(2, 1); }
+static void DMA_M2M_Stream3_Error(void) { DMA_M2M_Complete(3, 1); }
+static void DMA_M2M_Stream4_Error(void) { DMA_M2M_Complete(4, 1); }
+static void DMA_M2M_Stream5_Error(void) { DMA_M2M_Complete(5, 1); }
+static void DMA_M2M_Stream6_Error(void) { DMA_M2M_Complete(6, 1); }
+static void DMA_M2M_Stream7_Error(void) { DMA_M2M_Complete(7, 1); }
+
+static void (*const dma_m2m_complete_isr[8])(void) =
+{
+	DMA_M2M_Stream0_Complete, DMA_M2M_Stream1_Complete, DMA_M2M_Stream2_Complete, DMA_M2M_Stream3_Complete,
+	DMA_M2M_Stream4_Complete, DMA_M2M_Stream5_Complete, DMA_M2M_Stream6_Complete, DMA_M2M_Stream7_Complete,
+};
+
+static void (*const dma_m2m_error_isr[8])(void) =
+{
+	DMA_M2M_Stream0_Error, DMA_M2M_Stream1_Error, DMA_M2M_Stream2_Error, DMA_M2M_Stream3_Error,
+	DMA_M2M_Stream4_Error, DMA_M2M_Stream5_Error, DMA_M2M_Stream6_Error, DMA_M2M_Stream7_Error,
+};
+
+int8_t DMA_M2M_Init(uint8_t stream_mask)
+{
+	RCC -> AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+
+	dma_m2m_streams = 0;
+	dma_m2m_busy = 0;
+	dma_m2m_head = 0;
+	dma_m2m_tail = 0;
+
+	for(uint8_t index = 0; index < 8; index++)
 	{
-		DMA2_Stream0->CR &= ~DMA_SxCR_MSIZE;
+		DMA_Config *owner = dma_stream_context[8 + index].Config;
+
+		if((stream_mask & (1 << index)) == 0) continue;
+
+		// Leave streams alone that a peripheral already uses
+		if((owner != NULL) && (owner != &dma_m2m_config[index])) continue;
+
+		dma_m2m_config[index].Request.Controller = DMA2;
+		dma_m2m_config[index].Request.Stream = DMA_M2M_STREAM(index)->Stream;
+		dma_m2m_config[index].Request.channel = 0;
+		dma_m2m_config[index].transfer_direction = DMA_Configuration.Transfer_Direction.Memory_to_memory;
+		dma_m2m_config[index].interrupts = DMA_Configuration.DMA_Interrupts.Transfer_Complete | DMA_Configuration.DMA_Interrupts.Transfer_Error;
+		dma_m2m_config[index].ISR_Routines.Full_Transfer_Commplete_ISR = dma_m2m_complete_isr[index];
+		dma_m2m_config[index].ISR_Routines.Transfer_Error_ISR = dma_m2m_error_isr[index];
+
+		DMA_Stream_Register(8 + index, &dma_m2m_config[index]);
+		dma_m2m_streams |= 1 << index;
+		NVIC_EnableIRQ(DMA_M2M_STREAM(index)->IRQ);
 	}
 
-	// Configure source address increment mode
-	if(source_increment)
+	dma_m2m_ready = true;
+	return (dma_m2m_streams != 0) ? 1 : -1;
+}
+
+/* Copies a job into the queue, waits for room unless called with interrupts masked */
+static int8_t DMA_M2M_Enqueue(const DMA_M2M_Job *job)
+{
+	if(!dma_m2m_ready) DMA_M2M_Init(DMA_M2M_DEFAULT_STREAMS);
+	if((dma_m2m_streams == 0) || (job->Count == 0)) return -1;
+
+	for(;;)
 	{
-		DMA2_Stream0->CR |= DMA_SxCR_PINC;
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+
+		uint8_t next = (dma_m2m_head + 1) & (DMA_M2M_QUEUE_LENGTH - 1);
+		if(next != dma_m2m_tail)
+		{
+			dma_m2m_queue[dma_m2m_head] = *job;
+			dma_m2m_head = next;
+			DMA_M2M_Dispatch();
+			__set_PRIMASK(primask);
+			return 1;
+		}
+
+		__set_PRIMASK(primask);
+
+		if(primask) return 0;
 	}
-	else
+}
+
+int8_t DMA_M2M_Submit(volatile void *destination, uint8_t destination_size, bool destination_increment,
+		const volatile void *source, uint8_t source_size, bool source_increment,
+		uint16_t count, DMA_M2M_Callback callback, void *context)
+{
+	DMA_M2M_Job job;
+
+	job.Source = (uint32_t)source;
+	job.Destination = (uint32_t)destination;
+	job.Count = count;
+	job.Source_Size = source_size;
+	job.Destination_Size = destination_size;
+	job.Source_Increment = source_increment;
+	job.Destination_Increment = destination_increment;
+	job.Pattern = 0;
+	job.Fill = false;
+	job.Callback = callback;
+	job.Context = context;
+
+	return DMA_M2M_Enqueue(&job);
+}
+
+static uint8_t DMA_M2M_Item_Size(uint32_t destination, uint32_t source, uint32_t length)
+{
+	uint32_t bits = destination | source | length;
+
+	return ((bits & 3) == 0) ? 4 : ((bits & 1) == 0) ? 2 : 1;
+}
+
+int8_t DMA_M2M_Copy(volatile void *destination, const volatile void *source, uint32_t length,
+		DMA_M2M_Callback callback, void *context)
+{
+	if(length < DMA_M2M_CPU_THRESHOLD)
 	{
-		DMA2_Stream0->CR &= ~DMA_SxCR_PINC;
+		memcpy((void *)destination, (const void *)source, length);
+		if(callback) callback(context);
+		return 1;
 	}
 
-	// Configure destination address increment mode
-	if(destination_increment)
+	DMA_M2M_Job job;
+	uint8_t size = DMA_M2M_Item_Size((uint32_t)destination, (uint32_t)source, length);
+
+	job.Source = (uint32_t)source;
+	job.Destination = (uint32_t)destination;
+	job.Count = length / size;
+	job.Source_Size = size;
+	job.Destination_Size = size;
+	job.Source_Increment = true;
+	job.Destination_Increment = true;
+	job.Pattern = 0;
+	job.Fill = false;
+	job.Callback = callback;
+	job.Context = context;
+
+	return DMA_M2M_Enqueue(&job);
+}
+
+int8_t DMA_M2M_Fill(volatile void *destination, uint8_t value, uint32_t length,
+		DMA_M2M_Callback callback, void *context)
+{
+	if(length < DMA_M2M_CPU_THRESHOLD)
 	{
-		DMA2_Stream0->CR |= DMA_SxCR_MINC;
+		memset((void *)destination, value, length);
+		if(callback) callback(context);
+		return 1;
 	}
-	else
+
+	DMA_M2M_Job job;
+	uint8_t size = DMA_M2M_Item_Size((uint32_t)destination, 0, length);
+
+	job.Source = 0;
+	job.Destination = (uint32_t)destination;
+	job.Count = length / size;
+	job.Source_Size = size;
+	job.Destination_Size = size;
+	job.Source_Increment = false;
+	job.Destination_Increment = true;
+	job.Pattern = value * 0x01010101UL;
+	job.Fill = true;
+	job.Callback = callback;
+	job.Context = context;
+
+	return DMA_M2M_Enqueue(&job);
+}
+
+uint8_t DMA_M2M_Pending(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint8_t pending = (uint8_t)((dma_m2m_head - dma_m2m_tail) & (DMA_M2M_QUEUE_LENGTH - 1));
+	uint8_t busy = dma_m2m_busy;
+
+	__set_PRIMASK(primask);
+
+	while(busy)
+	{
+		pending += busy & 1;
+		busy >>= 1;
+	}
+
+	return pending;
+}
+
+void DMA_M2M_Wait_Idle(void)
+{
+	while(DMA_M2M_Pending() != 0){}
+}
+
+static volatile uint32_t dma_benchmark_cycles;
+static volatile bool dma_benchmark_done;
+
+static void DMA_Benchmark_Complete(void)
+{
+	dma_benchmark_cycles = DWT->CYCCNT - DMA_ISR_Entry_Cycles;
+	dma_benchmark_done = true;
+}
+
+int8_t DMA_Benchmark_ISR_Latency(uint16_t runs, DMA_Latency_Result *result)
+{
+	static uint32_t source[16];
+	static uint32_t destination[16];
+	DMA_Config config;
+	DMA_M2M_Job job;
+	uint8_t index;
+
+	if((runs == 0) || (__get_PRIMASK() != 0)) return -1;
+	if(!dma_m2m_ready) DMA_M2M_Init(DMA_M2M_DEFAULT_STREAMS);
+	if(dma_m2m_streams == 0) return -1;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	for(index = 0; (dma_m2m_streams & (1 << index)) == 0; index++){}
+
+	// Borrow an engine stream once it is idle so no queued job lands on it meanwhile
+	for(;;)
 	{
-		DMA2_Stream0->CR &= ~DMA_SxCR_MINC;
+		__disable_irq();
+		if((dma_m2m_busy & (1 << index)) == 0) break;
+		__enable_irq();
 	}
+	dma_m2m_busy |= 1 << index;
+	__enable_irq();
+
+	memset(&config, 0, sizeof(config));
+	config.Request.Controller = DMA2;
+	config.Request.Stream = DMA_M2M_STREAM(index)->Stream;
+	config.interrupts = DMA_Configuration.DMA_Interrupts.Transfer_Complete;
+	config.ISR_Routines.Full_Transfer_Commplete_ISR = DMA_Benchmark_Complete;
+	DMA_Stream_Register(8 + index, &config);
+
+	memset(&job, 0, sizeof(job));
+	job.Source = (uint32_t)source;
+	job.Destination = (uint32_t)destination;
+	job.Count = 16;
+	job.Source_Size = 4;
+	job.Destination_Size = 4;
+	job.Source_Increment = true;
+	job.Destination_Increment = true;
 
-	DMA2_Stream0->FCR |= DMA_SxFCR_DMDIS;
+	result->Runs = runs;
+	result->Min_Cycles = UINT32_MAX;
+	result->Max_Cycles = 0;
 
-	// Set the peripheral address (source)
-	DMA2_Stream0->PAR = (uint32_t)(source);
+	uint64_t total = 0;
 
-	// Set the memory address (destination)
-	DMA2_Stream0->M0AR = (uint32_t)(destination);
+	for(uint16_t run = 0; run < runs; run++)
+	{
+		dma_benchmark_done = false;
+		DMA_M2M_Start(index, &job);
+		while(!dma_benchmark_done){}
+
+		uint32_t cycles = dma_benchmark_cycles;
+		total += cycles;
+		if(cycles < result->Min_Cycles) result->Min_Cycles = cycles;
+		if(cycles > result->Max_Cycles) result->Max_Cycles = cycles;
+	}
+
+	result->Mean_Cycles = (uint32_t)(total / runs);
 
-	// Set the number of data items to transfer
-	DMA2_Stream0->NDTR = (uint16_t)length;
+	// Hand the stream back to the engine
+	DMA_Stream_Register(8 + index, &dma_m2m_config[index]);
 
-	// Enable the DMA stream
-	DMA2_Stream0->CR |= DMA_SxCR_EN;
+	__disable_irq();
+	dma_m2m_busy &= ~(1 << index);
+	DMA_M2M_Dispatch();
+	__enable_irq();
 
-	// Wait for the transfer to complete
-	while((DMA2->LISR & (DMA_LISR_TCIF0_Msk)) == 0) {}
+	return 1;
+}
 
-	// Clear the transfer complete flag
-	DMA2->LIFCR |= DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0;
+static void DMA_M2M_Blocking_Done(void *context)
+{
+	*(volatile bool *)context = true;
+}
 
-	// Disable the DMA stream
+/**
+ * @brief Performs a memory-to-memory data transfer using DMA.
+ *
+ * The transfer is queued on the memory-to-memory engine like any other job and
+ * the function waits for its completion callback.
+ *
+ * @param[in] source Pointer to the source memory location.
+ * @param[in] source_data_size Size of the data at the source (8, 16, or 32 bits).
+ * @param[in] source_increment If true, the source address will be incremented after each transfer.
+ * @param[in] destination Pointer to the destination memory location.
+ * @param[in] dest_data_size Size of the data at the destination (8, 16, or 32 bits).
+ * @param[in] destination_increment If true, the destination address will be incremented after each transfer.
+ * @param[in] length Number of data items to transfer.
+ */
+void DMA_Memory_To_Memory_Transfer(volatile void *source,
+		uint8_t source_data_size, bool source_increment,
+		volatile void *destination, uint8_t dest_data_size,
+		bool destination_increment, uint16_t length)
+{
+	volatile bool done = false;
 
-	DMA2_Stream0->CR = 0;
-	DMA2_Stream0->FCR = 0;
-	DMA2_Stream0->M0AR = 0;
-	DMA2_Stream0->M1AR = 0;
-	DMA2_Stream0->NDTR= 0;
-	DMA2_Stream0->PAR = 0;
+	if(DMA_M2M_Submit(destination, dest_data_size / 8, destination_increment,
+			source, source_data_size / 8, source_increment,
+			length, DMA_M2M_Blocking_Done, (void *)&done) != 1) return;
 
-	DMA2_Stream0->CR &= ~DMA_SxCR_EN;
+	while(!done){}
 }
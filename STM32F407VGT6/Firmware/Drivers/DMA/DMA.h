@@ -46,7 +46,24 @@
  * - `int8_t DMA_Init(DMA_Config *config)`: Initializes the DMA with the specified configuration.
  * - `void DMA_Set_Target(DMA_Config *config)`: Configures the target memory and peripheral for DMA transfers.
  * - `void DMA_Set_Trigger(DMA_Config *config)`: Sets up and enables the DMA stream for data transfer.
- * - `void DMA_Memory_To_Memory_Transfer(uint32_t *source, uint8_t source_data_size, uint8_t dest_data_size, uint32_t *destination, bool source_increment, bool destination_increment, uint16_t length)`: Performs a memory-to-memory data transfer using DMA.
+ * - `void DMA_Memory_To_Memory_Transfer(...)`: Performs a blocking memory-to-memory data transfer using DMA.
+ * - `int8_t DMA_M2M_Copy(...)` / `int8_t DMA_M2M_Fill(...)`: Queue an asynchronous memcpy / memset job.
+ * - `int8_t DMA_Get_Counters(...)`: Reads the per-stream interrupt event counters.
+ *
+ * @section isr_sec Interrupt Dispatch
+ *
+ * All sixteen stream interrupts share one table driven handler. It acknowledges the
+ * pending flags of the stream with a single write to LIFCR/HIFCR and then calls the
+ * callbacks registered by `DMA_Init` in the order FIFO error, direct mode error,
+ * transfer error, half transfer, transfer complete.
+ *
+ * @section m2m_sec Memory-to-Memory Engine
+ *
+ * Memory-to-memory jobs are queued and spread over the DMA2 streams no peripheral
+ * has claimed (by default Stream 3 and Stream 4). Each job runs with the FIFO enabled,
+ * uses bursts when addresses and length allow it and reports back through a callback
+ * from the stream interrupt. Jobs shorter than `DMA_M2M_CPU_THRESHOLD` bytes are
+ * cheaper to do with the CPU and are completed in place.
  *
  * @section usage_sec Usage
  *
@@ -55,7 +72,7 @@
  * 1. **Configure the DMA settings**: Initialize a `DMA_Config` structure with your desired settings.
  * 2. **Initialize the DMA**: Call `DMA_Init` with the configuration structure.
  * 3. **Set up data transfer**: Use `DMA_Set_Target` and `DMA_Set_Trigger` to configure the transfer settings.
- * 4. **Start the transfer**: If using memory-to-memory transfer, call `DMA_Memory_To_Memory_Transfer`.
+ * 4. **Start the transfer**: If using memory-to-memory transfer, call `DMA_M2M_Copy` or `DMA_Memory_To_Memory_Transfer`.
  *
  * @section example_sec Example
  *
@@ -113,6 +130,46 @@
 #include "main.h"
 #include "DMA_Defs.h"
 
+/** Length of the memory-to-memory job queue, must be a power of 2 */
+#define DMA_M2M_QUEUE_LENGTH		16
+
+/** DMA2 streams used for memory-to-memory jobs unless @ref DMA_M2M_Init says otherwise */
+#define DMA_M2M_DEFAULT_STREAMS		((1 << 3) | (1 << 4))
+
+/** Jobs shorter than this many bytes are done by the CPU */
+#define DMA_M2M_CPU_THRESHOLD		64
+
+/** Completion callback of a memory-to-memory job, runs in interrupt context */
+typedef void (*DMA_M2M_Callback)(void *context);
+
+/** Set to 0 to drop the per-stream event counters from the interrupt path */
+#ifndef DMA_STREAM_COUNTERS
+#define DMA_STREAM_COUNTERS			1
+#endif
+
+/**
+ * @brief Events seen by the interrupt of one stream, see @ref DMA_Get_Counters.
+ */
+typedef struct DMA_Stream_Counters
+{
+	uint32_t Interrupts;			/**< Interrupts taken */
+	uint32_t Transfer_Complete;		/**< Transfer complete flags */
+	uint32_t Half_Transfer;			/**< Half transfer flags */
+	uint32_t Transfer_Error;		/**< Transfer error flags */
+	uint32_t Fifo_Error;			/**< FIFO error flags */
+	uint32_t Direct_Mode_Error;		/**< Direct mode error flags */
+}DMA_Stream_Counters;
+
+/**
+ * @brief Result of @ref DMA_Benchmark_ISR_Latency.
+ */
+typedef struct DMA_Latency_Result
+{
+	uint16_t Runs;					/**< Number of measured interrupts */
+	uint32_t Min_Cycles;			/**< Fastest interrupt entry to callback */
+	uint32_t Max_Cycles;			/**< Slowest interrupt entry to callback */
+	uint32_t Mean_Cycles;			/**< Average interrupt entry to callback */
+}DMA_Latency_Result;
 
 /**
  * @brief DMA configuration structure.
@@ -196,13 +253,16 @@ void DMA_Set_Target(DMA_Config *config);
 void DMA_Set_Trigger(DMA_Config *config);
 
 /**
- * @brief Performs a memory-to-memory data transfer using DMA.
+ * @brief Performs a memory-to-memory data transfer using DMA and waits for it.
+ *
+ * The transfer is queued on the memory-to-memory engine, so it does not disturb
+ * streams used by peripherals. Must not be called with interrupts masked.
  *
  * @param[in] source Pointer to the source memory location.
  * @param[in] source_data_size Size of the data at the source (8, 16, or 32 bits).
- * @param[in] dest_data_size Size of the data at the destination (8, 16, or 32 bits).
- * @param[in] destination Pointer to the destination memory location.
  * @param[in] source_increment If true, the source address will be incremented after each transfer.
+ * @param[in] destination Pointer to the destination memory location.
+ * @param[in] dest_data_size Size of the data at the destination (8, 16, or 32 bits).
  * @param[in] destination_increment If true, the destination address will be incremented after each transfer.
  * @param[in] length Number of data items to transfer.
  */
@@ -211,6 +271,125 @@ void DMA_Memory_To_Memory_Transfer(volatile void *source,
 		volatile void *destination, uint8_t dest_data_size,
 		bool destination_increment, uint16_t length);
 
+/**
+ * @brief Hands the memory-to-memory engine its streams.
+ *
+ * Streams in `stream_mask` (bit n for DMA2 Stream n) that are already claimed by
+ * @ref DMA_Init are skipped. Call this after the peripherals are set up; the first
+ * job initializes the engine with `DMA_M2M_DEFAULT_STREAMS` otherwise.
+ *
+ * @param[in] stream_mask DMA2 streams the engine may use.
+ *
+ * @return int8_t Returns 1 if at least one stream is available, -1 otherwise.
+ */
+int8_t DMA_M2M_Init(uint8_t stream_mask);
+
+/**
+ * @brief Queues a memory-to-memory job with explicit item sizes.
+ *
+ * @param[out] destination Destination address.
+ * @param[in] destination_size Destination item size in bytes (1, 2 or 4).
+ * @param[in] destination_increment Increment the destination after each item.
+ * @param[in] source Source address.
+ * @param[in] source_size Source item size in bytes (1, 2 or 4).
+ * @param[in] source_increment Increment the source after each item.
+ * @param[in] count Number of source items.
+ * @param[in] callback Called from the stream interrupt when the job is done, may be NULL.
+ * @param[in] context Passed to `callback`.
+ *
+ * @return int8_t Returns 1 when queued, 0 if the queue is full and interrupts are masked, -1 on error.
+ */
+int8_t DMA_M2M_Submit(volatile void *destination, uint8_t destination_size, bool destination_increment,
+		const volatile void *source, uint8_t source_size, bool source_increment,
+		uint16_t count, DMA_M2M_Callback callback, void *context);
+
+/**
+ * @brief Asynchronous memcpy.
+ *
+ * The widest item size the alignment of both buffers and the length allow is used.
+ * Copies of more than 65535 items run as consecutive pieces on one stream, still
+ * one job with one callback. Copies shorter than `DMA_M2M_CPU_THRESHOLD` bytes are
+ * done by the CPU before returning. A transfer error ends the copy, counts in
+ * @ref DMA_M2M_Errors and still calls `callback`.
+ *
+ * @param[out] destination Destination buffer.
+ * @param[in] source Source buffer, must stay valid until the callback.
+ * @param[in] length Number of bytes.
+ * @param[in] callback Called once the whole copy is done, may be NULL.
+ * @param[in] context Passed to `callback`.
+ *
+ * @return int8_t Returns 1 when queued, 0 if the queue is full and interrupts are masked, -1 on error.
+ */
+int8_t DMA_M2M_Copy(volatile void *destination, const volatile void *source, uint32_t length,
+		DMA_M2M_Callback callback, void *context);
+
+/**
+ * @brief Asynchronous memset.
+ *
+ * Split and reported like @ref DMA_M2M_Copy.
+ *
+ * @param[out] destination Destination buffer.
+ * @param[in] value Byte value to fill with.
+ * @param[in] length Number of bytes.
+ * @param[in] callback Called once the whole fill is done, may be NULL.
+ * @param[in] context Passed to `callback`.
+ *
+ * @return int8_t Returns 1 when queued, 0 if the queue is full and interrupts are masked, -1 on error.
+ */
+int8_t DMA_M2M_Fill(volatile void *destination, uint8_t value, uint32_t length,
+		DMA_M2M_Callback callback, void *context);
+
+/**
+ * @brief Number of memory-to-memory jobs queued or running.
+ */
+uint8_t DMA_M2M_Pending(void);
+
+/**
+ * @brief Waits until all memory-to-memory jobs are done.
+ */
+void DMA_M2M_Wait_Idle(void);
+
+/** Memory-to-memory jobs that ended with a transfer error */
+extern volatile uint32_t DMA_M2M_Errors;
+
+/** DWT cycle counter sampled on entry of the last DMA stream interrupt */
+extern volatile uint32_t DMA_ISR_Entry_Cycles;
+
+#if DMA_STREAM_COUNTERS
+/**
+ * @brief Reads the event counters of a stream.
+ *
+ * @param[in] stream DMA stream, e.g. `DMA2_Stream0`.
+ * @param[out] counters Copy of the counters.
+ *
+ * @return int8_t Returns 1 on success, -1 if `stream` is not a DMA stream.
+ */
+int8_t DMA_Get_Counters(const DMA_Stream_TypeDef *stream, DMA_Stream_Counters *counters);
+
+/**
+ * @brief Clears the event counters of a stream.
+ *
+ * @param[in] stream DMA stream, e.g. `DMA2_Stream0`.
+ *
+ * @return int8_t Returns 1 on success, -1 if `stream` is not a DMA stream.
+ */
+int8_t DMA_Reset_Counters(const DMA_Stream_TypeDef *stream);
+#endif
+
+/**
+ * @brief Measures the cycles from DMA interrupt entry to the start of the callback.
+ *
+ * Runs `runs` short memory-to-memory transfers on a stream borrowed from the
+ * memory-to-memory engine. The fixed 12 cycle exception entry of the core comes
+ * on top of the measured figure. Must not be called with interrupts masked.
+ *
+ * @param[in] runs Number of interrupts to measure.
+ * @param[out] result Minimum, maximum and mean cycles.
+ *
+ * @return int8_t Returns 1 on success, -1 if no engine stream is available.
+ */
+int8_t DMA_Benchmark_ISR_Latency(uint16_t runs, DMA_Latency_Result *result);
+
 
 void DMA_Disable_Target(DMA_Config *config);
 
@@ -0,0 +1,172 @@
+/**
+ * @file Deadband.c
+ * @brief Change-only reporting of the temperatures with per-channel deadbands.
+ *
+ * Implementation of the reporting declared in @ref Deadband.h.
+ *
+ * @version 1.0
+ * @date 2025-06-18
+ *
+ * @author Kunal Salvi
+ */
+
+#include "Deadband.h"
+
+
+static uint8_t Deadband_Varint(uint8_t *out, uint32_t value)
+{
+	uint8_t length = 0;
+
+	while(value >= 0x80)
+	{
+		out[length++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	out[length++] = (uint8_t)value;
+
+	return length;
+}
+
+/* Small magnitudes of either sign become small codes: 0, -1, 1, -2 ... -> 0, 1, 2, 3 ... */
+static uint32_t Deadband_Zigzag(int32_t value)
+{
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+
+int8_t Deadband_Init(Deadband_Config *deadband, uint8_t channels)
+{
+	if((channels == 0) || (channels > DEADBAND_MAX_CHANNELS)) return -1;
+
+	deadband->Channels = channels;
+	deadband->Keyframe_Due = true;
+	deadband->Keyframe_Time = 0;
+	deadband->Record_Time = 0;
+	deadband->Frame_Time = 0;
+	deadband->Scans = 0;
+	deadband->Records = 0;
+	deadband->Values = 0;
+	deadband->Bytes = 0;
+
+	for(uint8_t ch = 0; ch < DEADBAND_MAX_CHANNELS; ch++)
+	{
+		deadband->Sent[ch] = 0;
+		deadband->Sent_Time[ch] = 0;
+	}
+
+	return 1;
+}
+
+void Deadband_Keyframe(Deadband_Config *deadband)
+{
+	deadband->Keyframe_Due = true;
+}
+
+uint16_t Deadband_Report(Deadband_Config *deadband, Telemetry_Config *telemetry, const int16_t *centi, uint16_t scans,
+		uint64_t time, uint32_t period)
+{
+	uint8_t channels = deadband->Channels;
+	uint64_t silence = (uint64_t)deadband->Max_Silence_ms * 1000000ULL;
+	uint64_t keyframe = (uint64_t)deadband->Keyframe_ms * 1000000ULL;
+	uint16_t records = 0;
+
+	if((scans == 0) || (period == 0)) return 0;
+
+	for(uint16_t scan = 0; scan < scans; scan++, centi += channels)
+	{
+		uint64_t now = time + (uint64_t)scan * period;
+		bool key = deadband->Keyframe_Due || ((keyframe != 0) && ((now - deadband->Keyframe_Time) >= keyframe));
+		uint16_t mask = 0;
+
+		for(uint8_t ch = 0; ch < channels; ch++)
+		{
+			int32_t change = (int32_t)centi[ch] - deadband->Sent[ch];
+			int32_t magnitude = (change < 0) ? -change : change;
+
+			if(key || ((magnitude != 0) && (magnitude >= deadband->Deadband_Centi[ch])) ||
+					((silence != 0) && ((now - deadband->Sent_Time[ch]) >= silence)))
+			{
+				mask |= 1U << ch;
+			}
+		}
+
+		if(mask == 0) continue;
+
+		// Encoded aside first, so the frame only has to make room for what the record really needs
+		uint8_t record[DEADBAND_RECORD_MAX(DEADBAND_MAX_CHANNELS)];
+		uint64_t skip = (deadband->Records == 0) ? 0 : (now - deadband->Record_Time + period / 2) / period;
+		uint8_t length = 0;
+
+		if(skip > (UINT32_MAX >> 1)) skip = UINT32_MAX >> 1;
+
+		length += Deadband_Varint(&record[length], ((uint32_t)skip << 1) | (key ? 1 : 0));
+		length += Deadband_Varint(&record[length], mask);
+
+		for(uint8_t ch = 0; ch < channels; ch++)
+		{
+			if(!(mask & (1U << ch))) continue;
+
+			int32_t value = key ? centi[ch] : (int32_t)centi[ch] - deadband->Sent[ch];
+
+			length += Deadband_Varint(&record[length], Deadband_Zigzag(value));
+		}
+
+		uint8_t *frame = Telemetry_Reserve_Bytes(telemetry, length);
+
+		if(frame == NULL) break;
+
+		if(telemetry->Scans == 0) deadband->Frame_Time = now;
+
+		memcpy(frame, record, length);
+		Telemetry_Commit_Bytes(telemetry, length, now);
+
+		for(uint8_t ch = 0; ch < channels; ch++)
+		{
+			if(!(mask & (1U << ch))) continue;
+
+			deadband->Sent[ch] = centi[ch];
+			deadband->Sent_Time[ch] = now;
+			deadband->Values++;
+		}
+
+		if(key)
+		{
+			deadband->Keyframe_Due = false;
+			deadband->Keyframe_Time = now;
+		}
+
+		deadband->Record_Time = now;
+		deadband->Records++;
+		deadband->Bytes += length;
+		records++;
+	}
+
+	deadband->Scans += scans;
+
+	// A quiet stream would keep its last records in the frame indefinitely
+	uint64_t last = time + (uint64_t)(scans - 1) * period;
+
+	if((telemetry->Scans != 0) && ((last - deadband->Frame_Time) >= (uint64_t)deadband->Hold_ms * 1000000ULL))
+	{
+		Telemetry_Flush(telemetry);
+	}
+
+	return records;
+}
+
+void Deadband_Dump(const Deadband_Config *deadband, void (*print)(char *msg, ...))
+{
+	uint32_t values = deadband->Scans * deadband->Channels;
+	uint32_t sent = (values != 0) ? (uint32_t)(((uint64_t)deadband->Values * 1000) / values) : 0;
+
+	print("Deadband");
+	for(uint8_t ch = 0; ch < deadband->Channels; ch++)
+	{
+		print(" %d", deadband->Deadband_Centi[ch]);
+	}
+	print(" (0.01 C), silence %lu ms, keyframe %lu ms, hold %lu ms\r\n", (unsigned long)deadband->Max_Silence_ms,
+			(unsigned long)deadband->Keyframe_ms, (unsigned long)deadband->Hold_ms);
+	print("Scans %lu, records %lu, values %lu of %lu (%lu.%lu %%), %lu bytes\r\n", (unsigned long)deadband->Scans,
+			(unsigned long)deadband->Records, (unsigned long)deadband->Values, (unsigned long)values,
+			(unsigned long)(sent / 10), (unsigned long)(sent % 10), (unsigned long)deadband->Bytes);
+}
@@ -0,0 +1,115 @@
+/**
+ * @file Deadband.h
+ * @brief Change-only reporting of the temperatures with per-channel deadbands.
+ *
+ * Instead of every decimated scan only significant changes are sent, as
+ * @ref TELEMETRY_TYPE_CHANGES records. A channel is reported when
+ *
+ * - it moved at least `Deadband_Centi` away from the value last sent for it,
+ * - or it has not been sent for `Max_Silence_ms`, so the host can tell a quiet
+ *   channel from a dead link.
+ *
+ * Every `Keyframe_ms`, and after @ref Deadband_Init or @ref Deadband_Keyframe,
+ * a record carries all channels with absolute values, from which the host can
+ * pick up the stream after a lost frame. All other values are zigzag varint
+ * differences to the value sent before, one or two bytes for a typical change.
+ * The values are 0.01 °C integers, so unlike floats there is nothing to gain from
+ * XOR encoding.
+ *
+ * Records wait in the telemetry frame until it is full or the first of them is
+ * `Hold_ms` old, which bounds the delay of a change on a quiet link.
+ *
+ * @code
+ * Deadband_Config deadband = {.Deadband_Centi = {5, 5, 5}, .Max_Silence_ms = 10000, .Keyframe_ms = 60000, .Hold_ms = 500};
+ *
+ * Deadband_Init(&deadband, 3);
+ * telemetry.Type = TELEMETRY_TYPE_CHANGES;
+ * Deadband_Report(&deadband, &telemetry, centi, outputs, time, period);
+ * @endcode
+ *
+ * @version 1.0
+ * @date 2025-06-18
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef DEADBAND_DEADBAND_H_
+#define DEADBAND_DEADBAND_H_
+
+#include "main.h"
+#include "Telemetry/Telemetry.h"
+
+#define DEADBAND_MAX_CHANNELS	16
+
+/**
+ * @brief Largest record for a channel count: head, mask and one 3-byte varint per channel.
+ */
+#define DEADBAND_RECORD_MAX(channels)	(5 + 3 + 3 * (channels))
+
+/** @struct Deadband_Config
+ *  @brief  Reporting limits and state, the fields above the state are filled in by the application.
+ */
+typedef struct Deadband_Config{
+	int16_t Deadband_Centi[DEADBAND_MAX_CHANNELS];	/**< Smallest change that is sent, 0 sends every change */
+	uint32_t Max_Silence_ms;						/**< A channel is sent at least this often, 0 never forces it */
+	uint32_t Keyframe_ms;							/**< Interval of the keyframes, 0 for the first one only */
+	uint32_t Hold_ms;								/**< Longest wait of a record in a partly filled frame */
+
+	/* State */
+	uint8_t Channels;
+	bool Keyframe_Due;
+	int16_t Sent[DEADBAND_MAX_CHANNELS];			/**< Last value sent, the reference of the next difference */
+	uint64_t Sent_Time[DEADBAND_MAX_CHANNELS];
+	uint64_t Keyframe_Time;
+	uint64_t Record_Time;							/**< Time of the last record (ns) */
+	uint64_t Frame_Time;							/**< Time of the first record in the frame being filled */
+	uint32_t Scans;									/**< Scans looked at */
+	uint32_t Records;
+	uint32_t Values;								/**< Channel values sent */
+	uint32_t Bytes;									/**< Record bytes sent */
+}Deadband_Config;
+
+/**
+ * @brief Starts reporting a set of channels, the next record is a keyframe.
+ *
+ * @param[in,out] deadband Reporting limits.
+ * @param[in] channels Channels in one scan, at most @ref DEADBAND_MAX_CHANNELS.
+ *
+ * @return int8_t Returns 1 on success, or -1 for an invalid channel count.
+ */
+int8_t Deadband_Init(Deadband_Config *deadband, uint8_t channels);
+
+/**
+ * @brief Makes the next record a keyframe, e.g. when the host reconnects.
+ *
+ * @param[in,out] deadband Reporting state.
+ */
+void Deadband_Keyframe(Deadband_Config *deadband);
+
+/**
+ * @brief Adds the significant changes of a block of scans to the telemetry stream.
+ *
+ * The stream has to be set to @ref TELEMETRY_TYPE_CHANGES and its scan period to
+ * `period`, so the host can turn the record heads back into times.
+ *
+ * @param[in,out] deadband Reporting state.
+ * @param[in,out] telemetry Stream.
+ * @param[in] centi Temperatures in 0.01 °C, `centi[scan * Channels + channel]`.
+ * @param[in] scans Number of scans in the block.
+ * @param[in] time Time of the first scan (ns).
+ * @param[in] period Time between two scans (ns).
+ *
+ * @return uint16_t Number of records added.
+ */
+uint16_t Deadband_Report(Deadband_Config *deadband, Telemetry_Config *telemetry, const int16_t *centi, uint16_t scans,
+		uint64_t time, uint32_t period);
+
+/**
+ * @brief Prints the limits and how much of the stream was left out.
+ *
+ * @param[in] deadband Reporting state.
+ * @param[in] print Output function, e.g. `printConsole` or `Log_Print`.
+ */
+void Deadband_Dump(const Deadband_Config *deadband, void (*print)(char *msg, ...));
+
+#endif /* DEADBAND_DEADBAND_H_ */
@@ -0,0 +1,161 @@
+/**
+ * @file Decimation.c
+ * @brief Oversampling and decimation of ADC scan blocks.
+ *
+ * Implementation of the boxcar decimator declared in @ref Decimation.h.
+ *
+ * @version 1.0
+ * @date 2025-06-02
+ *
+ * @author Kunal Salvi
+ */
+
+#include "Decimation.h"
+
+
+static void Decimation_Clear(Decimation_Config *dec)
+{
+	for(uint8_t ch = 0; ch < dec->Channels; ch++)
+	{
+		dec->Accumulator[ch] = 0;
+	}
+	dec->Count = 0;
+}
+
+static void Decimation_Accumulate_Scalar(Decimation_Config *dec, const volatile uint16_t *samples, uint16_t scans)
+{
+	uint8_t channels = dec->Channels;
+
+	for(uint16_t scan = 0; scan < scans; scan++)
+	{
+		for(uint8_t ch = 0; ch < channels; ch++)
+		{
+			dec->Accumulator[ch] += samples[ch];
+		}
+		samples += channels;
+	}
+}
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+/*
+ * Two scans make up exactly `Channels` 32-bit words, so word w of every scan pair
+ * always holds the same two channels. Each word is summed with __UADD16 into a
+ * pair of 16-bit lanes, the lanes are flushed into the 32-bit accumulators
+ * before they can overflow.
+ */
+static void Decimation_Accumulate_SIMD(Decimation_Config *dec, const uint32_t *words, uint16_t pairs)
+{
+	uint8_t channels = dec->Channels;
+	uint32_t lanes[DECIMATION_MAX_CHANNELS];
+
+	while(pairs > 0)
+	{
+		uint16_t run = (pairs > DECIMATION_LANE_DEPTH) ? DECIMATION_LANE_DEPTH : pairs;
+
+		for(uint8_t w = 0; w < channels; w++)
+		{
+			lanes[w] = 0;
+		}
+
+		for(uint16_t p = 0; p < run; p++)
+		{
+			for(uint8_t w = 0; w < channels; w++)
+			{
+				lanes[w] = __UADD16(lanes[w], words[w]);
+			}
+			words += channels;
+		}
+
+		for(uint8_t w = 0; w < channels; w++)
+		{
+			dec->Accumulator[dec->Lane_Channel[2 * w]] += lanes[w] & 0xFFFF;
+			dec->Accumulator[dec->Lane_Channel[2 * w + 1]] += lanes[w] >> 16;
+		}
+
+		pairs -= run;
+	}
+}
+#endif
+
+static void Decimation_Accumulate(Decimation_Config *dec, const volatile uint16_t *samples, uint16_t scans)
+{
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+	if((((uintptr_t)samples) & 0x3) == 0)
+	{
+		uint16_t pairs = scans / 2;
+
+		Decimation_Accumulate_SIMD(dec, (const uint32_t *)samples, pairs);
+		samples += (uint32_t)pairs * 2 * dec->Channels;
+		scans -= pairs * 2;
+	}
+#endif
+	Decimation_Accumulate_Scalar(dec, samples, scans);
+}
+
+static void Decimation_Dump(Decimation_Config *dec, uint16_t *output)
+{
+	uint8_t shift = 16 - dec->Input_Bits;
+
+	for(uint8_t ch = 0; ch < dec->Channels; ch++)
+	{
+		uint64_t scaled = (((uint64_t)dec->Accumulator[ch] << shift) + (dec->Ratio / 2)) / dec->Ratio;
+		output[ch] = (scaled > 0xFFFF) ? 0xFFFF : (uint16_t)scaled;
+	}
+}
+
+
+int8_t Decimation_Init(Decimation_Config *dec, uint8_t channels, uint8_t input_bits, uint16_t ratio)
+{
+	if((channels == 0) || (channels > DECIMATION_MAX_CHANNELS)) return -1;
+	if((input_bits == 0) || (input_bits > 12)) return -1;
+	if(ratio == 0) return -1;
+
+	dec->Channels = channels;
+	dec->Input_Bits = input_bits;
+	dec->Ratio = ratio;
+	dec->Outputs = 0;
+
+	for(uint8_t lane = 0; lane < 2 * channels; lane++)
+	{
+		dec->Lane_Channel[lane] = lane % channels;
+	}
+
+	Decimation_Clear(dec);
+	return 1;
+}
+
+uint16_t Decimation_Process(Decimation_Config *dec, const volatile uint16_t *samples, uint16_t scans,
+		uint16_t *output, uint16_t max_outputs)
+{
+	uint16_t produced = 0;
+
+	while(scans > 0)
+	{
+		uint16_t run = dec->Ratio - dec->Count;
+		if(run > scans) run = scans;
+
+		Decimation_Accumulate(dec, samples, run);
+		samples += (uint32_t)run * dec->Channels;
+		scans -= run;
+		dec->Count += run;
+
+		if(dec->Count == dec->Ratio)
+		{
+			// When the output buffer is full the sample is dropped, the sums restart regardless
+			if(produced < max_outputs)
+			{
+				Decimation_Dump(dec, &output[produced * dec->Channels]);
+				produced++;
+				dec->Outputs++;
+			}
+			Decimation_Clear(dec);
+		}
+	}
+
+	return produced;
+}
+
+void Decimation_Reset(Decimation_Config *dec)
+{
+	Decimation_Clear(dec);
+}
@@ -0,0 +1,91 @@
+/**
+ * @file Decimation.h
+ * @brief Oversampling and decimation of ADC scan blocks.
+ *
+ * The ADC is run at a few kHz and every channel of the scan is summed over
+ * `Ratio` consecutive scans (boxcar / first order CIC, sum and dump). The sum is
+ * scaled back to a 16-bit code, i.e. a 12-bit conversion of 2048 becomes 32768.
+ *
+ * Oversampling by 4 gains half a bit of resolution as long as the input carries
+ * at least ~1 LSB of noise, so a ratio of 16 gives 14 bits and a ratio of 256
+ * gives 16 bits. The output rate is `Sampling_Frequency / Ratio`.
+ *
+ * The accumulation works directly on the blocks handed out by @ref ADC_Get_Block.
+ * On the Cortex-M4 two samples are summed per instruction with `__UADD16`.
+ * The module has no hardware dependency apart from the CMSIS intrinsics and
+ * falls back to plain C when `__ARM_FEATURE_DSP` is not available, which allows
+ * recorded sample streams to be replayed through it on a host.
+ *
+ * @version 1.0
+ * @date 2025-06-02
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef DECIMATION_DECIMATION_H_
+#define DECIMATION_DECIMATION_H_
+
+#include "main.h"
+
+#define DECIMATION_MAX_CHANNELS		16
+
+/**
+ * @brief Number of 12-bit samples that can be summed in a 16-bit SIMD lane
+ *        without overflow (16 * 4095 = 65520).
+ */
+#define DECIMATION_LANE_DEPTH		16
+
+/** @struct Decimation_Config
+ *  @brief  State of one decimator, one accumulator per channel.
+ */
+typedef struct Decimation_Config{
+	uint8_t Channels;									/**< Conversions in one scan */
+	uint8_t Input_Bits;									/**< Resolution of the raw samples, 12 for the default ADC setup */
+	uint16_t Ratio;										/**< Scans summed into one output sample */
+	uint16_t Count;										/**< Scans summed so far */
+	uint32_t Accumulator[DECIMATION_MAX_CHANNELS];		/**< Running sum of every channel */
+	uint8_t Lane_Channel[2 * DECIMATION_MAX_CHANNELS];	/**< Channel of each 16-bit SIMD lane */
+	uint32_t Outputs;									/**< Output samples produced since init */
+}Decimation_Config;
+
+/**
+ * @brief Initializes a decimator.
+ *
+ * @param[out] dec Decimator state.
+ * @param[in] channels Conversions in one scan, at most @ref DECIMATION_MAX_CHANNELS.
+ * @param[in] input_bits Resolution of the raw samples (right aligned), at most 12.
+ * @param[in] ratio Scans summed into one output sample.
+ *
+ * @return int8_t Returns 1 on success, or -1 for an invalid configuration.
+ */
+int8_t Decimation_Init(Decimation_Config *dec, uint8_t channels, uint8_t input_bits, uint16_t ratio);
+
+/**
+ * @brief Feeds complete scans to the decimator.
+ *
+ * Every time `Ratio` scans have been summed one output scan of `Channels`
+ * 16-bit samples is appended to `output`. Blocks do not need to line up with
+ * the ratio, partial sums are carried over to the next call.
+ *
+ * The fast path needs the block to start on a 32-bit boundary, which is always
+ * the case for ADC blocks with an even number of scans per block.
+ *
+ * @param[in,out] dec Decimator state.
+ * @param[in] samples Scans stored one after the other, `samples[scan * Channels + rank]`.
+ * @param[in] scans Number of scans in `samples`.
+ * @param[out] output Buffer for the output scans.
+ * @param[in] max_outputs Number of output scans that fit in `output`.
+ *
+ * @return uint16_t Number of output scans written.
+ */
+uint16_t Decimation_Process(Decimation_Config *dec, const volatile uint16_t *samples, uint16_t scans,
+		uint16_t *output, uint16_t max_outputs);
+
+/**
+ * @brief Drops the partial sums, e.g. after a block overrun.
+ *
+ * @param[in,out] dec Decimator state.
+ */
+void Decimation_Reset(Decimation_Config *dec);
+
+#endif /* DECIMATION_DECIMATION_H_ */
@@ -0,0 +1,131 @@
+/**
+ * @file Profiler.c
+ * @brief Cycle accurate profiling with named probes.
+ *
+ * Implementation of the probes declared in @ref Profiler.h.
+ *
+ * @version 1.0
+ * @date 2025-06-10
+ *
+ * @author Kunal Salvi
+ */
+
+#include "Profiler.h"
+
+static Profiler_Probe *profiler_probes = NULL;
+
+
+static void Profiler_Clear(Profiler_Probe *probe)
+{
+	probe->Count = 0;
+	probe->Min_Cycles = UINT32_MAX;
+	probe->Max_Cycles = 0;
+	probe->Total_Cycles = 0;
+	memset(probe->Histogram, 0, sizeof(probe->Histogram));
+}
+
+static uint8_t Profiler_Bin(uint32_t cycles)
+{
+	int32_t bin = (int32_t)(32 - __CLZ(cycles)) - PROFILER_HISTOGRAM_SHIFT;
+
+	if(bin < 0) return 0;
+	if(bin >= PROFILER_HISTOGRAM_BINS) return PROFILER_HISTOGRAM_BINS - 1;
+	return (uint8_t)bin;
+}
+
+void Profiler_Init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+void Profiler_Record(Profiler_Probe *probe, uint32_t cycles)
+{
+	uint8_t bin = Profiler_Bin(cycles);
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if(!probe->Registered)
+	{
+		probe->Registered = true;
+		probe->Next = profiler_probes;
+		profiler_probes = probe;
+	}
+
+	probe->Count++;
+	probe->Total_Cycles += cycles;
+	if(cycles < probe->Min_Cycles) probe->Min_Cycles = cycles;
+	if(cycles > probe->Max_Cycles) probe->Max_Cycles = cycles;
+	probe->Histogram[bin]++;
+
+	__set_PRIMASK(primask);
+}
+
+void Profiler_Reset(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	for(Profiler_Probe *probe = profiler_probes; probe != NULL; probe = probe->Next)
+	{
+		Profiler_Clear(probe);
+	}
+
+	__set_PRIMASK(primask);
+}
+
+void Profiler_Dump(void (*print)(char *msg, ...))
+{
+	uint32_t cycles_per_us = SystemCoreClock / 1000000UL;
+	Profiler_Probe *probe = profiler_probes;
+
+	if(cycles_per_us == 0) cycles_per_us = 1;
+
+	print("probe        count       min       max      mean  mean us\r\n");
+
+	while(probe != NULL)
+	{
+		Profiler_Probe copy;
+		char line[96];
+		int length;
+
+		// Consistent snapshot, printing is far too slow to do with interrupts masked
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		copy = *probe;
+		probe = probe->Next;
+		__set_PRIMASK(primask);
+
+		if(copy.Count == 0)
+		{
+			print("%-10.10s %7lu         -         -         -        -\r\n", copy.Name, 0UL);
+			continue;
+		}
+
+		uint32_t mean = (uint32_t)(copy.Total_Cycles / copy.Count);
+		uint32_t mean_centi_us = (uint32_t)(((uint64_t)mean * 100 + cycles_per_us / 2) / cycles_per_us);
+
+		print("%-10.10s %7lu %9lu %9lu %9lu %5lu.%02lu\r\n", copy.Name, (unsigned long)copy.Count,
+				(unsigned long)copy.Min_Cycles, (unsigned long)copy.Max_Cycles, (unsigned long)mean,
+				(unsigned long)(mean_centi_us / 100), (unsigned long)(mean_centi_us % 100));
+
+		// Histogram as "<cycles>:<count>" for every non empty bin, wrapped to short lines
+		length = snprintf(line, sizeof(line), "  ");
+		for(uint8_t bin = 0; bin < PROFILER_HISTOGRAM_BINS; bin++)
+		{
+			if(copy.Histogram[bin] == 0) continue;
+
+			if(length > (int)sizeof(line) - 24)
+			{
+				print("%s\r\n", line);
+				length = snprintf(line, sizeof(line), "  ");
+			}
+
+			uint32_t from = (bin == 0) ? 0 : (1UL << (bin + PROFILER_HISTOGRAM_SHIFT - 1));
+			length += snprintf(&line[length], sizeof(line) - length, "%s%lu:%lu ",
+					(bin == PROFILER_HISTOGRAM_BINS - 1) ? ">=" : "", (unsigned long)from,
+					(unsigned long)copy.Histogram[bin]);
+		}
+		print("%s\r\n", line);
+	}
+}
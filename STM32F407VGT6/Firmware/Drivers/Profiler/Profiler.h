@@ -0,0 +1,151 @@
+/**
+ * @file Profiler.h
+ * @brief Cycle accurate profiling with named probes.
+ *
+ * A probe accumulates the durations of one piece of code measured with the DWT
+ * cycle counter: number of runs, minimum, maximum, mean and a histogram with one
+ * bin per power of two. Probes are ordinary variables, they link themselves into
+ * the probe list the first time they record something, so no registration is
+ * needed and probes compiled into a driver only show up once the code runs.
+ *
+ * @code
+ * PROFILER_PROBE(convert_probe, "convert");
+ *
+ * void Convert(void)
+ * {
+ *     PROFILER_SCOPE(convert_probe);	// Measures until the end of the block
+ *     ...
+ * }
+ *
+ * uint32_t start = Profiler_Start();
+ * Work();
+ * Profiler_End(&work_probe, start);
+ *
+ * Profiler_Dump(printConsole);			// Or Log_Print for the ITM
+ * @endcode
+ *
+ * Recording is safe from interrupts. Durations are in core clock cycles, the
+ * counter wraps after 2^32 cycles (25 s at 168 MHz). Set `PROFILER_ENABLE` to 0
+ * to compile all probes out.
+ *
+ * @version 1.0
+ * @date 2025-06-10
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef PROFILER_PROFILER_H_
+#define PROFILER_PROFILER_H_
+
+#include "main.h"
+
+#ifndef PROFILER_ENABLE
+#define PROFILER_ENABLE				1
+#endif
+
+/** Number of histogram bins */
+#define PROFILER_HISTOGRAM_BINS		20
+
+/**
+ * Bin 0 counts durations below 2^PROFILER_HISTOGRAM_SHIFT cycles, bin n the
+ * durations from 2^(n + PROFILER_HISTOGRAM_SHIFT - 1) cycles up, the last bin
+ * everything above.
+ */
+#define PROFILER_HISTOGRAM_SHIFT	4
+
+/** @struct Profiler_Probe
+ *  @brief  Statistics of one named probe, define it with @ref PROFILER_PROBE.
+ */
+typedef struct Profiler_Probe{
+	const char *Name;
+	uint32_t Count;
+	uint32_t Min_Cycles;
+	uint32_t Max_Cycles;
+	uint64_t Total_Cycles;
+	uint32_t Histogram[PROFILER_HISTOGRAM_BINS];
+	struct Profiler_Probe *Next;
+	bool Registered;
+}Profiler_Probe;
+
+/** @struct Profiler_Scope
+ *  @brief  Running measurement of @ref PROFILER_SCOPE.
+ */
+typedef struct Profiler_Scope{
+	Profiler_Probe *Probe;
+	uint32_t Start;
+}Profiler_Scope;
+
+/** Defines a probe variable named `variable` that is reported as `name` */
+#define PROFILER_PROBE(variable, name)	Profiler_Probe variable = {.Name = (name), .Min_Cycles = UINT32_MAX}
+
+/**
+ * @brief Enables the DWT cycle counter.
+ */
+void Profiler_Init(void);
+
+/**
+ * @brief Adds one duration to a probe.
+ *
+ * @param[in,out] probe Probe.
+ * @param[in] cycles Duration in core clock cycles.
+ */
+void Profiler_Record(Profiler_Probe *probe, uint32_t cycles);
+
+/**
+ * @brief Clears the statistics of every probe.
+ */
+void Profiler_Reset(void);
+
+/**
+ * @brief Prints the statistics of every probe.
+ *
+ * Every line is shorter than 100 characters so it fits the buffer of `Log_Print`.
+ *
+ * @param[in] print Output function, e.g. `printConsole` or `Log_Print`.
+ */
+void Profiler_Dump(void (*print)(char *msg, ...));
+
+#if PROFILER_ENABLE
+
+/** @brief Current cycle count, start of a measurement for @ref Profiler_End */
+__STATIC_INLINE uint32_t Profiler_Start(void)
+{
+	return DWT->CYCCNT;
+}
+
+/** @brief Records the cycles since `start` */
+__STATIC_INLINE void Profiler_End(Profiler_Probe *probe, uint32_t start)
+{
+	Profiler_Record(probe, DWT->CYCCNT - start);
+}
+
+__STATIC_INLINE void Profiler_Scope_End(Profiler_Scope *scope)
+{
+	Profiler_End(scope->Probe, scope->Start);
+}
+
+#define PROFILER_CONCAT_(a, b)		a##b
+#define PROFILER_CONCAT(a, b)		PROFILER_CONCAT_(a, b)
+
+/** Measures from here to the end of the enclosing block */
+#define PROFILER_SCOPE(probe)	\
+	Profiler_Scope PROFILER_CONCAT(profiler_scope_, __LINE__) __attribute__((cleanup(Profiler_Scope_End))) = {&(probe), DWT->CYCCNT}
+
+#else
+
+__STATIC_INLINE uint32_t Profiler_Start(void)
+{
+	return 0;
+}
+
+__STATIC_INLINE void Profiler_End(Profiler_Probe *probe, uint32_t start)
+{
+	(void)probe;
+	(void)start;
+}
+
+#define PROFILER_SCOPE(probe)	do{}while(0)
+
+#endif
+
+#endif /* PROFILER_PROFILER_H_ */
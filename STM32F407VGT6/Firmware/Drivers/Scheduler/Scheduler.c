@@ -0,0 +1,194 @@
+/**
+ * @file Scheduler.c
+ * @brief Cooperative run-to-completion task scheduler on the timebase.
+ *
+ * Implementation of the scheduler declared in @ref Scheduler.h.
+ *
+ * @version 1.0
+ * @date 2025-06-12
+ *
+ * @author Kunal Salvi
+ */
+
+#include "Scheduler.h"
+
+static Scheduler_Task *scheduler_tasks = NULL;
+static uint64_t scheduler_idle = 0;
+static uint64_t scheduler_window = 0;
+
+
+int8_t Scheduler_Add(Scheduler_Task *task, uint32_t offset)
+{
+	if(task->Run == NULL) return -1;
+
+	if(task->Deadline == 0) task->Deadline = task->Period;
+
+	task->Release = Timebase_Micros() + offset;
+	task->Due = 0;
+	task->Pending = false;
+	task->Runs = 0;
+	task->Deadline_Misses = 0;
+	task->Skipped = 0;
+	task->Max_Lateness = 0;
+	task->Max_Run_Time = 0;
+	task->Next = NULL;
+
+	// Keep the order of adding, it is the order of the dump
+	Scheduler_Task **last = &scheduler_tasks;
+	while(*last != NULL) last = &(*last)->Next;
+	*last = task;
+
+	if(scheduler_window == 0) scheduler_window = Timebase_Micros();
+
+	return 1;
+}
+
+void Scheduler_Signal(Scheduler_Task *task)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if(!task->Pending)
+	{
+		task->Due = (task->Deadline != 0) ? Timebase_Micros() + task->Deadline : UINT64_MAX;
+		task->Pending = true;
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/* Turns periodic releases that are due into pending runs */
+static void Scheduler_Release(uint64_t now)
+{
+	for(Scheduler_Task *task = scheduler_tasks; task != NULL; task = task->Next)
+	{
+		if((task->Period == 0) || (now < task->Release)) continue;
+
+		__disable_irq();
+		if(!task->Pending)
+		{
+			task->Due = task->Release + task->Deadline;
+			task->Pending = true;
+		}
+		__enable_irq();
+
+		task->Release += task->Period;
+
+		// More than a period behind, drop the missed releases but stay on the grid
+		if(now >= task->Release)
+		{
+			uint64_t missed = (now - task->Release) / task->Period + 1;
+			task->Skipped += (uint32_t)missed;
+			task->Release += missed * task->Period;
+		}
+	}
+}
+
+bool Scheduler_Run_Once(void)
+{
+	Scheduler_Task *next = NULL;
+
+	Scheduler_Release(Timebase_Micros());
+
+	// Earliest deadline first
+	for(Scheduler_Task *task = scheduler_tasks; task != NULL; task = task->Next)
+	{
+		if(task->Pending && ((next == NULL) || (task->Due < next->Due))) next = task;
+	}
+
+	if(next == NULL) return false;
+
+	__disable_irq();
+	uint64_t due = next->Due;
+	next->Pending = false;
+	__enable_irq();
+
+	uint64_t start = Timebase_Micros();
+	next->Run(next->Context);
+	uint64_t end = Timebase_Micros();
+
+	next->Runs++;
+	if((uint32_t)(end - start) > next->Max_Run_Time) next->Max_Run_Time = (uint32_t)(end - start);
+
+	if(end > due)
+	{
+		next->Deadline_Misses++;
+		if((end - due) > next->Max_Lateness) next->Max_Lateness = (uint32_t)(end - due);
+	}
+
+	return true;
+}
+
+static void Scheduler_Sleep(void)
+{
+	uint64_t wake = UINT64_MAX;
+
+	for(Scheduler_Task *task = scheduler_tasks; task != NULL; task = task->Next)
+	{
+		if((task->Period != 0) && (task->Release < wake)) wake = task->Release;
+	}
+
+	__disable_irq();
+
+	// A signal that arrived after the tasks were checked must not wait for the next interrupt
+	for(Scheduler_Task *task = scheduler_tasks; task != NULL; task = task->Next)
+	{
+		if(task->Pending)
+		{
+			__enable_irq();
+			return;
+		}
+	}
+
+	if((wake == UINT64_MAX) || (Timebase_Set_Alarm(wake) == 1))
+	{
+		uint64_t asleep = Timebase_Micros();
+
+		// WFI also ends on interrupts that are masked, they run once interrupts are enabled again
+		__DSB();
+		__WFI();
+
+		scheduler_idle += Timebase_Micros() - asleep;
+	}
+
+	__enable_irq();
+}
+
+void Scheduler_Run(void)
+{
+	for(;;)
+	{
+		if(!Scheduler_Run_Once())
+		{
+			Scheduler_Sleep();
+		}
+	}
+}
+
+uint32_t Scheduler_Idle_Centi_Percent(void)
+{
+	uint64_t now = Timebase_Micros();
+	uint64_t window = now - scheduler_window;
+	uint32_t result = (window == 0) ? 0 : (uint32_t)((scheduler_idle * 10000) / window);
+
+	scheduler_window = now;
+	scheduler_idle = 0;
+
+	return result;
+}
+
+void Scheduler_Dump(void (*print)(char *msg, ...))
+{
+	uint32_t idle = Scheduler_Idle_Centi_Percent();
+
+	print("task        period us    runs  missed skipped  late us   run us\r\n");
+
+	for(Scheduler_Task *task = scheduler_tasks; task != NULL; task = task->Next)
+	{
+		print("%-10.10s %10lu %7lu %7lu %7lu %8lu %8lu\r\n", task->Name ? task->Name : "-",
+				(unsigned long)task->Period, (unsigned long)task->Runs, (unsigned long)task->Deadline_Misses,
+				(unsigned long)task->Skipped, (unsigned long)task->Max_Lateness, (unsigned long)task->Max_Run_Time);
+	}
+
+	print("idle %lu.%02lu %%\r\n", (unsigned long)(idle / 100), (unsigned long)(idle % 100));
+}
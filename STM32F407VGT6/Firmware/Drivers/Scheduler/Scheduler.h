@@ -0,0 +1,100 @@
+/**
+ * @file Scheduler.h
+ * @brief Cooperative run-to-completion task scheduler on the timebase.
+ *
+ * Tasks are functions that run to completion. A task is released either
+ * periodically, every `Period` µs on an exact grid that does not drift, or when
+ * an interrupt calls @ref Scheduler_Signal. Of all released tasks the one with
+ * the earliest deadline runs first. When nothing is released the core sleeps in
+ * WFI until the next release time (TIM5 alarm) or any other interrupt.
+ *
+ * @code
+ * static void Blink(void *context) { GPIO_Pin_Toggle(GPIOD, 15); }
+ *
+ * Scheduler_Task blink_task = {.Name = "led", .Run = Blink, .Period = 500000};
+ *
+ * Timebase_Init();
+ * Scheduler_Add(&blink_task, 0);
+ * Scheduler_Run();
+ * @endcode
+ *
+ * @version 1.0
+ * @date 2025-06-12
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef SCHEDULER_SCHEDULER_H_
+#define SCHEDULER_SCHEDULER_H_
+
+#include "main.h"
+#include "Timebase/Timebase.h"
+
+/** @struct Scheduler_Task
+ *  @brief  A task, the fields above the state are filled in by the application.
+ */
+typedef struct Scheduler_Task{
+	const char *Name;
+	void (*Run)(void *context);
+	void *Context;
+	uint32_t Period;			/**< Release period in µs, 0 for tasks released by @ref Scheduler_Signal only */
+	uint32_t Deadline;			/**< Relative deadline in µs, 0 means equal to the period */
+
+	/* State */
+	uint64_t Release;			/**< Next periodic release */
+	uint64_t Due;				/**< Absolute deadline of the pending release */
+	volatile bool Pending;		/**< Released and waiting to run */
+	uint32_t Runs;
+	uint32_t Deadline_Misses;	/**< Runs that finished after their deadline */
+	uint32_t Skipped;			/**< Periodic releases dropped because the task was too late */
+	uint32_t Max_Lateness;		/**< Worst finish time after the deadline in µs */
+	uint32_t Max_Run_Time;		/**< Longest run in µs */
+	struct Scheduler_Task *Next;
+}Scheduler_Task;
+
+/**
+ * @brief Adds a task.
+ *
+ * @param[in,out] task Task, must stay valid.
+ * @param[in] offset First periodic release, µs from now. Spreads tasks with equal periods.
+ *
+ * @return int8_t Returns 1 on success, or -1 for a task without a function.
+ */
+int8_t Scheduler_Add(Scheduler_Task *task, uint32_t offset);
+
+/**
+ * @brief Releases a task, safe from interrupts.
+ *
+ * The deadline of the release starts now.
+ *
+ * @param[in,out] task Task.
+ */
+void Scheduler_Signal(Scheduler_Task *task);
+
+/**
+ * @brief Runs the released task with the earliest deadline, if any.
+ *
+ * Call from thread mode only, like @ref Scheduler_Run.
+ *
+ * @return bool true if a task ran.
+ */
+bool Scheduler_Run_Once(void);
+
+/**
+ * @brief Runs the tasks forever and sleeps whenever none is released.
+ */
+void Scheduler_Run(void) __attribute__((noreturn));
+
+/**
+ * @brief Share of the time spent asleep since the last call, in 0.01 %.
+ */
+uint32_t Scheduler_Idle_Centi_Percent(void);
+
+/**
+ * @brief Prints the statistics of every task.
+ *
+ * @param[in] print Output function, e.g. `printConsole` or `Log_Print`.
+ */
+void Scheduler_Dump(void (*print)(char *msg, ...));
+
+#endif /* SCHEDULER_SCHEDULER_H_ */
@@ -0,0 +1,254 @@
+/**
+ * @file Statistics.c
+ * @brief Running per-channel statistics of the linearized temperatures.
+ *
+ * Implementation of the statistics declared in @ref Statistics.h.
+ *
+ * @version 1.0
+ * @date 2025-06-16
+ *
+ * @author Kunal Salvi
+ */
+
+#include "Statistics.h"
+
+#define STATISTICS_Q16_ONE		65536
+
+
+int8_t Statistics_Init(Statistics_Config *stats, uint8_t channels)
+{
+	if((channels == 0) || (channels > STATISTICS_MAX_CHANNELS)) return -1;
+
+	stats->Channels = channels;
+	stats->Period = 0;
+	stats->Time = 0;
+	stats->Rate_Time = 0;
+	stats->Primed = false;
+
+	for(uint8_t e = 0; e < STATISTICS_EMAS; e++)
+	{
+		stats->Alpha[e] = 0;
+	}
+
+	for(uint8_t ch = 0; ch < STATISTICS_MAX_CHANNELS; ch++)
+	{
+		for(uint8_t e = 0; e < STATISTICS_EMAS; e++)
+		{
+			stats->EMA[e][ch] = 0;
+		}
+		stats->Rate_Reference[ch] = 0;
+		stats->Rate[ch] = 0;
+	}
+
+	Statistics_Reset(stats);
+
+	return 1;
+}
+
+int8_t Statistics_Set_Period(Statistics_Config *stats, uint32_t period)
+{
+	if(period == 0) return -1;
+
+	stats->Period = period;
+
+	for(uint8_t e = 0; e < STATISTICS_EMAS; e++)
+	{
+		float tau = (float)stats->Time_Constant_ms[e] * 1e6f;
+
+		if(tau <= (float)period)
+		{
+			// No slower than the samples, the average simply follows them
+			stats->Alpha[e] = 0x7FFFFFFFUL;
+			continue;
+		}
+
+		// 1 - e^(-T/tau), expm1f keeps the precision for long time constants
+		float alpha = -expm1f(-(float)period / tau);
+		uint32_t weight = (uint32_t)(alpha * 2147483648.0f);
+
+		stats->Alpha[e] = (weight == 0) ? 1 : weight;
+	}
+
+	return 1;
+}
+
+void Statistics_Update(Statistics_Config *stats, const int16_t *centi, uint16_t scans, uint64_t time)
+{
+	uint8_t channels = stats->Channels;
+
+	if(scans == 0) return;
+
+	bool first = !stats->Primed;
+
+	if(first)
+	{
+		for(uint8_t ch = 0; ch < channels; ch++)
+		{
+			for(uint8_t e = 0; e < STATISTICS_EMAS; e++)
+			{
+				stats->EMA[e][ch] = (int32_t)centi[ch] * STATISTICS_Q16_ONE;
+			}
+			stats->Rate_Reference[ch] = stats->EMA[0][ch];
+		}
+		stats->Primed = true;
+	}
+
+	uint32_t count = stats->Count + scans;
+
+	for(uint8_t ch = 0; ch < channels; ch++)
+	{
+		// Deviations from the first sample keep the block sums small and exact
+		const int16_t *sample = &centi[ch];
+		int32_t shift = *sample;
+		int64_t sum = 0;
+		uint64_t squares = 0;
+		int16_t min = stats->Min[ch];
+		int16_t max = stats->Max[ch];
+		int32_t ema[STATISTICS_EMAS];
+
+		for(uint8_t e = 0; e < STATISTICS_EMAS; e++)
+		{
+			ema[e] = stats->EMA[e][ch];
+		}
+
+		for(uint16_t scan = 0; scan < scans; scan++)
+		{
+			int32_t value = *sample;
+			int32_t deviation = value - shift;
+
+			sum += deviation;
+			squares += (uint64_t)((int64_t)deviation * deviation);
+			if(value < min) min = (int16_t)value;
+			if(value > max) max = (int16_t)value;
+
+			for(uint8_t e = 0; e < STATISTICS_EMAS; e++)
+			{
+				int64_t difference = (int64_t)value * STATISTICS_Q16_ONE - ema[e];
+				ema[e] += (int32_t)((difference * stats->Alpha[e]) >> 31);
+			}
+
+			sample += channels;
+		}
+
+		stats->Min[ch] = min;
+		stats->Max[ch] = max;
+
+		for(uint8_t e = 0; e < STATISTICS_EMAS; e++)
+		{
+			stats->EMA[e][ch] = ema[e];
+		}
+
+		// Merge the block into the running mean and sum of squared deviations
+		double block_mean = shift + (double)sum / scans;
+		double block_m2 = (double)squares - ((double)sum * (double)sum) / scans;
+		double delta = block_mean - stats->Mean[ch];
+
+		stats->Mean[ch] += delta * scans / count;
+		stats->M2[ch] += block_m2 + delta * delta * ((double)stats->Count * scans / count);
+	}
+
+	stats->Count = count;
+	stats->Time = time;
+
+	// Slope of the first moving average since the last block
+	if(!first && (time > stats->Rate_Time))
+	{
+		int64_t elapsed = (int64_t)(time - stats->Rate_Time);
+
+		for(uint8_t ch = 0; ch < channels; ch++)
+		{
+			int64_t change = (int64_t)stats->EMA[0][ch] - stats->Rate_Reference[ch];
+			stats->Rate[ch] = (int32_t)(((change * 1000000000LL) / elapsed) / STATISTICS_Q16_ONE);
+			stats->Rate_Reference[ch] = stats->EMA[0][ch];
+		}
+	}
+	else
+	{
+		for(uint8_t ch = 0; ch < channels; ch++)
+		{
+			stats->Rate_Reference[ch] = stats->EMA[0][ch];
+		}
+	}
+
+	stats->Rate_Time = time;
+}
+
+void Statistics_Reset(Statistics_Config *stats)
+{
+	stats->Count = 0;
+
+	for(uint8_t ch = 0; ch < STATISTICS_MAX_CHANNELS; ch++)
+	{
+		stats->Mean[ch] = 0.0;
+		stats->M2[ch] = 0.0;
+		stats->Min[ch] = INT16_MAX;
+		stats->Max[ch] = INT16_MIN;
+	}
+}
+
+static int32_t Statistics_Round(double value)
+{
+	return (int32_t)((value < 0.0) ? (value - 0.5) : (value + 0.5));
+}
+
+int8_t Statistics_Get(const Statistics_Config *stats, uint8_t channel, Statistics_Snapshot *snapshot)
+{
+	if(channel >= stats->Channels) return -1;
+
+	memset(snapshot, 0, sizeof(*snapshot));
+
+	if(stats->Primed)
+	{
+		for(uint8_t e = 0; e < STATISTICS_EMAS; e++)
+		{
+			snapshot->EMA[e] = (stats->EMA[e][channel] + STATISTICS_Q16_ONE / 2) >> 16;
+		}
+		snapshot->Rate = stats->Rate[channel];
+	}
+
+	snapshot->Count = stats->Count;
+	if(stats->Count == 0) return 1;
+
+	snapshot->Mean = Statistics_Round(stats->Mean[channel]);
+	snapshot->Min = stats->Min[channel];
+	snapshot->Max = stats->Max[channel];
+
+	if(stats->Count > 1)
+	{
+		snapshot->Deviation = Statistics_Round(sqrt(stats->M2[channel] / (stats->Count - 1)));
+	}
+
+	return 1;
+}
+
+/* Formats 0.01 °C with two decimals, keeps printf free of floats */
+static char *Statistics_Text(char *text, size_t size, int32_t centi)
+{
+	uint32_t magnitude = (centi < 0) ? (uint32_t)(-centi) : (uint32_t)centi;
+
+	snprintf(text, size, "%s%lu.%02lu", (centi < 0) ? "-" : "", (unsigned long)(magnitude / 100), (unsigned long)(magnitude % 100));
+
+	return text;
+}
+
+void Statistics_Dump(const Statistics_Config *stats, void (*print)(char *msg, ...))
+{
+	print("ch  samples     mean      std      min      max    ema 1    ema 2   rate/s\r\n");
+
+	for(uint8_t ch = 0; ch < stats->Channels; ch++)
+	{
+		Statistics_Snapshot snapshot;
+		char text[7][12];
+
+		Statistics_Get(stats, ch, &snapshot);
+
+		print("%2u %8lu %8s %8s %8s %8s %8s %8s %8s\r\n", ch, (unsigned long)snapshot.Count,
+				Statistics_Text(text[0], sizeof(text[0]), snapshot.Mean),
+				Statistics_Text(text[1], sizeof(text[1]), snapshot.Deviation),
+				Statistics_Text(text[2], sizeof(text[2]), snapshot.Min),
+				Statistics_Text(text[3], sizeof(text[3]), snapshot.Max),
+				Statistics_Text(text[4], sizeof(text[4]), snapshot.EMA[0]),
+				Statistics_Text(text[5], sizeof(text[5]), snapshot.EMA[1]),
+				Statistics_Text(text[6], sizeof(text[6]), snapshot.Rate));
+	}
+}
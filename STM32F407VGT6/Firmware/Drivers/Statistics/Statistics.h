@@ -0,0 +1,142 @@
+/**
+ * @file Statistics.h
+ * @brief Running per-channel statistics of the linearized temperatures.
+ *
+ * Every block of temperatures in 0.01 °C, as written by
+ * @ref Thermistor_Convert_Block_Centi, updates per channel:
+ *
+ * - minimum, maximum, mean and variance since the last @ref Statistics_Reset,
+ * - @ref STATISTICS_EMAS exponential moving averages with their own time constants,
+ * - the rate of change in 0.01 °C/s, taken from the first moving average.
+ *
+ * Mean and variance follow Welford: a block is summed exactly in integers and
+ * then merged into the running mean and sum of squared deviations (Chan et al.),
+ * so the floating point work is a few operations per block and channel, not per
+ * sample. The moving averages are Q16.16 fixed point with a Q1.31 weight, which
+ * keeps them exact enough for time constants of hours at kHz rates.
+ *
+ * The state is stored one array per quantity, indexed by channel, so the loop
+ * over a channel only touches the memory of that channel.
+ *
+ * @code
+ * Statistics_Config stats = {.Time_Constant_ms = {1000, 60000}};
+ *
+ * Statistics_Init(&stats, 5);
+ * Statistics_Set_Period(&stats, 100000000);	// 10 Hz temperatures
+ * Statistics_Update(&stats, centi, outputs, time);
+ * Statistics_Dump(&stats, printConsole);
+ * @endcode
+ *
+ * @version 1.0
+ * @date 2025-06-16
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef STATISTICS_STATISTICS_H_
+#define STATISTICS_STATISTICS_H_
+
+#include "main.h"
+
+#define STATISTICS_MAX_CHANNELS		16
+#define STATISTICS_EMAS				2		/**< Moving averages per channel */
+
+/** @struct Statistics_Config
+ *  @brief  Statistics of all channels, the time constants are filled in by the application.
+ */
+typedef struct Statistics_Config{
+	uint32_t Time_Constant_ms[STATISTICS_EMAS];		/**< Time constant of each moving average */
+
+	/* State */
+	uint8_t Channels;
+	uint32_t Period;								/**< Time between two samples in ns */
+	uint32_t Alpha[STATISTICS_EMAS];				/**< Weight of a new sample, Q1.31 */
+	uint32_t Count;									/**< Samples per channel since the last reset */
+	uint64_t Time;									/**< Time of the latest sample in ns */
+	uint64_t Rate_Time;								/**< Time of the last rate of change update */
+	bool Primed;									/**< Moving averages hold a value */
+
+	double Mean[STATISTICS_MAX_CHANNELS];
+	double M2[STATISTICS_MAX_CHANNELS];				/**< Sum of squared deviations from the mean */
+	int16_t Min[STATISTICS_MAX_CHANNELS];
+	int16_t Max[STATISTICS_MAX_CHANNELS];
+	int32_t EMA[STATISTICS_EMAS][STATISTICS_MAX_CHANNELS];	/**< Q16.16, 0.01 °C */
+	int32_t Rate_Reference[STATISTICS_MAX_CHANNELS];		/**< First moving average at `Rate_Time` */
+	int32_t Rate[STATISTICS_MAX_CHANNELS];			/**< 0.01 °C per second */
+}Statistics_Config;
+
+/** @struct Statistics_Snapshot
+ *  @brief  Statistics of one channel in 0.01 °C.
+ */
+typedef struct Statistics_Snapshot{
+	uint32_t Count;
+	int32_t Mean;
+	int32_t Deviation;								/**< Standard deviation */
+	int16_t Min;
+	int16_t Max;
+	int32_t EMA[STATISTICS_EMAS];
+	int32_t Rate;									/**< 0.01 °C per second */
+}Statistics_Snapshot;
+
+/**
+ * @brief Initializes the statistics and clears every channel.
+ *
+ * The sample period starts out unknown, call @ref Statistics_Set_Period before
+ * the first update.
+ *
+ * @param[in,out] stats Statistics with the time constants filled in.
+ * @param[in] channels Channels in one scan, at most @ref STATISTICS_MAX_CHANNELS.
+ *
+ * @return int8_t Returns 1 on success, or -1 for an invalid channel count.
+ */
+int8_t Statistics_Init(Statistics_Config *stats, uint8_t channels);
+
+/**
+ * @brief Sets the time between two samples and with it the moving average weights.
+ *
+ * @param[in,out] stats Statistics.
+ * @param[in] period Sample period in ns, e.g. the scan period times the decimation ratio.
+ *
+ * @return int8_t Returns 1 on success, or -1 for a period of 0.
+ */
+int8_t Statistics_Set_Period(Statistics_Config *stats, uint32_t period);
+
+/**
+ * @brief Adds a block of scans.
+ *
+ * @param[in,out] stats Statistics.
+ * @param[in] centi Temperatures in 0.01 °C, `centi[scan * Channels + channel]`.
+ * @param[in] scans Number of scans in the block.
+ * @param[in] time Time of the last scan in ns, for the rate of change.
+ */
+void Statistics_Update(Statistics_Config *stats, const int16_t *centi, uint16_t scans, uint64_t time);
+
+/**
+ * @brief Starts a new window for minimum, maximum, mean and variance.
+ *
+ * The moving averages and the rate of change carry on.
+ *
+ * @param[in,out] stats Statistics.
+ */
+void Statistics_Reset(Statistics_Config *stats);
+
+/**
+ * @brief Reads the statistics of one channel.
+ *
+ * @param[in] stats Statistics.
+ * @param[in] channel Channel.
+ * @param[out] snapshot Statistics of the channel, all 0 before the first sample.
+ *
+ * @return int8_t Returns 1 on success, or -1 for a channel that does not exist.
+ */
+int8_t Statistics_Get(const Statistics_Config *stats, uint8_t channel, Statistics_Snapshot *snapshot);
+
+/**
+ * @brief Prints the statistics of every channel.
+ *
+ * @param[in] stats Statistics.
+ * @param[in] print Output function, e.g. `printConsole` or `Log_Print`.
+ */
+void Statistics_Dump(const Statistics_Config *stats, void (*print)(char *msg, ...));
+
+#endif /* STATISTICS_STATISTICS_H_ */
@@ -0,0 +1,249 @@
+/**
+ * @file Telemetry.c
+ * @brief Binary framed telemetry stream.
+ *
+ * Implementation of the frame builder declared in @ref Telemetry.h.
+ *
+ * @version 1.0
+ * @date 2025-06-06
+ *
+ * @author Kunal Salvi
+ */
+
+#include "Telemetry.h"
+
+
+static uint32_t *Telemetry_Get_Frame(Telemetry_Config *telemetry)
+{
+	return &telemetry->Buffer[telemetry->Active * telemetry->Frame_Words];
+}
+
+static Telemetry_Header *Telemetry_Get_Header(Telemetry_Config *telemetry)
+{
+	return (Telemetry_Header *)Telemetry_Get_Frame(telemetry);
+}
+
+static uint16_t *Telemetry_Get_Payload(Telemetry_Config *telemetry)
+{
+	return (uint16_t *)((uint8_t *)Telemetry_Get_Frame(telemetry) + TELEMETRY_HEADER_SIZE);
+}
+
+/* Payload room of one frame in bytes */
+static uint16_t Telemetry_Capacity(Telemetry_Config *telemetry)
+{
+	return telemetry->Frame_Words * 4 - TELEMETRY_HEADER_SIZE - TELEMETRY_CRC_SIZE;
+}
+
+/* Waits until the frame being filled is off the wire */
+static void Telemetry_Wait_Active(Telemetry_Config *telemetry)
+{
+	if(telemetry->In_Flight[telemetry->Active])
+	{
+		telemetry->Stalls++;
+		while(telemetry->In_Flight[telemetry->Active]){}
+	}
+}
+
+/* Runs in the transmit complete interrupt */
+static void Telemetry_Frame_Sent(void *context)
+{
+	*(volatile bool *)context = false;
+}
+
+static void Telemetry_Set_Layout(Telemetry_Config *telemetry)
+{
+	telemetry->Channels = 0;
+	for(uint8_t ch = 0; ch < 16; ch++)
+	{
+		if(telemetry->Channel_Mask & (1 << ch)) telemetry->Channels++;
+	}
+
+	telemetry->Frame_Words = TELEMETRY_FRAME_WORDS(telemetry->Channels, telemetry->Scans_Per_Frame);
+}
+
+int8_t Telemetry_Init(Telemetry_Config *telemetry)
+{
+	if((telemetry->Buffer == NULL) || (telemetry->Write == NULL)) return -1;
+	if((telemetry->Channel_Mask == 0) || (telemetry->Scans_Per_Frame == 0)) return -1;
+
+	Telemetry_Set_Layout(telemetry);
+	telemetry->Scans = 0;
+	telemetry->Bytes = 0;
+	telemetry->Active = 0;
+	telemetry->In_Flight[0] = false;
+	telemetry->In_Flight[1] = false;
+	telemetry->Sequence = 0;
+	telemetry->Frames_Sent = 0;
+	telemetry->Frames_Dropped = 0;
+	telemetry->Stalls = 0;
+	telemetry->Urgent_In_Flight = false;
+	telemetry->Urgent_Sequence = 0;
+
+	CRC_Init();
+	return 1;
+}
+
+uint16_t *Telemetry_Reserve(Telemetry_Config *telemetry, uint8_t scans)
+{
+	if(scans > telemetry->Scans_Per_Frame) return NULL;
+
+	if((telemetry->Scans_Per_Frame - telemetry->Scans) < scans)
+	{
+		Telemetry_Flush(telemetry);
+	}
+
+	Telemetry_Wait_Active(telemetry);
+
+	return &Telemetry_Get_Payload(telemetry)[telemetry->Scans * telemetry->Channels];
+}
+
+uint8_t *Telemetry_Reserve_Bytes(Telemetry_Config *telemetry, uint16_t length)
+{
+	uint16_t capacity = Telemetry_Capacity(telemetry);
+
+	if(length > capacity) return NULL;
+
+	// The scans field counts the records, it has to stay below 256
+	if(((capacity - telemetry->Bytes) < length) || (telemetry->Scans == UINT8_MAX))
+	{
+		Telemetry_Flush(telemetry);
+	}
+
+	Telemetry_Wait_Active(telemetry);
+
+	return (uint8_t *)Telemetry_Get_Payload(telemetry) + telemetry->Bytes;
+}
+
+int8_t Telemetry_Commit_Bytes(Telemetry_Config *telemetry, uint16_t length, uint64_t timestamp)
+{
+	if(length == 0) return 0;
+
+	if(telemetry->Scans == 0)
+	{
+		Telemetry_Get_Header(telemetry)->Timestamp = timestamp;
+	}
+
+	telemetry->Bytes += length;
+	telemetry->Scans++;
+
+	return 1;
+}
+
+int8_t Telemetry_Commit(Telemetry_Config *telemetry, uint8_t scans, uint64_t timestamp)
+{
+	if(scans == 0) return 0;
+
+	if(telemetry->Scans == 0)
+	{
+		Telemetry_Get_Header(telemetry)->Timestamp = timestamp;
+	}
+
+	telemetry->Scans += scans;
+
+	if(telemetry->Scans >= telemetry->Scans_Per_Frame)
+	{
+		return Telemetry_Flush(telemetry);
+	}
+
+	return 0;
+}
+
+int8_t Telemetry_Flush(Telemetry_Config *telemetry)
+{
+	if(telemetry->Scans == 0) return 0;
+
+	Telemetry_Header *header = Telemetry_Get_Header(telemetry);
+	uint16_t used = (telemetry->Bytes != 0) ? telemetry->Bytes : telemetry->Scans * telemetry->Channels * 2;
+	uint16_t payload_length = (used + 3) & ~3;
+	uint8_t *payload = (uint8_t *)Telemetry_Get_Payload(telemetry);
+
+	// Zero the padding so the CRC is reproducible
+	memset(&payload[used], 0, payload_length - used);
+
+	header->Sync = TELEMETRY_SYNC;
+	header->Type = telemetry->Type;
+	header->Scans = telemetry->Scans;
+	header->Sequence = telemetry->Sequence++;
+	header->Channel_Mask = telemetry->Channel_Mask;
+	header->Payload_Length = payload_length;
+	header->Scan_Period = telemetry->Scan_Period;
+
+	uint32_t *frame = Telemetry_Get_Frame(telemetry);
+	uint16_t crc_words = (TELEMETRY_HEADER_SIZE + payload_length) / 4;
+	frame[crc_words] = CRC_Compute_32Bit_Block(frame, crc_words);
+
+	volatile bool *in_flight = &telemetry->In_Flight[telemetry->Active];
+	int8_t queued;
+
+	*in_flight = true;
+	queued = telemetry->Write((const uint8_t *)frame, (crc_words + 1) * 4, Telemetry_Frame_Sent, (void *)in_flight);
+
+	if(queued == 1)
+	{
+		telemetry->Frames_Sent++;
+	}
+	else
+	{
+		*in_flight = false;
+		telemetry->Frames_Dropped++;
+	}
+
+	// Fill the other frame while this one is on the wire
+	telemetry->Active ^= 1;
+	telemetry->Scans = 0;
+	telemetry->Bytes = 0;
+	return (queued == 1) ? 1 : 0;
+}
+
+int8_t Telemetry_Set_Channel_Mask(Telemetry_Config *telemetry, uint16_t channel_mask)
+{
+	if(channel_mask == 0) return -1;
+
+	Telemetry_Flush(telemetry);
+
+	// Frames on the wire keep the old layout until they are sent
+	while(telemetry->In_Flight[0] || telemetry->In_Flight[1]){}
+
+	telemetry->Channel_Mask = channel_mask;
+	telemetry->Active = 0;
+	Telemetry_Set_Layout(telemetry);
+
+	return 1;
+}
+
+int8_t Telemetry_Send_Urgent(Telemetry_Config *telemetry, uint8_t type, uint8_t records, uint16_t channel_mask,
+		uint64_t timestamp, const void *payload, uint16_t length)
+{
+	if((telemetry->Write_Urgent == NULL) || (length > TELEMETRY_URGENT_PAYLOAD)) return -1;
+	if(telemetry->Urgent_In_Flight) return 0;
+
+	uint32_t *frame = telemetry->Urgent;
+	Telemetry_Header *header = (Telemetry_Header *)frame;
+	uint16_t payload_length = (length + 3) & ~3;
+	uint8_t *data = (uint8_t *)frame + TELEMETRY_HEADER_SIZE;
+
+	memcpy(data, payload, length);
+	memset(&data[length], 0, payload_length - length);
+
+	header->Sync = TELEMETRY_SYNC;
+	header->Type = type;
+	header->Scans = records;
+	header->Sequence = telemetry->Urgent_Sequence;
+	header->Timestamp = timestamp;
+	header->Channel_Mask = channel_mask;
+	header->Payload_Length = payload_length;
+	header->Scan_Period = 0;
+
+	uint16_t crc_words = (TELEMETRY_HEADER_SIZE + payload_length) / 4;
+	frame[crc_words] = CRC_Compute_32Bit_Block(frame, crc_words);
+
+	telemetry->Urgent_In_Flight = true;
+	if(telemetry->Write_Urgent((const uint8_t *)frame, (crc_words + 1) * 4, Telemetry_Frame_Sent, (void *)&telemetry->Urgent_In_Flight) != 1)
+	{
+		telemetry->Urgent_In_Flight = false;
+		return 0;
+	}
+
+	telemetry->Urgent_Sequence++;
+	return 1;
+}
@@ -0,0 +1,257 @@
+/**
+ * @file Telemetry.h
+ * @brief Binary framed telemetry stream.
+ *
+ * Samples are sent in frames instead of printf formatted text. A frame is
+ *
+ * | Offset | Size | Field                                              |
+ * |--------|------|----------------------------------------------------|
+ * | 0      | 2    | Sync word 0x55AA (bytes AA 55)                     |
+ * | 2      | 1    | Sample type, @ref TELEMETRY_TYPE_CODE or ...       |
+ * | 3      | 1    | Scans in the frame                                 |
+ * | 4      | 4    | Frame sequence number                              |
+ * | 8      | 8    | Timestamp of the first scan (ns)                   |
+ * | 16     | 2    | Channel mask, bit n set when channel n is sent     |
+ * | 18     | 2    | Payload length in bytes, including padding         |
+ * | 20     | 4    | Scan period (ns)                                   |
+ * | 24     | n    | 16-bit samples, scan after scan, zero padded to 4  |
+ * | 24 + n | 4    | CRC                                                |
+ *
+ * All fields are little endian. The CRC is computed by the CRC peripheral over
+ * the header and payload taken as little endian 32-bit words (polynomial
+ * 0x04C11DB7, initial value 0xFFFFFFFF, no reflection, no final XOR).
+ * Times are in nanoseconds, timer triggered samples are timed finer than 1 µs.
+ *
+ * The payload is not copied: producers ask for room with @ref Telemetry_Reserve,
+ * write their samples straight into the frame and hand it back with
+ * @ref Telemetry_Commit. A full frame is passed to the `Write` function, which
+ * queues it for transmission, while the next frame is filled in the second half
+ * of the buffer. Only when the link cannot keep up does @ref Telemetry_Reserve
+ * wait for the older frame to leave.
+ *
+ * Variable length records, such as the change-only reports of @ref Deadband.h,
+ * use @ref Telemetry_Reserve_Bytes and @ref Telemetry_Commit_Bytes instead. The
+ * scans field then counts the records and the frame holds as many as fit into
+ * the payload of a sample frame. For @ref TELEMETRY_TYPE_CHANGES a record is
+ *
+ * | Field  | Encoding                                                      |
+ * |--------|---------------------------------------------------------------|
+ * | Head   | Varint, scan periods since the previous record << 1, bit 0 set for a keyframe |
+ * | Mask   | Varint, bit n set when the n-th channel of the stream follows |
+ * | Values | One zigzag varint per channel in the mask, 0.01 °C            |
+ *
+ * A varint carries 7 bits per byte, least significant first, with bit 7 set
+ * while more bytes follow. Keyframe values are absolute, all others are the
+ * difference to the last value sent for that channel. The first record of a
+ * frame is at the frame timestamp, its head still counts from the record before.
+ *
+ * Rare events such as alarms are sent with @ref Telemetry_Send_Urgent in a frame
+ * of their own. It has the same header and CRC, is passed to `Write_Urgent` so it
+ * overtakes the queued sample frames, and counts its own sequence numbers, which
+ * keeps gaps in the sample stream meaningful. For @ref TELEMETRY_TYPE_ALARM the
+ * header holds
+ *
+ * | Field        | Value                                             |
+ * |--------------|---------------------------------------------------|
+ * | Scans        | Number of 8-byte events in the payload            |
+ * | Timestamp    | Time of the first event (ns)                      |
+ * | Channel mask | Channels of the events                            |
+ * | Scan period  | 0                                                 |
+ *
+ * and every event is
+ *
+ * | Offset | Size | Field                                              |
+ * |--------|------|----------------------------------------------------|
+ * | 0      | 1    | Channel                                            |
+ * | 1      | 1    | Kind, 1 high, 2 low, 4 rate of rise                |
+ * | 2      | 1    | 1 when the alarm is raised, 0 when it clears       |
+ * | 3      | 1    | Source, 0 block check, 1 analog watchdog           |
+ * | 4      | 4    | Value, signed 0.01 °C or 0.01 °C/s for a rise      |
+ *
+ * @version 1.0
+ * @date 2025-06-06
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef TELEMETRY_TELEMETRY_H_
+#define TELEMETRY_TELEMETRY_H_
+
+#include "main.h"
+#include "CRC/CRC.h"
+
+#define TELEMETRY_SYNC				0x55AA
+
+#define TELEMETRY_TYPE_CODE			0x01	/**< Unsigned 16-bit ADC codes */
+#define TELEMETRY_TYPE_CENTI_CELSIUS	0x02	/**< Signed 16-bit temperatures in 0.01 °C */
+#define TELEMETRY_TYPE_ALARM		0x03	/**< Alarm events, sent urgent */
+#define TELEMETRY_TYPE_CHANGES		0x04	/**< Change-only records in 0.01 °C */
+
+#define TELEMETRY_HEADER_SIZE		24
+#define TELEMETRY_CRC_SIZE			4
+#define TELEMETRY_URGENT_PAYLOAD	32		/**< Largest payload of @ref Telemetry_Send_Urgent in bytes */
+
+/**
+ * @brief Size of the frame buffer in 32-bit words for a given channel count and
+ *        number of scans per frame.
+ */
+#define TELEMETRY_FRAME_WORDS(channels, scans)	\
+	((TELEMETRY_HEADER_SIZE + (((channels) * (scans) * 2 + 3) & ~3) + TELEMETRY_CRC_SIZE) / 4)
+
+/**
+ * @brief Size of the double frame buffer handed to @ref Telemetry_Config.Buffer.
+ */
+#define TELEMETRY_BUFFER_WORDS(channels, scans)	(2 * TELEMETRY_FRAME_WORDS(channels, scans))
+
+typedef struct __attribute__((packed)) Telemetry_Header{
+	uint16_t Sync;
+	uint8_t Type;
+	uint8_t Scans;
+	uint32_t Sequence;
+	uint64_t Timestamp;
+	uint16_t Channel_Mask;
+	uint16_t Payload_Length;
+	uint32_t Scan_Period;
+}Telemetry_Header;
+
+/** @struct Telemetry_Config
+ *  @brief  Configuration and state of one telemetry stream.
+ */
+typedef struct Telemetry_Config{
+	uint32_t *Buffer;			/**< Two frames, @ref TELEMETRY_BUFFER_WORDS words */
+	uint16_t Channel_Mask;		/**< Channels present in every scan */
+	uint8_t Type;				/**< Sample type of the payload */
+	uint8_t Scans_Per_Frame;	/**< Scans collected before a frame is sent */
+	uint32_t Scan_Period;		/**< Time between two scans (ns) */
+
+	/**
+	 * @brief Queues a complete frame for transmission, e.g. @ref Console_Write_Async.
+	 *        Returns 1 when queued and calls `complete(context)` once the frame is sent.
+	 */
+	int8_t (*Write)(const uint8_t *data, uint16_t length, void (*complete)(void *context), void *context);
+
+	/**
+	 * @brief Sends a frame ahead of the queued ones, e.g. @ref Console_Write_Urgent.
+	 *        Same contract as `Write`, may be NULL when urgent frames are not used.
+	 */
+	int8_t (*Write_Urgent)(const uint8_t *data, uint16_t length, void (*complete)(void *context), void *context);
+
+	/* State */
+	uint8_t Channels;
+	uint8_t Scans;				/**< Scans, or records, in the frame being filled */
+	uint16_t Bytes;				/**< Payload written by @ref Telemetry_Commit_Bytes */
+	uint8_t Active;				/**< Frame being filled */
+	uint16_t Frame_Words;
+	volatile bool In_Flight[2];	/**< Frame queued and not yet sent */
+	uint32_t Sequence;
+	uint32_t Frames_Sent;
+	uint32_t Frames_Dropped;	/**< Frames the Write function did not accept */
+	uint32_t Stalls;			/**< Times the producer waited for the link */
+	uint32_t Urgent[(TELEMETRY_HEADER_SIZE + TELEMETRY_URGENT_PAYLOAD + TELEMETRY_CRC_SIZE) / 4];
+	volatile bool Urgent_In_Flight;
+	uint32_t Urgent_Sequence;
+}Telemetry_Config;
+
+/**
+ * @brief Initializes a telemetry stream and the CRC unit.
+ *
+ * @param[in,out] telemetry Stream with the configuration fields filled in.
+ *
+ * @return int8_t Returns 1 on success, or -1 for an invalid configuration.
+ */
+int8_t Telemetry_Init(Telemetry_Config *telemetry);
+
+/**
+ * @brief Reserves room for `scans` scans in the current frame.
+ *
+ * If the current frame has less room it is sent first. If the frame buffer is
+ * still being transmitted this waits for it.
+ *
+ * @param[in,out] telemetry Stream.
+ * @param[in] scans Number of scans the producer may write.
+ *
+ * @return uint16_t* Where the producer writes its samples, NULL if `scans` exceeds a frame.
+ */
+uint16_t *Telemetry_Reserve(Telemetry_Config *telemetry, uint8_t scans);
+
+/**
+ * @brief Adds the scans written after @ref Telemetry_Reserve to the frame.
+ *
+ * The frame is sent as soon as it is full.
+ *
+ * @param[in,out] telemetry Stream.
+ * @param[in] scans Number of scans actually written.
+ * @param[in] timestamp Time of the first of these scans (ns).
+ *
+ * @return int8_t Returns 1 if a frame was queued, 0 otherwise.
+ */
+int8_t Telemetry_Commit(Telemetry_Config *telemetry, uint8_t scans, uint64_t timestamp);
+
+/**
+ * @brief Reserves room for a record of `length` bytes in the current frame.
+ *
+ * The byte counterpart of @ref Telemetry_Reserve, a frame holds either scans or
+ * records, never both.
+ *
+ * @param[in,out] telemetry Stream.
+ * @param[in] length Size of the record.
+ *
+ * @return uint8_t* Where the producer writes the record, NULL if it exceeds the payload of a frame.
+ */
+uint8_t *Telemetry_Reserve_Bytes(Telemetry_Config *telemetry, uint16_t length);
+
+/**
+ * @brief Adds a record written after @ref Telemetry_Reserve_Bytes to the frame.
+ *
+ * @param[in,out] telemetry Stream.
+ * @param[in] length Size of the record actually written.
+ * @param[in] timestamp Time of the record (ns), becomes the frame timestamp for the first record.
+ *
+ * @return int8_t Returns 1 if the record was added, 0 for an empty record.
+ */
+int8_t Telemetry_Commit_Bytes(Telemetry_Config *telemetry, uint16_t length, uint64_t timestamp);
+
+/**
+ * @brief Sends the current frame even if it is not full.
+ *
+ * @param[in,out] telemetry Stream.
+ *
+ * @return int8_t Returns 1 if a frame was queued, 0 if it was empty or dropped.
+ */
+int8_t Telemetry_Flush(Telemetry_Config *telemetry);
+
+/**
+ * @brief Changes the channels of the following frames.
+ *
+ * The current frame is sent first and the frames still being transmitted are
+ * waited for. The buffer must have room for two frames of the new mask, e.g. be
+ * sized for the largest channel set that is used.
+ *
+ * @param[in,out] telemetry Stream.
+ * @param[in] channel_mask Channels present in every scan from now on.
+ *
+ * @return int8_t Returns 1 on success, or -1 for an empty mask.
+ */
+int8_t Telemetry_Set_Channel_Mask(Telemetry_Config *telemetry, uint16_t channel_mask);
+
+/**
+ * @brief Sends a single frame ahead of the sample frames.
+ *
+ * The frame is built in a buffer of its own, so the sample frames are not
+ * touched. If the previous urgent frame is still on the wire nothing is sent and
+ * the caller keeps its data for a later try.
+ *
+ * @param[in,out] telemetry Stream with `Write_Urgent` set.
+ * @param[in] type Type of the payload, e.g. @ref TELEMETRY_TYPE_ALARM.
+ * @param[in] records Number of records in the payload, goes into the scans field.
+ * @param[in] channel_mask Channels the payload refers to.
+ * @param[in] timestamp Time of the first record (ns).
+ * @param[in] payload Payload, copied.
+ * @param[in] length Payload length, at most @ref TELEMETRY_URGENT_PAYLOAD bytes.
+ *
+ * @return int8_t Returns 1 if the frame was accepted, 0 if the link is busy, or -1 for invalid arguments.
+ */
+int8_t Telemetry_Send_Urgent(Telemetry_Config *telemetry, uint8_t type, uint8_t records, uint16_t channel_mask,
+		uint64_t timestamp, const void *payload, uint16_t length);
+
+#endif /* TELEMETRY_TELEMETRY_H_ */
@@ -0,0 +1,237 @@
+/**
+ * @file Thermistor.c
+ * @brief NTC thermistor linearization.
+ *
+ * Implementation of the table based conversion declared in @ref Thermistor.h.
+ *
+ * @version 1.0
+ * @date 2025-06-04
+ *
+ * @author Kunal Salvi
+ */
+
+#include "Thermistor.h"
+
+#define THERMISTOR_BENCHMARK_SAMPLES	256
+
+static uint16_t benchmark_codes[THERMISTOR_BENCHMARK_SAMPLES];
+static float benchmark_table[THERMISTOR_BENCHMARK_SAMPLES];
+static float benchmark_exact[THERMISTOR_BENCHMARK_SAMPLES];
+static int32_t benchmark_q16[THERMISTOR_BENCHMARK_SAMPLES];
+
+
+static uint32_t Thermistor_Code_Max(const Thermistor_Config *config)
+{
+	return (1UL << config->Code_Bits) - 1;
+}
+
+/* Exact model for any code, including the table end points past the last code */
+static float Thermistor_Exact(const Thermistor_Config *config, uint32_t code)
+{
+	uint32_t code_max = Thermistor_Code_Max(config);
+	float invT;
+
+	// Both rails are open / shorted thermistors, stay one code inside them
+	if(code < 1) code = 1;
+	if(code > code_max - 1) code = code_max - 1;
+
+	float rTherm = config->R_Fixed * ((float)code_max / (float)code - 1.0f);
+
+	if(config->Steinhart_Hart.Enable)
+	{
+		float lnR = logf(rTherm);
+		invT = config->Steinhart_Hart.A + config->Steinhart_Hart.B * lnR + config->Steinhart_Hart.C * lnR * lnR * lnR;
+	}
+	else
+	{
+		invT = (1.0f / config->T0_Kelvin) + (logf(rTherm / config->R0) / config->B_Coefficient);
+	}
+
+	return (1.0f / invT) - 273.15f;
+}
+
+/* First code whose temperature is at or above celsius, the curve rises with the code */
+static uint16_t Thermistor_Find_Code(const Thermistor_Config *config, float celsius)
+{
+	uint32_t low = 1;
+	uint32_t high = Thermistor_Code_Max(config) - 1;
+
+	while(low < high)
+	{
+		uint32_t mid = (low + high) / 2;
+
+		if(Thermistor_Exact(config, mid) < celsius)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	return (uint16_t)low;
+}
+
+int8_t Thermistor_Init(Thermistor_Config *config)
+{
+	if((config->Code_Bits < THERMISTOR_TABLE_BITS) || (config->Code_Bits > 16)) return -1;
+	if(config->R_Fixed <= 0.0f) return -1;
+	if(!config->Steinhart_Hart.Enable && ((config->R0 <= 0.0f) || (config->B_Coefficient <= 0.0f) || (config->T0_Kelvin <= 0.0f))) return -1;
+	if(config->Min_Celsius >= config->Max_Celsius) return -1;
+
+	uint8_t shift = config->Code_Bits - THERMISTOR_TABLE_BITS;
+
+	for(uint32_t i = 0; i < THERMISTOR_TABLE_SIZE; i++)
+	{
+		config->Table[i] = Thermistor_Exact(config, i << shift);
+		config->Table_Q16[i] = (int32_t)lroundf(config->Table[i] * (float)THERMISTOR_Q16_ONE);
+	}
+	config->Fraction_Scale = 1.0f / (float)(1UL << shift);
+
+	config->Min_Code = Thermistor_Find_Code(config, config->Min_Celsius);
+	config->Max_Code = Thermistor_Find_Code(config, config->Max_Celsius);
+	if(config->Max_Code > config->Min_Code && Thermistor_Exact(config, config->Max_Code) > config->Max_Celsius)
+	{
+		config->Max_Code--;
+	}
+	if(config->Max_Code <= config->Min_Code) return -1;
+
+	config->Error_Bound = 0.0f;
+	config->Worst_Code = config->Min_Code;
+	config->Error_Bound_Q16 = 0;
+
+	for(uint32_t code = config->Min_Code; code <= config->Max_Code; code++)
+	{
+		float exact = Thermistor_Exact(config, code);
+		float error = fabsf(Thermistor_Code_To_Celsius(config, code) - exact);
+		int32_t error_q16 = labs(Thermistor_Code_To_Q16(config, code) - lroundf(exact * (float)THERMISTOR_Q16_ONE));
+
+		if(error > config->Error_Bound)
+		{
+			config->Error_Bound = error;
+			config->Worst_Code = code;
+		}
+		if(error_q16 > config->Error_Bound_Q16)
+		{
+			config->Error_Bound_Q16 = error_q16;
+		}
+	}
+
+	return 1;
+}
+
+uint16_t Thermistor_Celsius_To_Code(const Thermistor_Config *config, float celsius)
+{
+	return Thermistor_Find_Code(config, celsius);
+}
+
+float Thermistor_Code_To_Celsius(const Thermistor_Config *config, uint16_t code)
+{
+	if(code < config->Min_Code) code = config->Min_Code;
+	else if(code > config->Max_Code) code = config->Max_Code;
+
+	uint8_t shift = config->Code_Bits - THERMISTOR_TABLE_BITS;
+	uint32_t index = code >> shift;
+	float fraction = (float)(code & ((1UL << shift) - 1)) * config->Fraction_Scale;
+	float low = config->Table[index];
+
+	return low + (config->Table[index + 1] - low) * fraction;
+}
+
+int32_t Thermistor_Code_To_Q16(const Thermistor_Config *config, uint16_t code)
+{
+	if(code < config->Min_Code) code = config->Min_Code;
+	else if(code > config->Max_Code) code = config->Max_Code;
+
+	uint8_t shift = config->Code_Bits - THERMISTOR_TABLE_BITS;
+	uint32_t index = code >> shift;
+	int32_t fraction = code & ((1UL << shift) - 1);
+	int32_t low = config->Table_Q16[index];
+
+	// 64-bit product, segments next to the rails can span hundreds of °C
+	return low + (int32_t)(((int64_t)(config->Table_Q16[index + 1] - low) * fraction) >> shift);
+}
+
+float Thermistor_Code_To_Celsius_Exact(const Thermistor_Config *config, uint16_t code)
+{
+	return Thermistor_Exact(config, code);
+}
+
+void Thermistor_Convert_Block(const Thermistor_Config *config, const uint16_t *codes, float *celsius, uint16_t count)
+{
+	for(uint16_t i = 0; i < count; i++)
+	{
+		celsius[i] = Thermistor_Code_To_Celsius(config, codes[i]);
+	}
+}
+
+void Thermistor_Convert_Block_Q16(const Thermistor_Config *config, const uint16_t *codes, int32_t *q16, uint16_t count)
+{
+	for(uint16_t i = 0; i < count; i++)
+	{
+		q16[i] = Thermistor_Code_To_Q16(config, codes[i]);
+	}
+}
+
+void Thermistor_Convert_Block_Centi(const Thermistor_Config *config, const uint16_t *codes, int16_t *centi, uint16_t count)
+{
+	for(uint16_t i = 0; i < count; i++)
+	{
+		int64_t scaled = (int64_t)Thermistor_Code_To_Q16(config, codes[i]) * 100 + (THERMISTOR_Q16_ONE / 2);
+		int32_t value = (int32_t)(scaled >> 16);
+
+		centi[i] = (value > INT16_MAX) ? INT16_MAX : (value < INT16_MIN) ? INT16_MIN : (int16_t)value;
+	}
+}
+
+void Thermistor_Benchmark(const Thermistor_Config *config, Thermistor_Benchmark_Result *result)
+{
+	uint32_t code_max = Thermistor_Code_Max(config);
+	uint32_t start;
+	uint32_t table_cycles;
+	uint32_t q16_cycles;
+	uint32_t exact_cycles;
+
+	for(uint32_t i = 0; i < THERMISTOR_BENCHMARK_SAMPLES; i++)
+	{
+		benchmark_codes[i] = (uint16_t)((i * code_max) / (THERMISTOR_BENCHMARK_SAMPLES - 1));
+	}
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	__disable_irq();
+
+	start = DWT->CYCCNT;
+	Thermistor_Convert_Block(config, benchmark_codes, benchmark_table, THERMISTOR_BENCHMARK_SAMPLES);
+	table_cycles = DWT->CYCCNT - start;
+
+	start = DWT->CYCCNT;
+	Thermistor_Convert_Block_Q16(config, benchmark_codes, benchmark_q16, THERMISTOR_BENCHMARK_SAMPLES);
+	q16_cycles = DWT->CYCCNT - start;
+
+	start = DWT->CYCCNT;
+	for(uint32_t i = 0; i < THERMISTOR_BENCHMARK_SAMPLES; i++)
+	{
+		benchmark_exact[i] = Thermistor_Code_To_Celsius_Exact(config, benchmark_codes[i]);
+	}
+	exact_cycles = DWT->CYCCNT - start;
+
+	__enable_irq();
+
+	result->Samples = THERMISTOR_BENCHMARK_SAMPLES;
+	result->Table_Cycles = (float)table_cycles / THERMISTOR_BENCHMARK_SAMPLES;
+	result->Q16_Cycles = (float)q16_cycles / THERMISTOR_BENCHMARK_SAMPLES;
+	result->Exact_Cycles = (float)exact_cycles / THERMISTOR_BENCHMARK_SAMPLES;
+	result->Max_Error = 0.0f;
+
+	for(uint32_t i = 0; i < THERMISTOR_BENCHMARK_SAMPLES; i++)
+	{
+		// Outside the valid range the table clamps on purpose
+		if((benchmark_codes[i] < config->Min_Code) || (benchmark_codes[i] > config->Max_Code)) continue;
+
+		float error = fabsf(benchmark_table[i] - benchmark_exact[i]);
+		if(error > result->Max_Error) result->Max_Error = error;
+	}
+}
@@ -0,0 +1,187 @@
+/**
+ * @file Thermistor.h
+ * @brief NTC thermistor linearization.
+ *
+ * Converts ADC codes of a thermistor divider to temperature without evaluating
+ * `logf` per sample. At init a table of the exact curve (B-parameter or
+ * Steinhart-Hart model) is built on evenly spaced codes and samples are linearly
+ * interpolated between the two neighbouring entries.
+ *
+ * The divider is the one on the board: thermistor from VREF to the ADC pin and
+ * `R_Fixed` from the ADC pin to ground, so the code rises with temperature and
+ * the conversion is ratiometric (VREF cancels out).
+ *
+ * Since the input is a finite set of codes, @ref Thermistor_Init compares the
+ * table against the exact curve for every code of the valid range and stores the
+ * worst deviation in `Error_Bound`. Codes outside the valid range are clamped.
+ *
+ * Next to the float table a Q16.16 copy is kept so the whole path from ADC code
+ * to output record can run in integer arithmetic, with the same cycle count for
+ * every sample and no FPU needed (see @ref Thermistor_Code_To_Q16).
+ *
+ * @version 1.0
+ * @date 2025-06-04
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef THERMISTOR_THERMISTOR_H_
+#define THERMISTOR_THERMISTOR_H_
+
+#include "main.h"
+
+/**
+ * @brief log2 of the number of table segments. 9 bits (513 entries, 2 KB) keeps
+ *        a 10k / B3950 part within ~0.07 °C from -40 °C to 150 °C.
+ */
+#define THERMISTOR_TABLE_BITS		9
+#define THERMISTOR_TABLE_SIZE		((1 << THERMISTOR_TABLE_BITS) + 1)
+
+/** @brief One °C in Q16.16 */
+#define THERMISTOR_Q16_ONE			65536L
+
+/** @struct Thermistor_Config
+ *  @brief  Thermistor model and the table built from it.
+ */
+typedef struct Thermistor_Config{
+	float R_Fixed;				/**< Divider resistor to ground (Ω) */
+	float R0;					/**< Thermistor resistance at T0 (Ω) */
+	float B_Coefficient;		/**< B-parameter (K) */
+	float T0_Kelvin;			/**< Reference temperature of R0 (K) */
+
+	/**
+	 * @brief Optional Steinhart-Hart model, 1/T = A + B ln(R) + C ln(R)^3.
+	 *        When enabled it replaces the B-parameter model.
+	 */
+	struct Steinhart_Hart
+	{
+		bool Enable;
+		float A;
+		float B;
+		float C;
+	}Steinhart_Hart;
+
+	uint8_t Code_Bits;			/**< Width of the input codes, 12 for raw samples, 16 after decimation */
+	float Min_Celsius;			/**< Lower end of the valid range */
+	float Max_Celsius;			/**< Upper end of the valid range */
+
+	/* Filled in by Thermistor_Init */
+	uint16_t Min_Code;			/**< First code of the valid range */
+	uint16_t Max_Code;			/**< Last code of the valid range */
+	float Error_Bound;			/**< Largest table error over the valid range (°C) */
+	uint16_t Worst_Code;		/**< Code at which Error_Bound occurs */
+	int32_t Error_Bound_Q16;	/**< Largest error of the Q16.16 path over the valid range */
+	float Fraction_Scale;		/**< 1 / codes per segment */
+	float Table[THERMISTOR_TABLE_SIZE];
+	int32_t Table_Q16[THERMISTOR_TABLE_SIZE];	/**< Table in Q16.16 °C */
+}Thermistor_Config;
+
+/** @struct Thermistor_Benchmark_Result
+ *  @brief  Outcome of @ref Thermistor_Benchmark.
+ */
+typedef struct Thermistor_Benchmark_Result{
+	uint32_t Samples;				/**< Samples converted by each path */
+	float Table_Cycles;				/**< Cycles per sample of the table path */
+	float Q16_Cycles;				/**< Cycles per sample of the Q16.16 table path */
+	float Exact_Cycles;				/**< Cycles per sample of the logf path */
+	float Max_Error;				/**< Largest deviation seen on the benchmark samples (°C) */
+}Thermistor_Benchmark_Result;
+
+/**
+ * @brief Builds the table and measures its error bound.
+ *
+ * Every code of the valid range is checked against the exact curve, which
+ * takes in the order of 100 ms for 16-bit codes. Call it once at startup.
+ *
+ * @param[in,out] config Thermistor model, the table fields are filled in.
+ *
+ * @return int8_t Returns 1 on success, or -1 for an invalid model.
+ */
+int8_t Thermistor_Init(Thermistor_Config *config);
+
+/**
+ * @brief Converts one code using the table.
+ *
+ * @param[in] config Initialized thermistor model.
+ * @param[in] code ADC code of `Code_Bits` width.
+ *
+ * @return float Temperature in °C.
+ */
+float Thermistor_Code_To_Celsius(const Thermistor_Config *config, uint16_t code);
+
+/**
+ * @brief Finds the code of a temperature, the inverse of the exact model.
+ *
+ * Searches the code range with the exact model, so it is meant for setting up
+ * limits, not for per sample work.
+ *
+ * @param[in] config Thermistor model.
+ * @param[in] celsius Temperature in °C.
+ *
+ * @return uint16_t First code of `Code_Bits` width whose temperature is at or above `celsius`.
+ */
+uint16_t Thermistor_Celsius_To_Code(const Thermistor_Config *config, float celsius);
+
+/**
+ * @brief Converts one code with the exact model (logf), reference path.
+ *
+ * @param[in] config Thermistor model.
+ * @param[in] code ADC code of `Code_Bits` width.
+ *
+ * @return float Temperature in °C.
+ */
+float Thermistor_Code_To_Celsius_Exact(const Thermistor_Config *config, uint16_t code);
+
+/**
+ * @brief Converts a block of codes using the table.
+ *
+ * @param[in] config Initialized thermistor model.
+ * @param[in] codes Input codes.
+ * @param[out] celsius Output temperatures in °C.
+ * @param[in] count Number of codes.
+ */
+void Thermistor_Convert_Block(const Thermistor_Config *config, const uint16_t *codes, float *celsius, uint16_t count);
+
+/**
+ * @brief Converts one code using the Q16.16 table, integer arithmetic only.
+ *
+ * @param[in] config Initialized thermistor model.
+ * @param[in] code ADC code of `Code_Bits` width.
+ *
+ * @return int32_t Temperature in Q16.16 °C.
+ */
+int32_t Thermistor_Code_To_Q16(const Thermistor_Config *config, uint16_t code);
+
+/**
+ * @brief Converts a block of codes using the Q16.16 table.
+ *
+ * @param[in] config Initialized thermistor model.
+ * @param[in] codes Input codes.
+ * @param[out] q16 Output temperatures in Q16.16 °C.
+ * @param[in] count Number of codes.
+ */
+void Thermistor_Convert_Block_Q16(const Thermistor_Config *config, const uint16_t *codes, int32_t *q16, uint16_t count);
+
+/**
+ * @brief Converts a block of codes to signed 0.01 °C steps using the Q16.16 table.
+ *
+ * `codes` and `centi` may point to the same buffer, the samples are then
+ * replaced in place (used to fill telemetry frames without a copy).
+ *
+ * @param[in] config Initialized thermistor model.
+ * @param[in] codes Input codes.
+ * @param[out] centi Output temperatures in 0.01 °C, saturated to the int16_t range.
+ * @param[in] count Number of codes.
+ */
+void Thermistor_Convert_Block_Centi(const Thermistor_Config *config, const uint16_t *codes, int16_t *centi, uint16_t count);
+
+/**
+ * @brief Measures cycles per sample of the table, Q16.16 and logf paths with the DWT
+ *        cycle counter, on codes spread over the full code range.
+ *
+ * @param[in] config Initialized thermistor model.
+ * @param[out] result Timing and accuracy of the run.
+ */
+void Thermistor_Benchmark(const Thermistor_Config *config, Thermistor_Benchmark_Result *result);
+
+#endif /* THERMISTOR_THERMISTOR_H_ */
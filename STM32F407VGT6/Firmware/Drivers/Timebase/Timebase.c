@@ -0,0 +1,108 @@
+/**
+ * @file Timebase.c
+ * @brief Monotonic 64-bit microsecond time on TIM5.
+ *
+ * Implementation of the timebase declared in @ref Timebase.h.
+ *
+ * @version 1.0
+ * @date 2025-06-12
+ *
+ * @author Kunal Salvi
+ */
+
+#include "Timebase.h"
+
+static volatile uint32_t timebase_wraps = 0;
+
+
+void TIM5_IRQHandler(void)
+{
+	uint32_t status = TIM5->SR;
+
+	if(status & TIM_SR_UIF)
+	{
+		TIM5->SR = (uint32_t)~TIM_SR_UIF;
+		timebase_wraps++;
+	}
+
+	if(status & TIM_SR_CC1IF)
+	{
+		// One shot, the interrupt itself has already ended the WFI
+		TIM5->SR = (uint32_t)~TIM_SR_CC1IF;
+		TIM5->DIER &= ~TIM_DIER_CC1IE;
+	}
+}
+
+int8_t Timebase_Init(void)
+{
+	uint32_t clock = Timer_Clock(TIM5);
+
+	if((clock % TIMEBASE_FREQUENCY) != 0) return -1;
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+
+	TIM5->CR1 = 0;
+	TIM5->PSC = clock / TIMEBASE_FREQUENCY - 1;
+	TIM5->ARR = 0xFFFFFFFF;
+	TIM5->CNT = 0;
+	TIM5->EGR = TIM_EGR_UG;				// Load the prescaler
+	TIM5->SR = 0;
+	timebase_wraps = 0;
+
+	TIM5->DIER = TIM_DIER_UIE;
+	NVIC_EnableIRQ(TIM5_IRQn);
+	TIM5->CR1 = TIM_CR1_URS | TIM_CR1_CEN;	// Only overflows raise the update interrupt
+
+	return 1;
+}
+
+uint64_t Timebase_Micros(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t high = timebase_wraps;
+	uint32_t low = TIM5->CNT;
+
+	// Wrapped after the interrupt was masked, the update is still pending
+	if((TIM5->SR & TIM_SR_UIF) && (low < 0x80000000UL)) high++;
+
+	__set_PRIMASK(primask);
+
+	return ((uint64_t)high << 32) | low;
+}
+
+uint64_t Timebase_Millis(void)
+{
+	return Timebase_Micros() / 1000;
+}
+
+int8_t Timebase_Set_Alarm(uint64_t when)
+{
+	TIM5->DIER &= ~TIM_DIER_CC1IE;
+	TIM5->CCR1 = (uint32_t)when;
+	TIM5->SR = (uint32_t)~TIM_SR_CC1IF;
+	TIM5->DIER |= TIM_DIER_CC1IE;
+
+	// The compare only matches on equality, an alarm set in the past would wait a whole wrap
+	if((int64_t)(when - Timebase_Micros()) <= 0)
+	{
+		TIM5->DIER &= ~TIM_DIER_CC1IE;
+		return 0;
+	}
+
+	return 1;
+}
+
+void Timebase_Cancel_Alarm(void)
+{
+	TIM5->DIER &= ~TIM_DIER_CC1IE;
+	TIM5->SR = (uint32_t)~TIM_SR_CC1IF;
+}
+
+void Timebase_Delay_us(uint32_t us)
+{
+	uint64_t end = Timebase_Micros() + us;
+
+	while(Timebase_Micros() < end){}
+}
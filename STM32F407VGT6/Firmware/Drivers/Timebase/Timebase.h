@@ -0,0 +1,65 @@
+/**
+ * @file Timebase.h
+ * @brief Monotonic 64-bit microsecond time on TIM5.
+ *
+ * TIM5 is a 32-bit timer on APB1. It runs free at 1 MHz and its update interrupt
+ * counts the wraps, which extends the count to 64 bits. There is no periodic
+ * tick: the only other interrupt is the one shot alarm on channel 1 that wakes
+ * the core from WFI when the next scheduled task is due.
+ *
+ * @version 1.0
+ * @date 2025-06-12
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef TIMEBASE_TIMEBASE_H_
+#define TIMEBASE_TIMEBASE_H_
+
+#include "main.h"
+#include "Timer/Timer.h"
+
+#define TIMEBASE_FREQUENCY		1000000UL	/**< Counts per second */
+
+/**
+ * @brief Starts TIM5 as the free running timebase.
+ *
+ * Must be called after the clock setup, the prescaler follows the APB1 timer clock.
+ *
+ * @return int8_t Returns 1 on success, or -1 if the timer clock is not a whole MHz multiple.
+ */
+int8_t Timebase_Init(void);
+
+/**
+ * @brief Microseconds since @ref Timebase_Init, safe from interrupts.
+ */
+uint64_t Timebase_Micros(void);
+
+/**
+ * @brief Milliseconds since @ref Timebase_Init.
+ */
+uint64_t Timebase_Millis(void);
+
+/**
+ * @brief Arms the wake-up alarm.
+ *
+ * The alarm only generates an interrupt to end a WFI, it calls nothing.
+ * Alarms more than 2^32 µs away fire early on the next wrap, which is harmless.
+ *
+ * @param[in] when Absolute time in µs.
+ *
+ * @return int8_t Returns 1 if armed, 0 if `when` has already passed.
+ */
+int8_t Timebase_Set_Alarm(uint64_t when);
+
+/**
+ * @brief Disarms the wake-up alarm.
+ */
+void Timebase_Cancel_Alarm(void);
+
+/**
+ * @brief Busy waits for `us` microseconds on the timebase.
+ */
+void Timebase_Delay_us(uint32_t us);
+
+#endif /* TIMEBASE_TIMEBASE_H_ */
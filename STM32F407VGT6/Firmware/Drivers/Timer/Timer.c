@@ -0,0 +1,199 @@
+/**
+ * @file Timer.c
+ * @brief Prescaler and reload values for a timer rate.
+ *
+ * Implementation of the solver declared in @ref Timer.h.
+ *
+ * @version 1.0
+ * @date 2025-06-14
+ *
+ * @author Kunal Salvi
+ */
+
+#include "Timer.h"
+
+
+uint32_t Timer_Clock(TIM_TypeDef *timer)
+{
+	uint32_t clock;
+
+	if((timer == TIM1) || (timer == TIM8) || (timer == TIM9) || (timer == TIM10) || (timer == TIM11))
+	{
+		clock = SystemAPB2_Clock_Speed();
+		if((RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1) clock *= 2;
+	}
+	else
+	{
+		clock = SystemAPB1_Clock_Speed();
+		if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) clock *= 2;
+	}
+
+	return clock;
+}
+
+uint32_t Timer_Max_Reload(TIM_TypeDef *timer)
+{
+	return ((timer == TIM2) || (timer == TIM5)) ? TIMER_RELOAD_32_BIT : TIMER_RELOAD_16_BIT;
+}
+
+/*
+ * Divisions next to a large, nearly prime ratio can need tens of thousands of
+ * trial divisions, past @ref TIMER_FACTOR_BUDGET the solver takes the best of
+ * the first prescalers instead.
+ */
+#define TIMER_NEAREST_PRESCALERS	128
+
+/*
+ * Splits a division into PSC + 1 and ARR + 1. The smaller factor of a pair is at
+ * most the square root, so only that side is searched, smallest prescaler first.
+ */
+static bool Timer_Factor(uint64_t division, uint32_t max_reload, Timer_Settings *settings, uint32_t *budget)
+{
+	uint64_t reloads = (uint64_t)max_reload + 1;
+
+	if(division <= reloads)
+	{
+		settings->Prescaler = 0;
+		settings->Reload = (uint32_t)(division - 1);
+		return true;
+	}
+
+	uint64_t largest = (reloads > 65536) ? reloads : 65536;
+	uint32_t first = (uint32_t)((division + largest - 1) / largest);
+
+	for(uint32_t factor = first; ((uint64_t)factor * factor <= division) && (*budget > 0); factor++, (*budget)--)
+	{
+		// Only a division of exactly 2^32 needs the 64-bit library modulo
+		uint32_t remainder = (division <= UINT32_MAX) ? ((uint32_t)division % factor) : (uint32_t)(division % factor);
+
+		if(remainder != 0) continue;
+
+		uint64_t other = division / factor;
+
+		if((factor <= 65536) && (other <= reloads))
+		{
+			settings->Prescaler = (uint16_t)(factor - 1);
+			settings->Reload = (uint32_t)(other - 1);
+			return true;
+		}
+
+		if((other <= 65536) && (factor <= reloads))
+		{
+			settings->Prescaler = (uint16_t)(other - 1);
+			settings->Reload = factor - 1;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Fallback once the budget is spent: every prescaler from the first one that
+ * reaches the ratio, i.e. from the top of the reload range, with both reloads
+ * next to the ratio. A prescaler P gets within P / 2 clocks of the ratio.
+ */
+static void Timer_Nearest(uint32_t clock, uint32_t frequency, uint32_t max_reload, Timer_Settings *settings)
+{
+	uint64_t reloads = (uint64_t)max_reload + 1;
+	uint64_t first = ((uint64_t)(clock / frequency) + reloads - 1) / reloads;
+	uint64_t best_error = 0;
+	uint64_t best_division = 0;
+
+	for(uint64_t prescaler = first; (prescaler < first + TIMER_NEAREST_PRESCALERS) && (prescaler <= 65536); prescaler++)
+	{
+		// Past the ratio the reload would be 0, below it the step fits in 32 bits
+		if((uint64_t)frequency * prescaler > clock) break;
+
+		uint32_t step = frequency * (uint32_t)prescaler;
+		uint64_t reload = clock / step;
+
+		for(uint8_t i = 0; i < 2; i++, reload++)
+		{
+			if((reload == 0) || (reload > reloads) || (prescaler * reload < 2)) continue;
+
+			uint64_t division = prescaler * reload;
+			uint64_t target = (uint64_t)frequency * division;
+			uint64_t error = (target > clock) ? (target - clock) : (clock - target);
+
+			// |clock/division - f| compared cross multiplied, ties keep the smaller prescaler
+			if((best_division == 0) || (error * best_division < best_error * division))
+			{
+				best_error = error;
+				best_division = division;
+				settings->Prescaler = (uint16_t)(prescaler - 1);
+				settings->Reload = (uint32_t)(reload - 1);
+			}
+		}
+	}
+
+	settings->Division = best_division;
+}
+
+int8_t Timer_Solve(uint32_t clock, uint32_t frequency, uint32_t max_reload, Timer_Settings *settings)
+{
+	uint64_t largest = ((uint64_t)max_reload + 1) * 65536;
+	uint32_t budget = TIMER_FACTOR_BUDGET;
+
+	// A division of 1 leaves ARR at 0, which stops the counter
+	if((frequency == 0) || (frequency > clock / 2) || ((clock / frequency) > largest)) return -1;
+
+	uint64_t below = clock / frequency;
+	uint64_t above = below + 1;
+
+	// Walk away from the ratio on both sides, always taking the division with the smaller error
+	for(;;)
+	{
+		bool use_below;
+
+		if(budget == 0)
+		{
+			Timer_Nearest(clock, frequency, max_reload, settings);
+			break;
+		}
+
+		if(below < 2)
+		{
+			use_below = false;
+		}
+		else if(above > largest)
+		{
+			use_below = true;
+		}
+		else
+		{
+			// |clock/below - f| <= |clock/above - f|, cross multiplied
+			uint64_t error_below = (uint64_t)clock - (uint64_t)frequency * below;
+			uint64_t error_above = (uint64_t)frequency * above - clock;
+			use_below = (error_below * above) <= (error_above * below);
+		}
+
+		// Every division tried costs at least one trial, even when there is no factor range to search
+		budget--;
+
+		if(use_below)
+		{
+			if(Timer_Factor(below, max_reload, settings, &budget))
+			{
+				settings->Division = below;
+				break;
+			}
+			below--;
+		}
+		else
+		{
+			if(above > largest) return -1;
+
+			if(Timer_Factor(above, max_reload, settings, &budget))
+			{
+				settings->Division = above;
+				break;
+			}
+			above++;
+		}
+	}
+
+	settings->Compare = settings->Reload / 2;
+
+	return ((settings->Division * frequency) == clock) ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file Timer.h
+ * @brief Prescaler and reload values for a timer rate.
+ *
+ * A timer divides its clock by `(PSC + 1) * (ARR + 1)`. For a rate `f` the best
+ * division is one of the two whole numbers next to `clock / f`, so instead of
+ * trying every prescaler the solver looks at the divisions nearest to the ratio,
+ * best first, and takes the first one that factors into a 16-bit prescaler and a
+ * reload that fits the timer. Whenever the ratio itself factors the result is
+ * exact, e.g. 84 MHz / 2 kHz = 42000 with PSC 0 and ARR 41999.
+ *
+ * Only integer arithmetic is used and the module has no hardware dependency
+ * apart from @ref Timer_Clock, so @ref Timer_Solve also runs on a host.
+ *
+ * @code
+ * Timer_Settings settings;
+ *
+ * if(Timer_Solve(Timer_Clock(TIM2), 2000, TIMER_RELOAD_32_BIT, &settings) >= 0)
+ * {
+ *     TIM2->PSC = settings.Prescaler;
+ *     TIM2->ARR = settings.Reload;
+ *     TIM2->CCR2 = settings.Compare;
+ * }
+ * @endcode
+ *
+ * @version 1.0
+ * @date 2025-06-14
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef TIMER_TIMER_H_
+#define TIMER_TIMER_H_
+
+#include "main.h"
+
+#define TIMER_RELOAD_16_BIT		0xFFFFUL		/**< Largest ARR of TIM1, TIM3, TIM4 and TIM6 to TIM14 */
+#define TIMER_RELOAD_32_BIT		0xFFFFFFFFUL	/**< Largest ARR of TIM2 and TIM5 */
+
+#define TIMER_APB1_CLOCK		84000000UL		/**< Clock of the APB1 timers after @ref MCU_Clock_Setup */
+#define TIMER_APB2_CLOCK		168000000UL		/**< Clock of the APB2 timers after @ref MCU_Clock_Setup */
+
+#define TIMER_FACTOR_BUDGET		1024			/**< Trial divisions one @ref Timer_Solve may spend on factoring */
+
+/**
+ * @brief Division of `clock` nearest to the rate `frequency`.
+ */
+#define TIMER_DIVISION(clock, frequency)	(((clock) + (frequency) / 2) / (frequency))
+
+/**
+ * @brief Smallest prescaler for a constant rate on a 16-bit timer.
+ *
+ * Together with @ref TIMER_RELOAD this is usable in constant expressions. The
+ * result is exact whenever the division is a multiple of `PSC + 1`, which holds
+ * for every division up to 65536, otherwise @ref Timer_Solve may do better.
+ */
+#define TIMER_PRESCALER(clock, frequency)	((TIMER_DIVISION(clock, frequency) - 1) / 65536)
+
+/**
+ * @brief Reload value that goes with @ref TIMER_PRESCALER.
+ */
+#define TIMER_RELOAD(clock, frequency)	\
+	((TIMER_DIVISION(clock, frequency) + (TIMER_PRESCALER(clock, frequency) + 1) / 2) / (TIMER_PRESCALER(clock, frequency) + 1) - 1)
+
+/** @struct Timer_Settings
+ *  @brief  Register values for one timer rate.
+ */
+typedef struct Timer_Settings{
+	uint16_t Prescaler;		/**< PSC */
+	uint32_t Reload;		/**< ARR */
+	uint32_t Compare;		/**< CCR for a compare match half way through the period */
+	uint64_t Division;		/**< Timer clocks per period, `(PSC + 1) * (ARR + 1)` */
+}Timer_Settings;
+
+/**
+ * @brief Clock of a timer.
+ *
+ * Timers run at twice their APB bus clock whenever the bus is divided.
+ *
+ * @param[in] timer Timer instance.
+ *
+ * @return uint32_t Timer clock in Hz.
+ */
+uint32_t Timer_Clock(TIM_TypeDef *timer);
+
+/**
+ * @brief Largest reload value of a timer.
+ *
+ * @param[in] timer Timer instance.
+ *
+ * @return uint32_t @ref TIMER_RELOAD_32_BIT for TIM2 and TIM5, @ref TIMER_RELOAD_16_BIT otherwise.
+ */
+uint32_t Timer_Max_Reload(TIM_TypeDef *timer);
+
+/**
+ * @brief Finds the prescaler and reload closest to a rate.
+ *
+ * The result has the smallest frequency error of all prescaler and reload pairs
+ * and, among those, the smallest prescaler. Factoring is capped at
+ * @ref TIMER_FACTOR_BUDGET trial divisions, which only large, nearly prime
+ * ratios on a 16-bit timer use up. The solver then takes the nearest of the
+ * first prescalers that reach the ratio, a relative error of at most about
+ * 1 / 131072 for a 16-bit reload.
+ *
+ * @param[in] clock Timer clock in Hz, e.g. from @ref Timer_Clock.
+ * @param[in] frequency Rate in Hz.
+ * @param[in] max_reload Largest ARR of the timer, @ref TIMER_RELOAD_16_BIT or @ref TIMER_RELOAD_32_BIT.
+ * @param[out] settings Register values.
+ *
+ * @return int8_t Returns 1 for an exact rate, 0 for the nearest rate, or -1 if the rate is out of range.
+ */
+int8_t Timer_Solve(uint32_t clock, uint32_t frequency, uint32_t max_reload, Timer_Settings *settings);
+
+#endif /* TIMER_TIMER_H_ */
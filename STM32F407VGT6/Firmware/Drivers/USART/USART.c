@@ -8,6 +8,7 @@
 
 #include "main.h"
 #include "USART.h"
+#include "Profiler/Profiler.h"
 
 // volatile  DMA_Flags_Typedef USART1_RX_DMA_Flag;
 // volatile  DMA_Flags_Typedef USART1_TX_DMA_Flag;
@@ -42,70 +43,208 @@ USART_Config *__usart_6_config__;
 
 volatile uint16_t USART_SR = 0;
 
-volatile bool U1TX_Complete = 0;
+typedef struct USART_TX_Descriptor
+{
+	const uint8_t *Buffer;
+	uint16_t Length;
+	USART_TX_Callback Callback;
+	void *Context;
+}USART_TX_Descriptor;
+
+/*
+ * Single producer / single consumer ring per USART. Head is only written by the
+ * submitting context, Tail only by the DMA transfer complete interrupt.
+ *
+ * Next to the ring there is one urgent slot, which the DMA takes before the ring
+ * as soon as the transfer in flight ends.
+ */
+typedef struct USART_TX_Queue
+{
+	USART_TX_Descriptor Descriptor[USART_TX_QUEUE_LENGTH];
+	volatile uint8_t Head;
+	volatile uint8_t Tail;
+	volatile bool Busy;
+	USART_TX_Descriptor Urgent;
+	volatile bool Urgent_Pending;	// Urgent holds a buffer not yet started
+	volatile bool Urgent_Sending;	// The transfer in flight is the urgent one
+	uint32_t Dropped;
+	uint32_t Start_Cycles;	// Start of the transfer in flight
+	USART_Config *Config;
+}USART_TX_Queue;
+
+static USART_TX_Queue usart_tx_queue[6];
+
+/* DMA time of one queued buffer, all instances */
+static PROFILER_PROBE(usart_tx_probe, "usart_tx");
+static USART_RX_Ring *usart_rx_ring[6];
+static const IRQn_Type usart_irq[6] = {USART1_IRQn, USART2_IRQn, USART3_IRQn, UART4_IRQn, UART5_IRQn, USART6_IRQn};
+
+/*
+ * Publishes the DMA write position of a receive ring. Runs in the RX DMA half /
+ * full transfer interrupts and on idle line, which together fire at least twice
+ * per lap so the position can never advance by a full ring unseen.
+ */
+static void USART_RX_Update(int8_t instance, bool idle_line)
+{
+	USART_RX_Ring *ring = usart_rx_ring[instance];
+	if(ring == NULL) return;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint16_t position = ring->Size - xUSART_RX[instance].Request.Stream->NDTR;
+	if(position >= ring->Size) position = 0;
+
+	uint16_t advance = (position + ring->Size - ring->Last_Position) % ring->Size;
+	ring->Last_Position = position;
+	ring->Received += advance;
+
+	if(idle_line)
+	{
+		uint8_t head = ring->Frame_Head;
+		uint8_t previous = (head - 1) & (USART_RX_FRAME_QUEUE_LENGTH - 1);
+
+		// Only mark a boundary when bytes came in since the last one
+		if((head == ring->Frame_Tail) ? (ring->Received != ring->Consumed) : (ring->Frame_End[previous] != ring->Received))
+		{
+			uint8_t next = (head + 1) & (USART_RX_FRAME_QUEUE_LENGTH - 1);
+
+			if(next != ring->Frame_Tail)
+			{
+				ring->Frame_End[head] = ring->Received;
+				ring->Frame_Head = next;
+			}
+			else
+			{
+				ring->Frames_Merged++;
+			}
+		}
+	}
+
+	__set_PRIMASK(primask);
+
+	if(idle_line && ring->Frame_Received_ISR) ring->Frame_Received_ISR();
+}
+
+static void USART_TX_Start(int8_t instance)
+{
+	USART_TX_Queue *queue = &usart_tx_queue[instance];
+	USART_TX_Descriptor *descriptor = &queue->Descriptor[queue->Tail];
+
+	if(queue->Urgent_Pending)
+	{
+		descriptor = &queue->Urgent;
+		queue->Urgent_Pending = 0;
+		queue->Urgent_Sending = 1;
+	}
+
+	queue->Busy = 1;
+	queue->Start_Cycles = Profiler_Start();
+	queue->Config->Port->SR &= ~USART_SR_TC;
+	xUSART_TX[instance].memory_address = (uint32_t)descriptor->Buffer;
+	xUSART_TX[instance].peripheral_address = (uint32_t)&queue->Config->Port->DR;
+	xUSART_TX[instance].buffer_length = descriptor->Length;
+	DMA_Set_Target(&xUSART_TX[instance]);
+	DMA_Set_Trigger(&xUSART_TX[instance]);
+	queue->Config->Port->CR3 |= USART_CR3_DMAT;
+}
+
+/* Runs in the TX DMA transfer complete interrupt */
+static void USART_TX_Complete(int8_t instance)
+{
+	USART_TX_Queue *queue = &usart_tx_queue[instance];
+	USART_TX_Descriptor *descriptor = queue->Urgent_Sending ? &queue->Urgent : &queue->Descriptor[queue->Tail];
+	USART_TX_Callback callback = descriptor->Callback;
+	void *context = descriptor->Context;
+
+	Profiler_End(&usart_tx_probe, queue->Start_Cycles);
+
+	if(queue->Urgent_Sending)
+	{
+		queue->Urgent_Sending = 0;
+	}
+	else
+	{
+		queue->Tail = (queue->Tail + 1) & (USART_TX_QUEUE_LENGTH - 1);
+	}
+
+	// Keep the line busy first, then let the owner of the finished buffer know
+	if(queue->Urgent_Pending || (queue->Tail != queue->Head))
+	{
+		USART_TX_Start(instance);
+	}
+	else
+	{
+		queue->Busy = 0;
+	}
+
+	if(callback) callback(context);
+}
+
 volatile bool U1RX_Complete = 0;
 
-volatile bool U2TX_Complete = 0;
 volatile bool U2RX_Complete = 0;
 
-volatile bool U3TX_Complete = 0;
 volatile bool U3RX_Complete = 0;
 
-volatile bool U4TX_Complete = 0;
 volatile bool U4RX_Complete = 0;
 
-volatile bool U5TX_Complete = 0;
 volatile bool U5RX_Complete = 0;
 
-volatile bool U6TX_Complete = 0;
 volatile bool U6RX_Complete = 0;
 
 void USART1_TX_ISR() {
-	U1TX_Complete = 1;
+	USART_TX_Complete(0);
 }
 
 void USART1_RX_ISR() {
 	U1RX_Complete = 1;
+	USART_RX_Update(0, 0);
 }
 
 void USART2_TX_ISR() {
-	U2TX_Complete = 1;
+	USART_TX_Complete(1);
 }
 
 void USART2_RX_ISR() {
 	U2RX_Complete = 1;
+	USART_RX_Update(1, 0);
 }
 
 void USART3_TX_ISR() {
-	U3TX_Complete = 1;
+	USART_TX_Complete(2);
 }
 
 void USART3_RX_ISR() {
 	U3RX_Complete = 1;
+	USART_RX_Update(2, 0);
 }
 
 void USART4_TX_ISR() {
-	U4TX_Complete = 1;
+	USART_TX_Complete(3);
 }
 
 void USART4_RX_ISR() {
 	U4RX_Complete = 1;
+	USART_RX_Update(3, 0);
 }
 
 void USART5_TX_ISR() {
-	U5TX_Complete = 1;
+	USART_TX_Complete(4);
 }
 
 void USART5_RX_ISR() {
 	U5RX_Complete = 1;
+	USART_RX_Update(4, 0);
 }
 
 void USART6_TX_ISR() {
-	U6TX_Complete = 1;
+	USART_TX_Complete(5);
 }
 
 void USART6_RX_ISR() {
 	U6RX_Complete = 1;
+	USART_RX_Update(5, 0);
 }
 
 
@@ -158,6 +297,10 @@ void UART4_IRQHandler(void)
 
 	if(USART_SR & USART_SR_IDLE)
 	{
+		if (usart_rx_ring[3]) {
+			(void)UART4->DR;  // SR then DR read clears the idle flag
+			USART_RX_Update(3, 1);
+		}
 		if (__usart_4_config__ ->ISR_Routines.Idle_Line_ISR) {
 			__usart_4_config__ ->ISR_Routines.Idle_Line_ISR();
 			UART4->SR &= ~USART_SR_IDLE;  // Clear the Break interrupt flag
@@ -222,6 +365,10 @@ void USART1_IRQHandler(void)
 
 	if(USART_SR & USART_SR_IDLE)
 	{
+		if (usart_rx_ring[0]) {
+			(void)USART1->DR;  // SR then DR read clears the idle flag
+			USART_RX_Update(0, 1);
+		}
 		if (__usart_1_config__ ->ISR_Routines.Idle_Line_ISR) {
 			__usart_1_config__ ->ISR_Routines.Idle_Line_ISR();
 			USART1->SR &= ~USART_SR_IDLE;  // Clear the Break interrupt flag
@@ -258,6 +405,7 @@ void USART_Config_Reset(USART_Config *config)
 	config->baudrate = 9600;
 	config->dma_enable = USART_Configuration.DMA_Enable.RX_Disable | USART_Configuration.DMA_Enable.TX_Disable;
 	config->interrupt = USART_Configuration.Interrupt_Type.Disable;
+	config->tx_policy = USART_Configuration.TX_Policy.Block;
 }
 
 
@@ -764,6 +912,14 @@ int8_t USART_Init(USART_Config *config)
 		xUSART_TX[usart_dma_instance_number].transfer_direction = DMA_Configuration.Transfer_Direction.Memory_to_peripheral;
 		config ->USART_DMA_Instance_TX = xUSART_TX[usart_dma_instance_number];
 		DMA_Init(&xUSART_TX[usart_dma_instance_number]);
+
+		usart_tx_queue[usart_dma_instance_number].Head = 0;
+		usart_tx_queue[usart_dma_instance_number].Tail = 0;
+		usart_tx_queue[usart_dma_instance_number].Busy = 0;
+		usart_tx_queue[usart_dma_instance_number].Urgent_Pending = 0;
+		usart_tx_queue[usart_dma_instance_number].Urgent_Sending = 0;
+		usart_tx_queue[usart_dma_instance_number].Dropped = 0;
+		usart_tx_queue[usart_dma_instance_number].Config = config;
 	}
 	else
 	{
@@ -782,49 +938,9 @@ int8_t USART_Init(USART_Config *config)
 
 int8_t USART_TX_Buffer(USART_Config *config, uint8_t *tx_buffer, uint16_t length)
 {
-	usart_dma_instance_number = USART_Get_Instance_Number(config);
-	if(config->dma_enable |= USART_Configuration.DMA_Enable.TX_Enable){
-		config -> Port -> SR &= ~USART_SR_TC;
-		xUSART_TX[usart_dma_instance_number].memory_address = (uint32_t)tx_buffer;
-		xUSART_TX[usart_dma_instance_number].peripheral_address = (uint32_t)&config->Port->DR;
-		xUSART_TX[usart_dma_instance_number].buffer_length = length;
-		DMA_Set_Target(&xUSART_TX[usart_dma_instance_number]);
-		DMA_Set_Trigger(&xUSART_TX[usart_dma_instance_number]);
-		config -> Port  -> CR3 |= USART_CR3_DMAT;
-
-		if(config->Port == USART1)
-		{
-			while(!U1TX_Complete){}
-			U1TX_Complete = 0;
-
-		}
-		else if(config->Port == USART2)
-		{
-			while(!U2TX_Complete){}
-			U2TX_Complete = 0;
-		}
-		else if(config->Port == USART3)
-		{
-			while(!U3TX_Complete){}
-			U3TX_Complete = 0;
-		}
-		else if(config->Port == UART4)
-		{
-			while(!U4TX_Complete){}
-			U4TX_Complete = 0;
-		}
-		else if(config->Port == UART5)
-		{
-			while(!U5TX_Complete){}
-			U5TX_Complete = 0;
-		}
-		else if(config->Port == USART6)
-		{
-			while(!U6TX_Complete){}
-			U6TX_Complete = 0;
-		}
-
-
+	if((config->dma_enable & USART_Configuration.DMA_Enable.TX_Enable) == USART_Configuration.DMA_Enable.TX_Enable){
+		if(USART_TX_Buffer_Async(config, tx_buffer, length, NULL, NULL) != 1) return -1;
+		USART_TX_Flush(config);
 	}
 	else
 	{ //Will Take more time
@@ -839,6 +955,110 @@ int8_t USART_TX_Buffer(USART_Config *config, uint8_t *tx_buffer, uint16_t length
 
 }
 
+int8_t USART_TX_Buffer_Async(USART_Config *config, const uint8_t *tx_buffer, uint16_t length, USART_TX_Callback callback, void *context)
+{
+	int8_t instance = USART_Get_Instance_Number(config);
+
+	if(instance == -1) return -1;
+	if((config->dma_enable & USART_Configuration.DMA_Enable.TX_Enable) != USART_Configuration.DMA_Enable.TX_Enable) return -1;
+	if(length == 0) return -1;
+
+	USART_TX_Queue *queue = &usart_tx_queue[instance];
+	uint8_t head = queue->Head;
+	uint8_t next = (head + 1) & (USART_TX_QUEUE_LENGTH - 1);
+
+	while(next == queue->Tail)
+	{
+		if(config->tx_policy == USART_Configuration.TX_Policy.Drop)
+		{
+			queue->Dropped++;
+			return 0;
+		}
+	}
+
+	queue->Descriptor[head].Buffer = tx_buffer;
+	queue->Descriptor[head].Length = length;
+	queue->Descriptor[head].Callback = callback;
+	queue->Descriptor[head].Context = context;
+
+	// Descriptor has to be visible before the interrupt can see the new head
+	__DMB();
+	queue->Head = next;
+
+	// Not busy means no transfer in flight, so the completion interrupt cannot race this
+	if(!queue->Busy)
+	{
+		USART_TX_Start(instance);
+	}
+
+	return 1;
+}
+
+int8_t USART_TX_Buffer_Urgent(USART_Config *config, const uint8_t *tx_buffer, uint16_t length, USART_TX_Callback callback, void *context)
+{
+	int8_t instance = USART_Get_Instance_Number(config);
+
+	if(instance == -1) return -1;
+	if((config->dma_enable & USART_Configuration.DMA_Enable.TX_Enable) != USART_Configuration.DMA_Enable.TX_Enable) return -1;
+	if(length == 0) return -1;
+
+	USART_TX_Queue *queue = &usart_tx_queue[instance];
+
+	// The slot is free again once its transfer has completed
+	if(queue->Urgent_Pending || queue->Urgent_Sending)
+	{
+		queue->Dropped++;
+		return 0;
+	}
+
+	queue->Urgent.Buffer = tx_buffer;
+	queue->Urgent.Length = length;
+	queue->Urgent.Callback = callback;
+	queue->Urgent.Context = context;
+
+	// May come from another context than the ring, so publish and start with interrupts masked
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	queue->Urgent_Pending = 1;
+	if(!queue->Busy)
+	{
+		USART_TX_Start(instance);
+	}
+
+	__set_PRIMASK(primask);
+
+	return 1;
+}
+
+int8_t USART_TX_Flush(USART_Config *config)
+{
+	int8_t instance = USART_Get_Instance_Number(config);
+
+	if(instance == -1) return -1;
+
+	while(usart_tx_queue[instance].Busy){}
+	return 1;
+}
+
+uint8_t USART_TX_Pending(USART_Config *config)
+{
+	int8_t instance = USART_Get_Instance_Number(config);
+
+	if(instance == -1) return 0;
+
+	return (usart_tx_queue[instance].Head - usart_tx_queue[instance].Tail) & (USART_TX_QUEUE_LENGTH - 1);
+}
+
+uint32_t USART_TX_Dropped(USART_Config *config)
+{
+	int8_t instance = USART_Get_Instance_Number(config);
+
+	if(instance == -1) return 0;
+
+	return usart_tx_queue[instance].Dropped;
+}
+
 int8_t USART_RX_Buffer(USART_Config *config, uint8_t *rx_buffer, uint16_t length, bool circular_buffer_enable)
 {
 	if(config->dma_enable |= USART_Configuration.DMA_Enable.RX_Enable)
@@ -908,6 +1128,149 @@ int8_t USART_RX_Buffer(USART_Config *config, uint8_t *rx_buffer, uint16_t length
 
 }
 
+int8_t USART_RX_Ring_Start(USART_Config *config, USART_RX_Ring *ring, volatile uint8_t *buffer, uint16_t size)
+{
+	int8_t instance = USART_Get_Instance_Number(config);
+
+	if(instance == -1) return -1;
+	// The idle line interrupt is only served by USART1_IRQHandler and UART4_IRQHandler
+	if((config->Port != USART1) && (config->Port != UART4)) return -1;
+	if((config->dma_enable & USART_Configuration.DMA_Enable.RX_Enable) != USART_Configuration.DMA_Enable.RX_Enable) return -1;
+	if(size < 2) return -1;
+
+	config->Port->CR3 &= ~USART_CR3_DMAR;
+	usart_rx_ring[instance] = NULL;
+
+	ring->Buffer = buffer;
+	ring->Size = size;
+	ring->Last_Position = 0;
+	ring->Received = 0;
+	ring->Frame_Head = 0;
+	ring->Frame_Tail = 0;
+	ring->Consumed = 0;
+	ring->Overflows = 0;
+	ring->Frames_Merged = 0;
+
+	xUSART_RX[instance].circular_mode = DMA_Configuration.Circular_Mode.Enable;
+	xUSART_RX[instance].interrupts = DMA_Configuration.DMA_Interrupts.Transfer_Complete | DMA_Configuration.DMA_Interrupts.Half_Transfer_Complete;
+	xUSART_RX[instance].ISR_Routines.Half_Transfer_Complete_ISR = xUSART_RX[instance].ISR_Routines.Full_Transfer_Commplete_ISR;
+	DMA_Init(&xUSART_RX[instance]);
+
+	xUSART_RX[instance].memory_address = (uint32_t)buffer;
+	xUSART_RX[instance].peripheral_address = (uint32_t)&config->Port->DR;
+	xUSART_RX[instance].buffer_length = size;
+
+	usart_rx_ring[instance] = ring;
+
+	USART_Clear_Status_Regs(config);
+	DMA_Set_Target(&xUSART_RX[instance]);
+	DMA_Set_Trigger(&xUSART_RX[instance]);
+	config->Port->CR3 |= USART_CR3_DMAR;
+
+	config->Port->CR1 |= USART_CR1_IDLEIE;
+	NVIC_EnableIRQ(usart_irq[instance]);
+
+	return 1;
+}
+
+/* Bytes received and not consumed yet, drops them all if the DMA lapped the reader */
+static uint32_t USART_RX_Pending(USART_RX_Ring *ring)
+{
+	uint32_t received = ring->Received;
+	uint32_t pending = received - ring->Consumed;
+
+	if(pending > ring->Size)
+	{
+		ring->Overflows++;
+		ring->Consumed = received;
+		ring->Frame_Tail = ring->Frame_Head;
+		pending = 0;
+	}
+
+	return pending;
+}
+
+static void USART_RX_View(USART_RX_Ring *ring, uint16_t length, USART_RX_Frame *view)
+{
+	uint16_t read = ring->Consumed % ring->Size;
+	uint16_t first = ring->Size - read;
+
+	if(first > length) first = length;
+
+	view->Data[0] = &ring->Buffer[read];
+	view->Length[0] = first;
+	view->Data[1] = (length > first) ? &ring->Buffer[0] : NULL;
+	view->Length[1] = length - first;
+	view->Total = length;
+}
+
+uint16_t USART_RX_Available(USART_RX_Ring *ring)
+{
+	return (uint16_t)USART_RX_Pending(ring);
+}
+
+uint16_t USART_RX_Peek(USART_RX_Ring *ring, USART_RX_Frame *view)
+{
+	uint16_t length = (uint16_t)USART_RX_Pending(ring);
+
+	USART_RX_View(ring, length, view);
+	return length;
+}
+
+void USART_RX_Consume(USART_RX_Ring *ring, uint16_t length)
+{
+	uint16_t pending = (uint16_t)USART_RX_Pending(ring);
+
+	if(length > pending) length = pending;
+	ring->Consumed += length;
+}
+
+int8_t USART_RX_Get_Frame(USART_RX_Ring *ring, USART_RX_Frame *frame)
+{
+	USART_RX_Pending(ring);
+
+	while(ring->Frame_Tail != ring->Frame_Head)
+	{
+		uint32_t end = ring->Frame_End[ring->Frame_Tail];
+
+		// Boundaries of bytes that were already consumed byte wise are stale
+		if((int32_t)(end - ring->Consumed) > 0)
+		{
+			USART_RX_View(ring, (uint16_t)(end - ring->Consumed), frame);
+			return 1;
+		}
+
+		ring->Frame_Tail = (ring->Frame_Tail + 1) & (USART_RX_FRAME_QUEUE_LENGTH - 1);
+	}
+
+	return 0;
+}
+
+void USART_RX_Release_Frame(USART_RX_Ring *ring, const USART_RX_Frame *frame)
+{
+	ring->Consumed += frame->Total;
+
+	if(ring->Frame_Tail != ring->Frame_Head)
+	{
+		ring->Frame_Tail = (ring->Frame_Tail + 1) & (USART_RX_FRAME_QUEUE_LENGTH - 1);
+	}
+}
+
+uint16_t USART_RX_Frame_Copy(const USART_RX_Frame *frame, uint8_t *destination, uint16_t max_length)
+{
+	uint16_t copied = 0;
+
+	for(uint8_t piece = 0; piece < 2; piece++)
+	{
+		for(uint16_t i = 0; (i < frame->Length[piece]) && (copied < max_length); i++)
+		{
+			destination[copied++] = frame->Data[piece][i];
+		}
+	}
+
+	return copied;
+}
+
 void USART_TX_Single_Byte(USART_Config *config, uint8_t data)
 {
 	config->Port->DR = data;
@@ -15,6 +15,59 @@
 #include "DMA/DMA.h"
 
 
+/*
+ * Number of buffers that can be queued for transmission per USART, power of two.
+ * One slot is kept free to tell a full queue from an empty one.
+ */
+#define USART_TX_QUEUE_LENGTH	8
+
+/*
+ * Called from the DMA transfer complete interrupt once a queued buffer has been
+ * sent, the buffer may be reused from then on.
+ */
+typedef void (*USART_TX_Callback)(void *context);
+
+/*
+ * Idle line frame boundaries remembered by a receive ring, power of two.
+ */
+#define USART_RX_FRAME_QUEUE_LENGTH	8
+
+/*
+ * Continuously running circular DMA receive ring.
+ *
+ * The DMA half transfer, transfer complete and USART idle line interrupts publish
+ * the number of bytes received so far. The reader works on the bytes in place and
+ * hands them back with USART_RX_Consume / USART_RX_Release_Frame, it has to do so
+ * before Size more bytes arrive or they are overwritten (counted in Overflows).
+ *
+ * Only USART1 and UART4 have an interrupt handler that serves the idle line,
+ * USART_RX_Ring_Start returns -1 for the other instances.
+ */
+typedef struct USART_RX_Ring
+{
+	volatile uint8_t *Buffer;
+	uint16_t Size;
+	uint16_t Last_Position;									// Interrupt side
+	volatile uint32_t Received;								// Interrupt side, bytes received since start
+	volatile uint32_t Frame_End[USART_RX_FRAME_QUEUE_LENGTH];	// Interrupt side, Received at each idle line
+	volatile uint8_t Frame_Head;							// Interrupt side
+	volatile uint8_t Frame_Tail;							// Reader side
+	uint32_t Consumed;										// Reader side, bytes handed back since start
+	uint32_t Overflows;										// Reader side, times the DMA lapped the reader
+	uint32_t Frames_Merged;									// Interrupt side, boundaries lost to a full queue
+	void (*Frame_Received_ISR)(void);						// Optional, called on every idle line
+}USART_RX_Ring;
+
+/*
+ * View of received bytes inside the ring. Data that wraps around the end of the
+ * ring comes in two pieces, Data[1] is NULL otherwise.
+ */
+typedef struct USART_RX_Frame
+{
+	const volatile uint8_t *Data[2];
+	uint16_t Length[2];
+	uint16_t Total;
+}USART_RX_Frame;
 
 typedef struct USART_Config
 {
@@ -31,6 +84,7 @@ typedef struct USART_Config
 	uint8_t stop_bits;
 	uint8_t dma_enable;
 	uint8_t parity;
+	uint8_t tx_policy;
 	DMA_Config USART_DMA_Instance_TX;
 	DMA_Config USART_DMA_Instance_RX;
 
@@ -56,7 +110,43 @@ int8_t USART_Init(USART_Config *config);
 void USART_TX_Single_Byte(USART_Config *config, uint8_t data);
 uint16_t USART_RX_Byte(USART_Config *config);
 int8_t USART_TX_Buffer(USART_Config *config, uint8_t *tx_buffer, uint16_t length);
+
+/*
+ * Queues a buffer for DMA transmission and returns immediately. Queued buffers are
+ * chained from the DMA transfer complete interrupt. The buffer has to stay valid
+ * until the callback runs. When the queue is full the tx_policy decides between
+ * waiting for a slot and dropping the buffer.
+ *
+ * The queue is single producer: per USART, submit either from thread context or
+ * from one interrupt, not both.
+ *
+ * Returns 1 if queued, 0 if dropped, -1 if TX DMA is not enabled or length is 0.
+ */
+int8_t USART_TX_Buffer_Async(USART_Config *config, const uint8_t *tx_buffer, uint16_t length, USART_TX_Callback callback, void *context);
+
+/*
+ * Sends a buffer ahead of everything queued. There is a single urgent slot per
+ * USART, the DMA takes it as soon as the transfer in flight has completed, so the
+ * wait is at most one queued buffer. A transfer that already runs is never cut.
+ *
+ * Unlike the queue the slot may be filled from thread or interrupt context.
+ *
+ * Returns 1 if started or pending, 0 if the slot is still taken, -1 if TX DMA is
+ * not enabled or length is 0.
+ */
+int8_t USART_TX_Buffer_Urgent(USART_Config *config, const uint8_t *tx_buffer, uint16_t length, USART_TX_Callback callback, void *context);
+int8_t USART_TX_Flush(USART_Config *config);
+uint8_t USART_TX_Pending(USART_Config *config);
+uint32_t USART_TX_Dropped(USART_Config *config);
 int8_t USART_RX_Buffer(USART_Config *config, uint8_t *rx_buffer, uint16_t length, bool circular_buffer_enable);
+
+int8_t USART_RX_Ring_Start(USART_Config *config, USART_RX_Ring *ring, volatile uint8_t *buffer, uint16_t size);
+uint16_t USART_RX_Available(USART_RX_Ring *ring);
+uint16_t USART_RX_Peek(USART_RX_Ring *ring, USART_RX_Frame *view);
+void USART_RX_Consume(USART_RX_Ring *ring, uint16_t length);
+int8_t USART_RX_Get_Frame(USART_RX_Ring *ring, USART_RX_Frame *frame);
+void USART_RX_Release_Frame(USART_RX_Ring *ring, const USART_RX_Frame *frame);
+uint16_t USART_RX_Frame_Copy(const USART_RX_Frame *frame, uint8_t *destination, uint16_t max_length);
 void USART_Clear_Status_Regs(USART_Config *config);
 
 
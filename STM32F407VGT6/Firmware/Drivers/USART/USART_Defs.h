@@ -67,6 +67,11 @@ typedef struct{
 	uint16_t Odd;
 }_USART_Parity_Type;
 
+typedef struct{
+	uint8_t Block;
+	uint8_t Drop;
+}_USART_TX_Policy_Type;
+
 
 
 static const struct USART_Configuration{
@@ -78,6 +83,7 @@ static const struct USART_Configuration{
 	_USART_Hardware_Flow_Type Hardware_Flow;
 	_USART_Stop_Bits          Stop_Bits;
 	_USART_Parity_Type        Parity_Type;
+	_USART_TX_Policy_Type     TX_Policy;
 
 }USART_Configuration =
 {
@@ -142,6 +148,12 @@ static const struct USART_Configuration{
 			.Odd = 0,
 		},
 
+		.TX_Policy =
+		{
+			.Block = 0,		// Wait for a free slot in the TX queue
+			.Drop = 1,		// Reject the buffer when the TX queue is full
+		},
+
 
 
 };
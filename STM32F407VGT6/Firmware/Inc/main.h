@@ -85,7 +85,6 @@ __STATIC_INLINE void MCU_Clock_Setup(void)
 	RCC -> CFGR |= RCC_CFGR_SW_PLL;
 	while((RCC -> CFGR & RCC_CFGR_SWS_PLL) != RCC_CFGR_SWS_PLL);
 	SystemCoreClockUpdate();
-	SysTick_Config(SystemCoreClock/168);
 	RCC -> APB2ENR |= RCC_APB2ENR_SYSCFGEN;
 }
 
@@ -135,13 +134,14 @@ __STATIC_INLINE int I2S_Clock_Init()
 
 
 
+/*
+ * Delays busy wait on the DWT cycle counter. SysTick is not touched, so delays
+ * can be used freely next to the Timebase driver and from any context.
+ */
 __STATIC_INLINE uint32_t Delay_Config(void)
 {
-
-	SysTick->CTRL = 0;
-	SysTick->LOAD = 0x00FFFFFF;
-	SysTick->VAL = 0;
-	SysTick->CTRL = 5;
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 	return (0UL);                                                     /* Function successful */
 }
 
@@ -149,20 +149,19 @@ __STATIC_INLINE uint32_t Delay_Config(void)
 
 __STATIC_INLINE uint32_t Delay_us(volatile uint32_t us)
 {
+	uint32_t start = DWT->CYCCNT;
+	uint32_t cycles = us * (SystemCoreClock / 1000000UL);
 
-	SysTick->LOAD = 168 * us;
-	SysTick->VAL = 0;
-	while((SysTick->CTRL & 0x00010000) == 0);
+	while((DWT->CYCCNT - start) < cycles){}
 	return (0UL);                                                     /* Function successful */
 }
 
 __STATIC_INLINE uint32_t Delay_ms(volatile uint32_t ms)
 {
-	unsigned long x =0x29040 * (ms);
-	SysTick->LOAD =  x ;
-	SysTick->VAL = 0;
-	SysTick->CTRL |= 1;
-	while((SysTick->CTRL & 0x00010000) == 0);
+	for (; ms>0; ms--)
+	{
+		Delay_us(1000);
+	}
 	return (0UL);                                                     /* Function successful */
 }
 
@@ -188,23 +187,24 @@ __STATIC_INLINE uint32_t Delay_s(unsigned long s)
 }
 
 
+/*
+ * Time stamps run on the DWT cycle counter like Delay_us and Delay_ms, SysTick is
+ * not used. The start is kept per source file, use the Profiler driver for anything finer.
+ */
+static uint32_t Time_Stamp_Origin __attribute__((unused));
+
 __STATIC_INLINE float Time_Stamp_Start(void)
 {
-	float temp = 0;
-	SysTick->CTRL = 0;
-	SysTick->LOAD = 0xFFFFFFFF;
-	SysTick->VAL = 0;
-	SysTick->CTRL = 0x5;
-	while(SysTick->VAL != 0);
-	temp = (float)(SysTick->VAL / (SystemCoreClock));
-	return temp;
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	Time_Stamp_Origin = DWT->CYCCNT;
+	return 0.0f;
 }
 
+/* Seconds since the last Time_Stamp_Start, wraps after 2^32 cycles */
 __STATIC_INLINE float Time_Stamp_End(void)
 {
-	float temp = 0;
-	temp = (float)(SysTick->VAL / (SystemCoreClock));
-	return temp;
+	return (float)(DWT->CYCCNT - Time_Stamp_Origin) / (float)SystemCoreClock;
 }
 
 __STATIC_INLINE	void separateFractionAndIntegral(double number, double *fractionalPart, double *integralPart) {
@@ -233,9 +233,10 @@ __STATIC_INLINE void Log_Print(char *msg, ...)
 
 	va_list args;
 	va_start(args, msg);
-	vsprintf(buff, msg, args);
+	vsnprintf(buff, sizeof(buff), msg, args);
+	va_end(args);
 
-	for(int i = 0; i<= strlen(buff)-1; i++)
+	for(int i = 0; buff[i] != '\0'; i++)
 	{
 		ITM_SendChar(buff[i]);
 	}
@@ -17,61 +17,356 @@
  */
 
 #define DEBUG_PRINTF 1
+#define THERMISTOR_FIXED_POINT 1	// 1: Q16.16 integer pipeline, 0: float pipeline
+#define TELEMETRY_BINARY 1			// 1: binary telemetry frames, 0: CSV text lines
 
 #include <stdint.h>
 #include "main.h"
 #include "ADC/ADC.h"
 #include "GPIO/GPIO.h"
 #include "Console/Console.h"
+#include "Decimation/Decimation.h"
+#include "Thermistor/Thermistor.h"
+#include "Telemetry/Telemetry.h"
+#include "Profiler/Profiler.h"
+#include "Command/Command.h"
+#include "Timebase/Timebase.h"
+#include "Scheduler/Scheduler.h"
+#include "Statistics/Statistics.h"
+#include "Alarm/Alarm.h"
+#include "Deadband/Deadband.h"
+#include "Custom_RS485_Comm/Custom_RS485_Comm.h"
+
+
+#define NUM_CHANNELS       5
+#define SAMPLING_FREQUENCY 2000    // Scans per second
+#define FAST_CHANNELS      2       // 'profile fast' samples the first two channels only
+#define FAST_FREQUENCY     8000
+#define SCANS_PER_BLOCK    100     // One block every 50 ms
+#define DECIMATION_RATIO   200     // 2 kHz / 200 = 10 Hz output, ~14 effective bits
+#define OUTPUTS_PER_BLOCK  ((SCANS_PER_BLOCK * NUM_CHANNELS / FAST_CHANNELS) / DECIMATION_RATIO + 1)	// Fewer channels fit more scans
+#define SCANS_PER_FRAME    5       // Decimated scans per telemetry frame
+#define BLOCK_PERIOD_US    ((1000000UL * SCANS_PER_BLOCK) / SAMPLING_FREQUENCY)
+#define EMA_FAST_MS        1000    // Time constants of the moving averages
+#define EMA_SLOW_MS        60000
+#define ALARM_HIGH_CENTI   8000    // 80 °C
+#define ALARM_LOW_CENTI    -1000   // -10 °C, also catches an open sensor
+#define ALARM_HYSTERESIS_CENTI 200
+#define ALARM_RISE_CENTI_PER_S 500 // 5 °C/s
+#define ALARM_WATCHDOG_CHANNEL 0   // Watched by the ADC on every conversion
+#define ALARM_PERIOD_US    10000   // Retry of alarm frames the link did not take yet
+#define ALARM_DEADLINE_US  1000
+#define REPORT_DEADBAND_CENTI 5    // 'report changes' sends moves of 0.05 °C and more
+#define REPORT_SILENCE_MS  10000   // Quiet channels are still sent this often
+#define REPORT_KEYFRAME_MS 60000
+#define REPORT_HOLD_MS     500     // Longest delay of a change on a quiet link
+#define RS485_NODE_ADDRESS 1       // Address of this DAQ node on the RS485 bus
+#define RS485_DEADLINE_US  500     // Turnaround of a response
+#define COMMAND_PERIOD_US  20000   // Console input is polled at 50 Hz
+#define LED_PERIOD_US      100000
 
+ADC_Config thermistor_config;
+Thermistor_Config thermistor_model =
+{
+	.R_Fixed = 10000.0f,		// Pull-down resistor value (Ω)
+	.R0 = 10000.0f,				// Thermistor resistance at T0 (Ω)
+	.B_Coefficient = 3950.0f,	// Beta coefficient (K)
+	.T0_Kelvin = 298.15f,		// 25 °C in Kelvin
+	.Code_Bits = 16,			// Decimated samples
+	.Min_Celsius = -40.0f,
+	.Max_Celsius = 150.0f,
+};
+Thermistor_Benchmark_Result thermistor_benchmark;
+ADC_Block thermistor_block;
+Decimation_Config thermistor_decimator;
+volatile uint16_t thermistor_buffer[2 * SCANS_PER_BLOCK * NUM_CHANNELS] __attribute__((aligned(4)));
+uint16_t thermistor_decimated[OUTPUTS_PER_BLOCK * NUM_CHANNELS];
+uint32_t thermistor_overruns = 0;
+int16_t thermistor_centi[OUTPUTS_PER_BLOCK * NUM_CHANNELS];
+Statistics_Config thermistor_stats = {.Time_Constant_ms = {EMA_FAST_MS, EMA_SLOW_MS}};
+Alarm_Config thermistor_alarm =
+{
+	.Enable_Mask = (1 << NUM_CHANNELS) - 1,
+	.Hysteresis_Centi = ALARM_HYSTERESIS_CENTI,
+	.Rise_Centi_Per_s = ALARM_RISE_CENTI_PER_S,
+	.Watchdog_Channel = ALARM_WATCHDOG_CHANNEL,
+};
 
-#define ADC_MAX       4095.0f    // 12-bit ADC
-#define VREF          3.3f       // ADC reference voltage (V)
-#define R_FIXED       10000.0f   // Pull-down resistor value (Ω)
-#define R0            10000.0f   // Thermistor resistance at T0 (Ω)
-#define B_COEF        3950.0f    // Beta coefficient (K)
-#define T0_KELVIN     298.15f    // 25 °C in Kelvin
+Deadband_Config thermistor_deadband =
+{
+	.Max_Silence_ms = REPORT_SILENCE_MS,
+	.Keyframe_ms = REPORT_KEYFRAME_MS,
+	.Hold_ms = REPORT_HOLD_MS,
+};
+bool report_changes = false;		// Change-only records instead of every decimated scan
+
+uint32_t telemetry_buffer[TELEMETRY_BUFFER_WORDS(NUM_CHANNELS, SCANS_PER_FRAME)];
+Telemetry_Config telemetry =
+{
+	.Buffer = telemetry_buffer,
+	.Channel_Mask = (1 << NUM_CHANNELS) - 1,
+	.Type = TELEMETRY_TYPE_CENTI_CELSIUS,
+	.Scans_Per_Frame = SCANS_PER_FRAME,
+	.Scan_Period = (1000000000ULL * DECIMATION_RATIO) / SAMPLING_FREQUENCY,
+	.Write = Console_Write_Async,
+	.Write_Urgent = Console_Write_Urgent,
+};
+
+int16_t rs485_centi[NUM_CHANNELS];	// Latest decimated scan, served to the bus
+uint64_t rs485_time = 0;
+uint8_t rs485_channels = 0;
+
+static int16_t RS485_Ping(const uint8_t *request, uint8_t length, uint8_t *response, void *context);
+static int16_t RS485_Read(const uint8_t *request, uint8_t length, uint8_t *response, void *context);
+static int16_t RS485_Alarms(const uint8_t *request, uint8_t length, uint8_t *response, void *context);
+
+static const RS485_Handler rs485_handlers[] =
+{
+	{RS485_FUNCTION_PING, RS485_Ping, NULL},
+	{RS485_FUNCTION_READ, RS485_Read, NULL},
+	{RS485_FUNCTION_ALARMS, RS485_Alarms, &thermistor_alarm},
+};
 
-//#define NUM_CHANNELS 4
-//uint16_t adc_buffer[NUM_CHANNELS];
+RS485_Node rs485_node =
+{
+	.Address = RS485_NODE_ADDRESS,
+	.Handlers = rs485_handlers,
+	.Handler_Count = sizeof(rs485_handlers) / sizeof(rs485_handlers[0]),
+	.Crc = Custom_Comm_CRC,
+};
+
+PROFILER_PROBE(decimate_probe, "decimate");
+PROFILER_PROBE(convert_probe, "convert");
+PROFILER_PROBE(commit_probe, "commit");
+PROFILER_PROBE(stats_probe, "stats");
+PROFILER_PROBE(alarm_probe, "alarm");
+
+/* prof: print the probes, prof reset: clear them */
+static void Profiler_Command(int argc, char *argv[])
+{
+	if((argc > 1) && (strcmp(argv[1], "reset") == 0))
+	{
+		Profiler_Reset();
+		return;
+	}
 
-ADC_Config thermistor_config;
-volatile uint16_t thermistor_buffer[5];
+	Profiler_Dump(printConsole);
+}
+
+static const Command_Entry profiler_command = {"prof", "Cycle counts of the probes, 'prof reset' clears them", Profiler_Command};
+
+static void Tasks_Command(int argc, char *argv[])
+{
+	Scheduler_Dump(printConsole);
+}
+
+static const Command_Entry tasks_command = {"tasks", "Runs, deadline misses and idle time of the tasks", Tasks_Command};
+
+/* rate: print the scan period, rate <Hz>: change the sampling rate */
+static void Rate_Command(int argc, char *argv[])
+{
+	if(argc > 1)
+	{
+		int8_t result = ADC_Set_Sampling_Frequency(&thermistor_config, (uint32_t)strtoul(argv[1], NULL, 10));
+
+		if(result != 1)
+		{
+			printConsole((result == 0) ? "Busy, try again\r\n" : "Rate out of range\r\n");
+			return;
+		}
+	}
+
+	printConsole("Scan period %lu ns\r\n", (unsigned long)ADC_Get_Scan_Period());
+}
+
+static const Command_Entry rate_command = {"rate", "Scan period, 'rate <Hz>' changes the sampling rate", Rate_Command};
+
+/* profile fast: first channels at a high rate, profile slow: all channels at the default rate */
+static void Profile_Command(int argc, char *argv[])
+{
+	uint8_t channels;
+	uint32_t frequency;
+
+	if((argc > 1) && (strcmp(argv[1], "fast") == 0))
+	{
+		channels = FAST_CHANNELS;
+		frequency = FAST_FREQUENCY;
+	}
+	else if((argc > 1) && (strcmp(argv[1], "slow") == 0))
+	{
+		channels = NUM_CHANNELS;
+		frequency = SAMPLING_FREQUENCY;
+	}
+	else
+	{
+		printConsole("Usage: profile fast|slow\r\n");
+		return;
+	}
+
+	// The enabled channels take the ranks in order, any subset works
+	thermistor_config.Channel_2.Enable = (channels > 2) ? ADC_Configuration.Channel.Enable.Enable : ADC_Configuration.Channel.Enable.Disable;
+	thermistor_config.Channel_3.Enable = (channels > 3) ? ADC_Configuration.Channel.Enable.Enable : ADC_Configuration.Channel.Enable.Disable;
+	thermistor_config.Channel_4.Enable = (channels > 4) ? ADC_Configuration.Channel.Enable.Enable : ADC_Configuration.Channel.Enable.Disable;
+	thermistor_config.External_Trigger.Sampling_Frequency = frequency;
+
+	int8_t result = ADC_Reconfigure(&thermistor_config);
+
+	if(result != 1)
+	{
+		printConsole((result == 0) ? "Busy, try again\r\n" : "Profile not possible\r\n");
+		return;
+	}
+
+	printConsole("%u channels at %lu Hz from the next buffer\r\n", channels, (unsigned long)frequency);
+}
+
+static const Command_Entry profile_command = {"profile", "'profile fast|slow' switches channel set and rate live", Profile_Command};
+
+/* stats: print the statistics of every channel, stats reset: start a new window */
+static void Stats_Command(int argc, char *argv[])
+{
+	if((argc > 1) && (strcmp(argv[1], "reset") == 0))
+	{
+		Statistics_Reset(&thermistor_stats);
+		return;
+	}
 
-const uint16_t resistor_ref = 10000;
+	Statistics_Dump(&thermistor_stats, printConsole);
+}
 
-volatile float thermistor[5] = {0};
+static const Command_Entry stats_command = {"stats", "Temperature statistics per channel, 'stats reset' starts a new window", Stats_Command};
 
+#if TELEMETRY_BINARY
+/* report all|changes: switch the telemetry mode, report key: keyframe next, report: print the deadbands */
+static void Report_Command(int argc, char *argv[])
+{
+	if((argc > 1) && ((strcmp(argv[1], "all") == 0) || (strcmp(argv[1], "changes") == 0)))
+	{
+		bool changes = (strcmp(argv[1], "changes") == 0);
+
+		if(changes != report_changes)
+		{
+			// A frame holds either scans or records, and its type is set when it is sent
+			Telemetry_Flush(&telemetry);
+			telemetry.Type = changes ? TELEMETRY_TYPE_CHANGES : TELEMETRY_TYPE_CENTI_CELSIUS;
+			Deadband_Keyframe(&thermistor_deadband);
+			report_changes = changes;
+		}
+	}
+	else if((argc > 1) && (strcmp(argv[1], "key") == 0))
+	{
+		Deadband_Keyframe(&thermistor_deadband);
+	}
 
-float digital_to_analog(uint16_t digital)
+	printConsole("Reporting %s\r\n", report_changes ? "changes" : "all scans");
+	Deadband_Dump(&thermistor_deadband, printConsole);
+}
+
+static const Command_Entry report_command = {"report", "'report all|changes' every scan or changes only, 'report key' sends a keyframe", Report_Command};
+#endif
+
+static void Alarm_Command(int argc, char *argv[])
 {
-	return(((float)digital*3.3)/4096.0);
+	Alarm_Dump(&thermistor_alarm, printConsole);
 }
 
-float Thermistor_GetTempC(uint16_t adcValue)
+static const Command_Entry alarm_command = {"alarm", "Alarm limits, active alarms and latency", Alarm_Command};
+
+/* rs485: requests served on the bus */
+static void RS485_Command(int argc, char *argv[])
 {
-    // 1) Convert ADC reading to voltage across thermistor
-    float vTherm = (adcValue / ADC_MAX) * VREF;
+	printConsole("Node %u: %lu requests, %lu responses, %lu bad frames\r\n", rs485_node.Address,
+			(unsigned long)rs485_node.Requests, (unsigned long)rs485_node.Responses, (unsigned long)rs485_node.Errors);
+}
 
-    // 2) Compute thermistor resistance from divider: V = VREF * (Rtherm / (Rtherm + R_FIXED))
-    float rTherm = R_FIXED * (VREF / vTherm - 1.0f);
+static const Command_Entry rs485_command = {"rs485", "Requests, responses and bad frames of the RS485 node", RS485_Command};
 
-    // 3) Apply B-parameter equation: 1/T = 1/T0 + (1/B) * ln(R/R0)
-    float lnTerm = logf(rTherm / R0);
-    float invT  = (1.0f / T0_KELVIN) + (lnTerm / B_COEF);
+static void Process_Task(void *context);
+static void Alarm_Task(void *context);
+static void RS485_Task(void *context);
+static void Command_Task(void *context);
+static void LED_Task(void *context);
 
-    // 4) Convert Kelvin back to °C
-    float tempK = 1.0f / invT;
-    float tempC = tempK - 273.15f;
+// Processing is released by every ADC block and must finish before the next one
+Scheduler_Task process_task = {.Name = "process", .Run = Process_Task, .Deadline = BLOCK_PERIOD_US};
+// Alarm changes go out first, the period only retries frames the link was too busy for
+Scheduler_Task alarm_task = {.Name = "alarm", .Run = Alarm_Task, .Period = ALARM_PERIOD_US, .Deadline = ALARM_DEADLINE_US};
+// Every received frame releases the node, the host waits for the answer
+Scheduler_Task rs485_task = {.Name = "rs485", .Run = RS485_Task, .Deadline = RS485_DEADLINE_US};
+Scheduler_Task command_task = {.Name = "command", .Run = Command_Task, .Period = COMMAND_PERIOD_US};
+Scheduler_Task led_task = {.Name = "led", .Run = LED_Task, .Period = LED_PERIOD_US};
 
-    return tempC;
+static void Block_Ready(void)
+{
+	Scheduler_Signal(&process_task);
 }
 
+static void RS485_Frame_Ready(void)
+{
+	Scheduler_Signal(&rs485_task);
+}
+
+/* Runs in the ADC interrupt on the first conversion of the watched channel above its limit */
+static void Watchdog_Alarm(void)
+{
+	Alarm_Watchdog_ISR(&thermistor_alarm, ADC_Get_Time());
+	Scheduler_Signal(&alarm_task);
+}
+
+#if THERMISTOR_FIXED_POINT
+int32_t thermistor[NUM_CHANNELS] = {0};	// Q16.16 °C
+char thermistor_line[NUM_CHANNELS * 14 + 4];
+
+/* Appends a Q16.16 value with two decimals, keeps printf free of floats */
+static int Q16_To_Text(char *text, size_t size, int32_t value)
+{
+	int64_t scaled = (int64_t)value * 100;
+	int32_t centi = (int32_t)((scaled + ((scaled < 0) ? -(THERMISTOR_Q16_ONE / 2) : (THERMISTOR_Q16_ONE / 2))) / THERMISTOR_Q16_ONE);
+	uint32_t magnitude = (centi < 0) ? (uint32_t)(-centi) : (uint32_t)centi;
+
+	return snprintf(text, size, "%s%lu.%02lu", (centi < 0) ? "-" : "", (unsigned long)(magnitude / 100), (unsigned long)(magnitude % 100));
+}
+#else
+float thermistor[NUM_CHANNELS] = {0};
+#endif
+
 int main(void)
 {
 	MCU_Clock_Setup();
 	Delay_Config();
+	Profiler_Init();
+	Timebase_Init();
 	Console_Init(115200);
+	Command_Register(&profiler_command);
+	Command_Register(&tasks_command);
+	Command_Register(&rate_command);
+	Command_Register(&profile_command);
+	Command_Register(&stats_command);
+	Command_Register(&alarm_command);
+	Command_Register(&rs485_command);
+#if TELEMETRY_BINARY
+	Command_Register(&report_command);
+#endif
+
+	Thermistor_Init(&thermistor_model);
+	Thermistor_Benchmark(&thermistor_model, &thermistor_benchmark);
+
+	for(uint8_t ch = 0; ch < NUM_CHANNELS; ch++)
+	{
+		thermistor_alarm.High_Centi[ch] = ALARM_HIGH_CENTI;
+		thermistor_alarm.Low_Centi[ch] = ALARM_LOW_CENTI;
+		thermistor_deadband.Deadband_Centi[ch] = REPORT_DEADBAND_CENTI;
+	}
+	Alarm_Init(&thermistor_alarm, &thermistor_model, 12);
+#if THERMISTOR_FIXED_POINT
+	Q16_To_Text(thermistor_line, sizeof(thermistor_line), thermistor_model.Error_Bound_Q16);
+	printConsole("Thermistor table: max error %s C, %lu vs %lu cycles/sample (logf) \r\n", thermistor_line,
+			(unsigned long)thermistor_benchmark.Q16_Cycles, (unsigned long)thermistor_benchmark.Exact_Cycles);
+#else
+	printConsole("Thermistor table: max error %f C at code %u, %f vs %f cycles/sample (logf) \r\n",
+			thermistor_model.Error_Bound, thermistor_model.Worst_Code,
+			thermistor_benchmark.Table_Cycles, thermistor_benchmark.Exact_Cycles);
+#endif
 
 
 	GPIO_Pin_Init(GPIOD, 12, GPIO_Configuration.Mode.General_Purpose_Output,
@@ -119,42 +414,281 @@ int main(void)
 
 	thermistor_config.Port = ADC_Configuration.Port._ADC1_;
 	thermistor_config.Channel_Type = ADC_Configuration.Channel_Type.Regular;
+	thermistor_config.Multi_Mode = ADC_Configuration.Multi_Mode.Independent;	// Five channels do not split over two converters
 	thermistor_config.Conversion_Mode = ADC_Configuration.Conversion_Mode.Single;
 	thermistor_config.Data_Alignment = ADC_Configuration.Data_Alignment.Right_Justified;
 	thermistor_config.Resolution = ADC_Configuration.Resolution.Bit_12;
-	thermistor_config.Watchdog_Analog.Enable = ADC_Configuration._Watchdog_Analog_.Disable;
+	thermistor_config.Watchdog_Analog.Enable = ADC_Configuration._Watchdog_Analog_.Enable;
+	thermistor_config.Watchdog_Analog.Channel_Type = ADC_Configuration._Watchdog_Analog_.Channel_Type.Regular;
+	thermistor_config.Watchdog_Analog.Channel_Scan = ADC_Configuration._Watchdog_Analog_.Channel_Scan.Single_Channel;
+	thermistor_config.Watchdog_Analog.Channel = thermistor_config.Channel_0.Sequence_Number;	// Input of ALARM_WATCHDOG_CHANNEL
+	thermistor_config.Watchdog_Analog.Higher_Threshold = ALARM_WATCHDOG_THRESHOLD(&thermistor_alarm, ALARM_WATCHDOG_CHANNEL);
+	thermistor_config.Watchdog_Analog.Lower_Threshold = 0;
 	thermistor_config.External_Trigger.Enable = ADC_Configuration.Regular_External_Trigger_Enable.Trigger_On_Rising_Edge;
-	thermistor_config.External_Trigger.Sampling_Frequency = 100;
+	thermistor_config.External_Trigger.Sampling_Frequency = SAMPLING_FREQUENCY;
 	thermistor_config.External_Trigger.Trigger_Event = ADC_Configuration.Regular_External_Trigger_Event.Timer_2_CC2;
 
+	Telemetry_Init(&telemetry);
 	ADC_Init(&thermistor_config);
-	ADC_Start_Capture(&thermistor_config, (uint16_t*)&thermistor_buffer);
+	Decimation_Init(&thermistor_decimator, NUM_CHANNELS, 12, DECIMATION_RATIO);
+	Statistics_Init(&thermistor_stats, NUM_CHANNELS);
+	Deadband_Init(&thermistor_deadband, NUM_CHANNELS);
+
+	// Blocks release the processing task from the first one on
+	Scheduler_Add(&process_task, 0);
+	ADC_Set_Block_Callback(Block_Ready);
+	ADC_Start_Block_Capture(&thermistor_config, (uint16_t*)&thermistor_buffer, SCANS_PER_BLOCK);
+	ADC_Watchdog_Arm(&thermistor_config, Watchdog_Alarm);
+
+	// The timer runs at the nearest rate it can reach, frames carry the real period
+	if(ADC_Get_Scan_Period() != 0) telemetry.Scan_Period = ADC_Get_Scan_Period() * DECIMATION_RATIO;
+	Statistics_Set_Period(&thermistor_stats, telemetry.Scan_Period);
 
 	GPIO_Pin_Toggle(GPIOD, 12);
 	GPIO_Pin_Toggle(GPIOD, 14);
 
+	Custom_Comm_Config rs485_bus;
+	Custom_Comm_Config_Reset(&rs485_bus);
+	Custom_Comm_Init(&rs485_bus);
+	Scheduler_Add(&rs485_task, 0);
+	Custom_Comm_Set_Frame_Callback(RS485_Frame_Ready);
 
+	Scheduler_Add(&alarm_task, 0);
+	Scheduler_Add(&command_task, 0);
+	Scheduler_Add(&led_task, LED_PERIOD_US / 2);
+	Scheduler_Run();
+}
 
+/* Bit n for every enabled Channel_n, the channels of the ranks in order */
+static uint16_t Thermistor_Channel_Mask(void)
+{
+	const ADC_Pin *pins[NUM_CHANNELS] = {
+		&thermistor_config.Channel_0, &thermistor_config.Channel_1, &thermistor_config.Channel_2,
+		&thermistor_config.Channel_3, &thermistor_config.Channel_4,
+	};
+	uint16_t mask = 0;
 
-	for(;;)
+	for(uint8_t ch = 0; ch < NUM_CHANNELS; ch++)
 	{
-		thermistor[0] = Thermistor_GetTempC(thermistor_buffer[0]);
-		thermistor[1] = Thermistor_GetTempC(thermistor_buffer[1]);
-		thermistor[2] = Thermistor_GetTempC(thermistor_buffer[2]);
-		thermistor[3] = Thermistor_GetTempC(thermistor_buffer[3]);
-		thermistor[4] = Thermistor_GetTempC(thermistor_buffer[4]);
-
+		if(pins[ch]->Enable == ENABLE) mask |= 1 << ch;
+	}
+	return mask;
+}
 
+/* Decimates, converts and sends every block the ADC has published */
+static void Process_Task(void *context)
+{
+	while(ADC_Get_Block(&thermistor_block) == 1)
+	{
+		if(thermistor_block.Channels != thermistor_decimator.Channels)
+		{
+			// The channel set changed, this block starts the new layout
+			Telemetry_Set_Channel_Mask(&telemetry, Thermistor_Channel_Mask());
+			Decimation_Init(&thermistor_decimator, thermistor_block.Channels, 12, DECIMATION_RATIO);
+			Statistics_Init(&thermistor_stats, thermistor_block.Channels);
+			Deadband_Init(&thermistor_deadband, thermistor_block.Channels);
+			telemetry.Scan_Period = ADC_Get_Scan_Period() * DECIMATION_RATIO;
+			Statistics_Set_Period(&thermistor_stats, telemetry.Scan_Period);
+			process_task.Deadline = (uint32_t)(((uint64_t)thermistor_block.Scans * ADC_Get_Scan_Period()) / 1000);
+		}
+		else if(thermistor_block.Rate_Scan < thermistor_block.Scans)
+		{
+			// The sampling rate changed in this block, new frames carry the new period
+			Telemetry_Flush(&telemetry);
+			telemetry.Scan_Period = ADC_Get_Scan_Period() * DECIMATION_RATIO;
+			Statistics_Set_Period(&thermistor_stats, telemetry.Scan_Period);
+		}
+
+		if(thermistor_block.Overruns != thermistor_overruns)
+		{
+			// Scans went missing, do not mix both sides of the gap into one output
+			thermistor_overruns = thermistor_block.Overruns;
+			Decimation_Reset(&thermistor_decimator);
+		}
+
+		// Limits are checked on the raw scans, an alarm waits for one block at most
+		uint32_t start = Profiler_Start();
+		if(Alarm_Check_Block(&thermistor_alarm, thermistor_block.Data, thermistor_block.Channels, thermistor_block.Scans,
+				ADC_Block_Timestamp(&thermistor_block, 0), ADC_Get_Scan_Period()) != 0)
+		{
+			Scheduler_Signal(&alarm_task);
+		}
+		Profiler_End(&alarm_probe, start);
+
+#if TELEMETRY_BINARY
+		// Decimated scans are written straight into the telemetry frame, change-only records are picked from them later
+		uint16_t *frame_samples = report_changes ? thermistor_decimated : Telemetry_Reserve(&telemetry, OUTPUTS_PER_BLOCK);
+#else
+		uint16_t *frame_samples = thermistor_decimated;
+#endif
+
+		start = Profiler_Start();
+		uint16_t outputs = Decimation_Process(&thermistor_decimator, thermistor_block.Data, thermistor_block.Scans,
+				frame_samples, OUTPUTS_PER_BLOCK);
+		Profiler_End(&decimate_probe, start);
+
+		if(ADC_Release_Block(&thermistor_block) != 1)
+		{
+			// The DMA caught up with the block while it was being accumulated
+			Decimation_Reset(&thermistor_decimator);
+			continue;
+		}
+
+		if(outputs == 0)
+		{
+			continue;
+		}
+
+		// The last output window ended `Count` scans before the end of this block
+		uint32_t output_scan = thermistor_block.Scans - thermistor_decimator.Count - (uint32_t)(outputs - 1) * DECIMATION_RATIO;
+		uint64_t output_time = ADC_Block_Timestamp(&thermistor_block, output_scan);
+
+#if TELEMETRY_BINARY
+		int16_t *centi = report_changes ? thermistor_centi : (int16_t *)frame_samples;
+#else
+		int16_t *centi = thermistor_centi;
+#endif
+
+		start = Profiler_Start();
+		Thermistor_Convert_Block_Centi(&thermistor_model, frame_samples, centi, outputs * thermistor_block.Channels);
+		Profiler_End(&convert_probe, start);
+
+		start = Profiler_Start();
+		Statistics_Update(&thermistor_stats, centi, outputs, output_time + (uint64_t)(outputs - 1) * telemetry.Scan_Period);
+		Profiler_End(&stats_probe, start);
+
+		// The bus reads the newest scan of the block
+		rs485_channels = thermistor_block.Channels;
+		memcpy(rs485_centi, &centi[(outputs - 1) * rs485_channels], rs485_channels * sizeof(int16_t));
+		rs485_time = output_time + (uint64_t)(outputs - 1) * telemetry.Scan_Period;
+
+		if(Alarm_Check_Rate(&thermistor_alarm, thermistor_stats.Rate, thermistor_block.Channels, thermistor_stats.Time) != 0)
+		{
+			Scheduler_Signal(&alarm_task);
+		}
+
+#if TELEMETRY_BINARY
+		start = Profiler_Start();
+		if(report_changes)
+		{
+			Deadband_Report(&thermistor_deadband, &telemetry, centi, outputs, output_time, telemetry.Scan_Period);
+		}
+		else
+		{
+			Telemetry_Commit(&telemetry, outputs, output_time);
+		}
+		Profiler_End(&commit_probe, start);
+#elif THERMISTOR_FIXED_POINT
+		uint8_t channels = thermistor_block.Channels;
+		Thermistor_Convert_Block_Q16(&thermistor_model, &thermistor_decimated[(outputs - 1) * channels],
+				thermistor, channels);
+
+		int length = 0;
+		for(uint8_t ch = 0; ch < channels; ch++)
+		{
+			length += Q16_To_Text(&thermistor_line[length], sizeof(thermistor_line) - length, thermistor[ch]);
+			length += snprintf(&thermistor_line[length], sizeof(thermistor_line) - length, (ch < channels - 1) ? ", " : " ");
+		}
+
+		printConsole("%s\r\n", thermistor_line);
+#else
+		Thermistor_Convert_Block(&thermistor_model, &thermistor_decimated[(outputs - 1) * NUM_CHANNELS],
+				thermistor, NUM_CHANNELS);
 
 		printConsole("%f, %f, %f, %f, %f \r\n",thermistor[0],thermistor[1],thermistor[2],thermistor[3],
 				thermistor[4]);
+#endif
+	}
+}
 
-		GPIO_Pin_Toggle(GPIOD, 12);
-		GPIO_Pin_Toggle(GPIOD, 13);
-		GPIO_Pin_Toggle(GPIOD, 14);
-		GPIO_Pin_Toggle(GPIOD, 15);
-		Delay_milli(100);
+/* Sends queued alarm changes and re-arms the watchdog once its alarm has cleared */
+static void Alarm_Task(void *context)
+{
+#if TELEMETRY_BINARY
+	Alarm_Send(&thermistor_alarm, &telemetry, ADC_Get_Time());
+#else
+	Alarm_Event event;
+
+	while(Alarm_Get_Event(&thermistor_alarm, &event, ADC_Get_Time()) == 1)
+	{
+		printConsole("Alarm ch %u %s %s %ld\r\n", event.Record.Channel,
+				(event.Record.Kind == ALARM_KIND_HIGH) ? "high" : ((event.Record.Kind == ALARM_KIND_LOW) ? "low" : "rise"),
+				event.Record.Active ? "raised" : "cleared", (long)event.Record.Value);
+	}
+#endif
+
+	if(!ADC_Watchdog_Armed(&thermistor_config) && !(thermistor_alarm.High_Active & (1U << ALARM_WATCHDOG_CHANNEL)))
+	{
+		ADC_Watchdog_Arm(&thermistor_config, Watchdog_Alarm);
 	}
 }
 
+/* Answers the requests addressed to this node */
+static void RS485_Task(void *context)
+{
+	Custom_Comm_Node_Poll(&rs485_node);
+}
 
+static int16_t RS485_Ping(const uint8_t *request, uint8_t length, uint8_t *response, void *context)
+{
+	response[0] = RS485_VERSION;
+	response[1] = rs485_channels;
+
+	return 2;
+}
+
+/* Timestamp, mask and every requested channel of the newest scan in one response */
+static int16_t RS485_Read(const uint8_t *request, uint8_t length, uint8_t *response, void *context)
+{
+	uint16_t available = (uint16_t)((1U << rs485_channels) - 1);
+	uint16_t mask = available;
+	uint8_t size = 0;
+
+	if((length != 0) && (length != 2)) return -RS485_ERROR_REQUEST;
+	if(rs485_channels == 0) return -RS485_ERROR_BUSY;
+
+	if(length == 2)
+	{
+		mask = (uint16_t)(request[0] | (request[1] << 8));
+		if(mask == 0) mask = available;
+		else if(mask & ~available) return -RS485_ERROR_REQUEST;
+	}
+
+	memcpy(&response[size], &rs485_time, sizeof(rs485_time));
+	size += sizeof(rs485_time);
+	memcpy(&response[size], &mask, sizeof(mask));
+	size += sizeof(mask);
+
+	for(uint8_t ch = 0; ch < rs485_channels; ch++)
+	{
+		if(!(mask & (1U << ch))) continue;
+
+		memcpy(&response[size], &rs485_centi[ch], sizeof(int16_t));
+		size += sizeof(int16_t);
+	}
+
+	return size;
+}
+
+static int16_t RS485_Alarms(const uint8_t *request, uint8_t length, uint8_t *response, void *context)
+{
+	const Alarm_Config *alarm = (const Alarm_Config *)context;
+	uint16_t active[3] = {alarm->High_Active, alarm->Low_Active, alarm->Rise_Active};
+
+	memcpy(response, active, sizeof(active));
+
+	return sizeof(active);
+}
+
+static void Command_Task(void *context)
+{
+	Command_Poll();
+}
+
+static void LED_Task(void *context)
+{
+	GPIO_Pin_Toggle(GPIOD, 12);
+	GPIO_Pin_Toggle(GPIOD, 13);
+	GPIO_Pin_Toggle(GPIOD, 14);
+	GPIO_Pin_Toggle(GPIOD, 15);
+}
@@ -0,0 +1,97 @@
+/**
+ * @file main.h
+ * @brief Host stand-in for Inc/main.h, used by the tests in this folder.
+ *
+ * Gives the drivers under test the C library and the few CMSIS names they
+ * touch, without the device header. Interrupt masking does nothing, the DWT
+ * cycle counter is a plain variable and the timers are only compared by
+ * address. With `HOST_SIMD` defined the Cortex-M4 SIMD intrinsics are emulated
+ * as well, so the `__ARM_FEATURE_DSP` paths of the drivers run on the host.
+ *
+ * @version 1.0
+ * @date 2025-06-20
+ *
+ * @author Kunal Salvi
+ */
+
+#ifndef MAIN_H_
+#define MAIN_H_
+
+#include <stdio.h>
+#include <math.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Interrupts */
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+
+/* DWT cycle counter */
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t CYCCNT;
+	volatile uint32_t DEMCR;
+}Host_Debug_TypeDef;
+
+static Host_Debug_TypeDef Host_Debug __attribute__((unused));
+
+#define DWT								(&Host_Debug)
+#define CoreDebug						(&Host_Debug)
+#define DWT_CTRL_CYCCNTENA_Msk			1UL
+#define CoreDebug_DEMCR_TRCENA_Msk		(1UL << 24)
+
+/* Timers and the clock tree as seen by Timer_Clock, APB1 / 4 and APB2 / 2 of MCU_Clock_Setup */
+typedef struct
+{
+	volatile uint32_t CR1;
+}TIM_TypeDef;
+
+typedef struct
+{
+	volatile uint32_t CFGR;
+}RCC_TypeDef;
+
+static TIM_TypeDef Host_Timers[14] __attribute__((unused));
+static RCC_TypeDef Host_RCC __attribute__((unused)) = {.CFGR = (0x5UL << 10) | (0x4UL << 13)};
+
+#define TIM1							(&Host_Timers[0])
+#define TIM2							(&Host_Timers[1])
+#define TIM3							(&Host_Timers[2])
+#define TIM4							(&Host_Timers[3])
+#define TIM5							(&Host_Timers[4])
+#define TIM6							(&Host_Timers[5])
+#define TIM7							(&Host_Timers[6])
+#define TIM8							(&Host_Timers[7])
+#define TIM9							(&Host_Timers[8])
+#define TIM10							(&Host_Timers[9])
+#define TIM11							(&Host_Timers[10])
+#define TIM12							(&Host_Timers[11])
+#define TIM13							(&Host_Timers[12])
+#define TIM14							(&Host_Timers[13])
+#define RCC								(&Host_RCC)
+#define RCC_CFGR_PPRE1					(0x7UL << 10)
+#define RCC_CFGR_PPRE1_DIV1				0UL
+#define RCC_CFGR_PPRE2					(0x7UL << 13)
+#define RCC_CFGR_PPRE2_DIV1				0UL
+
+static inline int32_t SystemAPB1_Clock_Speed(void) { return 42000000; }
+static inline int32_t SystemAPB2_Clock_Speed(void) { return 84000000; }
+
+#ifdef HOST_SIMD
+#define __ARM_FEATURE_DSP 1
+
+/* Two unsigned 16-bit additions, carries do not cross the lanes */
+static inline uint32_t __UADD16(uint32_t a, uint32_t b)
+{
+	return ((a + b) & 0xFFFFUL) | ((((a >> 16) + (b >> 16)) & 0xFFFFUL) << 16);
+}
+#endif
+
+#endif /* MAIN_H_ */
@@ -0,0 +1,142 @@
+/**
+ * @file Test_CRC.c
+ * @brief Software path of the CRC driver against zlib and bitwise references.
+ *
+ * CRC_MODE_CRC32 has to match `crc32` of zlib, CRC_MODE_MPEG2 and
+ * CRC_MODE_WORDS a plain bit by bit CRC, for every length up to 300 bytes at
+ * every alignment and for a 1 MB buffer. A CRC fed in random pieces has to
+ * match the CRC of the whole buffer.
+ *
+ * @version 1.0
+ * @date 2025-06-20
+ *
+ * @author Kunal Salvi
+ */
+
+#include "main.h"
+#include "CRC/CRC.h"
+#include <zlib.h>
+
+#define LARGE_SIZE		(1UL << 20)
+
+static int failures;
+
+#define CHECK(condition, ...) do{ if(!(condition)){ printf(__VA_ARGS__); failures++; } }while(0)
+
+/* Polynomial 0x04C11DB7, MSB first, initial value 0xFFFFFFFF, no final XOR */
+static uint32_t Reference_MPEG2(const uint8_t *bytes, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	for(size_t i = 0; i < length; i++)
+	{
+		crc ^= (uint32_t)bytes[i] << 24;
+		for(int bit = 0; bit < 8; bit++) crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+	}
+	return crc;
+}
+
+/* The CRC unit: each little endian word MSB first, the same as MPEG-2 of the byte swapped words */
+static uint32_t Reference_Words(const uint8_t *bytes, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	for(size_t i = 0; i < length; i += 4)
+	{
+		uint32_t word;
+		memcpy(&word, &bytes[i], 4);
+		crc ^= word;
+		for(int bit = 0; bit < 32; bit++) crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+	}
+	return crc;
+}
+
+static uint32_t random_state = 1;
+
+static uint32_t Random(void)
+{
+	random_state = random_state * 1664525UL + 1013904223UL;
+	return random_state >> 8;
+}
+
+/* CRC of `length` bytes fed in random pieces */
+static uint32_t Pieces(uint8_t mode, const uint8_t *bytes, size_t length)
+{
+	CRC_Context crc;
+	size_t done = 0;
+
+	CRC_Start(&crc, mode);
+	while(done < length)
+	{
+		size_t piece = Random() % 64;
+
+		if(piece > length - done) piece = length - done;
+		if(mode == CRC_MODE_WORDS) piece &= ~(size_t)3;
+		if((mode == CRC_MODE_WORDS) && (piece == 0)) piece = 4;
+
+		CHECK(CRC_Update(&crc, &bytes[done], piece) == 1, "Mode %u: update of %zu bytes failed\n", mode, piece);
+		done += piece;
+	}
+	return CRC_Final(&crc);
+}
+
+int main(void)
+{
+	uint8_t *large = malloc(LARGE_SIZE + 4);
+	const uint8_t check[] = "123456789";
+
+	for(size_t i = 0; i < LARGE_SIZE + 4; i++) large[i] = (uint8_t)Random();
+
+	CRC_Init();
+
+	// Catalogue check values
+	CHECK(CRC_Compute(CRC_MODE_CRC32, check, 9) == 0xCBF43926, "CRC-32 check value\n");
+	CHECK(CRC_Compute(CRC_MODE_MPEG2, check, 9) == 0x0376E6E7, "CRC-32/MPEG-2 check value\n");
+
+	for(size_t offset = 0; offset < 4; offset++)
+	{
+		const uint8_t *bytes = &large[offset];
+
+		for(size_t length = 0; length <= 300; length++)
+		{
+			uint32_t zlib_crc = (uint32_t)crc32(0, bytes, (uInt)length);
+
+			CHECK(CRC_Compute(CRC_MODE_CRC32, bytes, length) == zlib_crc, "CRC-32 of %zu bytes at offset %zu\n", length, offset);
+			CHECK(CRC_Compute_8Bit_Block((volatile uint8_t *)bytes, length) == zlib_crc, "8-bit block of %zu bytes at offset %zu\n", length, offset);
+			CHECK(CRC_Compute(CRC_MODE_MPEG2, bytes, length) == Reference_MPEG2(bytes, length), "MPEG-2 of %zu bytes at offset %zu\n", length, offset);
+
+			if((length & 3) == 0)
+			{
+				CHECK(CRC_Compute(CRC_MODE_WORDS, bytes, length) == Reference_Words(bytes, length), "Words of %zu bytes at offset %zu\n", length, offset);
+			}
+			else
+			{
+				CHECK(CRC_Compute(CRC_MODE_WORDS, bytes, length) == 0, "Words accepted %zu bytes\n", length);
+			}
+		}
+	}
+
+	uint32_t zlib_large = (uint32_t)crc32(0, &large[1], LARGE_SIZE);
+
+	CHECK(CRC_Compute(CRC_MODE_CRC32, &large[1], LARGE_SIZE) == zlib_large, "CRC-32 of 1 MB\n");
+	CHECK(CRC_Compute(CRC_MODE_MPEG2, &large[1], LARGE_SIZE) == Reference_MPEG2(&large[1], LARGE_SIZE), "MPEG-2 of 1 MB\n");
+	CHECK(CRC_Compute(CRC_MODE_WORDS, large, LARGE_SIZE) == Reference_Words(large, LARGE_SIZE), "Words of 1 MB\n");
+
+	for(int round = 0; round < 100; round++)
+	{
+		size_t offset = Random() % 4;
+		size_t length = Random() % 4096;
+
+		CHECK(Pieces(CRC_MODE_CRC32, &large[offset], length) == (uint32_t)crc32(0, &large[offset], (uInt)length), "CRC-32 in pieces, %zu bytes\n", length);
+		CHECK(Pieces(CRC_MODE_MPEG2, &large[offset], length) == Reference_MPEG2(&large[offset], length), "MPEG-2 in pieces, %zu bytes\n", length);
+		CHECK(Pieces(CRC_MODE_WORDS, large, length & ~(size_t)3) == Reference_Words(large, length & ~(size_t)3), "Words in pieces, %zu bytes\n", length);
+	}
+
+	CRC_Context crc;
+	CRC_Start(&crc, CRC_MODE_WORDS);
+	CHECK(CRC_Update(&crc, large, 6) == -1, "Words took 6 bytes\n");
+
+	printf("Test_CRC: %d failures\n", failures);
+	free(large);
+	return failures != 0;
+}
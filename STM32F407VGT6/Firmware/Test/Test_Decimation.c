@@ -0,0 +1,257 @@
+/**
+ * @file Test_Decimation.c
+ * @brief Replays recorded ADC scans through the decimator.
+ *
+ * Usage: Test_Decimation [channels ratio recording.raw [block]]
+ *
+ * A recording is the raw ADC DMA buffer, 12-bit samples as little endian
+ * uint16, scan after scan. It is fed to @ref Decimation_Process in blocks of
+ * `block` scans (64 by default, the ADC block size), the output scans are
+ * printed as CSV and every one is checked against the recorded input: bit
+ * exact against the integer sum and dump, and within half a code of the mean
+ * computed in double.
+ *
+ * Without arguments a synthetic recording is replayed for several channel
+ * counts, ratios, block sizes and a misaligned start, and the noise of a
+ * constant input is checked to drop with the square root of the ratio. Built
+ * with `HOST_SIMD` the same runs go through the `__UADD16` path.
+ *
+ * @version 1.0
+ * @date 2025-06-20
+ *
+ * @author Kunal Salvi
+ */
+
+#include "main.h"
+#include "Decimation/Decimation.h"
+
+#define INPUT_BITS		12
+#define DEFAULT_BLOCK	64
+
+static int failures;
+
+#define CHECK(condition, ...) do{ if(!(condition)){ printf(__VA_ARGS__); failures++; } }while(0)
+
+/**
+ * @brief Feeds `scans` scans in blocks and checks every output against the input.
+ *
+ * `samples` is copied to a buffer starting `offset` samples past a 32-bit
+ * boundary, so an odd offset takes the scalar path on every block. Output
+ * scans go to `csv` if given. Returns the number of output scans.
+ */
+static uint32_t Replay(const uint16_t *samples, uint32_t scans, uint8_t channels, uint16_t ratio,
+		uint16_t block, uint8_t offset, FILE *csv, uint16_t *outputs)
+{
+	Decimation_Config dec;
+	uint32_t total = scans * channels;
+	uint16_t *buffer = malloc((total + 2) * sizeof(uint16_t));
+	uint16_t *output = malloc(((block / ratio) + 1) * channels * sizeof(uint16_t));
+	uint32_t produced = 0;
+
+	memcpy(buffer + offset, samples, total * sizeof(uint16_t));
+
+	CHECK(Decimation_Init(&dec, channels, INPUT_BITS, ratio) == 1, "%u channels, ratio %u: init failed\n", channels, ratio);
+
+	for(uint32_t scan = 0; scan < scans; scan += block)
+	{
+		uint16_t run = ((scans - scan) < block) ? (uint16_t)(scans - scan) : block;
+		uint16_t count = Decimation_Process(&dec, buffer + offset + scan * channels, run, output, (block / ratio) + 1);
+
+		for(uint16_t i = 0; i < count; i++, produced++)
+		{
+			const uint16_t *input = &samples[produced * ratio * channels];
+
+			for(uint8_t ch = 0; ch < channels; ch++)
+			{
+				uint64_t sum = 0;
+				double mean = 0.0;
+
+				for(uint16_t k = 0; k < ratio; k++)
+				{
+					sum += input[k * channels + ch];
+					mean += input[k * channels + ch];
+				}
+				mean = mean / ratio * (1 << (16 - INPUT_BITS));
+
+				uint64_t exact = ((sum << (16 - INPUT_BITS)) + ratio / 2) / ratio;
+				uint16_t value = output[i * channels + ch];
+
+				if(exact > 0xFFFF) exact = 0xFFFF;
+
+				CHECK(value == exact, "%u channels, ratio %u, block %u: output %u channel %u is %u, not %u\n",
+						channels, ratio, block, produced, ch, value, (unsigned)exact);
+				CHECK((fabs(value - mean) <= 0.5) || (value == 0xFFFF), "%u channels, ratio %u: output %u channel %u is %u, mean %.3f\n",
+						channels, ratio, produced, ch, value, mean);
+
+				if(outputs != NULL) outputs[produced * channels + ch] = value;
+			}
+
+			if(csv != NULL)
+			{
+				fprintf(csv, "%u", produced);
+				for(uint8_t ch = 0; ch < channels; ch++) fprintf(csv, ",%u", output[i * channels + ch]);
+				fprintf(csv, "\n");
+			}
+		}
+	}
+
+	CHECK(produced == scans / ratio, "%u channels, ratio %u, block %u: %u outputs, not %u\n", channels, ratio, block, produced, scans / ratio);
+	CHECK(dec.Outputs == produced, "%u channels, ratio %u: output counter %u\n", channels, ratio, dec.Outputs);
+
+	free(buffer);
+	free(output);
+	return produced;
+}
+
+static uint32_t random_state = 12345;
+
+static uint32_t Random(void)
+{
+	random_state = random_state * 1664525UL + 1013904223UL;
+	return random_state >> 8;
+}
+
+/* Slow ramps with a few LSB of noise, full scale and zero on the last two channels */
+static uint16_t *Synthesize(uint32_t scans, uint8_t channels)
+{
+	uint16_t *samples = malloc(scans * channels * sizeof(uint16_t));
+
+	for(uint32_t scan = 0; scan < scans; scan++)
+	{
+		for(uint8_t ch = 0; ch < channels; ch++)
+		{
+			int32_t value = (int32_t)((scan * (ch + 1)) % 4096) + (int32_t)(Random() % 9) - 4;
+
+			if((channels > 2) && (ch == channels - 1)) value = 4095;
+			if((channels > 2) && (ch == channels - 2)) value = 0;
+
+			samples[scan * channels + ch] = (value < 0) ? 0 : (value > 4095) ? 4095 : (uint16_t)value;
+		}
+	}
+	return samples;
+}
+
+/* Constant input with uniform noise: the output noise has to scale with 1 / sqrt(ratio) */
+static void Check_Noise(uint16_t ratio)
+{
+	const uint32_t outputs = 4096;
+	const uint32_t scans = outputs * ratio;
+	uint16_t *samples = malloc(scans * sizeof(uint16_t));
+	uint16_t *decimated = malloc(outputs * sizeof(uint16_t));
+
+	for(uint32_t i = 0; i < scans; i++) samples[i] = 2000 + (uint16_t)(Random() % 33) - 16;
+
+	Replay(samples, scans, 1, ratio, DEFAULT_BLOCK, 0, NULL, decimated);
+
+	// Uniform over 33 codes, scaled by 16 to the output range
+	double input = 16.0 * sqrt((33.0 * 33.0 - 1.0) / 12.0);
+	double mean = 0.0, variance = 0.0;
+
+	for(uint32_t i = 0; i < outputs; i++) mean += decimated[i];
+	mean /= outputs;
+	for(uint32_t i = 0; i < outputs; i++) variance += (decimated[i] - mean) * (decimated[i] - mean);
+
+	double noise = sqrt(variance / (outputs - 1));
+	double expected = input / sqrt(ratio);
+
+	printf("Test_Decimation: ratio %3u, noise %.2f, expected %.2f\n", ratio, noise, expected);
+	CHECK(fabs(noise / expected - 1.0) < 0.1, "ratio %u: noise %.2f, expected %.2f\n", ratio, noise, expected);
+
+	free(samples);
+	free(decimated);
+}
+
+static int Self_Test(void)
+{
+	const uint8_t channel_counts[] = {1, 2, 3, 8, 16};
+	const uint16_t ratios[] = {1, 2, 5, 16, 64, 256};
+	const uint16_t blocks[] = {1, 7, 64, 1000};
+	uint32_t runs = 0, outputs = 0;
+
+	for(uint8_t c = 0; c < sizeof(channel_counts); c++)
+	{
+		uint32_t scans = 4096 + 37;
+		uint16_t *samples = Synthesize(scans, channel_counts[c]);
+
+		for(uint8_t r = 0; r < sizeof(ratios) / sizeof(ratios[0]); r++)
+		{
+			for(uint8_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++)
+			{
+				for(uint8_t offset = 0; offset < 2; offset++)
+				{
+					outputs += Replay(samples, scans, channel_counts[c], ratios[r], blocks[b], offset, NULL, NULL);
+					runs++;
+				}
+			}
+		}
+		free(samples);
+	}
+
+	Check_Noise(4);
+	Check_Noise(16);
+	Check_Noise(256);
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+	const char *path = "SIMD";
+#else
+	const char *path = "scalar";
+#endif
+	printf("Test_Decimation: %s path, %u replays, %u output scans, %d failures\n", path, runs, outputs, failures);
+	return failures != 0;
+}
+
+int main(int argc, char **argv)
+{
+	if(argc == 1) return Self_Test();
+
+	if((argc < 4) || (argc > 5))
+	{
+		fprintf(stderr, "Usage: %s [channels ratio recording.raw [block]]\n", argv[0]);
+		return 2;
+	}
+
+	uint8_t channels = (uint8_t)atoi(argv[1]);
+	uint16_t ratio = (uint16_t)atoi(argv[2]);
+	uint16_t block = (argc == 5) ? (uint16_t)atoi(argv[4]) : DEFAULT_BLOCK;
+	FILE *file = fopen(argv[3], "rb");
+
+	if((channels == 0) || (channels > DECIMATION_MAX_CHANNELS) || (ratio == 0) || (block == 0))
+	{
+		fprintf(stderr, "Invalid channels, ratio or block\n");
+		return 2;
+	}
+	if(file == NULL)
+	{
+		perror(argv[3]);
+		return 2;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long bytes = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	uint32_t scans = (uint32_t)(bytes / (2 * channels));
+	uint16_t *samples = malloc((size_t)scans * channels * sizeof(uint16_t));
+	uint8_t raw[2];
+
+	for(uint32_t i = 0; i < scans * channels; i++)
+	{
+		if(fread(raw, 1, 2, file) != 2) break;
+		samples[i] = raw[0] | (raw[1] << 8);
+		CHECK(samples[i] < (1 << INPUT_BITS), "Sample %u is %u, more than %d bits\n", i, samples[i], INPUT_BITS);
+	}
+	fclose(file);
+
+	if(failures == 0)
+	{
+		printf("output");
+		for(uint8_t ch = 0; ch < channels; ch++) printf(",ch%u", ch);
+		printf("\n");
+
+		Replay(samples, scans, channels, ratio, block, 0, stdout, NULL);
+	}
+
+	fprintf(stderr, "Test_Decimation: %u scans, %u outputs, %d failures\n", scans, scans / ratio, failures);
+	free(samples);
+	return failures != 0;
+}
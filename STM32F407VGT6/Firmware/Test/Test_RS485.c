@@ -0,0 +1,196 @@
+/**
+ * @file Test_RS485.c
+ * @brief Three nodes and a host on a simulated RS485 bus.
+ *
+ * Every frame put on the bus reaches every node and comes back to its sender,
+ * as on a bus with the receivers always enabled. The host polls the nodes for
+ * 100 cycles, corrupts one response on the way, broadcasts a function and
+ * asks for one a node does not serve. The CRC is the software path of the CRC
+ * driver in word mode, the one Custom_Comm_CRC uses on the target.
+ *
+ * @version 1.0
+ * @date 2025-06-20
+ *
+ * @author Kunal Salvi
+ */
+
+#include "main.h"
+#include "CRC/CRC.h"
+#include "Custom_RS485_Comm/RS485_Protocol.h"
+
+#define NODES			3
+#define CYCLES			100
+#define FUNCTION_SYNC	0x10
+
+static int failures;
+
+#define CHECK(condition) do{ if(!(condition)){ printf("%s:%d: %s\n", __FILE__, __LINE__, #condition); failures++; } }while(0)
+
+static uint32_t Bus_CRC(const uint32_t *words, uint32_t count)
+{
+	return CRC_Compute(CRC_MODE_WORDS, words, count * 4);
+}
+
+typedef struct{
+	uint8_t Address;
+	uint32_t Syncs;
+}Test_Node;
+
+static int16_t Ping(const uint8_t *request, uint8_t length, uint8_t *response, void *context)
+{
+	response[0] = RS485_VERSION;
+	response[1] = ((Test_Node *)context)->Address;
+	return 2;
+}
+
+// Channel ch of node a reads a * 1000 + ch
+static int16_t Read(const uint8_t *request, uint8_t length, uint8_t *response, void *context)
+{
+	if(length != 2) return -RS485_ERROR_REQUEST;
+
+	uint16_t mask;
+	memcpy(&mask, request, 2);
+
+	uint8_t n = 0;
+	for(uint8_t ch = 0; ch < 16; ch++)
+	{
+		if(!(mask & (1U << ch))) continue;
+		int16_t value = (int16_t)(((Test_Node *)context)->Address * 1000 + ch);
+		memcpy(&response[n], &value, 2);
+		n += 2;
+	}
+	return n;
+}
+
+static int16_t Sync(const uint8_t *request, uint8_t length, uint8_t *response, void *context)
+{
+	((Test_Node *)context)->Syncs++;
+	return 0;
+}
+
+static Test_Node test_nodes[NODES];
+static RS485_Handler handlers[NODES][3];
+static RS485_Node nodes[NODES];
+static RS485_Host host = {.Crc = Bus_CRC};
+
+static uint32_t request[RS485_FRAME_MAX / 4], response[RS485_FRAME_MAX / 4], scratch[RS485_FRAME_MAX / 4];
+
+/**
+ * @brief Puts a frame on the bus, returns the number of nodes that answered.
+ *
+ * The last answer is left in `response` with its length in `answer`.
+ */
+static int Bus_Send(const uint32_t *frame, uint16_t size, uint16_t *answer)
+{
+	int answers = 0;
+	for(int i = 0; i < NODES; i++)
+	{
+		uint16_t length = RS485_Node_Process(&nodes[i], (const uint8_t *)frame, size, (uint8_t *)scratch);
+		if(length == 0) continue;
+		memcpy(response, scratch, length);
+		*answer = length;
+		answers++;
+	}
+	return answers;
+}
+
+int main(void)
+{
+	RS485_Header header;
+	const uint8_t *payload;
+	uint16_t size, answer = 0;
+
+	for(int i = 0; i < NODES; i++)
+	{
+		test_nodes[i].Address = i + 1;
+		handlers[i][0] = (RS485_Handler){RS485_FUNCTION_PING, Ping, &test_nodes[i]};
+		handlers[i][1] = (RS485_Handler){RS485_FUNCTION_READ, Read, &test_nodes[i]};
+		handlers[i][2] = (RS485_Handler){FUNCTION_SYNC, Sync, &test_nodes[i]};
+		nodes[i] = (RS485_Node){.Address = i + 1, .Handlers = handlers[i], .Handler_Count = 3, .Crc = Bus_CRC};
+	}
+
+	// Ping every node
+	for(uint8_t address = 1; address <= NODES; address++)
+	{
+		size = RS485_Host_Request(&host, (uint8_t *)request, address, RS485_FUNCTION_PING, NULL, 0);
+		CHECK(size == RS485_FRAME_SIZE(0));
+		CHECK(Bus_Send(request, size, &answer) == 1);
+		CHECK(RS485_Host_Response(&host, (uint8_t *)request, (uint8_t *)response, answer, &header, &payload) == 1);
+		CHECK((header.Length == 2) && (payload[0] == RS485_VERSION) && (payload[1] == address));
+	}
+
+	// Poll cycles, one response corrupted on the wire
+	uint32_t corrupted = 0;
+	for(int cycle = 0; cycle < CYCLES; cycle++)
+	{
+		for(uint8_t address = 1; address <= NODES; address++)
+		{
+			uint16_t mask = 0x001F;
+			size = RS485_Host_Request(&host, (uint8_t *)request, address, RS485_FUNCTION_READ, (const uint8_t *)&mask, 2);
+			CHECK(Bus_Send(request, size, &answer) == 1);
+
+			// Echoes: the request back to the host, the response to every node
+			CHECK(RS485_Host_Response(&host, (uint8_t *)request, (uint8_t *)request, size, &header, &payload) == 0);
+			CHECK(Bus_Send(response, answer, &size) == 0);
+
+			if((cycle == CYCLES / 2) && (address == 2))
+			{
+				((uint8_t *)response)[RS485_HEADER_SIZE + 2] ^= 0x01;
+				CHECK(RS485_Host_Response(&host, (uint8_t *)request, (uint8_t *)response, answer, &header, &payload) == -1);
+				corrupted++;
+				continue;
+			}
+
+			CHECK(RS485_Host_Response(&host, (uint8_t *)request, (uint8_t *)response, answer, &header, &payload) == 1);
+			CHECK(header.Length == 10);
+			for(int ch = 0; ch < 5; ch++)
+			{
+				int16_t value;
+				memcpy(&value, &payload[ch * 2], 2);
+				CHECK(value == address * 1000 + ch);
+			}
+		}
+	}
+	CHECK(host.Errors == corrupted);
+
+	// A response of node 1 taken for the answer to a request to node 2 is not the response
+	size = RS485_Host_Request(&host, (uint8_t *)request, 1, RS485_FUNCTION_PING, NULL, 0);
+	Bus_Send(request, size, &answer);
+	size = RS485_Host_Request(&host, (uint8_t *)request, 2, RS485_FUNCTION_PING, NULL, 0);
+	CHECK(RS485_Host_Response(&host, (uint8_t *)request, (uint8_t *)response, answer, &header, &payload) == 0);
+
+	// Broadcast, executed by every node and never answered
+	size = RS485_Host_Request(&host, (uint8_t *)request, RS485_ADDRESS_BROADCAST, FUNCTION_SYNC, NULL, 0);
+	CHECK(Bus_Send(request, size, &answer) == 0);
+	for(int i = 0; i < NODES; i++) CHECK(test_nodes[i].Syncs == 1);
+
+	// Function not served and a malformed request, both answered with an error
+	uint32_t errors = host.Errors;
+	size = RS485_Host_Request(&host, (uint8_t *)request, 2, 0x22, NULL, 0);
+	CHECK(Bus_Send(request, size, &answer) == 1);
+	CHECK(RS485_Host_Response(&host, (uint8_t *)request, (uint8_t *)response, answer, &header, &payload) == 1);
+	CHECK((header.Function & RS485_FUNCTION_ERROR) && (header.Length == 1) && (payload[0] == RS485_ERROR_FUNCTION));
+
+	size = RS485_Host_Request(&host, (uint8_t *)request, 3, RS485_FUNCTION_READ, NULL, 0);
+	CHECK(Bus_Send(request, size, &answer) == 1);
+	CHECK(RS485_Host_Response(&host, (uint8_t *)request, (uint8_t *)response, answer, &header, &payload) == 1);
+	CHECK((header.Function & RS485_FUNCTION_ERROR) && (payload[0] == RS485_ERROR_REQUEST));
+	CHECK(host.Errors == errors + 2);
+
+	// Truncated frame, counted by the node and never answered
+	size = RS485_Host_Request(&host, (uint8_t *)request, 1, RS485_FUNCTION_PING, NULL, 0);
+	uint32_t bad = nodes[0].Errors;
+	CHECK(Bus_Send(request, size - 1, &answer) == 0);
+	CHECK(nodes[0].Errors == bad + 1);
+
+	// Requests seen by each node: pings, polls, the broadcast and the tests above
+	CHECK(nodes[0].Requests == 1 + CYCLES + 1 + 1);
+	CHECK(nodes[1].Requests == 1 + CYCLES + 1 + 1);
+	CHECK(nodes[2].Requests == 1 + CYCLES + 1 + 1);
+
+	// 10 bits per byte: 12 + 28 bytes at 115200 baud, rounded up, plus 500 µs turnaround
+	CHECK(RS485_Transaction_us(115200, 2, 18, 500) == 3473 + 500);
+
+	printf("Test_RS485: %u transactions, %d failures\n", host.Transactions, failures);
+	return failures != 0;
+}
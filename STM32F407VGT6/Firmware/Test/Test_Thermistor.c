@@ -0,0 +1,139 @@
+/**
+ * @file Test_Thermistor.c
+ * @brief Bit exact check of the Q16.16 thermistor path.
+ *
+ * For a 12-bit and a 16-bit B-parameter model and a Steinhart-Hart model,
+ * every code is converted and compared with a reference computed in double
+ * from the float table:
+ *
+ * - `Table_Q16` is the float table rounded to Q16.16,
+ * - @ref Thermistor_Code_To_Q16 is the floor of the exact interpolation,
+ * - @ref Thermistor_Convert_Block_Centi is the Q16.16 value rounded half up
+ *   to 0.01 °C,
+ *
+ * all bit exact. The Q16.16 path also has to stay within a few LSB of the float
+ * table path and within the `Error_Bound_Q16` Init measured against the model.
+ *
+ * @version 1.0
+ * @date 2025-06-20
+ *
+ * @author Kunal Salvi
+ */
+
+#include "main.h"
+#include "Thermistor/Thermistor.h"
+
+/* Table rounding, interpolation rounding and the float rounding of the table path */
+#define FLOAT_TOLERANCE		(3.0 / THERMISTOR_Q16_ONE)
+
+static int failures;
+
+#define CHECK(condition, ...) do{ if(!(condition)){ printf(__VA_ARGS__); failures++; } }while(0)
+
+static Thermistor_Config configs[] = {
+	{.R_Fixed = 10000.0f, .R0 = 10000.0f, .B_Coefficient = 3950.0f, .T0_Kelvin = 298.15f,
+			.Code_Bits = 12, .Min_Celsius = -40.0f, .Max_Celsius = 150.0f},
+	{.R_Fixed = 10000.0f, .R0 = 10000.0f, .B_Coefficient = 3950.0f, .T0_Kelvin = 298.15f,
+			.Code_Bits = 16, .Min_Celsius = -40.0f, .Max_Celsius = 150.0f},
+	{.R_Fixed = 10000.0f, .Steinhart_Hart = {.Enable = true, .A = 1.009249522e-3f, .B = 2.378405444e-4f, .C = 2.019202697e-7f},
+			.Code_Bits = 16, .Min_Celsius = -55.0f, .Max_Celsius = 200.0f},
+};
+
+static int32_t Reference_Q16(const Thermistor_Config *config, uint32_t code)
+{
+	if(code < config->Min_Code) code = config->Min_Code;
+	if(code > config->Max_Code) code = config->Max_Code;
+
+	uint8_t shift = config->Code_Bits - THERMISTOR_TABLE_BITS;
+	uint32_t index = code >> shift;
+	double fraction = code & ((1UL << shift) - 1);
+	double low = config->Table_Q16[index];
+	double high = config->Table_Q16[index + 1];
+
+	return (int32_t)(low + floor((high - low) * fraction / (1UL << shift)));
+}
+
+static int16_t Reference_Centi(int32_t q16)
+{
+	double value = floor(((double)q16 * 100.0 + 32768.0) / 65536.0);
+
+	return (value > INT16_MAX) ? INT16_MAX : (value < INT16_MIN) ? INT16_MIN : (int16_t)value;
+}
+
+static void Check_Config(Thermistor_Config *config)
+{
+	uint32_t codes = 1UL << config->Code_Bits;
+	uint16_t *input = malloc(codes * sizeof(uint16_t));
+	int32_t *q16 = malloc(codes * sizeof(int32_t));
+	int16_t *centi = malloc(codes * sizeof(int16_t));
+	double worst_float = 0.0, worst_model = 0.0;
+
+	CHECK(Thermistor_Init(config) == 1, "%u-bit: init failed\n", config->Code_Bits);
+
+	for(uint32_t i = 0; i < THERMISTOR_TABLE_SIZE; i++)
+	{
+		int32_t expected = (int32_t)lround((double)config->Table[i] * THERMISTOR_Q16_ONE);
+		CHECK(config->Table_Q16[i] == expected, "%u-bit: Table_Q16[%u] is %d, not %d\n", config->Code_Bits, i, config->Table_Q16[i], expected);
+	}
+
+	for(uint32_t code = 0; code < codes; code++) input[code] = (uint16_t)code;
+
+	// Blocks of at most 65535 codes, the count is 16 bits
+	for(uint32_t start = 0; start < codes; start += 32768)
+	{
+		uint16_t count = ((codes - start) < 32768) ? (uint16_t)(codes - start) : 32768;
+
+		Thermistor_Convert_Block_Q16(config, &input[start], &q16[start], count);
+		Thermistor_Convert_Block_Centi(config, &input[start], &centi[start], count);
+	}
+
+	for(uint32_t code = 0; code < codes; code++)
+	{
+		int32_t expected = Reference_Q16(config, code);
+
+		CHECK(q16[code] == expected, "%u-bit: code %u is %d, not %d\n", config->Code_Bits, code, q16[code], expected);
+		CHECK(Thermistor_Code_To_Q16(config, code) == q16[code], "%u-bit: code %u, block and single code differ\n", config->Code_Bits, code);
+		CHECK(centi[code] == Reference_Centi(q16[code]), "%u-bit: code %u is %d centi, not %d\n",
+				config->Code_Bits, code, centi[code], Reference_Centi(q16[code]));
+
+		double fixed = (double)q16[code] / THERMISTOR_Q16_ONE;
+		double table = Thermistor_Code_To_Celsius(config, code);
+		double error = fabs(fixed - table);
+
+		if(error > worst_float) worst_float = error;
+		CHECK(error <= FLOAT_TOLERANCE, "%u-bit: code %u, Q16.16 %.6f, float %.6f\n", config->Code_Bits, code, fixed, table);
+
+		if((code >= config->Min_Code) && (code <= config->Max_Code))
+		{
+			int32_t model = (int32_t)lroundf(Thermistor_Code_To_Celsius_Exact(config, code) * (float)THERMISTOR_Q16_ONE);
+			int32_t deviation = labs(q16[code] - model);
+
+			if(deviation > worst_model) worst_model = deviation;
+			CHECK(deviation <= config->Error_Bound_Q16, "%u-bit: code %u is %d from the model, bound %d\n",
+					config->Code_Bits, code, deviation, config->Error_Bound_Q16);
+		}
+	}
+
+	CHECK(worst_model == config->Error_Bound_Q16, "%u-bit: Error_Bound_Q16 %d, measured %.0f\n", config->Code_Bits, config->Error_Bound_Q16, worst_model);
+	CHECK(fabs(config->Error_Bound_Q16 / (double)THERMISTOR_Q16_ONE - config->Error_Bound) <= FLOAT_TOLERANCE,
+			"%u-bit: bounds %.6f and %.6f differ\n", config->Code_Bits, config->Error_Bound_Q16 / (double)THERMISTOR_Q16_ONE, config->Error_Bound);
+
+	printf("Test_Thermistor: %2u-bit %s, codes %u to %u, model error %.4f °C, Q16.16 to float %.2g °C\n",
+			config->Code_Bits, config->Steinhart_Hart.Enable ? "Steinhart-Hart" : "B-parameter",
+			config->Min_Code, config->Max_Code, config->Error_Bound, worst_float);
+
+	free(input);
+	free(q16);
+	free(centi);
+}
+
+int main(void)
+{
+	for(uint8_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++)
+	{
+		Check_Config(&configs[i]);
+	}
+
+	printf("Test_Thermistor: %d failures\n", failures);
+	return failures != 0;
+}
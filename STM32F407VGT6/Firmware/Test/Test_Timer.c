@@ -0,0 +1,202 @@
+/**
+ * @file Test_Timer.c
+ * @brief Sweep of @ref Timer_Solve against a brute force search.
+ *
+ * For both timer clocks and both reload widths, every rate on a logarithmic
+ * grid from 1 Hz to half the clock, plus rates picked to make the ratio a
+ * large prime, is solved and compared with the best pair over all 65536
+ * prescalers. Errors are compared exactly as fractions.
+ *
+ * The solver is either optimal or, when it ran out of its factoring budget,
+ * within half a prescaler step of the ratio. The sweep counts both cases and
+ * reports the solve time.
+ *
+ * @version 1.0
+ * @date 2025-06-20
+ *
+ * @author Kunal Salvi
+ */
+
+#include "main.h"
+#include "Timer/Timer.h"
+#include <time.h>
+
+#define RATES_PER_DECADE	60
+
+static int failures;
+
+#define CHECK(condition, ...) do{ if(!(condition)){ printf(__VA_ARGS__); failures++; } }while(0)
+
+typedef unsigned __int128 uint128_t;
+
+typedef struct{
+	uint32_t Solves;
+	uint32_t Optimal;
+	uint32_t Nearest;
+	double Worst;			/**< Largest relative error of a result that is not optimal */
+	double Seconds;
+	double Slowest;
+}Sweep;
+
+/* |clock / division - frequency| = error / division */
+static uint64_t Error(uint32_t clock, uint32_t frequency, uint64_t division)
+{
+	uint64_t target = (uint64_t)frequency * division;
+	return (target > clock) ? (target - clock) : (clock - target);
+}
+
+/* -1, 0 or 1 as error_a / division_a is smaller, equal or larger than error_b / division_b */
+static int Compare(uint64_t error_a, uint64_t division_a, uint64_t error_b, uint64_t division_b)
+{
+	uint128_t a = (uint128_t)error_a * division_b;
+	uint128_t b = (uint128_t)error_b * division_a;
+	return (a < b) ? -1 : (a > b);
+}
+
+/* Best pair over every prescaler, the smallest prescaler among equals */
+static void Brute_Force(uint32_t clock, uint32_t frequency, uint32_t max_reload, uint32_t *prescaler, uint64_t *division)
+{
+	uint64_t reloads = (uint64_t)max_reload + 1;
+	uint64_t best_error = 0;
+
+	*division = 0;
+
+	for(uint64_t p = 1; p <= 65536; p++)
+	{
+		uint64_t r = clock / ((uint64_t)frequency * p);
+
+		for(int i = 0; i < 2; i++, r++)
+		{
+			if((r == 0) || (r > reloads) || (p * r < 2)) continue;
+
+			uint64_t error = Error(clock, frequency, p * r);
+
+			if((*division == 0) || (Compare(error, p * r, best_error, *division) < 0))
+			{
+				best_error = error;
+				*division = p * r;
+				*prescaler = (uint32_t)p;
+			}
+		}
+	}
+}
+
+static double Now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void Check_Rate(uint32_t clock, uint32_t frequency, uint32_t max_reload, Sweep *sweep)
+{
+	Timer_Settings settings;
+	uint32_t prescaler = 0;
+	uint64_t division;
+
+	double start = Now();
+	int8_t result = Timer_Solve(clock, frequency, max_reload, &settings);
+	double elapsed = Now() - start;
+
+	sweep->Seconds += elapsed;
+	if(elapsed > sweep->Slowest) sweep->Slowest = elapsed;
+
+	Brute_Force(clock, frequency, max_reload, &prescaler, &division);
+
+	if(division == 0)
+	{
+		CHECK(result == -1, "%u Hz / %u: solved a rate out of range\n", clock, frequency);
+		return;
+	}
+
+	sweep->Solves++;
+
+	CHECK(result >= 0, "%u Hz / %u, reload %u: no result\n", clock, frequency, max_reload);
+	if(result < 0) return;
+
+	uint64_t solved = settings.Division;
+	uint64_t error = Error(clock, frequency, solved);
+	uint64_t best = Error(clock, frequency, division);
+
+	CHECK((uint64_t)(settings.Prescaler + 1) * ((uint64_t)settings.Reload + 1) == solved,
+			"%u Hz / %u: PSC %u ARR %u do not give %" PRIu64 "\n", clock, frequency, settings.Prescaler, settings.Reload, solved);
+	CHECK((settings.Reload <= max_reload) && (solved >= 2), "%u Hz / %u: ARR %u out of range\n", clock, frequency, settings.Reload);
+	CHECK(settings.Compare == settings.Reload / 2, "%u Hz / %u: compare\n", clock, frequency);
+	CHECK((result == 1) == (error == 0), "%u Hz / %u: exact flag %d\n", clock, frequency, result);
+
+	int order = Compare(error, solved, best, division);
+
+	CHECK(order >= 0, "%u Hz / %u: better than the brute force\n", clock, frequency);
+
+	if(order == 0)
+	{
+		sweep->Optimal++;
+		CHECK(settings.Prescaler + 1U == prescaler, "%u Hz / %u, reload %u: PSC %u, brute force %u\n",
+				clock, frequency, max_reload, settings.Prescaler, prescaler - 1);
+		return;
+	}
+
+	// Budget spent: within half a step of the first prescaler that reaches the ratio, plus half a clock
+	double ratio = (double)clock / frequency;
+	double first = ceil(ratio / ((double)max_reload + 1));
+	double relative = fabs((double)clock / solved - frequency) / frequency;
+	double bound = (first / 2 + 0.5) / (ratio - first);
+
+	sweep->Nearest++;
+	if(relative > sweep->Worst) sweep->Worst = relative;
+
+	CHECK(relative <= bound, "%u Hz / %u, reload %u: error %.3g above %.3g\n", clock, frequency, max_reload, relative, bound);
+}
+
+static bool Is_Prime(uint32_t n)
+{
+	if(n < 2) return false;
+	for(uint32_t d = 2; (uint64_t)d * d <= n; d++) if((n % d) == 0) return false;
+	return true;
+}
+
+int main(void)
+{
+	const uint32_t clocks[] = {TIMER_APB1_CLOCK, TIMER_APB2_CLOCK};
+	const uint32_t reloads[] = {TIMER_RELOAD_16_BIT, TIMER_RELOAD_32_BIT};
+
+	for(int c = 0; c < 2; c++)
+	{
+		for(int r = 0; r < 2; r++)
+		{
+			Sweep sweep = {0};
+			uint32_t clock = clocks[c];
+			uint32_t previous = 0;
+
+			for(double f = 1.0; f <= clock / 2; f *= pow(10.0, 1.0 / RATES_PER_DECADE))
+			{
+				uint32_t frequency = (uint32_t)llround(f);
+				if(frequency == previous) continue;
+				previous = frequency;
+
+				Check_Rate(clock, frequency, reloads[r], &sweep);
+			}
+
+			// Rates whose ratio is the prime just below clock / f, the case that exhausts the factoring
+			for(uint32_t frequency = 1; frequency <= 1000; frequency = frequency * 3 + 1)
+			{
+				uint32_t ratio = clock / frequency;
+				while(!Is_Prime(ratio)) ratio--;
+				Check_Rate(clock, clock / ratio, reloads[r], &sweep);
+				Check_Rate(clock, frequency, reloads[r], &sweep);
+			}
+
+			printf("Test_Timer: %3u MHz, %2d-bit reload: %u rates, %u optimal, %u nearest (worst %.2g), %.2f us mean, %.2f us worst\n",
+					clock / 1000000, (reloads[r] == TIMER_RELOAD_16_BIT) ? 16 : 32, sweep.Solves, sweep.Optimal, sweep.Nearest,
+					sweep.Worst, 1e6 * sweep.Seconds / sweep.Solves, 1e6 * sweep.Slowest);
+		}
+	}
+
+	// Out of range
+	Timer_Settings settings;
+	CHECK(Timer_Solve(TIMER_APB1_CLOCK, 0, TIMER_RELOAD_16_BIT, &settings) == -1, "0 Hz solved\n");
+	CHECK(Timer_Solve(TIMER_APB1_CLOCK, TIMER_APB1_CLOCK / 2 + 1, TIMER_RELOAD_16_BIT, &settings) == -1, "clock / 2 + 1 solved\n");
+
+	printf("Test_Timer: %d failures\n", failures);
+	return failures != 0;
+}